@@ -34,6 +34,14 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <pthread.h>
 
 /* Headers required by PAPI */
 #include "papi.h"
@@ -65,8 +73,7 @@ papi_vector_t _appio_vector;
 static APPIO_native_event_entry_t * _appio_native_events;
 
 
-/* If you modify the appio_stats_t below, you MUST update APPIO_MAX_COUNTERS */
-static __thread long long _appio_register_current[APPIO_MAX_COUNTERS];
+/* If you modify the appio_stats_t below, you MUST update APPIO_NUM_SCALARS */
 typedef enum {
   READ_BYTES = 0,
   READ_CALLS,
@@ -98,6 +105,14 @@ typedef enum {
   RECV_EOF,
   RECV_BLOCK_SIZE,
   RECV_USEC,
+  SEND_BYTES,
+  SEND_CALLS,
+  SEND_ERR,
+  SEND_INTERRUPTED,
+  SEND_WOULD_BLOCK,
+  SEND_SHORT,
+  SEND_BLOCK_SIZE,
+  SEND_USEC,
   SOCK_READ_BYTES,
   SOCK_READ_CALLS,
   SOCK_READ_ERR,
@@ -112,13 +127,22 @@ typedef enum {
   SOCK_WRITE_USEC,
   SEEK_CALLS,
   SEEK_ABS_STRIDE_SIZE,
-  SEEK_USEC
+  SEEK_USEC,
+  IO_URING_CALLS,
+  IO_URING_ERR,
+  IO_URING_SUBMITTED,
+  IO_URING_USEC,
+  /* log2 histograms, APPIO_HIST_BUCKETS events each, named in init */
+  READ_LAT_BUCKET_0 = APPIO_NUM_SCALARS,
+  READ_SIZE_BUCKET_0 = READ_LAT_BUCKET_0 + APPIO_HIST_BUCKETS,
+  WRITE_LAT_BUCKET_0 = READ_SIZE_BUCKET_0 + APPIO_HIST_BUCKETS,
+  WRITE_SIZE_BUCKET_0 = WRITE_LAT_BUCKET_0 + APPIO_HIST_BUCKETS
 } _appio_stats_t ;
 
 static const struct appio_counters {
     const char *name;
     const char *description;
-} _appio_counter_info[APPIO_MAX_COUNTERS] = {
+} _appio_counter_info[APPIO_NUM_SCALARS] = {
     { "READ_BYTES",      "Bytes read"},
     { "READ_CALLS",      "Number of read calls"},
     { "READ_ERR",        "Number of read calls that resulted in an error"},
@@ -149,6 +173,14 @@ static const struct appio_counters {
     { "RECV_EOF",        "Number of recv/recvmsg/recvfrom calls that returned an EOF"},
     { "RECV_BLOCK_SIZE", "Average block size of recv/recvmsg/recvfrom"},
     { "RECV_USEC",       "Real microseconds spent in recv/recvmsg/recvfrom"},
+    { "SEND_BYTES",      "Bytes written in sendmsg"},
+    { "SEND_CALLS",      "Number of sendmsg calls"},
+    { "SEND_ERR",        "Number of sendmsg calls that resulted in an error"},
+    { "SEND_INTERRUPTED","Number of sendmsg calls that timed out or were interrupted"},
+    { "SEND_WOULD_BLOCK","Number of sendmsg calls that would have blocked"},
+    { "SEND_SHORT",      "Number of sendmsg calls that sent less bytes than requested"},
+    { "SEND_BLOCK_SIZE", "Average block size of sendmsg"},
+    { "SEND_USEC",       "Real microseconds spent in sendmsg"},
     { "SOCK_READ_BYTES", "Bytes read from socket"},
     { "SOCK_READ_CALLS", "Number of read calls on socket"},
     { "SOCK_READ_ERR",   "Number of read calls on socket that resulted in an error"},
@@ -163,9 +195,31 @@ static const struct appio_counters {
     { "SOCK_WRITE_USEC", "Real microseconds spent in write(s) to socket(s)"},
     { "SEEK_CALLS",      "Number of seek calls"},
     { "SEEK_ABS_STRIDE_SIZE", "Average absolute stride size of seeks"},
-    { "SEEK_USEC",       "Real microseconds spent in seek calls"}
+    { "SEEK_USEC",       "Real microseconds spent in seek calls"},
+    { "IO_URING_CALLS",  "Number of io_uring_enter calls"},
+    { "IO_URING_ERR",    "Number of io_uring_enter calls that resulted in an error"},
+    { "IO_URING_SUBMITTED", "Number of submission queue entries consumed by io_uring_enter"},
+    { "IO_URING_USEC",   "Real microseconds spent in io_uring_enter"}
 };
 
+/* The histograms, in _appio_stats_t order */
+static const struct appio_histograms {
+    const char *name;
+    const char *calls;
+    const char *unit;
+} _appio_hist_info[4] = {
+    { "READ_LAT",   "read calls that took",          "ns" },
+    { "READ_SIZE",  "read calls that transferred",   "bytes" },
+    { "WRITE_LAT",  "write calls that took",         "ns" },
+    { "WRITE_SIZE", "write calls that transferred",  "bytes" }
+};
+
+/* Names and descriptions of the histogram events, built in init */
+static struct appio_hist_event {
+    char name[PAPI_MIN_STR_LEN];
+    char description[PAPI_MAX_STR_LEN];
+} *_appio_hist_events;
+
 // The following macro follows if a string function has an error. It should 
 // never happen; but it is necessary to prevent compiler warnings. We print 
 // something just in case there is programmer error in invoking the function.
@@ -175,236 +229,840 @@ static const struct appio_counters {
  ***  BEGIN FUNCTIONS  USED INTERNALLY SPECIFIC TO THIS COMPONENT ****
  ********************************************************************/
 
+/* Counters of one thread.  Only the owning thread ever writes its
+ * block, so counting needs no atomics.  Blocks are linked on a global
+ * list; when a thread exits, the key destructor adds its counts to
+ * _appio_retired and frees its block, so process granularity still
+ * sees the I/O of threads that have exited. */
+typedef struct appio_block {
+  long long c[APPIO_MAX_COUNTERS];
+  struct appio_block *next;
+} appio_block_t;
+
+/* Weak like pthread_once in papi.c, to not need libpthread */
+#pragma weak pthread_key_create
+#pragma weak pthread_key_delete
+#pragma weak pthread_setspecific
+
+static __thread appio_block_t *_appio_self;
+static appio_block_t *_appio_blocks;
+static appio_block_t _appio_retired;
+
+/* Component shutdown frees every block; a thread whose block is from
+ * an older generation starts a new one */
+static unsigned int _appio_generation;
+static __thread unsigned int _appio_self_generation;
+
+/* used when a block cannot be allocated; counted but never summed */
+static __thread appio_block_t _appio_spare;
+
+/* Guards the list, _appio_retired and the key.  Only taken when a
+ * thread starts or ends counting and by process granularity reads. */
+static volatile int _appio_lock;
+static pthread_key_t _appio_key;
+static int _appio_key_ok;
+
+static inline void appio_lock(void) {
+  while (__sync_lock_test_and_set(&_appio_lock, 1))
+    while (_appio_lock) ;
+}
+
+static inline void appio_unlock(void) {
+  __sync_lock_release(&_appio_lock);
+}
+
+/* Thread exit: fold the block into _appio_retired and free it.  A
+ * block that is no longer on the list was freed by shutdown already. */
+static void appio_thread_exit(void *arg) {
+  appio_block_t *b = (appio_block_t *) arg;
+  appio_block_t **prev;
+  int i;
+
+  appio_lock();
+  for (prev = &_appio_blocks; *prev != NULL; prev = &(*prev)->next) {
+    if (*prev == b) break;
+  }
+  if (*prev != NULL) {
+    *prev = b->next;
+    for (i = 0; i < APPIO_MAX_COUNTERS; i++)
+      _appio_retired.c[i] += b->c[i];
+  } else {
+    b = NULL;
+  }
+  appio_unlock();
+  free(b);
+  /* I/O done by later destructors starts a new block */
+  _appio_self = NULL;
+}
+
+static appio_block_t *appio_new_block(void) {
+  appio_block_t *b = calloc(1, sizeof(appio_block_t));
+  _appio_self_generation = _appio_generation;
+  if (b == NULL) {
+    _appio_self = &_appio_spare;
+    return _appio_self;
+  }
+  appio_lock();
+  if (!_appio_key_ok && pthread_key_create)
+    _appio_key_ok = (pthread_key_create(&_appio_key, appio_thread_exit) == 0);
+  if (_appio_key_ok && pthread_setspecific)
+    pthread_setspecific(_appio_key, b);
+  b->next = _appio_blocks;
+  _appio_blocks = b;
+  appio_unlock();
+  _appio_self = b;
+  return b;
+}
+
+static inline long long *appio_counters(void) {
+  appio_block_t *b = _appio_self;
+  if (b == NULL || _appio_self_generation != _appio_generation)
+    b = appio_new_block();
+  return b->c;
+}
+
+/* Fast mode (PAPI_APPIO_FAST=1 in the environment) skips the fstat()
+ * and zero-timeout select() probes done around every read/write.
+ * Socket-ness of a descriptor is looked up once and cached until the
+ * descriptor is closed or replaced; every call below that hands out a
+ * descriptor clears its entry, so a number reused after a close the
+ * component did not see is looked up again.  Would-block is only
+ * counted when the call itself fails with EAGAIN/EWOULDBLOCK. */
+static int _appio_fast;
+
+#define APPIO_FD_UNKNOWN 0
+#define APPIO_FD_FILE    1
+#define APPIO_FD_SOCKET  2
+static unsigned char _appio_fd_class[APPIO_FD_CACHE_SIZE];
+
+static inline void appio_forget_fd(int fd) {
+  if (fd >= 0 && fd < APPIO_FD_CACHE_SIZE) _appio_fd_class[fd] = APPIO_FD_UNKNOWN;
+}
+
+static int appio_issocket(int fd) {
+  struct stat st;
+  int issocket = 0;
+  int cached = _appio_fast && fd >= 0 && fd < APPIO_FD_CACHE_SIZE;
+
+  if (cached && _appio_fd_class[fd] != APPIO_FD_UNKNOWN)
+    return _appio_fd_class[fd] == APPIO_FD_SOCKET;
+
+  if (fstat(fd, &st) == 0) {
+    if ((st.st_mode & S_IFMT) == S_IFSOCK) issocket = 1;
+    if (cached) _appio_fd_class[fd] = issocket ? APPIO_FD_SOCKET : APPIO_FD_FILE;
+  }
+  return issocket;
+}
+
+/* The replacements below must be visible outside of libpapi.so, which
+   is otherwise built with hidden visibility */
+#pragma GCC visibility push(default)
+
 int __close(int fd);
 int close(int fd) {
   int retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted close(%d)\n", fd);
+  appio_forget_fd(fd);
   retval = __close(fd);
-  if ((retval == 0) && (_appio_register_current[OPEN_FDS]>0)) _appio_register_current[OPEN_FDS]--;
+  if ((retval == 0) && (c[OPEN_FDS]>0)) c[OPEN_FDS]--;
   return retval;
 }
 
 int __open(const char *pathname, int flags, mode_t mode);
 int open(const char *pathname, int flags, mode_t mode) {
   int retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted open(%s,%d,%d)\n", pathname, flags, mode);
   retval = __open(pathname,flags,mode);
-  _appio_register_current[OPEN_CALLS]++;
-  if (retval < 0) _appio_register_current[OPEN_ERR]++;
-  else _appio_register_current[OPEN_FDS]++;
+  c[OPEN_CALLS]++;
+  if (retval < 0) c[OPEN_ERR]++;
+  else {
+    c[OPEN_FDS]++;
+    appio_forget_fd(retval);
+  }
+  return retval;
+}
+
+int __dup2(int oldfd, int newfd);
+int dup2(int oldfd, int newfd) {
+  int retval;
+  SUBDBG("appio: intercepted dup2(%d,%d)\n", oldfd, newfd);
+  retval = __dup2(oldfd, newfd);
+  if (retval >= 0) appio_forget_fd(retval);
+  return retval;
+}
+
+// The PIC test implies it's built for shared linkage
+#ifdef PIC
+/* Look up the libc version of an interposed call that libc does not
+   export under a __ name */
+#define APPIO_REAL(fn) \
+  if (!__##fn) __##fn = dlsym(RTLD_NEXT, #fn); \
+  if (!__##fn) { \
+    fprintf(stderr, "appio,c Internal Error: Could not obtain handle for real " #fn "\n"); \
+    exit(1); \
+  }
+
+static int (*__dup)(int oldfd) = NULL;
+int dup(int oldfd) {
+  int retval;
+  SUBDBG("appio: intercepted dup(%d)\n", oldfd);
+  if (!__dup) __dup = dlsym(RTLD_NEXT, "dup");
+  if (!__dup) {
+    fprintf(stderr, "appio,c Internal Error: Could not obtain handle for real dup\n");
+    exit(1);
+  }
+  retval = __dup(oldfd);
+  if (retval >= 0) appio_forget_fd(retval);
+  return retval;
+}
+
+static int (*__dup3)(int oldfd, int newfd, int flags) = NULL;
+int dup3(int oldfd, int newfd, int flags) {
+  int retval;
+  SUBDBG("appio: intercepted dup3(%d,%d,%d)\n", oldfd, newfd, flags);
+  if (!__dup3) __dup3 = dlsym(RTLD_NEXT, "dup3");
+  if (!__dup3) {
+    fprintf(stderr, "appio,c Internal Error: Could not obtain handle for real dup3\n");
+    exit(1);
+  }
+  retval = __dup3(oldfd, newfd, flags);
+  if (retval >= 0) appio_forget_fd(retval);
+  return retval;
+}
+
+/* Other calls that create descriptors only need the cache entry of
+   the new one cleared */
+#define APPIO_NEW_FD(fn, call) \
+  int retval; \
+  SUBDBG("appio: intercepted " #fn "\n"); \
+  APPIO_REAL(fn); \
+  retval = call; \
+  if (retval >= 0) appio_forget_fd(retval); \
+  return retval;
+
+static int (*__socket)(int domain, int type, int protocol) = NULL;
+int socket(int domain, int type, int protocol) {
+  APPIO_NEW_FD(socket, __socket(domain, type, protocol));
+}
+
+static int (*__accept)(int sockfd, struct sockaddr *addr, socklen_t *addrlen) = NULL;
+int accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
+  APPIO_NEW_FD(accept, __accept(sockfd, addr, addrlen));
+}
+
+static int (*__accept4)(int sockfd, struct sockaddr *addr, socklen_t *addrlen, int flags) = NULL;
+int accept4(int sockfd, struct sockaddr *addr, socklen_t *addrlen, int flags) {
+  APPIO_NEW_FD(accept4, __accept4(sockfd, addr, addrlen, flags));
+}
+
+static int (*__openat)(int dirfd, const char *pathname, int flags, mode_t mode) = NULL;
+int openat(int dirfd, const char *pathname, int flags, mode_t mode) {
+  APPIO_NEW_FD(openat, __openat(dirfd, pathname, flags, mode));
+}
+
+static int (*__creat)(const char *pathname, mode_t mode) = NULL;
+int creat(const char *pathname, mode_t mode) {
+  APPIO_NEW_FD(creat, __creat(pathname, mode));
+}
+
+static int (*__eventfd)(unsigned int initval, int flags) = NULL;
+int eventfd(unsigned int initval, int flags) {
+  APPIO_NEW_FD(eventfd, __eventfd(initval, flags));
+}
+
+static int (*__epoll_create)(int size) = NULL;
+int epoll_create(int size) {
+  APPIO_NEW_FD(epoll_create, __epoll_create(size));
+}
+
+static int (*__epoll_create1)(int flags) = NULL;
+int epoll_create1(int flags) {
+  APPIO_NEW_FD(epoll_create1, __epoll_create1(flags));
+}
+
+/* F_DUPFD and F_DUPFD_CLOEXEC from <fcntl.h>, which cannot be included
+   next to the open() replacement above */
+#define APPIO_F_DUPFD         0
+#define APPIO_F_DUPFD_CLOEXEC 1030
+
+static int (*__fcntl)(int fd, int cmd, ...) = NULL;
+int fcntl(int fd, int cmd, ...) {
+  int retval;
+  void *arg;
+  va_list ap;
+  va_start(ap, cmd);
+  arg = va_arg(ap, void *);
+  va_end(ap);
+  APPIO_REAL(fcntl);
+  retval = __fcntl(fd, cmd, arg);
+  if ((cmd == APPIO_F_DUPFD || cmd == APPIO_F_DUPFD_CLOEXEC) && retval >= 0)
+    appio_forget_fd(retval);
+  return retval;
+}
+
+static int (*__pipe)(int pipefd[2]) = NULL;
+int pipe(int pipefd[2]) {
+  int retval;
+  SUBDBG("appio: intercepted pipe\n");
+  APPIO_REAL(pipe);
+  retval = __pipe(pipefd);
+  if (retval == 0) {
+    appio_forget_fd(pipefd[0]);
+    appio_forget_fd(pipefd[1]);
+  }
+  return retval;
+}
+
+static int (*__pipe2)(int pipefd[2], int flags) = NULL;
+int pipe2(int pipefd[2], int flags) {
+  int retval;
+  SUBDBG("appio: intercepted pipe2\n");
+  APPIO_REAL(pipe2);
+  retval = __pipe2(pipefd, flags);
+  if (retval == 0) {
+    appio_forget_fd(pipefd[0]);
+    appio_forget_fd(pipefd[1]);
+  }
+  return retval;
+}
+
+static int (*__socketpair)(int domain, int type, int protocol, int sv[2]) = NULL;
+int socketpair(int domain, int type, int protocol, int sv[2]) {
+  int retval;
+  SUBDBG("appio: intercepted socketpair\n");
+  APPIO_REAL(socketpair);
+  retval = __socketpair(domain, type, protocol, sv);
+  if (retval == 0) {
+    appio_forget_fd(sv[0]);
+    appio_forget_fd(sv[1]);
+  }
+  return retval;
+}
+
+/* fclose() closes the descriptor inside libc, past close() above */
+static int (*__fclose)(FILE *stream) = NULL;
+int fclose(FILE *stream) {
+  int fd = stream ? fileno(stream) : -1;
+  int retval;
+  SUBDBG("appio: intercepted fclose(%p)\n", stream);
+  APPIO_REAL(fclose);
+  retval = __fclose(stream);
+  appio_forget_fd(fd);
   return retval;
 }
+#endif /* PIC */
 
 /* we use timeval as a zero value timeout to select in read/write
    for polling if the operation would block */
 struct timeval zerotv; /* this has to be zero, so define it here */
 
+/* Histogram bucket of v: bucket k holds [2^k, 2^(k+1)), bucket 0 also
+   holds 0 and the last bucket everything above */
+static inline void appio_hist(long long *c, int bucket0, long long v) {
+  int k = (v > 1) ? 63 - __builtin_clzll((unsigned long long)v) : 0;
+  if (k >= APPIO_HIST_BUCKETS) k = APPIO_HIST_BUCKETS - 1;
+  c[bucket0 + k]++;
+}
+
 int __select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
+
+/* Zero-timeout select() on fd; only done outside of fast mode */
+static void appio_probe_would_block(long long *c, int fd, int issocket, int writing) {
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(fd, &fds);
+  int ready = writing ? __select(fd+1, NULL, &fds, NULL, &zerotv)
+                      : __select(fd+1, &fds, NULL, NULL, &zerotv);
+  if (ready == 0) {
+    if (writing) {
+      c[WRITE_WOULD_BLOCK]++;
+      if (issocket) c[SOCK_WRITE_WOULD_BLOCK]++;
+    } else {
+      c[READ_WOULD_BLOCK]++;
+      if (issocket) c[SOCK_READ_WOULD_BLOCK]++;
+    }
+  }
+}
+
+/* Count a read of count bytes that returned retval after duration ns,
+   err is errno right after the call */
+static void appio_count_read(long long *c, int issocket, ssize_t retval, size_t count, long long duration, int err) {
+  c[READ_CALLS]++; // read calls
+  if (issocket) c[SOCK_READ_CALLS]++; // read calls
+  if (retval > 0) {
+    c[READ_BLOCK_SIZE] += count; // summed, the mean is taken in _appio_read
+    c[READ_BYTES] += retval; // read bytes
+    if (issocket) c[SOCK_READ_BYTES] += retval;
+    if ((size_t)retval < count) {
+       c[READ_SHORT]++; // read short
+       if (issocket) c[SOCK_READ_SHORT]++; // read short
+    }
+    c[READ_USEC] += duration;
+    if (issocket) c[SOCK_READ_USEC] += duration;
+  }
+  if (retval < 0) { 
+    c[READ_ERR]++; // read err
+    if (issocket) c[SOCK_READ_ERR]++; // read err
+    if (EINTR == err)
+      c[READ_INTERRUPTED]++; // signal interrupted the read
+    if (_appio_fast && ((EAGAIN == err) || (EWOULDBLOCK == err))) {
+      c[READ_WOULD_BLOCK]++; //read would block on descriptor marked as non-blocking
+      if (issocket) c[SOCK_READ_WOULD_BLOCK]++;
+    }
+  }
+  if (retval == 0) c[READ_EOF]++; // read eof
+  appio_hist(c, READ_LAT_BUCKET_0, duration);
+  if (retval >= 0) appio_hist(c, READ_SIZE_BUCKET_0, retval);
+}
+
+/* Same for writes */
+static void appio_count_write(long long *c, int issocket, ssize_t retval, size_t count, long long duration, int err) {
+  c[WRITE_CALLS]++; // write calls
+  if (issocket) c[SOCK_WRITE_CALLS]++; // socket write
+  if (retval >= 0) {
+    c[WRITE_BLOCK_SIZE] += count; // summed, the mean is taken in _appio_read
+    c[WRITE_BYTES]+= retval; // write bytes
+    if (issocket) c[SOCK_WRITE_BYTES] += retval;
+    if ((size_t)retval < count) {
+      c[WRITE_SHORT]++; // short write
+      if (issocket) c[SOCK_WRITE_SHORT]++; 
+    }
+    c[WRITE_USEC] += duration;
+    if (issocket) c[SOCK_WRITE_USEC] += duration;
+  }
+  if (retval < 0) {
+    c[WRITE_ERR]++; // err
+    if (issocket) c[SOCK_WRITE_ERR]++;
+    if (EINTR == err)
+      c[WRITE_INTERRUPTED]++; // signal interrupted the op
+    if (_appio_fast && ((EAGAIN == err) || (EWOULDBLOCK == err))) {
+      c[WRITE_WOULD_BLOCK]++; //op would block on descriptor marked as non-blocking
+      if (issocket) c[SOCK_WRITE_WOULD_BLOCK]++;
+    }
+  }
+  appio_hist(c, WRITE_LAT_BUCKET_0, duration);
+  if (retval >= 0) appio_hist(c, WRITE_SIZE_BUCKET_0, retval);
+}
+
 int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout) {
   int retval;
   SUBDBG("appio: intercepted select(%d,%p,%p,%p,%p)\n", nfds,readfds,writefds,exceptfds,timeout);
-  long long start_ts = PAPI_get_real_usec();
+  long long start_ts = PAPI_get_real_nsec();
   retval = __select(nfds,readfds,writefds,exceptfds,timeout);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  _appio_register_current[SELECT_USEC] += duration;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_counters()[SELECT_USEC] += duration;
   return retval;
 }
 
 off_t __lseek(int fd, off_t offset, int whence);
 off_t lseek(int fd, off_t offset, int whence) {
   off_t retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted lseek(%d,%ld,%d)\n", fd, offset, whence);
-  long long start_ts = PAPI_get_real_usec();
+  long long start_ts = PAPI_get_real_nsec();
   retval = __lseek(fd, offset, whence);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  int n = _appio_register_current[SEEK_CALLS]++;
-  _appio_register_current[SEEK_USEC] += duration;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  c[SEEK_CALLS]++;
+  c[SEEK_USEC] += duration;
   if (offset < 0) offset = -offset; // get abs offset
-  _appio_register_current[SEEK_ABS_STRIDE_SIZE]= (n * _appio_register_current[SEEK_ABS_STRIDE_SIZE] + offset)/(n+1); // mean absolute stride size
+  c[SEEK_ABS_STRIDE_SIZE] += offset; // summed, the mean is taken in _appio_read
   return retval;
 }
 
 extern int errno;
 ssize_t __read(int fd, void *buf, size_t count);
 ssize_t read(int fd, void *buf, size_t count) {
-  int retval;
+  ssize_t retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted read(%d,%p,%lu)\n", fd, buf, (unsigned long)count);
 
-  struct stat st;
-  int issocket = 0;
-  if (fstat(fd, &st) == 0) {
-    if ((st.st_mode & S_IFMT) == S_IFSOCK) issocket = 1;
-  }
-  // check if read would block on descriptor
-  fd_set readfds;
-  FD_ZERO(&readfds);
-  FD_SET(fd, &readfds);
-  int ready = __select(fd+1, &readfds, NULL, NULL, &zerotv);
-  if (ready == 0) {
-     _appio_register_current[READ_WOULD_BLOCK]++; 
-     if (issocket) _appio_register_current[SOCK_READ_WOULD_BLOCK]++; 
-  }
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 0);
 
-  long long start_ts = PAPI_get_real_usec();
+  long long start_ts = PAPI_get_real_nsec();
   retval = __read(fd,buf, count);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  int n = _appio_register_current[READ_CALLS]++; // read calls
-  if (issocket) _appio_register_current[SOCK_READ_CALLS]++; // read calls
-  if (retval > 0) {
-    _appio_register_current[READ_BLOCK_SIZE]= (n * _appio_register_current[READ_BLOCK_SIZE] + count)/(n+1); // mean size
-    _appio_register_current[READ_BYTES] += retval; // read bytes
-    if (issocket) _appio_register_current[SOCK_READ_BYTES] += retval;
-    if (retval < (int)count) {
-       _appio_register_current[READ_SHORT]++; // read short
-       if (issocket) _appio_register_current[SOCK_READ_SHORT]++; // read short
-    }
-    _appio_register_current[READ_USEC] += duration;
-    if (issocket) _appio_register_current[SOCK_READ_USEC] += duration;
-  }
-  if (retval < 0) { 
-    _appio_register_current[READ_ERR]++; // read err
-    if (issocket) _appio_register_current[SOCK_READ_ERR]++; // read err
-    if (EINTR == errno)
-      _appio_register_current[READ_INTERRUPTED]++; // signal interrupted the read
-    //if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) {
-    //  _appio_register_current[READ_WOULD_BLOCK]++; //read would block on descriptor marked as non-blocking
-    //  if (issocket) _appio_register_current[SOCK_READ_WOULD_BLOCK]++; //read would block on descriptor marked as non-blocking
-    //}
-  }
-  if (retval == 0) _appio_register_current[READ_EOF]++; // read eof
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_read(c, issocket, retval, count, duration, err);
+  errno = err;
+  return retval;
+}
+
+ssize_t __pread64(int fd, void *buf, size_t count, off64_t offset);
+static ssize_t appio_pread(int fd, void *buf, size_t count, off64_t offset) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted pread(%d,%p,%lu,%lld)\n", fd, buf, (unsigned long)count, (long long)offset);
+
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 0);
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __pread64(fd, buf, count, offset);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_read(c, issocket, retval, count, duration, err);
+  errno = err;
   return retval;
 }
+ssize_t pread(int fd, void *buf, size_t count, off_t offset) {
+  return appio_pread(fd, buf, count, offset);
+}
+ssize_t pread64(int fd, void *buf, size_t count, off64_t offset) {
+  return appio_pread(fd, buf, count, offset);
+}
 
 size_t _IO_fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
 size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream) {
   size_t retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted fread(%p,%lu,%lu,%p)\n", ptr, (unsigned long) size, (unsigned long) nmemb, (void*) stream);
-  long long start_ts = PAPI_get_real_usec();
+  long long start_ts = PAPI_get_real_nsec();
   retval = _IO_fread(ptr,size,nmemb,stream);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  int n = _appio_register_current[READ_CALLS]++; // read calls
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  c[READ_CALLS]++; // read calls
   if (retval > 0) {
-    _appio_register_current[READ_BLOCK_SIZE]= (n * _appio_register_current[READ_BLOCK_SIZE]+ size*nmemb)/(n+1);//mean size
-    _appio_register_current[READ_BYTES]+= retval * size; // read bytes
-    if (retval < nmemb) _appio_register_current[READ_SHORT]++; // read short
-    _appio_register_current[READ_USEC] += duration;
+    c[READ_BLOCK_SIZE] += size*nmemb; // summed, the mean is taken in _appio_read
+    c[READ_BYTES]+= retval * size; // read bytes
+    if (retval < nmemb) c[READ_SHORT]++; // read short
+    c[READ_USEC] += duration;
   }
 
   /* A value of zero returned means one of two things..*/
   if (retval == 0) {
-     if (feof(stream)) _appio_register_current[READ_EOF]++; // read eof
-     else _appio_register_current[READ_ERR]++; // read err
+     if (feof(stream)) c[READ_EOF]++; // read eof
+     else c[READ_ERR]++; // read err
   }
+  appio_hist(c, READ_LAT_BUCKET_0, duration);
+  appio_hist(c, READ_SIZE_BUCKET_0, retval * size);
   return retval;
 }
 
 ssize_t __write(int fd, const void *buf, size_t count);
 ssize_t write(int fd, const void *buf, size_t count) {
-  int retval;
+  ssize_t retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted write(%d,%p,%lu)\n", fd, buf, (unsigned long)count);
-  struct stat st;
-  int issocket = 0;
-  if (fstat(fd, &st) == 0) {
-    if ((st.st_mode & S_IFMT) == S_IFSOCK) issocket = 1;
-  }
 
-  // check if write would block on descriptor
-  fd_set writefds;
-  FD_ZERO(&writefds);
-  FD_SET(fd, &writefds);
-  int ready = __select(fd+1, NULL, &writefds, NULL, &zerotv);
-  if (ready == 0) {
-    _appio_register_current[WRITE_WOULD_BLOCK]++; 
-    if (issocket) _appio_register_current[SOCK_WRITE_WOULD_BLOCK]++; 
-  }
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 1);
 
-  long long start_ts = PAPI_get_real_usec();
+  long long start_ts = PAPI_get_real_nsec();
   retval = __write(fd,buf, count);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  int n = _appio_register_current[WRITE_CALLS]++; // write calls
-  if (issocket) _appio_register_current[SOCK_WRITE_CALLS]++; // socket write
-  if (retval >= 0) {
-    _appio_register_current[WRITE_BLOCK_SIZE]= (n * _appio_register_current[WRITE_BLOCK_SIZE] + count)/(n+1); // mean size
-    _appio_register_current[WRITE_BYTES]+= retval; // write bytes
-    if (issocket) _appio_register_current[SOCK_WRITE_BYTES] += retval;
-    if (retval < (int)count) {
-      _appio_register_current[WRITE_SHORT]++; // short write
-      if (issocket) _appio_register_current[SOCK_WRITE_SHORT]++; 
-    }
-    _appio_register_current[WRITE_USEC] += duration;
-    if (issocket) _appio_register_current[SOCK_WRITE_USEC] += duration;
-  }
-  if (retval < 0) {
-    _appio_register_current[WRITE_ERR]++; // err
-    if (issocket) _appio_register_current[SOCK_WRITE_ERR]++;
-    if (EINTR == errno)
-      _appio_register_current[WRITE_INTERRUPTED]++; // signal interrupted the op
-    //if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) {
-    //  _appio_register_current[WRITE_WOULD_BLOCK]++; //op would block on descriptor marked as non-blocking
-    //  if (issocket) _appio_register_current[SOCK_WRITE_WOULD_BLOCK]++;
-    //}
-  }
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_write(c, issocket, retval, count, duration, err);
+  errno = err;
+  return retval;
+}
+
+ssize_t __pwrite64(int fd, const void *buf, size_t count, off64_t offset);
+static ssize_t appio_pwrite(int fd, const void *buf, size_t count, off64_t offset) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted pwrite(%d,%p,%lu,%lld)\n", fd, buf, (unsigned long)count, (long long)offset);
+
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 1);
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __pwrite64(fd, buf, count, offset);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_write(c, issocket, retval, count, duration, err);
+  errno = err;
   return retval;
 }
+ssize_t pwrite(int fd, const void *buf, size_t count, off_t offset) {
+  return appio_pwrite(fd, buf, count, offset);
+}
+ssize_t pwrite64(int fd, const void *buf, size_t count, off64_t offset) {
+  return appio_pwrite(fd, buf, count, offset);
+}
 
 // The PIC test implies it's built for shared linkage
 #ifdef PIC
+/* Same for recv() and recvmsg(), which also go in the read histograms */
+static void appio_count_recv(long long *c, ssize_t retval, size_t len, long long duration, int err) {
+  c[RECV_CALLS]++; // read calls
+  if (retval > 0) {
+    c[RECV_BLOCK_SIZE] += len; // summed, the mean is taken in _appio_read
+    c[RECV_BYTES] += retval; // read bytes
+    if ((size_t)retval < len) c[RECV_SHORT]++; // read short
+    c[RECV_USEC] += duration;
+  }
+  if (retval < 0) { 
+    c[RECV_ERR]++; // read err
+    if (EINTR == err)
+      c[RECV_INTERRUPTED]++; // signal interrupted the read
+    if (_appio_fast && ((EAGAIN == err) || (EWOULDBLOCK == err)))
+      c[RECV_WOULD_BLOCK]++; //read would block on descriptor marked as non-blocking
+  }
+  if (retval == 0) c[RECV_EOF]++; // read eof
+  appio_hist(c, READ_LAT_BUCKET_0, duration);
+  if (retval >= 0) appio_hist(c, READ_SIZE_BUCKET_0, retval);
+}
+
+/* Same for sendmsg(), which also goes in the write histograms */
+static void appio_count_send(long long *c, ssize_t retval, size_t len, long long duration, int err) {
+  c[SEND_CALLS]++;
+  if (retval > 0) {
+    c[SEND_BLOCK_SIZE] += len; // summed, the mean is taken in _appio_read
+    c[SEND_BYTES] += retval;
+    if ((size_t)retval < len) c[SEND_SHORT]++;
+    c[SEND_USEC] += duration;
+  }
+  if (retval < 0) {
+    c[SEND_ERR]++;
+    if (EINTR == err)
+      c[SEND_INTERRUPTED]++; // signal interrupted the send
+    if (_appio_fast && ((EAGAIN == err) || (EWOULDBLOCK == err)))
+      c[SEND_WOULD_BLOCK]++; // send would block on descriptor marked as non-blocking
+  }
+  appio_hist(c, WRITE_LAT_BUCKET_0, duration);
+  if (retval >= 0) appio_hist(c, WRITE_SIZE_BUCKET_0, retval);
+}
+
+static size_t appio_iov_len(const struct iovec *iov, int iovcnt) {
+  size_t len = 0;
+  int i;
+  for (i = 0; i < iovcnt; i++) len += iov[i].iov_len;
+  return len;
+}
+
 static ssize_t (*__recv)(int sockfd, void *buf, size_t len, int flags) = NULL;
 ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
-  int retval;
+  ssize_t retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted recv(%d,%p,%lu,%d)\n", sockfd, buf, (unsigned long)len, flags);
-  if (!__recv) __recv  = dlsym(RTLD_NEXT, "recv");
-  if (!__recv) {
-    fprintf(stderr, "appio,c Internal Error: Could not obtain handle for real recv\n");
-    exit(1);
+  APPIO_REAL(recv);
+  if (!_appio_fast) {
+    // check if recv would block on descriptor
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(sockfd, &readfds);
+    int ready = __select(sockfd+1, &readfds, NULL, NULL, &zerotv);
+    if (ready == 0) c[RECV_WOULD_BLOCK]++; 
   }
-  // check if recv would block on descriptor
-  fd_set readfds;
-  FD_ZERO(&readfds);
-  FD_SET(sockfd, &readfds);
-  int ready = __select(sockfd+1, &readfds, NULL, NULL, &zerotv);
-  if (ready == 0) _appio_register_current[RECV_WOULD_BLOCK]++; 
-
-  long long start_ts = PAPI_get_real_usec();
+
+  long long start_ts = PAPI_get_real_nsec();
   retval = __recv(sockfd, buf, len, flags);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  int n = _appio_register_current[RECV_CALLS]++; // read calls
-  if (retval > 0) {
-    _appio_register_current[RECV_BLOCK_SIZE]= (n * _appio_register_current[RECV_BLOCK_SIZE] + len)/(n+1); // mean size
-    _appio_register_current[RECV_BYTES] += retval; // read bytes
-    if (retval < (int)len) _appio_register_current[RECV_SHORT]++; // read short
-    _appio_register_current[RECV_USEC] += duration;
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_recv(c, retval, len, duration, err);
+  errno = err;
+  return retval;
+}
+
+static ssize_t (*__recvmsg)(int sockfd, struct msghdr *msg, int flags) = NULL;
+ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted recvmsg(%d,%p,%d)\n", sockfd, msg, flags);
+  APPIO_REAL(recvmsg);
+  size_t len = appio_iov_len(msg->msg_iov, msg->msg_iovlen);
+  if (!_appio_fast) {
+    // check if recvmsg would block on descriptor
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(sockfd, &readfds);
+    int ready = __select(sockfd+1, &readfds, NULL, NULL, &zerotv);
+    if (ready == 0) c[RECV_WOULD_BLOCK]++;
   }
-  if (retval < 0) { 
-    _appio_register_current[RECV_ERR]++; // read err
-    if (EINTR == errno)
-      _appio_register_current[RECV_INTERRUPTED]++; // signal interrupted the read
-    if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) 
-      _appio_register_current[RECV_WOULD_BLOCK]++; //read would block on descriptor marked as non-blocking
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __recvmsg(sockfd, msg, flags);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_recv(c, retval, len, duration, err);
+  errno = err;
+  return retval;
+}
+
+static ssize_t (*__sendmsg)(int sockfd, const struct msghdr *msg, int flags) = NULL;
+ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted sendmsg(%d,%p,%d)\n", sockfd, msg, flags);
+  APPIO_REAL(sendmsg);
+  size_t len = appio_iov_len(msg->msg_iov, msg->msg_iovlen);
+  if (!_appio_fast) {
+    // check if sendmsg would block on descriptor
+    fd_set writefds;
+    FD_ZERO(&writefds);
+    FD_SET(sockfd, &writefds);
+    int ready = __select(sockfd+1, NULL, &writefds, NULL, &zerotv);
+    if (ready == 0) c[SEND_WOULD_BLOCK]++;
+  }
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __sendmsg(sockfd, msg, flags);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_send(c, retval, len, duration, err);
+  errno = err;
+  return retval;
+}
+
+static ssize_t (*__readv)(int fd, const struct iovec *iov, int iovcnt) = NULL;
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted readv(%d,%p,%d)\n", fd, iov, iovcnt);
+  APPIO_REAL(readv);
+  size_t count = appio_iov_len(iov, iovcnt);
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 0);
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __readv(fd, iov, iovcnt);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_read(c, issocket, retval, count, duration, err);
+  errno = err;
+  return retval;
+}
+
+static ssize_t (*__preadv2)(int fd, const struct iovec *iov, int iovcnt, off_t offset, int flags) = NULL;
+ssize_t preadv2(int fd, const struct iovec *iov, int iovcnt, off_t offset, int flags) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted preadv2(%d,%p,%d,%ld,%d)\n", fd, iov, iovcnt, (long)offset, flags);
+  APPIO_REAL(preadv2);
+  size_t count = appio_iov_len(iov, iovcnt);
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 0);
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __preadv2(fd, iov, iovcnt, offset, flags);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_read(c, issocket, retval, count, duration, err);
+  errno = err;
+  return retval;
+}
+
+static ssize_t (*__writev)(int fd, const struct iovec *iov, int iovcnt) = NULL;
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+  ssize_t retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted writev(%d,%p,%d)\n", fd, iov, iovcnt);
+  APPIO_REAL(writev);
+  size_t count = appio_iov_len(iov, iovcnt);
+  int issocket = appio_issocket(fd);
+  if (!_appio_fast) appio_probe_would_block(c, fd, issocket, 1);
+
+  long long start_ts = PAPI_get_real_nsec();
+  retval = __writev(fd, iov, iovcnt);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  appio_count_write(c, issocket, retval, count, duration, err);
+  errno = err;
+  return retval;
+}
+
+#ifdef SYS_io_uring_enter
+/* libc has no io_uring_enter(); this catches programs and liburing
+   versions that call one, and falls back to the raw system call. */
+static int (*__io_uring_enter)(unsigned int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags, sigset_t *sig) = NULL;
+static int _appio_io_uring_looked_up;
+int io_uring_enter(unsigned int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags, sigset_t *sig) {
+  int retval;
+  long long *c = appio_counters();
+  SUBDBG("appio: intercepted io_uring_enter(%u,%u,%u,%u,%p)\n", fd, to_submit, min_complete, flags, sig);
+  if (!_appio_io_uring_looked_up) {
+    __io_uring_enter = dlsym(RTLD_NEXT, "io_uring_enter");
+    _appio_io_uring_looked_up = 1;
   }
-  if (retval == 0) _appio_register_current[RECV_EOF]++; // read eof
+
+  long long start_ts = PAPI_get_real_nsec();
+  if (__io_uring_enter)
+    retval = __io_uring_enter(fd, to_submit, min_complete, flags, sig);
+  else
+    retval = syscall(SYS_io_uring_enter, fd, to_submit, min_complete, flags, sig, _NSIG / 8);
+  int err = errno;
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  c[IO_URING_CALLS]++;
+  c[IO_URING_USEC] += duration;
+  if (retval < 0) c[IO_URING_ERR]++;
+  else c[IO_URING_SUBMITTED] += retval;
+  errno = err;
   return retval;
 }
+#endif /* SYS_io_uring_enter */
 #endif /* PIC */
 
 size_t _IO_fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream);
 size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream) {
   size_t retval;
+  long long *c = appio_counters();
   SUBDBG("appio: intercepted fwrite(%p,%lu,%lu,%p)\n", ptr, (unsigned long) size, (unsigned long) nmemb, (void*) stream);
-  long long start_ts = PAPI_get_real_usec();
+  long long start_ts = PAPI_get_real_nsec();
   retval = _IO_fwrite(ptr,size,nmemb,stream);
-  long long duration = PAPI_get_real_usec() - start_ts;
-  int n = _appio_register_current[WRITE_CALLS]++; // write calls
+  long long duration = PAPI_get_real_nsec() - start_ts;
+  c[WRITE_CALLS]++; // write calls
   if (retval > 0) {
-    _appio_register_current[WRITE_BLOCK_SIZE]= (n * _appio_register_current[WRITE_BLOCK_SIZE] + size*nmemb)/(n+1); // mean block size
-    _appio_register_current[WRITE_BYTES]+= retval * size; // write bytes
-    if (retval < nmemb) _appio_register_current[WRITE_SHORT]++; // short write
-    _appio_register_current[WRITE_USEC] += duration;
+    c[WRITE_BLOCK_SIZE] += size*nmemb; // summed, the mean is taken in _appio_read
+    c[WRITE_BYTES]+= retval * size; // write bytes
+    if (retval < nmemb) c[WRITE_SHORT]++; // short write
+    c[WRITE_USEC] += duration;
   }
-  if (retval == 0) _appio_register_current[WRITE_ERR]++; // err
+  if (retval == 0) c[WRITE_ERR]++; // err
+  appio_hist(c, WRITE_LAT_BUCKET_0, duration);
+  appio_hist(c, WRITE_SIZE_BUCKET_0, retval * size);
   return retval;
 }
 
+#pragma GCC visibility pop
+
+/* Counters as seen by one event set: the calling thread's block, or
+ * the sum over every thread's block and the exited threads for
+ * PAPI_GRN_PROC. Other threads keep counting while this runs, so a
+ * process sum is a snapshot. */
+static void appio_snapshot(int granularity, long long *out) {
+  appio_block_t *b;
+  int i;
+
+  if (granularity != PAPI_GRN_PROC) {
+    memcpy(out, appio_counters(), APPIO_MAX_COUNTERS * sizeof(long long));
+    return;
+  }
+  appio_lock();
+  memcpy(out, _appio_retired.c, APPIO_MAX_COUNTERS * sizeof(long long));
+  for (b = _appio_blocks; b != NULL; b = b->next) {
+    for (i = 0; i < APPIO_MAX_COUNTERS; i++)
+      out[i] += *(volatile long long *)&b->c[i];
+  }
+  appio_unlock();
+}
+
+/* Events that are means; the sums above are divided by the calls */
+static int appio_mean_calls(int index) {
+  switch (index) {
+    case READ_BLOCK_SIZE:      return READ_CALLS;
+    case WRITE_BLOCK_SIZE:     return WRITE_CALLS;
+    case RECV_BLOCK_SIZE:      return RECV_CALLS;
+    case SEND_BLOCK_SIZE:      return SEND_CALLS;
+    case SEEK_ABS_STRIDE_SIZE: return SEEK_CALLS;
+    default:                   return -1;
+  }
+}
+
+/* Times are kept in nanoseconds for the histograms, reported in usec */
+static int appio_is_usec(int index) {
+  switch (index) {
+    case READ_USEC: case WRITE_USEC: case SELECT_USEC: case RECV_USEC:
+    case SEND_USEC:
+    case SOCK_READ_USEC: case SOCK_WRITE_USEC: case SEEK_USEC:
+    case IO_URING_USEC:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
 
 /*********************************************************************
  ***************  BEGIN PAPI's COMPONENT REQUIRED FUNCTIONS  *********
@@ -432,7 +1090,11 @@ _appio_init_component( int cidx  )
 {
     int strErr;
     int retval = PAPI_OK;
+    char *fast;
     SUBDBG("_appio_component %d\n", cidx);
+
+    fast = getenv("PAPI_APPIO_FAST");
+    _appio_fast = (fast != NULL) && (atoi(fast) != 0);
     _appio_native_events = (APPIO_native_event_entry_t *) papi_calloc(APPIO_MAX_COUNTERS, sizeof(APPIO_native_event_entry_t));
 
     if (_appio_native_events == NULL ) {
@@ -443,12 +1105,36 @@ _appio_init_component( int cidx  )
       retval = PAPI_ENOMEM;
       goto fn_fail;
     }
-    int i;
-    for (i=0; i<APPIO_MAX_COUNTERS; i++) {
+    _appio_hist_events = (struct appio_hist_event *) papi_calloc(APPIO_MAX_COUNTERS - APPIO_NUM_SCALARS, sizeof(struct appio_hist_event));
+    if (_appio_hist_events == NULL ) {
+      PAPIERROR( "malloc():Could not get memory for histogram events" );
+      strErr=snprintf(_appio_vector.cmp_info.disabled_reason, PAPI_MAX_STR_LEN, "malloc() failed in %s for %lu bytes.", __func__, (APPIO_MAX_COUNTERS - APPIO_NUM_SCALARS)*sizeof(struct appio_hist_event));
+      _appio_vector.cmp_info.disabled_reason[PAPI_MAX_STR_LEN-1]=0;
+      if (strErr>PAPI_MAX_STR_LEN) HANDLE_STRING_ERROR;
+      retval = PAPI_ENOMEM;
+      goto fn_fail;
+    }
+    int i, k;
+    for (i=0; i<APPIO_NUM_SCALARS; i++) {
       _appio_native_events[i].name = _appio_counter_info[i].name;
       _appio_native_events[i].description = _appio_counter_info[i].description;
       _appio_native_events[i].resources.selector = i + 1;
     }
+    for (i=APPIO_NUM_SCALARS; i<APPIO_MAX_COUNTERS; i++) {
+      struct appio_hist_event *ev = &_appio_hist_events[i - APPIO_NUM_SCALARS];
+      const struct appio_histograms *h = &_appio_hist_info[(i - APPIO_NUM_SCALARS) / APPIO_HIST_BUCKETS];
+      k = (i - APPIO_NUM_SCALARS) % APPIO_HIST_BUCKETS;
+      snprintf(ev->name, sizeof(ev->name), "%s_BUCKET_%d", h->name, k);
+      if (k == 0)
+        snprintf(ev->description, sizeof(ev->description), "Number of %s less than 2 %s", h->calls, h->unit);
+      else if (k == APPIO_HIST_BUCKETS - 1)
+        snprintf(ev->description, sizeof(ev->description), "Number of %s %llu %s or more", h->calls, 1ULL << k, h->unit);
+      else
+        snprintf(ev->description, sizeof(ev->description), "Number of %s %llu to %llu %s", h->calls, 1ULL << k, (2ULL << k) - 1, h->unit);
+      _appio_native_events[i].name = ev->name;
+      _appio_native_events[i].description = ev->description;
+      _appio_native_events[i].resources.selector = i + 1;
+    }
   
     /* Export the total number of events available */
     _appio_vector.cmp_info.num_native_events = APPIO_MAX_COUNTERS;;
@@ -471,7 +1157,8 @@ _appio_init_component( int cidx  )
 static int
 _appio_init_control_state( hwd_control_state_t *ctl )
 {
-    ( void ) ctl;
+    APPIO_control_state_t *appio_ctl = (APPIO_control_state_t *) ctl;
+    appio_ctl->granularity = PAPI_GRN_THR;
 
     return PAPI_OK;
 }
@@ -485,8 +1172,8 @@ _appio_start( hwd_context_t *ctx, hwd_control_state_t *ctl )
     SUBDBG("_appio_start %p %p\n", ctx, ctl);
     APPIO_control_state_t *appio_ctl = (APPIO_control_state_t *) ctl;
 
-    /* this memset needs to move to thread_init */
-    memset(_appio_register_current, 0, APPIO_MAX_COUNTERS * sizeof(_appio_register_current[0]));
+    /* counters keep running, remember where they were */
+    appio_snapshot(appio_ctl->granularity, appio_ctl->start);
 
     /* set initial values to 0 */
     memset(appio_ctl->values, 0, APPIO_MAX_COUNTERS*sizeof(appio_ctl->values[0]));
@@ -504,12 +1191,24 @@ _appio_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
 
     SUBDBG("_appio_read %p %p\n", ctx, ctl);
     APPIO_control_state_t *appio_ctl = (APPIO_control_state_t *) ctl;
-    int i;
+    long long now[APPIO_MAX_COUNTERS];
+    int i, calls;
+
+    appio_snapshot(appio_ctl->granularity, now);
 
     for ( i=0; i<appio_ctl->num_events; i++ ) {
             int index = appio_ctl->counter_bits[i];
-            SUBDBG("event=%d, index=%d, val=%lld\n", i, index, _appio_register_current[index]);
-            appio_ctl->values[index] = _appio_register_current[index];
+            long long value = now[index] - appio_ctl->start[index];
+            calls = appio_mean_calls(index);
+            if (calls >= 0) {
+                long long n = now[calls] - appio_ctl->start[calls];
+                value = (n > 0) ? value / n : 0;
+            }
+            else if (appio_is_usec(index)) value /= 1000;
+            /* descriptors closed that were opened before the start */
+            if (index == OPEN_FDS && value < 0) value = 0;
+            SUBDBG("event=%d, index=%d, val=%lld\n", i, index, value);
+            appio_ctl->values[index] = value;
     }
     *events = appio_ctl->values;
 
@@ -521,15 +1220,10 @@ static int
 _appio_stop( hwd_context_t *ctx, hwd_control_state_t *ctl )
 {
     (void) ctx;
+    (void) ctl;
 
+    /* the framework reads the final values before stopping */
     SUBDBG("_appio_stop ctx=%p ctl=%p\n", ctx, ctl);
-    APPIO_control_state_t *appio_ctl = (APPIO_control_state_t *) ctl;
-    int i;
-    for ( i=0; i<appio_ctl->num_events; i++ ) {
-            int index = appio_ctl->counter_bits[i];
-            SUBDBG("event=%d, index=%d, val=%lld\n", i, index, _appio_register_current[index]);
-            appio_ctl->values[i] = _appio_register_current[index];
-    }
 
     return PAPI_OK;
 }
@@ -553,7 +1247,24 @@ _appio_shutdown_thread( hwd_context_t *ctx )
 static int
 _appio_shutdown_component( void )
 {
+    appio_block_t *b;
+
+    appio_lock();
+    /* no more thread exit destructors for the blocks freed below */
+    if (_appio_key_ok && pthread_key_delete) {
+        pthread_key_delete(_appio_key);
+        _appio_key_ok = 0;
+    }
+    while ((b = _appio_blocks) != NULL) {
+        _appio_blocks = b->next;
+        free(b);
+    }
+    memset(&_appio_retired, 0, sizeof(_appio_retired));
+    _appio_generation++;
+    appio_unlock();
+
     papi_free( _appio_native_events );
+    papi_free( _appio_hist_events );
     return PAPI_OK;
 }
 
@@ -567,8 +1278,14 @@ static int
 _appio_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 {
     ( void ) ctx;
-    ( void ) code;
-    ( void ) option;
+
+    /* PAPI_GRN_THR counts the I/O of the thread reading the event set,
+     * PAPI_GRN_PROC the I/O of all threads of the process */
+    if ( code == PAPI_GRANUL ) {
+        APPIO_control_state_t *appio_ctl =
+            (APPIO_control_state_t *) option->granularity.ESI->ctl_state;
+        appio_ctl->granularity = option->granularity.granularity;
+    }
 
     return PAPI_OK;
 }
@@ -627,7 +1344,9 @@ static int
 _appio_reset( hwd_context_t *ctx, hwd_control_state_t *ctl )
 {
     ( void ) ctx;
-    ( void ) ctl;
+
+    APPIO_control_state_t *appio_ctl = (APPIO_control_state_t *) ctl;
+    appio_snapshot(appio_ctl->granularity, appio_ctl->start);
 
     return PAPI_OK;
 }
@@ -674,7 +1393,7 @@ _appio_ntv_name_to_code( const char *name, unsigned int *EventCode )
     int i;
 
     for ( i=0; i<APPIO_MAX_COUNTERS; i++) {
-        if (strcmp(name, _appio_counter_info[i].name) == 0) {
+        if (strcmp(name, _appio_native_events[i].name) == 0) {
             *EventCode = i;
             return PAPI_OK;
         }
@@ -693,7 +1412,7 @@ _appio_ntv_code_to_name( unsigned int EventCode, char *name, int len )
     int index = EventCode;
 
     if ( index >= 0 && index < APPIO_MAX_COUNTERS ) {
-        strncpy( name, _appio_counter_info[index].name, len );
+        strncpy( name, _appio_native_events[index].name, len );
         return PAPI_OK;
     }
 
@@ -710,7 +1429,7 @@ _appio_ntv_code_to_descr( unsigned int EventCode, char *desc, int len )
     int index = EventCode;
 
     if ( index >= 0 && index < APPIO_MAX_COUNTERS ) {
-        strncpy(desc, _appio_counter_info[index].description, len );
+        strncpy(desc, _appio_native_events[index].description, len );
         return PAPI_OK;
     }
 
@@ -752,7 +1471,7 @@ papi_vector_t _appio_vector = {
         .default_domain        = PAPI_DOM_USER,
         .available_domains   = PAPI_DOM_USER,
         .default_granularity   = PAPI_GRN_THR,
-        .available_granularities = PAPI_GRN_THR,
+        .available_granularities = PAPI_GRN_THR | PAPI_GRN_PROC,
         .hardware_intr_sig     = PAPI_INT_SIGNAL,
 
         /* component specific cmp_info initializations */
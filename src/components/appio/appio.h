@@ -29,7 +29,17 @@
 /*************************  DEFINES SECTION  ***********************************/
 
 /* Set this equal to the number of elements in _appio_counter_info array */
-#define APPIO_MAX_COUNTERS 45
+#define APPIO_NUM_SCALARS 57
+
+/* Buckets of each log2 latency and size histogram; bucket k counts
+   calls in [2^k, 2^(k+1)) ns or bytes */
+#define APPIO_HIST_BUCKETS 32
+
+/* Scalar counters plus read/write latency/size histograms */
+#define APPIO_MAX_COUNTERS (APPIO_NUM_SCALARS + 4 * APPIO_HIST_BUCKETS)
+
+/* Descriptors below this have their socket-ness cached in fast mode */
+#define APPIO_FD_CACHE_SIZE 4096
 
 /** Structure that stores private information of each event */
 typedef struct APPIO_register
@@ -65,7 +75,9 @@ typedef struct APPIO_reg_alloc
 typedef struct APPIO_control_state
 {
     int num_events;
+    int granularity;                      // PAPI_GRN_THR or PAPI_GRN_PROC
     int counter_bits[APPIO_MAX_COUNTERS];
+    long long start[APPIO_MAX_COUNTERS];  // counters at start/reset
     long long values[APPIO_MAX_COUNTERS]; // used for caching
 } APPIO_control_state_t;
 
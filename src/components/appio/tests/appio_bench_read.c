@@ -0,0 +1,115 @@
+/* 
+ * Benchmark for appio
+ *
+ * Description: Reads /dev/zero in small blocks, once with the raw
+ *              system call (bypassing appio) and once through the
+ *              intercepted read(), and prints the throughput and the
+ *              cost per call of each.  Run it with and without
+ *              PAPI_APPIO_FAST=1 in the environment to compare the
+ *              default and the fast mode of the component.
+ *
+ *              usage: appio_bench_read [block size] [calls]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#define BLOCK_SIZE 64
+#define NUM_CALLS  1000000
+
+static char buf[1<<20];
+
+static void report(const char *what, long long nsec, long calls, size_t block) {
+  double mb = (double)calls * block / (1024.0*1024.0);
+  printf("%-12s %10.1f ns/call %10.1f MB/s\n", what,
+         (double)nsec / calls, mb / ((double)nsec / 1e9));
+}
+
+int main(int argc, char** argv) {
+  int EventSet = PAPI_NULL;
+  long long values[1];
+  long long start, raw, appio;
+  size_t block = BLOCK_SIZE;
+  long calls = NUM_CALLS, i;
+  int retval, fd;
+  char *fast;
+
+  /* Set TESTS_QUIET variable */
+  tests_quiet( argc, argv );
+
+  if (argc > 1 && atol(argv[1]) > 0) block = atol(argv[1]);
+  if (argc > 2 && atol(argv[2]) > 0) calls = atol(argv[2]);
+  if (block > sizeof(buf)) block = sizeof(buf);
+
+  retval = PAPI_library_init (PAPI_VER_CURRENT);
+  if (retval != PAPI_VER_CURRENT) {
+    test_fail(__FILE__, __LINE__, "PAPI_library_init", retval);
+  }
+
+  retval = PAPI_create_eventset(&EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_create_eventset", retval);
+  }
+  retval = PAPI_add_named_event(EventSet, "appio:::READ_CALLS");
+  if (retval != PAPI_OK) {
+    test_skip(__FILE__, __LINE__, "appio:::READ_CALLS", retval);
+  }
+
+  fd = open("/dev/zero", O_RDONLY);
+  if (fd < 0) {
+    test_fail(__FILE__, __LINE__, "open(/dev/zero)", 0);
+  }
+
+  retval = PAPI_start(EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_start", retval);
+  }
+
+  /* warm up, and fill the descriptor cache in fast mode */
+  for (i = 0; i < calls / 10; i++) {
+    syscall(SYS_read, fd, buf, block);
+    read(fd, buf, block);
+  }
+
+  start = PAPI_get_real_nsec();
+  for (i = 0; i < calls; i++) {
+    if (syscall(SYS_read, fd, buf, block) < 0) break;
+  }
+  raw = PAPI_get_real_nsec() - start;
+
+  start = PAPI_get_real_nsec();
+  for (i = 0; i < calls; i++) {
+    if (read(fd, buf, block) < 0) break;
+  }
+  appio = PAPI_get_real_nsec() - start;
+
+  retval = PAPI_stop(EventSet, values);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_stop", retval);
+  }
+  close(fd);
+
+  if (!TESTS_QUIET) {
+    fast = getenv("PAPI_APPIO_FAST");
+    printf("read(2) of %lu bytes from /dev/zero, %ld calls, %s mode\n",
+           (unsigned long)block, calls,
+           (fast && atoi(fast)) ? "fast" : "default");
+    report("raw", raw, calls, block);
+    report("appio", appio, calls, block);
+    printf("%-12s %10.1f ns/call\n", "overhead",
+           (double)(appio - raw) / calls);
+  }
+
+  /* every intercepted read, including the warm up, was counted */
+  if (values[0] != calls + calls / 10) {
+    test_fail(__FILE__, __LINE__, "READ_CALLS does not match", 0);
+  }
+
+  test_pass( __FILE__ );
+  return 0;
+}
@@ -0,0 +1,127 @@
+/* 
+ * Test case for appio
+ *
+ * Description: Worker threads read /dev/zero while the main thread
+ *              counts READ_CALLS with PAPI_GRN_PROC.  The process count
+ *              must include the reads of every worker, while each
+ *              worker counting with the default PAPI_GRN_THR sees only
+ *              its own reads.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#define NUM_WORKERS 4
+#define NUM_READS   1000
+
+static void *worker(void *arg) {
+  int EventSet = PAPI_NULL;
+  long long values[1];
+  char buf[64];
+  int i, fd;
+
+  (void) arg;
+
+  if (PAPI_create_eventset(&EventSet) != PAPI_OK ||
+      PAPI_add_named_event(EventSet, "appio:::READ_CALLS") != PAPI_OK ||
+      PAPI_start(EventSet) != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "worker event set", 0);
+  }
+
+  fd = open("/dev/zero", O_RDONLY);
+  if (fd < 0) test_fail(__FILE__, __LINE__, "open(/dev/zero)", 0);
+  for (i = 0; i < NUM_READS; i++) read(fd, buf, sizeof(buf));
+  close(fd);
+
+  if (PAPI_stop(EventSet, values) != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_stop", 0);
+  }
+  if (values[0] != NUM_READS) {
+    test_fail(__FILE__, __LINE__, "thread READ_CALLS", 0);
+  }
+  PAPI_cleanup_eventset(EventSet);
+  PAPI_destroy_eventset(&EventSet);
+  PAPI_unregister_thread();
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  int EventSet = PAPI_NULL;
+  long long values[1];
+  pthread_t threads[NUM_WORKERS];
+  PAPI_option_t opt;
+  int retval, i, cidx;
+
+  /* Set TESTS_QUIET variable */
+  tests_quiet( argc, argv );
+
+  retval = PAPI_library_init (PAPI_VER_CURRENT);
+  if (retval != PAPI_VER_CURRENT) {
+    test_fail(__FILE__, __LINE__, "PAPI_library_init", retval);
+  }
+  retval = PAPI_thread_init(pthread_self);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_thread_init", retval);
+  }
+
+  cidx = PAPI_get_component_index("appio");
+  if (cidx < 0) {
+    test_skip(__FILE__, __LINE__, "appio component not found", 0);
+  }
+
+  retval = PAPI_create_eventset(&EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_create_eventset", retval);
+  }
+  retval = PAPI_assign_eventset_component(EventSet, cidx);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_assign_eventset_component", retval);
+  }
+
+  memset(&opt, 0, sizeof(opt));
+  opt.granularity.eventset = EventSet;
+  opt.granularity.granularity = PAPI_GRN_PROC;
+  retval = PAPI_set_opt(PAPI_GRANUL, &opt);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_set_opt(PAPI_GRANUL)", retval);
+  }
+
+  retval = PAPI_add_named_event(EventSet, "appio:::READ_CALLS");
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "appio:::READ_CALLS", retval);
+  }
+
+  retval = PAPI_start(EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_start", retval);
+  }
+
+  for (i = 0; i < NUM_WORKERS; i++) {
+    if (pthread_create(&threads[i], NULL, worker, NULL) != 0) {
+      test_fail(__FILE__, __LINE__, "pthread_create", 0);
+    }
+  }
+  for (i = 0; i < NUM_WORKERS; i++) pthread_join(threads[i], NULL);
+
+  retval = PAPI_stop(EventSet, values);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_stop", retval);
+  }
+
+  if (!TESTS_QUIET) {
+    printf("READ_CALLS of the process: %lld (%d threads x %d reads)\n",
+           values[0], NUM_WORKERS, NUM_READS);
+  }
+  if (values[0] < NUM_WORKERS * NUM_READS) {
+    test_fail(__FILE__, __LINE__, "process READ_CALLS too low", 0);
+  }
+
+  test_pass( __FILE__ );
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* 
+ * Test case for appio
+ *
+ * Description: pwrite()s and pread()s a temporary file in fixed size
+ *              blocks and checks that the READ/WRITE latency and size
+ *              histograms account for every call, with the sizes in
+ *              the expected log2 bucket.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#define NUM_CALLS   64
+#define BLOCK_SIZE  4096   /* log2 bucket 12 */
+#define HIST_EVENTS 32
+
+static const char *hists[4] = { "READ_LAT", "READ_SIZE", "WRITE_LAT", "WRITE_SIZE" };
+
+int main(int argc, char** argv) {
+  int EventSet = PAPI_NULL;
+  long long values[2 + 4 * HIST_EVENTS], sum[4];
+  char name[PAPI_MAX_STR_LEN], tmpl[] = "/tmp/appio_histXXXXXX";
+  static char buf[BLOCK_SIZE];
+  int retval, fd, i, h, n = 0;
+
+  /* Set TESTS_QUIET variable */
+  tests_quiet( argc, argv );
+
+  retval = PAPI_library_init (PAPI_VER_CURRENT);
+  if (retval != PAPI_VER_CURRENT) {
+    test_fail(__FILE__, __LINE__, "PAPI_library_init", retval);
+  }
+  retval = PAPI_create_eventset(&EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_create_eventset", retval);
+  }
+
+  if (PAPI_add_named_event(EventSet, "appio:::READ_CALLS") != PAPI_OK ||
+      PAPI_add_named_event(EventSet, "appio:::WRITE_CALLS") != PAPI_OK) {
+    test_skip(__FILE__, __LINE__, "appio:::READ_CALLS", 0);
+  }
+  for (h = 0; h < 4; h++) {
+    for (i = 0; i < HIST_EVENTS; i++) {
+      snprintf(name, sizeof(name), "appio:::%s_BUCKET_%d", hists[h], i);
+      retval = PAPI_add_named_event(EventSet, name);
+      if (retval != PAPI_OK) {
+        test_fail(__FILE__, __LINE__, name, retval);
+      }
+    }
+  }
+
+  fd = mkstemp(tmpl);
+  if (fd < 0) {
+    test_fail(__FILE__, __LINE__, "mkstemp", 0);
+  }
+  unlink(tmpl);
+
+  retval = PAPI_start(EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_start", retval);
+  }
+
+  memset(buf, 'a', sizeof(buf));
+  for (i = 0; i < NUM_CALLS; i++) {
+    if (pwrite(fd, buf, BLOCK_SIZE, (off_t)i * BLOCK_SIZE) != BLOCK_SIZE) {
+      test_fail(__FILE__, __LINE__, "pwrite", 0);
+    }
+  }
+  for (i = 0; i < NUM_CALLS; i++) {
+    if (pread(fd, buf, BLOCK_SIZE, (off_t)i * BLOCK_SIZE) != BLOCK_SIZE) {
+      test_fail(__FILE__, __LINE__, "pread", 0);
+    }
+  }
+
+  retval = PAPI_stop(EventSet, values);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_stop", retval);
+  }
+  close(fd);
+
+  for (h = 0; h < 4; h++) {
+    sum[h] = 0;
+    for (i = 0; i < HIST_EVENTS; i++) {
+      long long v = values[2 + h * HIST_EVENTS + i];
+      if (v && !TESTS_QUIET) printf("%s_BUCKET_%d: %lld\n", hists[h], i, v);
+      sum[h] += v;
+    }
+  }
+  if (!TESTS_QUIET) {
+    printf("READ_CALLS: %lld WRITE_CALLS: %lld\n", values[0], values[1]);
+  }
+
+  if (values[0] != NUM_CALLS || values[1] != NUM_CALLS) n++;
+  if (sum[0] != values[0] || sum[1] != values[0]) n++;
+  if (sum[2] != values[1] || sum[3] != values[1]) n++;
+  if (values[2 + 1 * HIST_EVENTS + 12] != NUM_CALLS) n++;
+  if (values[2 + 3 * HIST_EVENTS + 12] != NUM_CALLS) n++;
+  if (n) {
+    test_fail(__FILE__, __LINE__, "histograms do not match the calls", n);
+  }
+
+  test_pass( __FILE__ );
+  return 0;
+}
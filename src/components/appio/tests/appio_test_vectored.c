@@ -0,0 +1,100 @@
+/* 
+ * Test case for appio
+ *
+ * Description: Exercises the vectored and message calls, which appio
+ *              can only intercept when PAPI is a shared library:
+ *              writev()/readv()/preadv2() on a temporary file and
+ *              sendmsg()/recvmsg() on a socket pair.
+ */
+#define _GNU_SOURCE  /* preadv2() */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#define NUM_EVENTS 5
+#define NUM_CALLS  16
+
+int main(int argc, char** argv) {
+  const char* names[NUM_EVENTS] = {"appio:::READ_CALLS", "appio:::WRITE_CALLS",
+      "appio:::RECV_CALLS", "appio:::SEND_CALLS", "appio:::READ_BYTES"};
+  long long values[NUM_EVENTS];
+  int EventSet = PAPI_NULL;
+  char tmpl[] = "/tmp/appio_vecXXXXXX";
+  char a[100], b[28];
+  struct iovec iov[2] = { { a, sizeof(a) }, { b, sizeof(b) } };
+  struct msghdr msg;
+  int retval, fd, sv[2], i;
+
+  /* Set TESTS_QUIET variable */
+  tests_quiet( argc, argv );
+
+  retval = PAPI_library_init (PAPI_VER_CURRENT);
+  if (retval != PAPI_VER_CURRENT) {
+    test_fail(__FILE__, __LINE__, "PAPI_library_init", retval);
+  }
+  retval = PAPI_create_eventset(&EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_create_eventset", retval);
+  }
+  for (i = 0; i < NUM_EVENTS; i++) {
+    retval = PAPI_add_named_event(EventSet, names[i]);
+    if (retval != PAPI_OK) {
+      test_skip(__FILE__, __LINE__, names[i], retval);
+    }
+  }
+
+  fd = mkstemp(tmpl);
+  if (fd < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+    test_fail(__FILE__, __LINE__, "mkstemp/socketpair", 0);
+  }
+  unlink(tmpl);
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+
+  retval = PAPI_start(EventSet);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_start", retval);
+  }
+
+  for (i = 0; i < NUM_CALLS; i++) {
+    writev(fd, iov, 2);
+    sendmsg(sv[0], &msg, 0);
+    recvmsg(sv[1], &msg, 0);
+  }
+  for (i = 0; i < NUM_CALLS; i++) {
+    preadv2(fd, iov, 2, (off_t)i * 128, 0);
+  }
+  lseek(fd, 0, SEEK_SET);
+  for (i = 0; i < NUM_CALLS; i++) {
+    readv(fd, iov, 2);
+  }
+
+  retval = PAPI_stop(EventSet, values);
+  if (retval != PAPI_OK) {
+    test_fail(__FILE__, __LINE__, "PAPI_stop", retval);
+  }
+  close(fd);
+  close(sv[0]);
+  close(sv[1]);
+
+  if (!TESTS_QUIET) {
+    for (i = 0; i < NUM_EVENTS; i++) printf("%s: %lld\n", names[i], values[i]);
+  }
+
+  if (values[0] != 2 * NUM_CALLS || values[1] != NUM_CALLS ||
+      values[2] != NUM_CALLS || values[3] != NUM_CALLS ||
+      values[4] != 2 * NUM_CALLS * 128) {
+    test_fail(__FILE__, __LINE__, "calls not counted", 0);
+  }
+
+  test_pass( __FILE__ );
+  return 0;
+}
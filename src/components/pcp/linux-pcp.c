@@ -134,6 +134,12 @@ typedef struct _pcp_reg_alloc
 // lockstep; to be NULL together or [maxAllocated] together. We cannot create a
 // structure to make that automatic; we need to point to an array of long long
 // values alone after a read.
+//
+// The fetch plan is built when the event set changes, so a read is a single
+// pmFetch of the unique PMIDs and one pass to scatter the results: for each
+// event, fetchSlot[] is its pmResult vset[] and fetchInst[] its vlist[] index.
+// fetchPMID[] has room for maxAllocated, fetchSlot[] and fetchInst[] grow in
+// lockstep with pcpIndex[].
 //-----------------------------------------------------------------------------
 
 typedef struct _pcp_control_state  
@@ -142,6 +148,10 @@ typedef struct _pcp_control_state
    int maxAllocated;                               // The most ever allocated.
    int *pcpIndex;                                  // array of indices into pcp_event_info[].
    unsigned long long *pcpValue;                   // corresponding value read.
+   int numPMID;                                    // number of unique PMIDs in fetchPMID[].
+   pmID *fetchPMID;                                // unique PMIDs, passed to pmFetch as is.
+   int *fetchSlot;                                 // for each event, index into pmResult vset[].
+   int *fetchInst;                                 // for each event, index into that vset's vlist[].
 } _pcp_control_state_t;
 
 
@@ -1315,12 +1325,19 @@ static int _pcp_update_control_state(
    _pcp_control_state_t* MyCtl = ( _pcp_control_state_t* ) ctl;         // Recast ctl.
 
    MyCtl->numEvents = count;                                            // remember how many there are.
+   MyCtl->numPMID = 0;                                                  // fetch plan is rebuilt below.
    if (count == 0) {                                                    // If we are deleting a set,
       if (MyCtl->pcpIndex != NULL) {                                    // If we have space allocated,
          free(MyCtl->pcpIndex);                                         // .. discard it,
-         free(MyCtl->pcpValue);                                         // .. and values.
+         free(MyCtl->pcpValue);                                         // .. and values,
+         free(MyCtl->fetchPMID);                                        // .. and the fetch plan.
+         free(MyCtl->fetchSlot);                                        // ..
+         free(MyCtl->fetchInst);                                        // ..
          MyCtl->pcpIndex = NULL;                                        // .. never free it again.
          MyCtl->pcpValue = NULL;                                        // .. never free it again.
+         MyCtl->fetchPMID = NULL;                                       // ..
+         MyCtl->fetchSlot = NULL;                                       // ..
+         MyCtl->fetchInst = NULL;                                       // ..
       }
 
       MyCtl->maxAllocated = 0;                                          // .. no longer tracking max.
@@ -1338,6 +1355,12 @@ static int _pcp_update_control_state(
                                    newalloc*sizeof(int));               // .. .. ..
          MyCtl->pcpValue = realloc(MyCtl->pcpValue,                     // .. .. reallocate to make more room.
                                    newalloc*sizeof(unsigned long long));// .. .. ..
+         MyCtl->fetchPMID = realloc(MyCtl->fetchPMID,                   // .. .. and the fetch plan.
+                                   newalloc*sizeof(pmID));              // .. .. ..
+         MyCtl->fetchSlot = realloc(MyCtl->fetchSlot,                   // .. .. ..
+                                   newalloc*sizeof(int));               // .. .. ..
+         MyCtl->fetchInst = realloc(MyCtl->fetchInst,                   // .. .. ..
+                                   newalloc*sizeof(int));               // .. .. ..
          MyCtl->maxAllocated = newalloc;                                // .. .. remember what we've got.
       }
    } else {                                                             // If NULL then I have no previous set,
@@ -1346,9 +1369,18 @@ static int _pcp_update_control_state(
          calloc(MyCtl->maxAllocated, sizeof(int));                      // .. 
       MyCtl->pcpValue =                                                 // .. make room for 'count' values.
          calloc(MyCtl->maxAllocated, sizeof(unsigned long long));       // .. 
+      MyCtl->fetchPMID =                                                // .. and the fetch plan.
+         calloc(MyCtl->maxAllocated, sizeof(pmID));                     // .. 
+      MyCtl->fetchSlot =                                                // .. 
+         calloc(MyCtl->maxAllocated, sizeof(int));                      // .. 
+      MyCtl->fetchInst =                                                // .. 
+         calloc(MyCtl->maxAllocated, sizeof(int));                      // .. 
    }
 
-   if (MyCtl->pcpIndex == NULL) {                                       // If malloc failed,
+   if (MyCtl->pcpIndex == NULL || MyCtl->pcpValue == NULL ||            // If malloc failed,
+       MyCtl->fetchPMID == NULL || MyCtl->fetchSlot == NULL ||          // ..
+       MyCtl->fetchInst == NULL) {                                      // ..
+      MyCtl->numEvents = 0;                                             // .. nothing can be read,
       return PAPI_ENOMEM;                                               // .. out of memory.
    } // end if malloc failed.
 
@@ -1371,6 +1403,33 @@ static int _pcp_update_control_state(
       getPMDesc(index);                                                 // Any time an event is added, ensure we have its variable descriptor.
    } // end for each event listed.
 
+   //------------------------------------------------------------------
+   // Build the fetch plan. Because PMID can return an array of N
+   // values for a single event (e.g. one per CPU), we 'explode' such
+   // events into N events for PAPI, which can only return 1 value per
+   // event. Thus PAPI could add several to an EventSet that all have
+   // the same PMID (PCP's ID). We fetch each PMID once; the results
+   // come back in the order of fetchPMID[], so the slot of an event is
+   // the position of its PMID there, and its instance is the index
+   // pcp_event_info[] holds into the array returned for that PMID.
+   // This is the only place we search; a read just scatters.
+   //------------------------------------------------------------------
+
+   for (i=0; i<count; i++) {                                            // For every event in the event set,
+      int j;
+      pmID myPMID = pcp_event_info[MyCtl->pcpIndex[i]].pmid;            // .. get the PMID for that event,
+      for (j=0; j<MyCtl->numPMID; j++) {                                // .. Search the unique PMID list for a match.
+         if (myPMID == MyCtl->fetchPMID[j]) break;                      // .. .. found it. break out.
+      }
+
+      if (j == MyCtl->numPMID) {                                        // full loop ==> myPMID was not found in list,
+         MyCtl->fetchPMID[MyCtl->numPMID++] = myPMID;                   // .. store the unique pmid in list, inc count.
+      }
+
+      MyCtl->fetchSlot[i] = j;                                          // .. its vset[] in the pmResult,
+      MyCtl->fetchInst[i] = pcp_event_info[MyCtl->pcpIndex[i]].idx;     // .. and its value within that vset.
+   } // end for each event, plan done.
+
    return PAPI_OK;
 } // end routine.
 
@@ -1392,73 +1451,33 @@ static int _pcp_update_control_state(
 static int PCP_ReadList(hwd_control_state_t *ctl,                       // the event set.
     pmResult **results)                                                 // results from pmFetch, caller must pmFreeResult(results).
 {
-   int i, j, ret;
+   int i, ret;
     _pcp_control_state_t* myCtl = ( _pcp_control_state_t* ) ctl;
    *results = NULL;                                                     // Nothing allocated.
    if (myCtl->numEvents < 1) return PAPI_ENOEVNT;                       // No events to start.
-   int nPMID = 0;                                                       // To count number of **unique** PMIDs.
-
-   pmID *allPMID=malloc((myCtl->numEvents)*sizeof(pmID));               // Make maximum possible room.
 
-   // We build a list of all *unique* PMIDs. Because PMID can return
-   // an array of N values for a single event (e.g. one per CPU), we
-   // 'explode' such events into N events for PAPI, which can only
-   // return 1 value per event. Thus PAPI could add several to an
-   // EventSet that all have the same PMID (PCP's ID). We only need
-   // to read those once, our pcp_event_info[] contains the index
-   // for each exploded event into the array returned for that PMID.
-
-   allPMID[nPMID++] = pcp_event_info[myCtl->pcpIndex[0]].pmid;          // Move the first, increment total so far. 
-
-   for (i=1; i<myCtl->numEvents; i++) {                                 // For every event in the event set,
-      int myIdx = myCtl->pcpIndex[i];                                   // .. Get pcp_event_info[] index of the event,
-      pmID myPMID = pcp_event_info[myIdx].pmid;                         // .. get the PMID for that event,
-      for (j=0; j<nPMID; j++) {                                         // .. Search the unique PMID list for a match. 
-         if (myPMID == allPMID[j]) break;                               // .. .. found it. break out.
-      } 
+   // The unique PMIDs, and where each event finds its value in the
+   // result, were worked out by _pcp_update_control_state().
 
-      if (j == nPMID) {                                                 // full loop ==> myPMID was not found in list,
-         allPMID[nPMID++] = myPMID;                                     // .. store the unique pmid in list, inc count.
-      }
-   }                                                                    // done building list of unique pmid.
-   
-   // nPMID is # of unique PMID, now ready to read all the pmid needed.
    pmResult *allFetch = NULL;                                           // result of pmFetch. 
-   ret = pcp_pmFetch(nPMID, allPMID, &allFetch);                        // Fetch them all.
+   ret = pcp_pmFetch(myCtl->numPMID, myCtl->fetchPMID, &allFetch);      // Fetch them all.
    *results = allFetch;                                                 // For either success or failure.
    
    if( ret != PAPI_OK) {                                                // If fetch failed .. 
       fprintf(stderr, "%s:%i:%s pcp_pmFetch failed, return=%s.\n", 
          __FILE__, __LINE__, FUNC, PAPI_strerror(ret));                 // .. report error.
-         if (allPMID != NULL)  free(allPMID);                           // .. no memory leak.
-         allPMID = NULL;                                                // .. prevent future use.
       return(ret);                                                      // .. exit with that error.
    }
 
-   // For each unique PMID we just read, we must map it to the event
-   // sets, which may contain multiple entries with that same PMID.
-   // This is because PCP returns arrays, and PAPI does not, so each
-   // of our names translates to a PMID + an index.
+   // Scatter the results to the events; several events may share a
+   // PMID, since PCP returns arrays and PAPI does not, so each of our
+   // names translates to a PMID + an index.
+
+   for (i=0; i<myCtl->numEvents; i++) {                                 // for each event,
+      pmValueSet *vset = allFetch->vset[myCtl->fetchSlot[i]];           // .. get the result for its PMID,
+      myCtl->pcpValue[i] = getULLValue(vset, myCtl->fetchInst[i]);      // .. translate as needed, put back into pcpValue array.
+   } // end loop through all events in this event set.
 
-   for (i=0; i<nPMID; i++) {                                            // process all the fetch results.
-      pmValueSet *vset = allFetch->vset[i];                             // get the result for event[i].
-      pmID myPMID = allPMID[i];                                         // get the pmid from this read.
-       
-      // Now we must search for any events with this pmid, and get
-      // the corresponding value (may be more than one, since we
-      // treat each idx as its own value).         
-
-      for (j=0; j<myCtl->numEvents; j++) {                              // for each event,
-         int myPCPIdx = myCtl->pcpIndex[j];                             // .. get my pcp_event_info[] index.
-         pmID thisPMID = pcp_event_info[myPCPIdx].pmid;                 // .. collect its pmid.
-         if (thisPMID == myPMID) {                                      // .. If this result services that event, 
-            int myArrayIdx = pcp_event_info[myPCPIdx].idx;              // .. .. get array index within result array, for result value list.
-            myCtl->pcpValue[j] = getULLValue(vset, myArrayIdx);         // .. .. translate as needed, put back into pcpValue array.
-         } // end if counter was found for this PMID.
-      } // end loop through all events in this event set.
-   } // end for each pmID read.
-
-   if (allPMID != NULL)  free(allPMID);                                 // Done with this work area; no memory leak.
    return PAPI_OK;                                                      // All done.
 } // end routine.
 
@@ -0,0 +1,465 @@
+/*
+* File:    pe_vector.c
+*
+* Replicate one event list on a set of cpus (PAPI_CPU_VECTOR), or on
+* every instance and socket of an uncore PMU (PAPI_UNCORE_AGGREGATE).
+*
+* Every cpu gets its own group: the first event is the leader and the
+* rest are opened disabled=0 against it, all with PERF_FORMAT_GROUP.
+* A row is then read with a single read() of its leader, and the whole
+* vector with one read() per cpu.  With many cpus these reads can be
+* spread over a small pool of persistent reader threads; the calling
+* thread always takes its share so num_threads=0 works without pthreads.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <syscall.h>
+#include <sys/ioctl.h>
+
+#include "papi.h"
+#include "papi_memory.h"
+#include "papi_internal.h"
+
+#include PEINCLUDE
+
+#include "perf_event_lib.h"
+#include "pe_vector.h"
+
+/* values in a group read: nr followed by one count per event */
+#define VEC_READ_SIZE (1 + PERF_EVENT_MAX_MPX_COUNTERS)
+
+#define VEC_OP_READ   0
+#define VEC_OP_IOCTL  1
+
+struct pe_vector_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t go;
+	pthread_cond_t done;
+	unsigned long generation;       /* bumped for every dispatched op */
+	int op;                         /* VEC_OP_*                       */
+	unsigned long request;          /* ioctl request for VEC_OP_IOCTL */
+	int pending;                    /* workers still busy             */
+	int error;                      /* first error of this op         */
+	int quit;
+	int num_threads;
+	pe_vector_t *vec;
+	pthread_t *threads;
+};
+
+typedef struct {
+	struct pe_vector_pool *pool;
+	int part;
+} vec_worker_arg_t;
+
+static int
+vec_read_row( pe_vector_t *vec, int row )
+{
+	long long buffer[VEC_READ_SIZE];
+	long long *counts = vec->counts + ( size_t ) row * vec->num_events;
+	int i, ret;
+
+	ret = read( vec->fd[( size_t ) row * vec->num_events],
+		    buffer, sizeof ( buffer ) );
+	if ( ret == -1 ) {
+		PAPIERROR( "read of cpu %d returned an error: %s",
+			   vec->cpu[row], strerror( errno ) );
+		return PAPI_ESYS;
+	}
+	if ( ret < ( signed ) ( ( 1 + vec->num_events ) * sizeof ( long long ) ) ||
+	     buffer[0] != vec->num_events ) {
+		PAPIERROR( "Error! short read on cpu %d", vec->cpu[row] );
+		return PAPI_ESYS;
+	}
+
+	for ( i = 0; i < vec->num_events; i++ ) {
+		counts[i] = buffer[1 + i];
+	}
+	return PAPI_OK;
+}
+
+static int
+vec_ioctl_row( pe_vector_t *vec, int row, unsigned long request )
+{
+	int fd = vec->fd[( size_t ) row * vec->num_events];
+
+	if ( ioctl( fd, request, PERF_IOC_FLAG_GROUP ) == -1 ) {
+		PAPIERROR( "ioctl(%d, %#lx, PERF_IOC_FLAG_GROUP) on cpu %d "
+			   "returned error, Linux says: %s",
+			   fd, request, vec->cpu[row], strerror( errno ) );
+		return PAPI_ESYS;
+	}
+	return PAPI_OK;
+}
+
+/* Run op on every row r with r % parts == part */
+static int
+vec_run_part( pe_vector_t *vec, int op, unsigned long request,
+	      int part, int parts )
+{
+	int row, ret, result = PAPI_OK;
+
+	for ( row = part; row < vec->num_rows; row += parts ) {
+		if ( op == VEC_OP_READ ) {
+			ret = vec_read_row( vec, row );
+		} else {
+			ret = vec_ioctl_row( vec, row, request );
+		}
+		if ( ret != PAPI_OK ) result = ret;
+	}
+	return result;
+}
+
+static void *
+vec_worker( void *arg )
+{
+	vec_worker_arg_t *warg = ( vec_worker_arg_t * ) arg;
+	struct pe_vector_pool *pool = warg->pool;
+	int part = warg->part;
+	unsigned long seen = 0;
+	int op, ret;
+	unsigned long request;
+
+	papi_free( warg );
+
+	pthread_mutex_lock( &pool->lock );
+	for ( ;; ) {
+		while ( !pool->quit && pool->generation == seen ) {
+			pthread_cond_wait( &pool->go, &pool->lock );
+		}
+		if ( pool->quit ) break;
+		seen = pool->generation;
+		op = pool->op;
+		request = pool->request;
+		pthread_mutex_unlock( &pool->lock );
+
+		ret = vec_run_part( pool->vec, op, request,
+				    part, pool->num_threads + 1 );
+
+		pthread_mutex_lock( &pool->lock );
+		if ( ret != PAPI_OK && pool->error == PAPI_OK ) {
+			pool->error = ret;
+		}
+		if ( --pool->pending == 0 ) {
+			pthread_cond_signal( &pool->done );
+		}
+	}
+	pthread_mutex_unlock( &pool->lock );
+
+	return NULL;
+}
+
+static void
+vec_pool_destroy( struct pe_vector_pool *pool )
+{
+	int i;
+
+	pthread_mutex_lock( &pool->lock );
+	pool->quit = 1;
+	pthread_cond_broadcast( &pool->go );
+	pthread_mutex_unlock( &pool->lock );
+
+	for ( i = 0; i < pool->num_threads; i++ ) {
+		pthread_join( pool->threads[i], NULL );
+	}
+
+	pthread_cond_destroy( &pool->go );
+	pthread_cond_destroy( &pool->done );
+	pthread_mutex_destroy( &pool->lock );
+	papi_free( pool->threads );
+	papi_free( pool );
+}
+
+static struct pe_vector_pool *
+vec_pool_create( pe_vector_t *vec, int num_threads )
+{
+	struct pe_vector_pool *pool;
+	vec_worker_arg_t *warg;
+	sigset_t all, old;
+	int i;
+
+	pool = papi_calloc( 1, sizeof ( struct pe_vector_pool ) );
+	if ( pool == NULL ) return NULL;
+	pool->threads = papi_calloc( ( size_t ) num_threads, sizeof ( pthread_t ) );
+	if ( pool->threads == NULL ) {
+		papi_free( pool );
+		return NULL;
+	}
+	pthread_mutex_init( &pool->lock, NULL );
+	pthread_cond_init( &pool->go, NULL );
+	pthread_cond_init( &pool->done, NULL );
+	pool->vec = vec;
+	pool->error = PAPI_OK;
+
+	/* Keep overflow and timer signals on the application's threads */
+	sigfillset( &all );
+	pthread_sigmask( SIG_SETMASK, &all, &old );
+
+	for ( i = 0; i < num_threads; i++ ) {
+		warg = papi_malloc( sizeof ( vec_worker_arg_t ) );
+		if ( warg == NULL ) break;
+		warg->pool = pool;
+		warg->part = i + 1;
+		if ( pthread_create( &pool->threads[i], NULL, vec_worker, warg ) ) {
+			papi_free( warg );
+			break;
+		}
+		pool->num_threads++;
+	}
+
+	pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+	if ( pool->num_threads == 0 ) {
+		vec_pool_destroy( pool );
+		return NULL;
+	}
+	SUBDBG( "started %d vector reader threads\n", pool->num_threads );
+	return pool;
+}
+
+/* Apply op to every row, on the pool if there is one */
+static int
+vec_dispatch( pe_vector_t *vec, int op, unsigned long request )
+{
+	struct pe_vector_pool *pool = vec->pool;
+	int ret;
+
+	if ( pool == NULL ) {
+		return vec_run_part( vec, op, request, 0, 1 );
+	}
+
+	pthread_mutex_lock( &pool->lock );
+	pool->op = op;
+	pool->request = request;
+	pool->error = PAPI_OK;
+	pool->pending = pool->num_threads;
+	pool->generation++;
+	pthread_cond_broadcast( &pool->go );
+	pthread_mutex_unlock( &pool->lock );
+
+	ret = vec_run_part( vec, op, request, 0, pool->num_threads + 1 );
+
+	pthread_mutex_lock( &pool->lock );
+	while ( pool->pending ) {
+		pthread_cond_wait( &pool->done, &pool->lock );
+	}
+	if ( ret == PAPI_OK ) ret = pool->error;
+	pthread_mutex_unlock( &pool->lock );
+
+	return ret;
+}
+
+/* Fill cpus from a sysfs cpu list file ("0-3,6,8-11") */
+int
+_pe_vector_parse_cpus( const char *path, cpu_set_t *cpus )
+{
+	char buffer[BUFSIZ], *p, *end;
+	long first, last, cpu;
+	FILE *fff;
+
+	CPU_ZERO( cpus );
+
+	fff = fopen( path, "r" );
+	if ( fff == NULL ) return PAPI_ESYS;
+	if ( fgets( buffer, sizeof ( buffer ), fff ) == NULL ) {
+		fclose( fff );
+		return PAPI_ESYS;
+	}
+	fclose( fff );
+
+	p = buffer;
+	while ( *p && *p != '\n' ) {
+		first = strtol( p, &end, 10 );
+		if ( end == p ) return PAPI_ESYS;
+		last = first;
+		p = end;
+		if ( *p == '-' ) {
+			p++;
+			last = strtol( p, &end, 10 );
+			if ( end == p ) return PAPI_ESYS;
+			p = end;
+		}
+		for ( cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++ ) {
+			CPU_SET( cpu, cpus );
+		}
+		if ( *p == ',' ) p++;
+	}
+
+	return CPU_COUNT( cpus ) ? PAPI_OK : PAPI_ESYS;
+}
+
+/* Fill cpus with all online cpus */
+int
+_pe_vector_parse_online( cpu_set_t *cpus )
+{
+	long n, cpu;
+
+	if ( _pe_vector_parse_cpus( "/sys/devices/system/cpu/online",
+				    cpus ) == PAPI_OK ) {
+		return PAPI_OK;
+	}
+
+	CPU_ZERO( cpus );
+	n = sysconf( _SC_NPROCESSORS_ONLN );
+	for ( cpu = 0; cpu < n && cpu < CPU_SETSIZE; cpu++ ) {
+		CPU_SET( cpu, cpus );
+	}
+	return n > 0 ? PAPI_OK : PAPI_ESYS;
+}
+
+/* Open events on every cpu in cpus.  pid and flags are passed to    */
+/* perf_event_open() unchanged.  On failure errno is left as set by  */
+/* the failing call and PAPI_ESYS (or PAPI_ENOMEM) is returned.      */
+int
+_pe_vector_open( pe_vector_t *vec, pe_event_info_t *events, int num_events,
+		 cpu_set_t *cpus, int num_threads, long pid,
+		 unsigned long flags )
+{
+	int cpu_list[CPU_SETSIZE];
+	int cpu, num_rows = 0;
+
+	for ( cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+		if ( CPU_ISSET( cpu, cpus ) ) cpu_list[num_rows++] = cpu;
+	}
+
+	return _pe_vector_open_rows( vec, events, num_events, num_rows,
+				     cpu_list, NULL, num_threads, pid, flags );
+}
+
+/* Open one group per row on cpu[row].  If type is not NULL the     */
+/* events of a row are opened on PMU type[row] instead of their own */
+/* attr.type, for PMUs that come in several identical instances.    */
+int
+_pe_vector_open_rows( pe_vector_t *vec, pe_event_info_t *events,
+		      int num_events, int num_rows, const int *cpu,
+		      const unsigned int *type, int num_threads, long pid,
+		      unsigned long flags )
+{
+	struct perf_event_attr attr;
+	int row, i, fd, saved_errno;
+	size_t slots;
+
+	memset( vec, 0, sizeof ( pe_vector_t ) );
+
+	if ( num_rows <= 0 || num_events <= 0 ) {
+		errno = EINVAL;
+		return PAPI_ESYS;
+	}
+
+	slots = ( size_t ) num_rows * ( size_t ) num_events;
+	vec->cpu = papi_malloc( ( size_t ) num_rows * sizeof ( int ) );
+	vec->fd = papi_malloc( slots * sizeof ( int ) );
+	vec->counts = papi_calloc( slots, sizeof ( long long ) );
+	vec->sum = papi_calloc( ( size_t ) num_events, sizeof ( long long ) );
+	if ( !vec->cpu || !vec->fd || !vec->counts || !vec->sum ) {
+		_pe_vector_close( vec );
+		return PAPI_ENOMEM;
+	}
+	for ( i = 0; i < ( int ) slots; i++ ) {
+		vec->fd[i] = -1;
+	}
+	vec->num_rows = num_rows;
+	vec->num_events = num_events;
+
+	for ( row = 0; row < num_rows; row++ ) {
+
+		vec->cpu[row] = cpu[row];
+		for ( i = 0; i < num_events; i++ ) {
+			memcpy( &attr, &events[i].attr, sizeof ( attr ) );
+			if ( type ) attr.type = type[row];
+			attr.read_format = PERF_FORMAT_GROUP;
+			attr.inherit = 0;
+			attr.sample_period = 0;
+			attr.disabled = ( i == 0 );
+			attr.pinned = ( i == 0 );
+
+			fd = syscall( __NR_perf_event_open, &attr, pid, cpu[row],
+				      i == 0 ? -1 : vec->fd[( size_t ) row * num_events],
+				      flags );
+			if ( fd == -1 ) {
+				saved_errno = errno;
+				SUBDBG( "perf_event_open of event %d on cpu %d "
+					"failed: %s\n", i, cpu[row], strerror( errno ) );
+				_pe_vector_close( vec );
+				errno = saved_errno;
+				return PAPI_ESYS;
+			}
+			vec->fd[( size_t ) row * num_events + i] = fd;
+		}
+	}
+
+	if ( num_threads > 0 && num_rows > 1 ) {
+		if ( num_threads > num_rows - 1 ) num_threads = num_rows - 1;
+		vec->pool = vec_pool_create( vec, num_threads );
+	}
+
+	SUBDBG( "opened %d events on %d rows\n", num_events, num_rows );
+	return PAPI_OK;
+}
+
+int
+_pe_vector_close( pe_vector_t *vec )
+{
+	int row, i, result = PAPI_OK;
+
+	if ( vec->pool ) {
+		vec_pool_destroy( vec->pool );
+		vec->pool = NULL;
+	}
+
+	/* close the group members before their leaders */
+	if ( vec->fd ) {
+		for ( row = 0; row < vec->num_rows; row++ ) {
+			for ( i = vec->num_events - 1; i >= 0; i-- ) {
+				int *fd = &vec->fd[( size_t ) row * vec->num_events + i];
+				if ( *fd < 0 ) continue;
+				if ( close( *fd ) ) {
+					PAPIERROR( "close of fd = %d returned error: %s",
+						   *fd, strerror( errno ) );
+					result = PAPI_ESYS;
+				}
+				*fd = -1;
+			}
+		}
+	}
+
+	if ( vec->cpu ) papi_free( vec->cpu );
+	if ( vec->fd ) papi_free( vec->fd );
+	if ( vec->counts ) papi_free( vec->counts );
+	if ( vec->sum ) papi_free( vec->sum );
+	memset( vec, 0, sizeof ( pe_vector_t ) );
+
+	return result;
+}
+
+/* PERF_EVENT_IOC_ENABLE, _DISABLE or _RESET on every row's group */
+int
+_pe_vector_ioctl( pe_vector_t *vec, unsigned long request )
+{
+	return vec_dispatch( vec, VEC_OP_IOCTL, request );
+}
+
+/* Read every row into counts and their column sums into sum */
+int
+_pe_vector_read( pe_vector_t *vec )
+{
+	int row, i, ret;
+	long long *counts;
+
+	ret = vec_dispatch( vec, VEC_OP_READ, 0 );
+	if ( ret != PAPI_OK ) return ret;
+
+	memset( vec->sum, 0, ( size_t ) vec->num_events * sizeof ( long long ) );
+	for ( row = 0; row < vec->num_rows; row++ ) {
+		counts = vec->counts + ( size_t ) row * vec->num_events;
+		for ( i = 0; i < vec->num_events; i++ ) {
+			vec->sum[i] += counts[i];
+		}
+	}
+	return PAPI_OK;
+}
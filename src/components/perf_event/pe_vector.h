@@ -0,0 +1,25 @@
+/*
+* File:    pe_vector.h
+*
+* An event list replicated on a set of cpus or PMU instances ("rows"),
+* each row opened as its own perf_event group so one read() returns
+* the whole row.
+*/
+
+#ifndef _PE_VECTOR_H
+#define _PE_VECTOR_H
+
+int _pe_vector_parse_cpus( const char *path, cpu_set_t *cpus );
+int _pe_vector_parse_online( cpu_set_t *cpus );
+int _pe_vector_open( pe_vector_t *vec, pe_event_info_t *events,
+		     int num_events, cpu_set_t *cpus, int num_threads,
+		     long pid, unsigned long flags );
+int _pe_vector_open_rows( pe_vector_t *vec, pe_event_info_t *events,
+		     int num_events, int num_rows, const int *cpu,
+		     const unsigned int *type, int num_threads,
+		     long pid, unsigned long flags );
+int _pe_vector_close( pe_vector_t *vec );
+int _pe_vector_ioctl( pe_vector_t *vec, unsigned long request );
+int _pe_vector_read( pe_vector_t *vec );
+
+#endif
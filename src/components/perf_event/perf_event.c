@@ -54,6 +54,7 @@
 
 #include "perf_event_lib.h"
 #include "perf_helpers.h"
+#include "pe_vector.h"
 
 /* Set to enable pre-Linux 2.6.34 perf_event workarounds   */
 /* If disabling them gets no complaints then we can remove */
@@ -89,6 +90,8 @@ static int exclude_guest_unsupported;
 #endif
 
 static int _pe_set_domain( hwd_control_state_t *ctl, int domain);
+static int open_exit_ring( pe_control_t *ctl );
+static int close_exit_ring( pe_control_t *ctl );
 
 #if (OBSOLETE_WORKAROUNDS==1)
 
@@ -688,6 +691,25 @@ static inline void arm64_request_user_access(struct perf_event_attr *hw_event)
 	hw_event->config1=0x2;        /* Request user access */
 }
 
+/* Copy the fds and mmap pages of the opened events into ctl->slot */
+static int
+set_up_read_slots( pe_control_t *ctl )
+{
+	int i;
+
+	papi_aligned_free( ctl->slot );
+	ctl->slot = papi_aligned_calloc( ( size_t ) ctl->num_events,
+					 sizeof ( pe_read_slot_t ) );
+	if ( ctl->slot == NULL ) {
+		return PAPI_ENOMEM;
+	}
+	for ( i = 0; i < ctl->num_events; i++ ) {
+		ctl->slot[i].event_fd = ctl->events[i].event_fd;
+		ctl->slot[i].mmap_buf = ctl->events[i].mmap_buf;
+	}
+	return PAPI_OK;
+}
+
 /* Open all events in the control state */
 static int
 open_pe_events( pe_context_t *ctx, pe_control_t *ctl )
@@ -715,6 +737,50 @@ open_pe_events( pe_context_t *ctx, pe_control_t *ctl )
 		}
 	}
 
+	/* Replicated on a set of cpus, one group per cpu */
+	if (ctl->vector) {
+		int cgroup_fd = -1;
+		unsigned long flags = 0;
+
+		for( i = 0; i < ctl->num_events; i++ ) {
+			ctl->events[i].event_opened=0;
+			if ((ctl->events[i].attr.exclude_guest) &&
+				(exclude_guest_unsupported)) {
+				ctl->events[i].attr.exclude_guest=0;
+			}
+		}
+
+		/* In cgroup mode pid is an fd of the cgroup directory.     */
+		/* The kernel takes its own reference on the cgroup, so the */
+		/* fd is only needed while the events are being opened.     */
+		pid = -1;
+		if (ctl->cgroup) {
+			cgroup_fd = open( ctl->cgroup_path, O_RDONLY | O_CLOEXEC );
+			if ( cgroup_fd == -1 ) {
+				SUBDBG("open of cgroup %s failed: %s\n",
+					ctl->cgroup_path, strerror( errno ) );
+				return map_perf_event_errors_to_papi(errno);
+			}
+			pid = cgroup_fd;
+			flags = PERF_FLAG_PID_CGROUP;
+		}
+
+		ret = _pe_vector_open( &ctl->vec, ctl->events, ctl->num_events,
+				&ctl->vector_cpus, ctl->vector_threads,
+				pid, flags );
+		if ( ret == PAPI_ESYS ) {
+			ret = map_perf_event_errors_to_papi(errno);
+		}
+		if ( cgroup_fd != -1 ) {
+			close( cgroup_fd );
+		}
+		if ( ret != PAPI_OK ) {
+			return ret;
+		}
+		ctx->state |= PERF_EVENTS_OPENED;
+		return PAPI_OK;
+	}
+
 	for( i = 0; i < ctl->num_events; i++ ) {
 
 		ctl->events[i].event_opened=0;
@@ -766,6 +832,12 @@ open_pe_events( pe_context_t *ctx, pe_control_t *ctl )
 							0 );
 		}
 
+		/* each exiting child reports its counts, tagged by id */
+		ctl->events[i].attr.inherit_stat = ctl->inherit_threads;
+		if (ctl->inherit_threads) {
+			ctl->events[i].attr.read_format |= PERF_FORMAT_ID;
+		}
+
 		/* try to open */
 		perf_event_dump_attr(
 				&ctl->events[i].attr,
@@ -879,6 +951,23 @@ open_pe_events( pe_context_t *ctx, pe_control_t *ctl )
 		}
 	}
 
+	if (ctl->inherit_threads) {
+		ret = open_exit_ring( ctl );
+		if ( ret != PAPI_OK ) {
+			i = ctl->num_events;
+			goto open_pe_cleanup;
+		}
+	}
+
+	ret = set_up_read_slots( ctl );
+	if ( ret != PAPI_OK ) {
+		if ( ctl->exit_ring.event_opened ) {
+			close_exit_ring( ctl );
+		}
+		i = ctl->num_events;
+		goto open_pe_cleanup;
+	}
+
 	/* Set num_evts only if completely successful */
 	ctx->state |= PERF_EVENTS_OPENED;
 
@@ -933,6 +1022,189 @@ close_event( pe_event_info_t *event )
 	return 0;
 }
 
+/* Inherited per-task events cannot be mmap()ed, so their exit      */
+/* records (PERF_RECORD_READ, one per event when an inherited child */
+/* exits, enabled by inherit_stat) are redirected into the ring of  */
+/* a dummy event on the same task.                                  */
+static int
+open_exit_ring( pe_control_t *ctl )
+{
+	pe_event_info_t *ring = &ctl->exit_ring;
+	struct perf_event_attr attr;
+	int i;
+
+	memset( &attr, 0, sizeof ( attr ) );
+	attr.size = sizeof ( attr );
+	attr.type = PERF_TYPE_SOFTWARE;
+	attr.config = PERF_COUNT_SW_DUMMY;
+
+	memset( ring, 0, sizeof ( pe_event_info_t ) );
+	ring->cpu = ctl->events[0].cpu;
+	ring->event_fd = sys_perf_event_open( &attr,
+				ctl->granularity==PAPI_GRN_SYS ? -1 : ctl->tid,
+				ring->cpu, -1, 0 );
+	if ( ring->event_fd == -1 ) {
+		SUBDBG( "dummy event failed: %s\n", strerror( errno ) );
+		return map_perf_event_errors_to_papi( errno );
+	}
+	ring->event_opened = 1;
+	ring->nr_mmap_pages = 1 + PERF_EVENT_EXIT_RING_PAGES;
+	ring->mask = ( PERF_EVENT_EXIT_RING_PAGES * getpagesize() ) - 1;
+	ring->mmap_buf = mmap( NULL, ring->nr_mmap_pages * getpagesize(),
+			       PROT_READ | PROT_WRITE, MAP_SHARED,
+			       ring->event_fd, 0 );
+	if ( ring->mmap_buf == MAP_FAILED ) {
+		SUBDBG( "mmap of exit ring failed: %s\n", strerror( errno ) );
+		ring->mmap_buf = NULL;
+		close_exit_ring( ctl );
+		return PAPI_ESYS;
+	}
+
+	for ( i = 0; i < ctl->num_events; i++ ) {
+		if ( ioctl( ctl->events[i].event_fd, PERF_EVENT_IOC_ID,
+			    &ctl->events[i].id ) == -1 ||
+		     ioctl( ctl->events[i].event_fd, PERF_EVENT_IOC_SET_OUTPUT,
+			    ring->event_fd ) == -1 ) {
+			PAPIERROR( "cannot redirect exit records of fd %d: %s",
+				   ctl->events[i].event_fd, strerror( errno ) );
+			close_exit_ring( ctl );
+			return PAPI_ESYS;
+		}
+	}
+
+	ctl->num_exited = 0;
+	return PAPI_OK;
+}
+
+static int
+close_exit_ring( pe_control_t *ctl )
+{
+	int result = PAPI_OK;
+
+	if ( ctl->exit_ring.event_opened ) {
+		result = close_event( &ctl->exit_ring );
+	}
+	memset( &ctl->exit_ring, 0, sizeof ( pe_event_info_t ) );
+
+	if ( ctl->exited_tid ) papi_free( ctl->exited_tid );
+	if ( ctl->exited_counts ) papi_free( ctl->exited_counts );
+	ctl->exited_tid = NULL;
+	ctl->exited_counts = NULL;
+	ctl->num_exited = 0;
+	ctl->max_exited = 0;
+
+	return result;
+}
+
+/* Row of exited child tid, added if this is its first record */
+static long long *
+exited_row( pe_control_t *ctl, int tid )
+{
+	int i, max;
+	int *tids;
+	long long *counts;
+
+	/* the records of one child arrive together */
+	for ( i = ctl->num_exited - 1; i >= 0; i-- ) {
+		if ( ctl->exited_tid[i] == tid ) {
+			return ctl->exited_counts + ( size_t ) i * ctl->num_events;
+		}
+	}
+
+	if ( ctl->num_exited == ctl->max_exited ) {
+		max = ctl->max_exited ? 2 * ctl->max_exited : 16;
+		tids = papi_realloc( ctl->exited_tid, max * sizeof ( int ) );
+		if ( tids == NULL ) return NULL;
+		ctl->exited_tid = tids;
+		counts = papi_realloc( ctl->exited_counts, ( size_t ) max *
+				       ctl->num_events * sizeof ( long long ) );
+		if ( counts == NULL ) return NULL;
+		ctl->exited_counts = counts;
+		ctl->max_exited = max;
+	}
+
+	i = ctl->num_exited++;
+	ctl->exited_tid[i] = tid;
+	counts = ctl->exited_counts + ( size_t ) i * ctl->num_events;
+	memset( counts, 0, ctl->num_events * sizeof ( long long ) );
+	return counts;
+}
+
+/* Move the exit records collected so far into the exited_* table */
+static int
+drain_exit_ring( pe_control_t *ctl )
+{
+	pe_event_info_t *ring = &ctl->exit_ring;
+	struct perf_event_mmap_page *pc = ring->mmap_buf;
+	unsigned char *data = ( ( unsigned char * ) ring->mmap_buf ) + getpagesize();
+	uint64_t record[8], head, old, offset, len, cpy;
+	uint32_t *ids;
+	long long *row, value, enabled = 0, running = 0;
+	int i, n, size;
+
+	if ( pc == NULL ) return PAPI_OK;
+
+	head = pc->data_head;
+	rmb();
+	old = ring->tail;
+
+	while ( old != head ) {
+		struct perf_event_header *header =
+			( struct perf_event_header * ) &data[old & ring->mask];
+		size = header->size;
+		if ( size == 0 ) break;
+
+		/* copy the record out, it may wrap around the end */
+		offset = old;
+		len = min( ( size_t ) size, sizeof ( record ) );
+		for ( n = 0; len; n += cpy ) {
+			cpy = min( ring->mask + 1 - ( offset & ring->mask ), len );
+			memcpy( ( unsigned char * ) record + n,
+				&data[offset & ring->mask], cpy );
+			offset += cpy;
+			len -= cpy;
+		}
+		old += size;
+
+		if ( header->type == PERF_RECORD_LOST ) {
+			SUBDBG( "exit ring overrun, %"PRIu64" records lost\n",
+				record[2] );
+			continue;
+		}
+		if ( header->type != PERF_RECORD_READ ) continue;
+
+		/* header, pid/tid, value, [enabled], [running], id */
+		ids = ( uint32_t * ) &record[1];
+		value = record[2];
+		n = 3;
+		if ( ctl->events[0].attr.read_format &
+		     PERF_FORMAT_TOTAL_TIME_ENABLED ) enabled = record[n++];
+		if ( ctl->events[0].attr.read_format &
+		     PERF_FORMAT_TOTAL_TIME_RUNNING ) running = record[n++];
+		if ( running && running != enabled ) {
+			value = ( long long ) ( ( double ) value * enabled / running );
+		}
+
+		for ( i = 0; i < ctl->num_events; i++ ) {
+			if ( ctl->events[i].id == record[n] ) break;
+		}
+		if ( i == ctl->num_events ) continue;
+
+		row = exited_row( ctl, ids[1] );
+		if ( row == NULL ) {
+			ring->tail = old;
+			mmap_write_tail( ring, old );
+			return PAPI_ENOMEM;
+		}
+		row[i] += value;
+	}
+
+	ring->tail = old;
+	mmap_write_tail( ring, old );
+
+	return PAPI_OK;
+}
+
 /* Close all of the opened events */
 static int
 close_pe_events( pe_context_t *ctx, pe_control_t *ctl )
@@ -946,6 +1218,17 @@ close_pe_events( pe_context_t *ctx, pe_control_t *ctl )
 		SUBDBG("Closing without stopping first\n");
 	}
 
+	/* Per-cpu groups of a replicated control state */
+	if ( ctl->vec.num_rows ) {
+		result=_pe_vector_close(&ctl->vec);
+		if (result!=PAPI_OK) return result;
+	}
+
+	if ( ctl->exit_ring.event_opened ) {
+		result=close_exit_ring(ctl);
+		if (result!=PAPI_OK) return result;
+	}
+
 	/* Close child events first */
 	/* Is that necessary? -- vmw */
 	for( i=0; i<ctl->num_events; i++ ) {
@@ -983,6 +1266,9 @@ close_pe_events( pe_context_t *ctx, pe_control_t *ctl )
 
 	ctl->num_events=0;
 
+	papi_aligned_free( ctl->slot );
+	ctl->slot = NULL;
+
 	ctx->state &= ~PERF_EVENTS_OPENED;
 
 	return PAPI_OK;
@@ -1061,13 +1347,27 @@ _pe_reset( hwd_context_t *ctx, hwd_control_state_t *ctl )
 
 	( void ) ctx;			 /*unused */
 
+	if ( pe_ctl->vector ) {
+		return _pe_vector_ioctl( &pe_ctl->vec, PERF_EVENT_IOC_RESET );
+	}
+
+	/* forget the children that exited before now */
+	if ( pe_ctl->exit_ring.mmap_buf ) {
+		ret = drain_exit_ring( pe_ctl );
+		pe_ctl->num_exited = 0;
+		if ( ret != PAPI_OK ) return ret;
+	}
+
 	/* We need to reset all of the events, not just the group leaders */
 	for( i = 0; i < pe_ctl->num_events; i++ ) {
 		if (_perf_event_vector.cmp_info.fast_counter_read) {
 			ret = ioctl( pe_ctl->events[i].event_fd, 
 					PERF_EVENT_IOC_RESET, NULL );
-			pe_ctl->reset_counts[i] = mmap_read_reset_count(
-					pe_ctl->events[i].mmap_buf);
+			if ( pe_ctl->slot ) {
+				pe_ctl->slot[i].reset_count =
+					mmap_read_reset_count(
+						pe_ctl->slot[i].mmap_buf);
+			}
 			pe_ctl->reset_flag = 1;
 		} else {
 			ret = ioctl( pe_ctl->events[i].event_fd, 
@@ -1139,12 +1439,14 @@ _pe_rdpmc_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
 	unsigned long long count, enabled = 0, running = 0, adjusted;
 	int errors=0;
 
+	pe_read_slot_t *slot = pe_ctl->slot;
+
 	/* we must read each counter individually */
 	for ( i = 0; i < pe_ctl->num_events; i++ ) {
 
-		count = mmap_read_self(pe_ctl->events[i].mmap_buf,
+		count = mmap_read_self(slot[i].mmap_buf,
 						pe_ctl->reset_flag,
-						pe_ctl->reset_counts[i],
+						slot[i].reset_count,
 						&enabled,&running);
 
 		if (count==0xffffffffffffffffULL) {
@@ -1193,7 +1495,7 @@ _pe_read_multiplexed( pe_control_t *pe_ctl )
 
 	for ( i = 0; i < pe_ctl->num_events; i++ ) {
 
-		ret = read( pe_ctl->events[i].event_fd,
+		ret = read( pe_ctl->slot[i].event_fd,
 				papi_pe_buffer,
 				sizeof ( papi_pe_buffer ) );
 		if ( ret == -1 ) {
@@ -1261,7 +1563,7 @@ _pe_read_nogroup( pe_control_t *pe_ctl ) {
 
 	/* we must read each counter individually */
 	for ( i = 0; i < pe_ctl->num_events; i++ ) {
-		ret = read( pe_ctl->events[i].event_fd,
+		ret = read( pe_ctl->slot[i].event_fd,
 				papi_pe_buffer,
 				sizeof ( papi_pe_buffer ) );
 		if ( ret == -1 ) {
@@ -1270,8 +1572,9 @@ _pe_read_nogroup( pe_control_t *pe_ctl ) {
 			return PAPI_ESYS;
 		}
 
-		/* we should read one 64-bit value from each counter */
-		if (ret!=sizeof(long long)) {
+		/* we should read one 64-bit value from each counter, */
+		/* followed by its id with PAPI_INHERIT_THREADS        */
+		if (ret<(signed)sizeof(long long)) {
 			PAPIERROR("Error!  short read");
 			PAPIERROR("read: fd: %2d, tid: %ld, cpu: %d, ret: %d",
 				pe_ctl->events[i].event_fd,
@@ -1305,6 +1608,16 @@ _pe_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
 	long long papi_pe_buffer[READ_BUFFER_SIZE];
 	int result;
 
+	/* Replicated on a set of cpus: report the sum over all cpus */
+	if (pe_ctl->vector) {
+		result = _pe_vector_read( &pe_ctl->vec );
+		if (result != PAPI_OK) return result;
+		memcpy( pe_ctl->counts, pe_ctl->vec.sum,
+			pe_ctl->num_events * sizeof(long long) );
+		*events = pe_ctl->counts;
+		return PAPI_OK;
+	}
+
 	/* Handle fast case */
 	/* FIXME: we fallback to slow reads if *any* event in eventset fails */
 	/*        in theory we could only fall back for the one event        */
@@ -1385,6 +1698,55 @@ _pe_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
 	return PAPI_OK;
 }
 
+/* Read each cpu of a replicated control state as its own row */
+static int
+_pe_read_vector( hwd_context_t *ctx, hwd_control_state_t *ctl,
+	       long long **events, int *rows, int *row_len )
+{
+	pe_control_t *pe_ctl = ( pe_control_t *) ctl;
+	int ret;
+
+	( void ) ctx;			 /*unused */
+
+	if (!pe_ctl->vector) {
+		return PAPI_EINVAL;
+	}
+
+	ret = _pe_vector_read( &pe_ctl->vec );
+	if (ret != PAPI_OK) return ret;
+
+	*events = pe_ctl->vec.counts;
+	*rows = pe_ctl->vec.num_rows;
+	*row_len = pe_ctl->vec.num_events;
+
+	return PAPI_OK;
+}
+
+/* Counts of each inherited child that exited since the last reset */
+static int
+_pe_read_inherited( hwd_context_t *ctx, hwd_control_state_t *ctl,
+	       int **tids, long long **events, int *rows, int *row_len )
+{
+	pe_control_t *pe_ctl = ( pe_control_t *) ctl;
+	int ret;
+
+	( void ) ctx;			 /*unused */
+
+	if (!pe_ctl->inherit_threads) {
+		return PAPI_EINVAL;
+	}
+
+	ret = drain_exit_ring( pe_ctl );
+	if (ret != PAPI_OK) return ret;
+
+	*tids = pe_ctl->exited_tid;
+	*events = pe_ctl->exited_counts;
+	*rows = pe_ctl->num_exited;
+	*row_len = pe_ctl->num_events;
+
+	return PAPI_OK;
+}
+
 #if (OBSOLETE_WORKAROUNDS==1)
 /* On kernels before 2.6.33 the TOTAL_TIME_ENABLED and TOTAL_TIME_RUNNING */
 /* fields are always 0 unless the counter is disabled.  So if we are on   */
@@ -1459,6 +1821,15 @@ _pe_start( hwd_context_t *ctx, hwd_control_state_t *ctl )
 		return ret;
 	}
 
+	if ( pe_ctl->vector ) {
+		ret = _pe_vector_ioctl( &pe_ctl->vec, PERF_EVENT_IOC_ENABLE );
+		if ( ret != PAPI_OK ) {
+			return ret;
+		}
+		pe_ctx->state |= PERF_EVENTS_RUNNING;
+		return PAPI_OK;
+	}
+
 	/* Enable all of the group leaders                */
 	/* All group leaders have a group_leader_fd of -1 */
 	for( i = 0; i < pe_ctl->num_events; i++ ) {
@@ -1468,7 +1839,9 @@ _pe_start( hwd_context_t *ctx, hwd_control_state_t *ctl )
 			ret=ioctl( pe_ctl->events[i].event_fd,
 				PERF_EVENT_IOC_ENABLE, NULL) ;
 			if (_perf_event_vector.cmp_info.fast_counter_read) {
-				pe_ctl->reset_counts[i] = 0LL;
+				if ( pe_ctl->slot ) {
+					pe_ctl->slot[i].reset_count = 0LL;
+				}
 				pe_ctl->reset_flag = 0;
 			}
 
@@ -1504,6 +1877,15 @@ _pe_stop( hwd_context_t *ctx, hwd_control_state_t *ctl )
 	pe_context_t *pe_ctx = ( pe_context_t *) ctx;
 	pe_control_t *pe_ctl = ( pe_control_t *) ctl;
 
+	if ( pe_ctl->vector ) {
+		ret = _pe_vector_ioctl( &pe_ctl->vec, PERF_EVENT_IOC_DISABLE );
+		if ( ret != PAPI_OK ) {
+			return PAPI_EBUG;
+		}
+		pe_ctx->state &= ~PERF_EVENTS_RUNNING;
+		return PAPI_OK;
+	}
+
 	/* Just disable the group leaders */
 	for ( i = 0; i < pe_ctl->num_events; i++ ) {
 		if ( pe_ctl->events[i].group_leader_fd == -1 ) {
@@ -1665,17 +2047,29 @@ _pe_update_control_state( hwd_control_state_t *ctl,
 	return PAPI_OK;
 }
 
+/* Path of PAPI_CGROUP_ATTACH, strdup'd by the attach */
+static void
+free_cgroup_path( pe_control_t *ctl )
+{
+	if ( ctl->cgroup_path ) papi_free( ctl->cgroup_path );
+	ctl->cgroup_path = NULL;
+}
+
 /* Set various options on a control state */
 static int
 _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 {
    int ret;
+   char *cgroup_path;
    pe_context_t *pe_ctx = ( pe_context_t *) ctx;
    pe_control_t *pe_ctl = NULL;
 
    switch ( code ) {
       case PAPI_MULTIPLEX:
 	   pe_ctl = ( pe_control_t * ) ( option->multiplex.ESI->ctl_state );
+	   if (pe_ctl->vector) {
+	      return PAPI_ECMP;
+	   }
 	   ret = check_permissions( pe_ctl->tid, pe_ctl->cpu, pe_ctl->domain,
 				    pe_ctl->granularity,
 				    1, pe_ctl->inherit );
@@ -1694,6 +2088,9 @@ _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 
       case PAPI_ATTACH:
 	   pe_ctl = ( pe_control_t * ) ( option->attach.ESI->ctl_state );
+	   if (pe_ctl->vector) {
+	      return PAPI_ECMP;
+	   }
 	   ret = check_permissions( option->attach.tid, pe_ctl->cpu,
 				  pe_ctl->domain, pe_ctl->granularity,
 				  pe_ctl->multiplexed,
@@ -1722,6 +2119,9 @@ _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 
       case PAPI_CPU_ATTACH:
 	   pe_ctl = ( pe_control_t *) ( option->cpu.ESI->ctl_state );
+	   if (pe_ctl->vector) {
+	      return PAPI_ECMP;
+	   }
 	   ret = check_permissions( pe_ctl->tid, option->cpu.cpu_num,
 				    pe_ctl->domain, pe_ctl->granularity,
 				    pe_ctl->multiplexed,
@@ -1735,6 +2135,139 @@ _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 
 	   return PAPI_OK;
 
+      case PAPI_CPU_VECTOR:
+	   pe_ctl = ( pe_control_t *) ( option->cpu_vector.ESI->ctl_state );
+	   if (pe_ctl->multiplexed || pe_ctl->attached || pe_ctl->inherit) {
+	      return PAPI_ECMP;
+	   }
+
+	   /* a negative count turns replication back off, */
+	   /* but a cgroup can only be counted per cpu      */
+	   if (option->cpu_vector.num_cpus < 0) {
+	      if (pe_ctl->cgroup) {
+	         return PAPI_EINVAL;
+	      }
+	      pe_ctl->vector = 0;
+	      return _pe_update_control_state( pe_ctl, NULL,
+						pe_ctl->num_events, pe_ctx );
+	   }
+
+	   {
+	      cpu_set_t cpus;
+	      int i;
+
+	      if (option->cpu_vector.num_cpus == 0) {
+	         ret = _pe_vector_parse_online( &cpus );
+	         if (ret != PAPI_OK) {
+	            return ret;
+	         }
+	      } else {
+	         if (option->cpu_vector.cpus == NULL) {
+	            return PAPI_EINVAL;
+	         }
+	         CPU_ZERO( &cpus );
+	         for (i = 0; i < option->cpu_vector.num_cpus; i++) {
+	            if (option->cpu_vector.cpus[i] >= CPU_SETSIZE) {
+	               return PAPI_EINVAL;
+	            }
+	            CPU_SET( option->cpu_vector.cpus[i], &cpus );
+	         }
+	      }
+
+	      /* the rows count cpu wide, check each cpu as PAPI_CPU_ATTACH */
+	      /* does; without a hardware PMU the probe event is missing and */
+	      /* opening the events reports the permissions instead          */
+	      for (i = 0; i < CPU_SETSIZE; i++) {
+	         if (!CPU_ISSET( i, &cpus )) continue;
+	         ret = check_permissions( pe_ctl->tid, i,
+				    pe_ctl->domain, PAPI_GRN_SYS,
+				    pe_ctl->multiplexed,
+				    pe_ctl->inherit );
+	         if (ret != PAPI_OK && ret != PAPI_ENOEVNT) {
+	            return ret;
+	         }
+	      }
+	      pe_ctl->vector_cpus = cpus;
+	   }
+	   pe_ctl->vector = 1;
+	   pe_ctl->cgroup_vector = 0;
+	   pe_ctl->vector_threads = option->cpu_vector.num_threads;
+	   option->cpu_vector.num_cpus = CPU_COUNT( &pe_ctl->vector_cpus );
+
+	   /* reopen anything already added on the new cpus */
+	   ret = _pe_update_control_state( pe_ctl, NULL,
+						pe_ctl->num_events, pe_ctx );
+	   if (ret != PAPI_OK) {
+	      pe_ctl->vector = 0;
+	   }
+	   return ret;
+
+      case PAPI_CGROUP_ATTACH:
+	   pe_ctl = ( pe_control_t *) ( option->cgroup.ESI->ctl_state );
+	   if (pe_ctl->multiplexed || pe_ctl->attached || pe_ctl->inherit) {
+	      return PAPI_ECMP;
+	   }
+
+	   /* detach; drop the cpus too if the attach chose them */
+	   if (option->cgroup.path == NULL) {
+	      pe_ctl->cgroup = 0;
+	      free_cgroup_path( pe_ctl );
+	      if (pe_ctl->cgroup_vector) {
+	         pe_ctl->vector = 0;
+	         pe_ctl->cgroup_vector = 0;
+	      }
+	      option->cgroup.num_cpus = pe_ctl->vector ?
+			CPU_COUNT( &pe_ctl->vector_cpus ) : 0;
+	      return _pe_update_control_state( pe_ctl, NULL,
+						pe_ctl->num_events, pe_ctx );
+	   }
+
+	   if (strlen(option->cgroup.path) >= PATH_MAX) {
+	      return PAPI_EINVAL;
+	   }
+	   {
+	      int cgroup_fd = open( option->cgroup.path, O_RDONLY | O_CLOEXEC );
+	      if (cgroup_fd == -1) {
+	         SUBDBG("open of cgroup %s failed: %s\n",
+			option->cgroup.path, strerror( errno ) );
+	         return ( errno == EACCES ) ? PAPI_EPERM : PAPI_EINVAL;
+	      }
+	      close( cgroup_fd );
+	   }
+
+	   cgroup_path = papi_strdup( option->cgroup.path );
+	   if (cgroup_path == NULL) {
+	      return PAPI_ENOMEM;
+	   }
+
+	   /* cgroup events must name a cpu, default to all of them */
+	   if (!pe_ctl->vector) {
+	      ret = _pe_vector_parse_online( &pe_ctl->vector_cpus );
+	      if (ret != PAPI_OK) {
+	         papi_free( cgroup_path );
+	         return ret;
+	      }
+	      pe_ctl->vector = 1;
+	      pe_ctl->cgroup_vector = 1;
+	   }
+	   free_cgroup_path( pe_ctl );
+	   pe_ctl->cgroup_path = cgroup_path;
+	   pe_ctl->cgroup = 1;
+	   option->cgroup.num_cpus = CPU_COUNT( &pe_ctl->vector_cpus );
+
+	   /* reopen anything already added in the cgroup */
+	   ret = _pe_update_control_state( pe_ctl, NULL,
+						pe_ctl->num_events, pe_ctx );
+	   if (ret != PAPI_OK) {
+	      pe_ctl->cgroup = 0;
+	      free_cgroup_path( pe_ctl );
+	      if (pe_ctl->cgroup_vector) {
+	         pe_ctl->vector = 0;
+	         pe_ctl->cgroup_vector = 0;
+	      }
+	   }
+	   return ret;
+
       case PAPI_DOMAIN:
 	   pe_ctl = ( pe_control_t *) ( option->domain.ESI->ctl_state );
 	   ret = check_permissions( pe_ctl->tid, pe_ctl->cpu,
@@ -1778,6 +2311,9 @@ _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 
       case PAPI_INHERIT:
 	   pe_ctl = (pe_control_t *) ( option->inherit.ESI->ctl_state );
+	   if (pe_ctl->vector) {
+	      return PAPI_ECMP;
+	   }
 	   ret = check_permissions( pe_ctl->tid, pe_ctl->cpu, pe_ctl->domain,
 				  pe_ctl->granularity, pe_ctl->multiplexed,
 				    option->inherit.inherit );
@@ -1792,6 +2328,9 @@ _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 	      /* children won't inherit counters */
 	      pe_ctl->inherit = 0;
 	   }
+	   /* and report their counts as they exit */
+	   pe_ctl->inherit_threads =
+		(option->inherit.inherit == PAPI_INHERIT_THREADS);
 	   return PAPI_OK;
 
       case PAPI_DATA_ADDRESS:
@@ -1838,6 +2377,18 @@ _pe_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 }
 
 
+/* Release what PAPI_CGROUP_ATTACH allocated before the framework frees
+   the control state */
+static int
+_pe_cleanup_eventset( hwd_control_state_t *ctl )
+{
+	pe_control_t *pe_ctl = ( pe_control_t *) ctl;
+
+	pe_ctl->cgroup = 0;
+	free_cgroup_path( pe_ctl );
+	return PAPI_OK;
+}
+
 /* Initialize a new control state */
 static int
 _pe_init_control_state( hwd_control_state_t *ctl )
@@ -2174,6 +2725,11 @@ _pe_set_overflow( EventSetInfo_t *ESI, int EventIndex, int threshold )
 		return PAPI_EINVAL;
 	}
 
+	/* No sampling on events replicated over a cpu vector */
+	if (ctl->vector) {
+		return PAPI_ENOSUPP;
+	}
+
 	/* It's an error to disable overflow if it wasn't set in the	*/
 	/* first place.							*/
 	if (( threshold == 0 ) &&
@@ -2576,6 +3132,12 @@ _pe_init_component( int cidx )
 		_papi_hwd[cidx]->cmp_info.fast_counter_read = 0;
 	}
 
+	/* PAPI_PERF_EVENT_RDPMC=0 makes reads use read(), e.g. to compare */
+	if ((getenv("PAPI_PERF_EVENT_RDPMC")!=NULL) &&
+		(atoi(getenv("PAPI_PERF_EVENT_RDPMC"))==0)) {
+		_papi_hwd[cidx]->cmp_info.fast_counter_read = 0;
+	}
+
 #if (USE_PERFEVENT_RDPMC==1)
 
 #else
@@ -2709,6 +3271,7 @@ papi_vector_t _perf_event_vector = {
   .shutdown_component =    _pe_shutdown_component,
   .init_thread =           _pe_init_thread,
   .init_control_state =    _pe_init_control_state,
+  .cleanup_eventset =      _pe_cleanup_eventset,
   .dispatch_timer =        _pe_dispatch_timer,
 
   /* function pointers from the shared perf_event lib */
@@ -2724,6 +3287,8 @@ papi_vector_t _perf_event_vector = {
   .set_profile =           _pe_set_profile,
   .stop_profiling =        _pe_stop_profiling,
   .write =                 _pe_write,
+  .read_vector =           _pe_read_vector,
+  .read_inherited =        _pe_read_inherited,
 
 
   /* from counter name mapper */
@@ -1,9 +1,19 @@
 /* Various definitions */
 
+#include <sched.h>
+#include <limits.h>
+
 /* This is arbitrary.  Typically you can add up to ~1000 before */
 /* you run out of fds                                           */
 #define PERF_EVENT_MAX_MPX_COUNTERS 384
 
+/* Most instances of one uncore PMU (boxes per socket) we aggregate */
+#define PERF_EVENT_MAX_UNCORE_INSTANCES 256
+
+/* Data pages of the ring that collects the counts of exited children */
+/* with PAPI_INHERIT_THREADS; each child leaves 32 bytes per event    */
+#define PERF_EVENT_EXIT_RING_PAGES 16
+
 /* We really don't need fancy definitions for these */
 
 typedef struct
@@ -18,10 +28,45 @@ typedef struct
   uint64_t tail;                  /* current read location in mmap buffer */
   uint64_t mask;                  /* mask used for wrapping the pages     */
   int cpu;                        /* cpu associated with this event       */
+  uint64_t id;                    /* kernel id, tags exited child counts  */
   struct perf_event_attr attr;    /* perf_event config structure          */
 } pe_event_info_t;
 
 
+/* What the read paths need of one opened event.  events[] entries */
+/* carry their perf_event_attr and are several cache lines each, so */
+/* these are copied into a cache aligned array of num_events slots  */
+/* when the events are opened.                                      */
+typedef struct
+{
+  void *mmap_buf;                 /* user page for rdpmc, or NULL         */
+  long long reset_count;          /* rdpmc count at the last reset        */
+  int event_fd;                   /* fd of event                          */
+} pe_read_slot_t;
+
+
+/* An event list replicated on a set of cpus, see pe_vector.c */
+struct pe_vector_pool;
+
+typedef struct {
+  int num_rows;                   /* number of cpus the events are open on */
+  int num_events;                 /* number of events in each row          */
+  int *cpu;                       /* cpu of each row                       */
+  int *fd;                        /* fds, [num_rows][num_events]           */
+  long long *counts;              /* counts, [num_rows][num_events]        */
+  long long *sum;                 /* counts summed over rows, [num_events] */
+  struct pe_vector_pool *pool;    /* reader threads, NULL if none          */
+} pe_vector_t;
+
+
+/* The instances of the uncore PMU an aggregated event set counts */
+typedef struct {
+  int num_instances;              /* instances of the PMU              */
+  unsigned int instance_type[PERF_EVENT_MAX_UNCORE_INSTANCES];
+  char pmu[PAPI_MIN_STR_LEN];     /* PMU family, digits stripped       */
+} pe_uncore_instances_t;
+
+
 typedef struct {
   int num_events;                 /* number of events in control state */
   unsigned int domain;            /* control-state wide domain         */
@@ -29,6 +74,7 @@ typedef struct {
   unsigned int multiplexed;       /* multiplexing enable               */
   unsigned int overflow;          /* overflow enable                   */
   unsigned int inherit;           /* inherit enable                    */
+  unsigned int inherit_threads;   /* keep counts of each exited child  */
   unsigned int overflow_signal;   /* overflow signal                   */
   unsigned int attached;          /* attached to a process             */
   int cidx;                       /* current component                 */
@@ -37,7 +83,25 @@ typedef struct {
   pe_event_info_t events[PERF_EVENT_MAX_MPX_COUNTERS];
   long long counts[PERF_EVENT_MAX_MPX_COUNTERS];
   unsigned int reset_flag;
-  long long reset_counts[PERF_EVENT_MAX_MPX_COUNTERS];
+  pe_read_slot_t *slot;           /* per event read state while opened */
+  unsigned int vector;            /* replicated on vector_cpus         */
+  int vector_threads;             /* reader threads for the vector     */
+  cpu_set_t vector_cpus;          /* cpus set by PAPI_CPU_VECTOR       */
+  pe_vector_t vec;                /* per-cpu fds and counts when open  */
+  unsigned int cgroup;            /* restricted to cgroup_path         */
+  unsigned int cgroup_vector;     /* vector_cpus set up by the cgroup  */
+  char *cgroup_path;              /* set by PAPI_CGROUP_ATTACH         */
+  unsigned int aggregate;         /* uncore: every instance and socket */
+  unsigned int per_socket;        /* uncore: rows summed per socket    */
+  pe_uncore_instances_t *agg;     /* uncore: allocated while aggregate */
+  int num_sockets;                /* uncore: per-socket rows           */
+  int *row_socket;                /* socket row of each vector row     */
+  long long *socket_counts;       /* [num_sockets][num_events]         */
+  pe_event_info_t exit_ring;      /* dummy event with the exit records */
+  int num_exited;                 /* exited children seen so far       */
+  int max_exited;                 /* allocated rows of exited_*        */
+  int *exited_tid;                /* tid of each exited child          */
+  long long *exited_counts;       /* [max_exited][num_events]          */
 } pe_control_t;
 
 
@@ -0,0 +1,167 @@
+/*
+ * This tests counting only the tasks of a cgroup with PAPI_CGROUP_ATTACH
+ *
+ * By default the cgroup (v2) this process runs in is used, so the
+ * work done below must show up in the counts.  A different cgroup
+ * directory can be given as the first argument.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#include "do_loops.h"
+
+/* cgroup2 mount point + our path from /proc/self/cgroup ("0::/path") */
+static int
+find_own_cgroup( char *path, int len ) {
+
+	char line[BUFSIZ], mnt[BUFSIZ], type[64], own[BUFSIZ];
+	FILE *fff;
+	int found=0;
+
+	fff=fopen("/proc/self/mounts","r");
+	if (fff==NULL) return 0;
+	while(fgets(line,sizeof(line),fff)) {
+		if (sscanf(line,"%*s %s %63s",mnt,type)==2 &&
+			!strcmp(type,"cgroup2")) {
+			found=1;
+			break;
+		}
+	}
+	fclose(fff);
+	if (!found) return 0;
+
+	found=0;
+	fff=fopen("/proc/self/cgroup","r");
+	if (fff==NULL) return 0;
+	while(fgets(line,sizeof(line),fff)) {
+		if (!strncmp(line,"0::",3)) {
+			sscanf(line+3,"%s",own);
+			found=1;
+			break;
+		}
+	}
+	fclose(fff);
+	if (!found) return 0;
+
+	snprintf(path,len,"%s%s",mnt,strcmp(own,"/")?own:"");
+	return 1;
+}
+
+int main( int argc, char **argv ) {
+
+	int retval, i, rows;
+	int EventSet = PAPI_NULL;
+	int quiet=0;
+	char path[BUFSIZ];
+	PAPI_option_t opt;
+	long long values[1], sum, *vector;
+
+	/* Set TESTS_QUIET variable */
+	quiet=tests_quiet( argc, argv );
+
+	if ((argc > 1) && (argv[argc-1][0] == '/')) {
+		strncpy(path,argv[argc-1],sizeof(path)-1);
+		path[sizeof(path)-1]=0;
+	}
+	else if (!find_own_cgroup(path,sizeof(path))) {
+		test_skip( __FILE__, __LINE__, "no cgroup v2 hierarchy", 0 );
+	}
+
+	/* Init the PAPI library */
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	retval = PAPI_create_eventset(&EventSet);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_create_eventset",retval);
+	}
+
+	retval = PAPI_assign_eventset_component(EventSet, 0);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_assign_eventset_component",retval);
+	}
+
+	memset(&opt, 0, sizeof(opt));
+	opt.cgroup.eventset = EventSet;
+	opt.cgroup.path = path;
+
+	retval = PAPI_set_opt(PAPI_CGROUP_ATTACH, &opt);
+	if (retval != PAPI_OK) {
+		test_skip(__FILE__, __LINE__, "PAPI_set_opt(PAPI_CGROUP_ATTACH)",retval);
+	}
+
+	retval = PAPI_add_named_event(EventSet, "perf::CPU-CLOCK");
+	if (retval != PAPI_OK) {
+		/* no CONFIG_CGROUP_PERF, or not allowed to count per cpu */
+		test_skip(__FILE__, __LINE__, "perf::CPU-CLOCK in a cgroup", retval);
+	}
+
+	if (!quiet) {
+		printf("\nCPU-CLOCK of cgroup %s on %d cpus:\n",
+			path, opt.cgroup.num_cpus);
+	}
+
+	retval = PAPI_start( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_start", retval );
+	}
+
+	do_flops( NUM_FLOPS );
+
+	rows = opt.cgroup.num_cpus;
+	vector = calloc(rows, sizeof(long long));
+	if (vector == NULL) {
+		test_fail(__FILE__, __LINE__, "calloc", PAPI_ENOMEM);
+	}
+	retval = PAPI_read_vector( EventSet, vector, &rows );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_read_vector", retval );
+	}
+
+	retval = PAPI_stop( EventSet, values );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_stop", retval );
+	}
+
+	sum=0;
+	for(i=0;i<rows;i++) {
+		if (!quiet) printf("\tcpu row %3d: %lld\n",i,vector[i]);
+		sum+=vector[i];
+	}
+	if (!quiet) printf("\ttotal: %lld\n",values[0]);
+
+	if (sum > values[0]) {
+		test_fail( __FILE__, __LINE__, "row sum larger than total", 0 );
+	}
+	if ((argc < 2 || argv[argc-1][0] != '/') && values[0] <= 0) {
+		test_fail( __FILE__, __LINE__, "own cgroup counted nothing", 0 );
+	}
+
+	/* detach and make sure it is gone */
+	opt.cgroup.path = NULL;
+	retval = PAPI_set_opt(PAPI_CGROUP_ATTACH, &opt);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_set_opt(detach)",retval);
+	}
+	if (PAPI_get_opt(PAPI_CGROUP_ATTACH, &opt) != 0) {
+		test_fail(__FILE__, __LINE__, "still attached", 0);
+	}
+
+	retval = PAPI_cleanup_eventset( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_cleanup_eventset", retval );
+	}
+
+	free(vector);
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
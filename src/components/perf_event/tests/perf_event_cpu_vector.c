@@ -0,0 +1,155 @@
+/*
+ * This tests replicating an event set on all cpus with PAPI_CPU_VECTOR
+ * and reading the per-cpu rows with PAPI_read_vector()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#include "do_loops.h"
+
+#define NUM_EVENTS 2
+
+static void
+run_vector( int num_threads, int quiet ) {
+
+	int retval, i, j, rows;
+	int EventSet = PAPI_NULL;
+	PAPI_option_t opt;
+	long long *vector;
+	long long values[NUM_EVENTS], sum[NUM_EVENTS];
+	const char *events[NUM_EVENTS] = { "perf::CPU-CLOCK", "perf::CONTEXT-SWITCHES" };
+
+	retval = PAPI_create_eventset(&EventSet);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_create_eventset",retval);
+	}
+
+	retval = PAPI_assign_eventset_component(EventSet, 0);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_assign_eventset_component",retval);
+	}
+
+	memset(&opt, 0, sizeof(opt));
+	opt.cpu_vector.eventset = EventSet;
+	opt.cpu_vector.num_cpus = 0;
+	opt.cpu_vector.cpus = NULL;
+	opt.cpu_vector.num_threads = num_threads;
+
+	retval = PAPI_set_opt(PAPI_CPU_VECTOR, &opt);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_set_opt(PAPI_CPU_VECTOR)",retval);
+	}
+
+	for(i=0;i<NUM_EVENTS;i++) {
+		retval = PAPI_add_named_event(EventSet, events[i]);
+		if (retval != PAPI_OK) {
+			if (retval==PAPI_EPERM || retval==PAPI_ECMP) {
+				test_skip( __FILE__, __LINE__,
+					"this test; system-wide events need root or low perf_event_paranoid",
+					retval);
+			}
+			test_fail(__FILE__, __LINE__, events[i], retval);
+		}
+	}
+
+	rows = opt.cpu_vector.num_cpus;
+	if (rows <= 0) {
+		test_fail(__FILE__, __LINE__, "num_cpus not reported", rows);
+	}
+	vector = calloc(rows * NUM_EVENTS, sizeof(long long));
+	if (vector == NULL) {
+		test_fail(__FILE__, __LINE__, "calloc", PAPI_ENOMEM);
+	}
+
+	retval = PAPI_start( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_start", retval );
+	}
+
+	do_flops( NUM_FLOPS );
+
+	/* too small a buffer reports the number of rows needed */
+	i = 0;
+	retval = PAPI_read_vector( EventSet, vector, &i );
+	if ( retval != PAPI_EINVAL || i != rows ) {
+		test_fail( __FILE__, __LINE__, "PAPI_read_vector(rows=0)", retval );
+	}
+
+	retval = PAPI_read_vector( EventSet, vector, &rows );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_read_vector", retval );
+	}
+
+	retval = PAPI_stop( EventSet, values );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_stop", retval );
+	}
+
+	for(j=0;j<NUM_EVENTS;j++) sum[j]=0;
+	for(i=0;i<rows;i++) {
+		if (!quiet) printf("\tcpu row %3d:",i);
+		for(j=0;j<NUM_EVENTS;j++) {
+			if (!quiet) printf(" %12lld",vector[i*NUM_EVENTS+j]);
+			sum[j]+=vector[i*NUM_EVENTS+j];
+		}
+		if (!quiet) printf("\n");
+	}
+
+	if (!quiet) {
+		printf("\tthreads %d, rows %d, sum %lld %lld, stop %lld %lld\n",
+			num_threads, rows, sum[0], sum[1], values[0], values[1]);
+	}
+
+	/* the total at stop includes everything read before it */
+	for(j=0;j<NUM_EVENTS;j++) {
+		if (sum[j] > values[j]) {
+			test_fail( __FILE__, __LINE__, "row sum larger than total", 0 );
+		}
+	}
+	if (sum[0] <= 0) {
+		test_fail( __FILE__, __LINE__, "no cpu time counted", 0 );
+	}
+
+	free(vector);
+
+	retval = PAPI_cleanup_eventset( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_cleanup_eventset", retval );
+	}
+	retval = PAPI_destroy_eventset( &EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_destroy_eventset", retval );
+	}
+}
+
+int main( int argc, char **argv ) {
+
+	int retval;
+	int quiet=0;
+
+	/* Set TESTS_QUIET variable */
+	quiet=tests_quiet( argc, argv );
+
+	/* Init the PAPI library */
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	if (!quiet) {
+		printf("\nCPU-CLOCK and CONTEXT-SWITCHES on every cpu:\n");
+	}
+
+	/* read on the calling thread only, then with reader threads */
+	run_vector( 0, quiet );
+	run_vector( 2, quiet );
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
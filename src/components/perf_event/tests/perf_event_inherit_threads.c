@@ -0,0 +1,145 @@
+/*
+ * This tests the per-thread counts PAPI_INHERIT_THREADS keeps for
+ * inherited children, read back with PAPI_read_inherited()
+ *
+ * Some threads and a forked child do work and exit; each of them
+ * must be reported with its own tid and a nonzero TASK-CLOCK.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#include "do_loops.h"
+
+#define NUM_WORKERS 3
+
+static void *
+worker( void *arg ) {
+
+	( void ) arg;
+	do_flops( NUM_FLOPS );
+	return NULL;
+}
+
+int main( int argc, char **argv ) {
+
+	int retval, i, index, children;
+	int EventSet = PAPI_NULL;
+	int quiet=0;
+	pid_t pid;
+	pthread_t threads[NUM_WORKERS];
+	PAPI_option_t opt;
+	unsigned long tid;
+	long long values[1], total[1], sum;
+
+	/* Set TESTS_QUIET variable */
+	quiet=tests_quiet( argc, argv );
+
+	/* Init the PAPI library */
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	retval = PAPI_create_eventset(&EventSet);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_create_eventset",retval);
+	}
+
+	retval = PAPI_assign_eventset_component(EventSet, 0);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_assign_eventset_component",retval);
+	}
+
+	memset(&opt, 0, sizeof(opt));
+	opt.inherit.eventset = EventSet;
+	opt.inherit.inherit = PAPI_INHERIT_THREADS;
+	retval = PAPI_set_opt(PAPI_INHERIT, &opt);
+	if (retval != PAPI_OK) {
+		/* the permission check opens a hardware event */
+		if (retval==PAPI_ENOEVNT || retval==PAPI_EPERM) {
+			test_skip(__FILE__, __LINE__, "PAPI_set_opt(PAPI_INHERIT)",retval);
+		}
+		test_fail(__FILE__, __LINE__, "PAPI_set_opt(PAPI_INHERIT)",retval);
+	}
+
+	retval = PAPI_add_named_event(EventSet, "perf::TASK-CLOCK");
+	if (retval != PAPI_OK) {
+		test_skip(__FILE__, __LINE__, "perf::TASK-CLOCK", retval);
+	}
+
+	retval = PAPI_start( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_start", retval );
+	}
+
+	for(i=0;i<NUM_WORKERS;i++) {
+		if (pthread_create(&threads[i],NULL,worker,NULL)) {
+			test_fail( __FILE__, __LINE__, "pthread_create", PAPI_ESYS );
+		}
+	}
+	for(i=0;i<NUM_WORKERS;i++) {
+		pthread_join(threads[i],NULL);
+	}
+
+	pid = fork();
+	if (pid == 0) {
+		worker(NULL);
+		_exit(0);
+	}
+	if (pid < 0) {
+		test_fail( __FILE__, __LINE__, "fork", PAPI_ESYS );
+	}
+	waitpid(pid,NULL,0);
+
+	retval = PAPI_stop( EventSet, total );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_stop", retval );
+	}
+
+	if (!quiet) {
+		printf("\nTASK-CLOCK of each exited child:\n");
+	}
+
+	sum=0;
+	children=0;
+	index=0;
+	while((retval=PAPI_read_inherited(EventSet,&index,&tid,values))==PAPI_OK) {
+		if (!quiet) printf("\ttid %8lu: %lld\n",tid,values[0]);
+		if (values[0] <= 0) {
+			test_fail( __FILE__, __LINE__, "child counted nothing", 0 );
+		}
+		sum+=values[0];
+		children++;
+	}
+	if (retval != PAPI_ENOEVNT) {
+		test_fail( __FILE__, __LINE__, "PAPI_read_inherited", retval );
+	}
+
+	if (!quiet) {
+		printf("\t%d children, sum %lld, total %lld\n",children,sum,total[0]);
+	}
+
+	if (children != NUM_WORKERS+1) {
+		test_fail( __FILE__, __LINE__, "wrong number of children", children );
+	}
+	if (sum > total[0]) {
+		test_fail( __FILE__, __LINE__, "children count more than total", 0 );
+	}
+
+	retval = PAPI_cleanup_eventset( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_cleanup_eventset", retval );
+	}
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
@@ -14,6 +14,8 @@
 */
 
 #include <stdio.h>
+#include <ctype.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <string.h>
 #include <errno.h>
@@ -34,6 +36,7 @@
 #include "papi_libpfm4_events.h"
 #include "components/perf_event/pe_libpfm4_events.h"
 #include "perfmon/pfmlib.h"
+#include "perfmon/pfmlib_perf_event.h"
 #include PEINCLUDE
 
 /* Linux-specific includes */
@@ -44,6 +47,7 @@
 #include "linux-context.h"
 
 #include "components/perf_event/perf_event_lib.h"
+#include "components/perf_event/pe_vector.h"
 
 /* Forward declaration */
 papi_vector_t _perf_event_uncore_vector;
@@ -302,6 +306,206 @@ check_scheduability( pe_context_t *ctx, pe_control_t *ctl)
 }
 
 
+/********************************************************************/
+/* Aggregation over all instances of an uncore PMU                  */
+/********************************************************************/
+
+/* An uncore PMU comes as numbered instances, one per box, that   */
+/* libpfm4 names alike ("snbep_unc_imc0" .. "snbep_unc_imc7").     */
+/* The instance number stripped off gives the PMU family.          */
+static void
+pmu_family( const char *pmu, char *family, int len )
+{
+   int n;
+
+   strncpy( family, pmu, len - 1 );
+   family[len - 1] = 0;
+   n = strlen( family );
+   while ( n > 0 && isdigit( ( unsigned char ) family[n - 1] ) ) {
+      family[--n] = 0;
+   }
+}
+
+/* Instances of PAPI_UNCORE_AGGREGATE, allocated when it is set */
+static void
+free_uncore_instances( pe_control_t *ctl )
+{
+   if ( ctl->agg ) papi_free( ctl->agg );
+   ctl->agg = NULL;
+}
+
+/* Find every present instance of the PMU family of ntv_evt and the */
+/* perf type the event gets on each, in libpfm4 PMU order.          */
+static int
+find_uncore_instances( pe_control_t *ctl, struct native_event_t *ntv_evt )
+{
+   pfm_pmu_info_t pinfo;
+   pfm_perf_encode_arg_t perf_arg;
+   struct perf_event_attr attr;
+   char family[PAPI_MIN_STR_LEN], name[PAPI_HUGE_STR_LEN];
+   int pidx, ret;
+
+   pmu_family( ntv_evt->pmu, ctl->agg->pmu, sizeof ( ctl->agg->pmu ) );
+   ctl->agg->num_instances = 0;
+
+   _papi_hwi_lock( NAMELIB_LOCK );
+   pfm_for_all_pmus( pidx ) {
+      memset( &pinfo, 0, sizeof ( pinfo ) );
+      pinfo.size = sizeof ( pinfo );
+      if ( pfm_get_pmu_info( pidx, &pinfo ) != PFM_SUCCESS ) continue;
+      if ( !pinfo.is_present || pinfo.type != PFM_PMU_TYPE_UNCORE ) continue;
+
+      pmu_family( pinfo.name, family, sizeof ( family ) );
+      if ( strcmp( family, ctl->agg->pmu ) ) continue;
+
+      if ( ctl->agg->num_instances == PERF_EVENT_MAX_UNCORE_INSTANCES ) {
+         SUBDBG( "more than %d instances of %s\n",
+		 PERF_EVENT_MAX_UNCORE_INSTANCES, ctl->agg->pmu );
+         break;
+      }
+
+      snprintf( name, sizeof ( name ), "%s::%s%s%s", pinfo.name,
+		ntv_evt->base_name,
+		( ntv_evt->mask_string && ntv_evt->mask_string[0] ) ? ":" : "",
+		ntv_evt->mask_string ? ntv_evt->mask_string : "" );
+
+      memset( &perf_arg, 0, sizeof ( perf_arg ) );
+      memset( &attr, 0, sizeof ( attr ) );
+      attr.size = sizeof ( attr );
+      perf_arg.attr = &attr;
+      ret = pfm_get_os_event_encoding( name, PFM_PLM0 | PFM_PLM3,
+				       PFM_OS_PERF_EVENT_EXT, &perf_arg );
+      if ( ret != PFM_SUCCESS ) {
+         SUBDBG( "cannot encode %s: %s\n", name, pfm_strerror( ret ) );
+         continue;
+      }
+      ctl->agg->instance_type[ctl->agg->num_instances++] = attr.type;
+   }
+   _papi_hwi_unlock( NAMELIB_LOCK );
+
+   SUBDBG( "%d instances of %s\n", ctl->agg->num_instances, ctl->agg->pmu );
+   return ctl->agg->num_instances ? PAPI_OK : PAPI_ENOEVNT;
+}
+
+/* The cpus the kernel wants PMU type counted on, one per socket */
+static int
+uncore_type_cpus( unsigned int type, cpu_set_t *cpus )
+{
+   char path[PATH_MAX], buffer[64];
+   struct dirent *entry;
+   DIR *dir;
+   FILE *fff;
+   int ret = PAPI_ESYS;
+
+   dir = opendir( "/sys/bus/event_source/devices" );
+   if ( dir == NULL ) return PAPI_ESYS;
+
+   while ( ( entry = readdir( dir ) ) != NULL ) {
+      if ( entry->d_name[0] == '.' ) continue;
+      snprintf( path, sizeof ( path ),
+		"/sys/bus/event_source/devices/%s/type", entry->d_name );
+      fff = fopen( path, "r" );
+      if ( fff == NULL ) continue;
+      if ( fgets( buffer, sizeof ( buffer ), fff ) == NULL ||
+	   strtoul( buffer, NULL, 10 ) != type ) {
+         fclose( fff );
+         continue;
+      }
+      fclose( fff );
+
+      snprintf( path, sizeof ( path ),
+		"/sys/bus/event_source/devices/%s/cpumask", entry->d_name );
+      ret = _pe_vector_parse_cpus( path, cpus );
+      break;
+   }
+   closedir( dir );
+
+   return ret;
+}
+
+/* Open every event once per PMU instance and socket.  Rows are  */
+/* instance-major with the socket's cpu ascending, and each row  */
+/* remembers its socket so PAPI_read_vector can sum per socket.  */
+static int
+open_aggregate_events( pe_context_t *ctx, pe_control_t *ctl )
+{
+   cpu_set_t cpus, sockets;
+   int *cpu = NULL, *socket_of = NULL;
+   unsigned int *type = NULL;
+   int k, c, n, num_rows = 0, ret;
+
+   if ( ctl->agg->num_instances == 0 ) return PAPI_ENOEVNT;
+
+   CPU_ZERO( &sockets );
+   for ( k = 0; k < ctl->agg->num_instances; k++ ) {
+      if ( uncore_type_cpus( ctl->agg->instance_type[k], &cpus ) != PAPI_OK ) {
+         CPU_ZERO( &cpus );
+         CPU_SET( ctl->events[0].cpu >= 0 ? ctl->events[0].cpu : 0, &cpus );
+      }
+      CPU_OR( &sockets, &sockets, &cpus );
+      num_rows += CPU_COUNT( &cpus );
+   }
+
+   cpu = papi_malloc( num_rows * sizeof ( int ) );
+   type = papi_malloc( num_rows * sizeof ( unsigned int ) );
+   socket_of = papi_malloc( CPU_SETSIZE * sizeof ( int ) );
+   ctl->row_socket = papi_malloc( num_rows * sizeof ( int ) );
+   if ( !cpu || !type || !socket_of || !ctl->row_socket ) {
+      ret = PAPI_ENOMEM;
+      goto out;
+   }
+
+   /* sockets are numbered by their counting cpu */
+   for ( c = 0, n = 0; c < CPU_SETSIZE; c++ ) {
+      if ( CPU_ISSET( c, &sockets ) ) socket_of[c] = n++;
+   }
+   ctl->num_sockets = n;
+
+   for ( k = 0, n = 0; k < ctl->agg->num_instances; k++ ) {
+      if ( uncore_type_cpus( ctl->agg->instance_type[k], &cpus ) != PAPI_OK ) {
+         CPU_ZERO( &cpus );
+         CPU_SET( ctl->events[0].cpu >= 0 ? ctl->events[0].cpu : 0, &cpus );
+      }
+      for ( c = 0; c < CPU_SETSIZE && n < num_rows; c++ ) {
+         if ( !CPU_ISSET( c, &cpus ) ) continue;
+         cpu[n] = c;
+         type[n] = ctl->agg->instance_type[k];
+         ctl->row_socket[n] = socket_of[c];
+         n++;
+      }
+   }
+
+   ctl->socket_counts = papi_calloc( ( size_t ) ctl->num_sockets *
+				     ctl->num_events, sizeof ( long long ) );
+   if ( ctl->socket_counts == NULL ) {
+      ret = PAPI_ENOMEM;
+      goto out;
+   }
+
+   ret = _pe_vector_open_rows( &ctl->vec, ctl->events, ctl->num_events,
+			       n, cpu, type, 0, -1, 0 );
+   if ( ret == PAPI_ESYS ) {
+      ret = map_perf_event_errors_to_papi( errno );
+   }
+   if ( ret == PAPI_OK ) {
+      ctx->state |= PERF_EVENTS_OPENED;
+   }
+
+out:
+   if ( cpu ) papi_free( cpu );
+   if ( type ) papi_free( type );
+   if ( socket_of ) papi_free( socket_of );
+   if ( ret != PAPI_OK ) {
+      if ( ctl->row_socket ) papi_free( ctl->row_socket );
+      if ( ctl->socket_counts ) papi_free( ctl->socket_counts );
+      ctl->row_socket = NULL;
+      ctl->socket_counts = NULL;
+      ctl->num_sockets = 0;
+   }
+   return ret;
+}
+
+
 /* Open all events in the control state */
 static int
 open_pe_events( pe_context_t *ctx, pe_control_t *ctl )
@@ -310,6 +514,10 @@ open_pe_events( pe_context_t *ctx, pe_control_t *ctl )
    int i, ret = PAPI_OK;
    long pid;
 
+   if (ctl->aggregate) {
+      return open_aggregate_events( ctx, ctl );
+   }
+
    if (ctl->granularity==PAPI_GRN_SYS) {
       pid = -1;
    }
@@ -462,6 +670,18 @@ close_pe_events( pe_context_t *ctx, pe_control_t *ctl )
       SUBDBG("Closing without stopping first\n");
    }
 
+   if ( ctl->vec.num_rows ) {
+      i = _pe_vector_close( &ctl->vec );
+      if ( ctl->row_socket ) papi_free( ctl->row_socket );
+      if ( ctl->socket_counts ) papi_free( ctl->socket_counts );
+      ctl->row_socket = NULL;
+      ctl->socket_counts = NULL;
+      ctl->num_sockets = 0;
+      ctl->num_events = 0;
+      ctx->state &= ~PERF_EVENTS_OPENED;
+      return i;
+   }
+
    /* Close child events first */
    for( i=0; i<ctl->num_events; i++ ) {
 
@@ -586,6 +806,19 @@ _peu_init_control_state( hwd_control_state_t *ctl )
   return PAPI_OK;
 }
 
+/* Release the aggregation state before the framework frees the */
+/* control state                                                 */
+static int
+_peu_cleanup_eventset( hwd_control_state_t *ctl )
+{
+  pe_control_t *pe_ctl = ( pe_control_t *) ctl;
+
+  pe_ctl->aggregate = 0;
+  pe_ctl->per_socket = 0;
+  free_uncore_instances( pe_ctl );
+  return PAPI_OK;
+}
+
 
 
 /* Initialize the perf_event uncore component */
@@ -752,6 +985,22 @@ _peu_update_control_state( hwd_control_state_t *ctl,
 			// this native index is positive so there was a mask with the event, the ntv_idx identifies which native event to use
 			ntv_evt = (struct native_event_t *)(&(pe_ctx->event_table->native_events[ntv_idx]));
 
+			// an aggregated event set counts the instances of one PMU family,
+			// found from its first event; the others must belong to it too
+			if (pe_ctl->aggregate) {
+				if (i == 0) {
+					ret = find_uncore_instances(pe_ctl, ntv_evt);
+					if (ret != PAPI_OK) return ret;
+				} else {
+					char family[PAPI_MIN_STR_LEN];
+					pmu_family(ntv_evt->pmu, family, sizeof(family));
+					if (strcmp(family, pe_ctl->agg->pmu)) {
+						SUBDBG("%s is not an instance of %s\n", ntv_evt->pmu, pe_ctl->agg->pmu);
+						return PAPI_ECNFLCT;
+					}
+				}
+			}
+
 			SUBDBG("ntv_evt: %p\n", ntv_evt);
 
 			SUBDBG("i: %d, pe_ctx->event_table->num_native_events: %d\n", i, pe_ctx->event_table->num_native_events);
@@ -860,6 +1109,10 @@ _peu_reset( hwd_context_t *ctx, hwd_control_state_t *ctl )
 
    ( void ) ctx;			 /*unused */
 
+   if ( pe_ctl->aggregate ) {
+      return _pe_vector_ioctl( &pe_ctl->vec, PERF_EVENT_IOC_RESET );
+   }
+
    /* We need to reset all of the events, not just the group leaders */
    for( i = 0; i < pe_ctl->num_events; i++ ) {
       ret = ioctl( pe_ctl->events[i].event_fd, PERF_EVENT_IOC_RESET, NULL );
@@ -921,8 +1174,16 @@ _peu_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
    long long papi_pe_buffer[READ_BUFFER_SIZE];
    long long tot_time_running, tot_time_enabled, scale;
 
+   /* Aggregated events: the sum over all instances and sockets */
+   if (pe_ctl->aggregate) {
+      ret = _pe_vector_read( &pe_ctl->vec );
+      if ( ret != PAPI_OK ) return ret;
+      memcpy( pe_ctl->counts, pe_ctl->vec.sum,
+	      pe_ctl->num_events * sizeof ( long long ) );
+   }
+
    /* Handle case where we are multiplexing */
-   if (pe_ctl->multiplexed) {
+   else if (pe_ctl->multiplexed) {
 
       /* currently we handle multiplexing by having individual events */
       /* so we read from each in turn.                                */
@@ -1070,6 +1331,49 @@ _peu_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
    return PAPI_OK;
 }
 
+/* Read an aggregated event set one row per instance and socket, */
+/* or summed into one row per socket                             */
+static int
+_peu_read_vector( hwd_context_t *ctx, hwd_control_state_t *ctl,
+	       long long **events, int *rows, int *row_len )
+{
+   pe_control_t *pe_ctl = ( pe_control_t *) ctl;
+   long long *counts, *socket;
+   int ret, row, i;
+
+   ( void ) ctx;			 /*unused */
+
+   if ( !pe_ctl->aggregate ) {
+      return PAPI_EINVAL;
+   }
+
+   ret = _pe_vector_read( &pe_ctl->vec );
+   if ( ret != PAPI_OK ) return ret;
+
+   *row_len = pe_ctl->vec.num_events;
+
+   if ( !pe_ctl->per_socket ) {
+      *events = pe_ctl->vec.counts;
+      *rows = pe_ctl->vec.num_rows;
+      return PAPI_OK;
+   }
+
+   memset( pe_ctl->socket_counts, 0, ( size_t ) pe_ctl->num_sockets *
+	   pe_ctl->vec.num_events * sizeof ( long long ) );
+   for ( row = 0; row < pe_ctl->vec.num_rows; row++ ) {
+      counts = pe_ctl->vec.counts + ( size_t ) row * pe_ctl->vec.num_events;
+      socket = pe_ctl->socket_counts +
+	       ( size_t ) pe_ctl->row_socket[row] * pe_ctl->vec.num_events;
+      for ( i = 0; i < pe_ctl->vec.num_events; i++ ) {
+         socket[i] += counts[i];
+      }
+   }
+
+   *events = pe_ctl->socket_counts;
+   *rows = pe_ctl->num_sockets;
+   return PAPI_OK;
+}
+
 /* Start counting events */
 static int
 _peu_start( hwd_context_t *ctx, hwd_control_state_t *ctl )
@@ -1086,6 +1390,13 @@ _peu_start( hwd_context_t *ctx, hwd_control_state_t *ctl )
       return ret;
    }
 
+   if ( pe_ctl->aggregate ) {
+      ret = _pe_vector_ioctl( &pe_ctl->vec, PERF_EVENT_IOC_ENABLE );
+      if ( ret != PAPI_OK ) return ret;
+      pe_ctx->state |= PERF_EVENTS_RUNNING;
+      return PAPI_OK;
+   }
+
    /* Enable all of the group leaders                */
    /* All group leaders have a group_leader_fd of -1 */
    for( i = 0; i < pe_ctl->num_events; i++ ) {
@@ -1124,6 +1435,13 @@ _peu_stop( hwd_context_t *ctx, hwd_control_state_t *ctl )
    pe_context_t *pe_ctx = ( pe_context_t *) ctx;
    pe_control_t *pe_ctl = ( pe_control_t *) ctl;
 
+   if ( pe_ctl->aggregate ) {
+      ret = _pe_vector_ioctl( &pe_ctl->vec, PERF_EVENT_IOC_DISABLE );
+      if ( ret != PAPI_OK ) return ret;
+      pe_ctx->state &= ~PERF_EVENTS_RUNNING;
+      return PAPI_OK;
+   }
+
    /* Just disable the group leaders */
    for ( i = 0; i < pe_ctl->num_events; i++ ) {
       if ( pe_ctl->events[i].group_leader_fd == -1 ) {
@@ -1154,6 +1472,11 @@ _peu_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
       case PAPI_MULTIPLEX:
 	   pe_ctl = ( pe_control_t * ) ( option->multiplex.ESI->ctl_state );
 
+	   /* aggregated groups are read whole, they cannot rotate */
+	   if (pe_ctl->aggregate) {
+	      return PAPI_ECMP;
+	   }
+
 	   pe_ctl->multiplexed = 1;
 	   ret = _peu_update_control_state( pe_ctl, NULL,
 						pe_ctl->num_events, pe_ctx );
@@ -1165,6 +1488,10 @@ _peu_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
       case PAPI_ATTACH:
 	   pe_ctl = ( pe_control_t * ) ( option->attach.ESI->ctl_state );
 
+	   if (pe_ctl->aggregate) {
+	      return PAPI_ECMP;
+	   }
+
 	   pe_ctl->tid = option->attach.tid;
 
 	   /* If events have been already been added, something may */
@@ -1183,6 +1510,11 @@ _peu_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
       case PAPI_CPU_ATTACH:
 	   pe_ctl = ( pe_control_t *) ( option->cpu.ESI->ctl_state );
 
+	   /* an aggregated event set already picks its cpus per socket */
+	   if (pe_ctl->aggregate) {
+	      return PAPI_ECMP;
+	   }
+
 	   /* this tells the kernel not to count for a thread   */
 	   /* should we warn if we try to set both?  perf_event */
 	   /* will reject it.                                   */
@@ -1228,6 +1560,10 @@ _peu_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
       case PAPI_INHERIT:
 	   pe_ctl = (pe_control_t *) ( option->inherit.ESI->ctl_state );
 
+	   if (pe_ctl->aggregate && option->inherit.inherit) {
+	      return PAPI_ECMP;
+	   }
+
 	   if (option->inherit.inherit) {
 	      /* children will inherit counters */
 	      pe_ctl->inherit = 1;
@@ -1237,6 +1573,37 @@ _peu_ctl( hwd_context_t *ctx, int code, _papi_int_option_t *option )
 	   }
 	   return PAPI_OK;
 
+      case PAPI_UNCORE_AGGREGATE:
+	   pe_ctl = (pe_control_t *) ( option->uncore_aggregate.ESI->ctl_state );
+
+	   if (!option->uncore_aggregate.aggregate) {
+	      pe_ctl->per_socket = 0;
+	      if (!pe_ctl->aggregate) return PAPI_OK;
+	      pe_ctl->aggregate = 0;
+	      free_uncore_instances( pe_ctl );
+	      if (pe_ctl->num_events == 0) return PAPI_OK;
+	      return _peu_update_control_state( pe_ctl, NULL,
+						pe_ctl->num_events, pe_ctx );
+	   }
+
+	   if (pe_ctl->multiplexed) {
+	      return PAPI_ECMP;
+	   }
+
+	   /* the instances are found from the names of the events as */
+	   /* they are added, so this has to come first                */
+	   if (!pe_ctl->aggregate && pe_ctl->num_events) {
+	      return PAPI_EINVAL;
+	   }
+
+	   if (pe_ctl->agg == NULL) {
+	      pe_ctl->agg = papi_calloc( 1, sizeof ( pe_uncore_instances_t ) );
+	      if (pe_ctl->agg == NULL) return PAPI_ENOMEM;
+	   }
+	   pe_ctl->aggregate = 1;
+	   pe_ctl->per_socket = (option->uncore_aggregate.per_socket != 0);
+	   return PAPI_OK;
+
       case PAPI_DATA_ADDRESS:
 	   return PAPI_ENOSUPP;
 
@@ -1269,13 +1636,71 @@ _peu_ntv_enum_events( unsigned int *PapiEventCode, int modifier )
                                        &uncore_native_event_table);
 }
 
+/* "imc::UNC_M_CAS_COUNT:RD" names the first present instance of  */
+/* the PMU family imc, here e.g. snbep_unc_imc0; the other instances */
+/* are added to the count with PAPI_UNCORE_AGGREGATE.                */
+static int
+uncore_family_name( const char *name, char *full, int len )
+{
+   pfm_pmu_info_t pinfo;
+   char family[PAPI_MIN_STR_LEN], short_name[PAPI_MIN_STR_LEN];
+   const char *event;
+   int pidx, n, flen, best = -1, best_num = 0, num;
+
+   event = strstr( name, "::" );
+   if ( event == NULL || event == name ||
+	event - name >= ( int ) sizeof ( short_name ) ) {
+      return PAPI_ENOEVNT;
+   }
+   strncpy( short_name, name, event - name );
+   short_name[event - name] = 0;
+
+   pfm_for_all_pmus( pidx ) {
+      memset( &pinfo, 0, sizeof ( pinfo ) );
+      pinfo.size = sizeof ( pinfo );
+      if ( pfm_get_pmu_info( pidx, &pinfo ) != PFM_SUCCESS ) continue;
+      if ( !pinfo.is_present || pinfo.type != PFM_PMU_TYPE_UNCORE ) continue;
+
+      pmu_family( pinfo.name, family, sizeof ( family ) );
+      n = strlen( short_name );
+      flen = strlen( family );
+      if ( strcmp( family, short_name ) &&
+	   ( flen <= n + 4 || strcmp( family + flen - n, short_name ) ||
+	     strncmp( family + flen - n - 4, "unc_", 4 ) ) ) {
+         continue;
+      }
+
+      num = atoi( pinfo.name + flen );
+      if ( best < 0 || num < best_num ) {
+         best = pidx;
+         best_num = num;
+      }
+   }
+   if ( best < 0 ) return PAPI_ENOEVNT;
+
+   memset( &pinfo, 0, sizeof ( pinfo ) );
+   pinfo.size = sizeof ( pinfo );
+   pfm_get_pmu_info( best, &pinfo );
+   snprintf( full, len, "%s%s", pinfo.name, event );
+   return PAPI_OK;
+}
+
 static int
 _peu_ntv_name_to_code( const char *name, unsigned int *event_code) {
 
+  char full[PAPI_HUGE_STR_LEN];
+  int ret;
+
   if (_perf_event_uncore_vector.cmp_info.disabled) return PAPI_ENOEVNT;
 
-  return _pe_libpfm4_ntv_name_to_code(name,event_code, our_cidx,
+  ret = _pe_libpfm4_ntv_name_to_code(name,event_code, our_cidx,
                                         &uncore_native_event_table);
+  if ((ret != PAPI_OK) &&
+      (uncore_family_name(name, full, sizeof(full)) == PAPI_OK)) {
+     ret = _pe_libpfm4_ntv_name_to_code(full,event_code, our_cidx,
+                                          &uncore_native_event_table);
+  }
+  return ret;
 }
 
 static int
@@ -1349,6 +1774,7 @@ papi_vector_t _perf_event_uncore_vector = {
   .shutdown_component =    _peu_shutdown_component,
   .init_thread =           _peu_init_thread,
   .init_control_state =    _peu_init_control_state,
+  .cleanup_eventset =      _peu_cleanup_eventset,
   .start =                 _peu_start,
   .stop =                  _peu_stop,
   .read =                  _peu_read,
@@ -1358,6 +1784,7 @@ papi_vector_t _perf_event_uncore_vector = {
   .set_domain =            _peu_set_domain,
   .reset =                 _peu_reset,
   .write =                 _peu_write,
+  .read_vector =           _peu_read_vector,
 
   /* from counter name mapper */
   .ntv_enum_events =   _peu_ntv_enum_events,
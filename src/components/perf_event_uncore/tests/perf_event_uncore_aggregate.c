@@ -0,0 +1,168 @@
+/*
+ * This tests counting an uncore event on every instance and socket
+ * of its PMU with PAPI_UNCORE_AGGREGATE, and reading the instances
+ * and the per-socket sums with PAPI_read_vector()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#include "do_loops.h"
+
+#include "perf_event_uncore_lib.h"
+
+/* Count for a while with per-instance or per-socket rows and    */
+/* check that the rows read while running stay within the total. */
+static int
+measure( int EventSet, int per_socket, int quiet )
+{
+	PAPI_option_t opt;
+	long long values[1], sum, *vector;
+	int retval, i, rows = 0;
+
+	/* only the row layout changes, so this may follow the add */
+	memset(&opt, 0, sizeof(opt));
+	opt.uncore_aggregate.eventset = EventSet;
+	opt.uncore_aggregate.aggregate = 1;
+	opt.uncore_aggregate.per_socket = per_socket;
+	retval = PAPI_set_opt(PAPI_UNCORE_AGGREGATE, &opt);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_set_opt(per_socket)", retval);
+	}
+
+	retval = PAPI_start( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_start", retval );
+	}
+
+	do_flops( NUM_FLOPS );
+
+	/* ask how many rows there are */
+	retval = PAPI_read_vector( EventSet, values, &rows );
+	if ( retval != PAPI_EINVAL || rows <= 0 ) {
+		test_fail( __FILE__, __LINE__, "PAPI_read_vector(rows=0)", retval );
+	}
+	vector = calloc( rows, sizeof(long long) );
+	if (vector == NULL) {
+		test_fail(__FILE__, __LINE__, "calloc", PAPI_ENOMEM);
+	}
+
+	retval = PAPI_read_vector( EventSet, vector, &rows );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_read_vector", retval );
+	}
+
+	retval = PAPI_stop( EventSet, values );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_stop", retval );
+	}
+
+	for(sum=0,i=0;i<rows;i++) {
+		if (!quiet) {
+			printf("\t%s %3d: %lld\n",
+				per_socket?"socket":"row",i,vector[i]);
+		}
+		sum+=vector[i];
+	}
+	if (!quiet) printf("\ttotal: %lld\n",values[0]);
+
+	if (sum > values[0]) {
+		test_fail( __FILE__, __LINE__, "row sum larger than total", 0 );
+	}
+
+	free(vector);
+	return rows;
+}
+
+int main( int argc, char **argv ) {
+
+	int retval,quiet,rows,sockets;
+	int EventSet = PAPI_NULL;
+	char *uncore_event=NULL;
+	char event_name[BUFSIZ];
+	int uncore_cidx=-1;
+	const PAPI_component_info_t *info;
+	PAPI_option_t opt;
+
+	/* Set TESTS_QUIET variable */
+	quiet = tests_quiet( argc, argv );
+
+	/* Init the PAPI library */
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	/* Find the uncore PMU */
+	uncore_cidx=PAPI_get_component_index("perf_event_uncore");
+	if (uncore_cidx<0) {
+		test_skip(__FILE__,__LINE__,"perf_event_uncore component not found",0);
+	}
+
+	/* Check if component disabled */
+	info=PAPI_get_component_info(uncore_cidx);
+	if (info->disabled) {
+		test_skip(__FILE__,__LINE__,"uncore component disabled",0);
+	}
+
+	/* Get a relevant event name */
+	uncore_event=get_uncore_event(event_name, BUFSIZ);
+	if (uncore_event==NULL) {
+		test_skip( __FILE__, __LINE__,
+			"PAPI does not support uncore on this processor",
+			PAPI_ENOSUPP );
+	}
+
+	/* Create an eventset */
+	retval = PAPI_create_eventset(&EventSet);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_create_eventset",retval);
+	}
+
+	retval = PAPI_assign_eventset_component(EventSet, uncore_cidx);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_assign_eventset_component",retval);
+	}
+
+	/* aggregation has to be on before the event is added */
+	memset(&opt, 0, sizeof(opt));
+	opt.uncore_aggregate.eventset = EventSet;
+	opt.uncore_aggregate.aggregate = 1;
+	retval = PAPI_set_opt(PAPI_UNCORE_AGGREGATE, &opt);
+	if (retval != PAPI_OK) {
+		test_fail(__FILE__, __LINE__, "PAPI_set_opt(PAPI_UNCORE_AGGREGATE)",retval);
+	}
+
+	retval = PAPI_add_named_event(EventSet, uncore_event);
+	if (retval != PAPI_OK) {
+		test_skip( __FILE__, __LINE__, uncore_event, retval);
+	}
+
+	if (!quiet) {
+		printf("%s on every instance and socket:\n",uncore_event);
+	}
+
+	rows = measure( EventSet, 0, quiet );
+	sockets = measure( EventSet, 1, quiet );
+
+	if (!quiet) {
+		printf("\t%d instance rows, %d sockets\n",rows,sockets);
+	}
+
+	if (sockets > rows) {
+		test_fail( __FILE__, __LINE__, "more sockets than rows", 0 );
+	}
+
+	retval = PAPI_cleanup_eventset( EventSet );
+	if ( retval != PAPI_OK ) {
+		test_fail( __FILE__, __LINE__, "PAPI_cleanup_eventset", retval );
+	}
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
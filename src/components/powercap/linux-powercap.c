@@ -22,6 +22,7 @@
 #include "papi_internal.h"
 #include "papi_vector.h"
 #include "papi_memory.h"
+#include "energy_sampler.h"
 
 // The following macro follows if a string function has an error. It should 
 // never happen; but it is necessary to prevent compiler warnings. We print 
@@ -42,6 +43,9 @@ typedef struct _powercap_native_event_entry {
   int event_id;
   int type;
   int return_type;
+  char path[128];           /* sysfs file, kept across re-initialization */
+  mode_t flags;             /* mode it is opened with                    */
+  long long max_range;      /* energy events: where the zone wraps       */
   _powercap_register_t resources;
 } _powercap_native_event_entry_t;
 
@@ -49,14 +53,31 @@ typedef struct _powercap_reg_alloc {
     _powercap_register_t ra_bits;
 } _powercap_reg_alloc_t;
 
+#define POWERCAP_SYSFS "/sys/class/powercap"
+
+/* energy_uj counts wrap at max_energy_range_uj, this is assumed if */
+/* a zone doesn't say                                                */
+#define POWERCAP_DEFAULT_RANGE 0x100000000LL
+
+/* enough for any value in a powercap attribute file */
+#define POWERCAP_VALUE_LEN 32
+
+/* what read_powercap_fd() returns when the file can't be read, the */
+/* attributes themselves are never negative                          */
+#define POWERCAP_READ_ERROR -1LL
+
 static char read_buff[PAPI_MAX_STR_LEN];
 static char write_buff[PAPI_MAX_STR_LEN];
 
-static long long max_pkg_energy_count;
-static long long max_component_energy_count;
-
 static int num_events=0;
 
+/* Zone discovery walks sysfs once; a later PAPI_library_init() only */
+/* reopens the files found then                                      */
+static int zones_discovered=0;
+
+/* set when PAPI_POWERCAP_SAMPLE_INTERVAL asks for background sampling */
+static energy_sampler_t *sampler=NULL;
+
 // package events
 #define PKG_ENERGY                  0
 #define PKG_MAX_ENERGY_RANGE        1
@@ -103,6 +124,10 @@ typedef struct _powercap_control_state {
   long long need_difference[POWERCAP_MAX_COUNTERS];
   long long lastupdate;
   int active_counters;
+  /* read plan for the active counters, set in update_control_state */
+  int fd[POWERCAP_MAX_COUNTERS];
+  long long max_range[POWERCAP_MAX_COUNTERS];
+  long long value[POWERCAP_MAX_COUNTERS];
 } _powercap_control_state_t;
 
 typedef struct _powercap_context {
@@ -131,12 +156,136 @@ static char * _local_strlcpy( char *dst, const char *src, size_t size )
   return( retval );
 }
 
-static long long read_powercap_value( int index )
+static long long read_powercap_fd( int fd )
+{
+  char buff[POWERCAP_VALUE_LEN];
+  ssize_t sz = pread(fd, buff, sizeof(buff) - 1, 0);
+
+  if (sz <= 0) return POWERCAP_READ_ERROR;
+  buff[sz] = '\0';
+
+  return strtoll(buff, NULL, 10);
+}
+
+/* Refresh every active counter of a control state: one pread() per */
+/* zone file on fds that stay open, before any value is processed.  */
+/* With the sampler running, energy counters are its 64-bit totals. */
+static int read_powercap_values( _powercap_control_state_t *control )
+{
+  int c;
+
+  for( c = 0; c < control->active_counters; c++ ) {
+    if (sampler && control->need_difference[c]) {
+      control->value[c] = _papi_energy_sampler_total(sampler, control->which_counter[c]);
+    } else {
+      control->value[c] = read_powercap_fd(control->fd[c]);
+      if (control->value[c] == POWERCAP_READ_ERROR) {
+        SUBDBG("Could not read %s\n", powercap_ntv_events[control->which_counter[c]].path);
+        return PAPI_ESYS;
+      }
+    }
+  }
+  return PAPI_OK;
+}
+
+/* The sampler has no way to report a failed read, so it is given the */
+/* previous value again and that interval counts as no energy used.   */
+static long long sample_powercap_value( int index )
 {
-  int sz = pread(event_fds[index], read_buff, PAPI_MAX_STR_LEN, 0);
-  read_buff[sz] = '\0';
+  static long long last[POWERCAP_MAX_COUNTERS];
+  long long value = read_powercap_fd(event_fds[index]);
 
-  return atoll(read_buff);
+  if (value == POWERCAP_READ_ERROR) return last[index];
+  last[index] = value;
+  return value;
+}
+
+static void start_powercap_sampler( void )
+{
+  energy_channel_t channel[POWERCAP_MAX_COUNTERS];
+  int e;
+
+  for (e = 0; e < num_events; e++) {
+    channel[e].name = powercap_ntv_events[e].name;
+    channel[e].range = powercap_ntv_events[e].max_range;
+    channel[e].joules = 1e-6;
+  }
+  sampler = _papi_energy_sampler_start("PAPI_POWERCAP", channel, num_events,
+                                       sample_powercap_value);
+}
+
+/* Energy used between two readings of a counter that wraps at range */
+static long long powercap_difference( long long start, long long curr,
+                                      long long range )
+{
+  if (curr >= start) return curr - start;
+
+  SUBDBG("Wraparound!\nstart value:\t%lld,\tcurrent value:%lld\n", start, curr);
+  return range - start + curr;
+}
+
+/* Cache one sysfs file of a zone as native event num_events */
+static int add_powercap_event( const char *events_dir, const char *sys_name,
+                               int type, mode_t flags, const char *name_fmt,
+                               const char *event_name, int s, int c )
+{
+  _powercap_native_event_entry_t *entry;
+  long unsigned int strErr;
+  char range_path[128];
+  int fd;
+
+  if (num_events >= POWERCAP_MAX_COUNTERS) {
+    SUBDBG("Too many powercap events, ignoring %s%s\n", events_dir, sys_name);
+    return PAPI_ENOMEM;
+  }
+  entry = &powercap_ntv_events[num_events];
+
+  // compose string to individual event
+  strErr=snprintf(entry->path, sizeof(entry->path), "%s%s", events_dir, sys_name);
+  entry->path[sizeof(entry->path)-1]=0;
+  if (strErr > sizeof(entry->path)) HANDLE_STRING_ERROR;
+
+  // not a valid event path so continue
+  if (access(entry->path, R_OK) == -1) { return PAPI_ENOEVNT; }
+
+  strErr=snprintf(entry->name, sizeof(entry->name), name_fmt, event_name, s, c);
+  entry->name[sizeof(entry->name)-1]=0;
+  if (strErr > sizeof(entry->name)) HANDLE_STRING_ERROR;
+  entry->return_type = PAPI_DATATYPE_UINT64;
+  entry->type = type;
+  entry->resources.selector = num_events + 1;
+  entry->flags = flags;
+
+  if ((type == PKG_NAME) || (type == COMPONENT_NAME)) {
+    fd = open(entry->path, O_RDONLY);
+    if (fd != -1) {
+      int sz = pread(fd, read_buff, PAPI_MAX_STR_LEN - 1, 0);
+      read_buff[sz > 0 ? sz : 0] = '\0';
+      close(fd);
+    } else {
+      read_buff[0] = '\0';
+    }
+    strErr=snprintf(entry->description, sizeof(entry->description), "%s", read_buff);
+    entry->description[sizeof(entry->description)-1]=0;
+    if (strErr > sizeof(entry->description)) HANDLE_STRING_ERROR;
+  }
+
+  /* each zone wraps at its own range */
+  if ((type == PKG_ENERGY) || (type == COMPONENT_ENERGY)) {
+    strErr=snprintf(range_path, sizeof(range_path), "%smax_energy_range_uj", events_dir);
+    range_path[sizeof(range_path)-1]=0;
+    if (strErr > sizeof(range_path)) HANDLE_STRING_ERROR;
+    entry->max_range = 0;
+    fd = open(range_path, O_RDONLY);
+    if (fd != -1) {
+      entry->max_range = read_powercap_fd(fd);
+      close(fd);
+    }
+    if (entry->max_range <= 0) entry->max_range = POWERCAP_DEFAULT_RANGE;
+  }
+
+  num_events++;
+  return PAPI_OK;
 }
 
 static int write_powercap_value( int index, long long value )
@@ -167,7 +316,8 @@ static int _powercap_init_component( int cidx )
 {
     int retval = PAPI_OK;
   int num_sockets = -1;
-  int s = -1, e = -1, c = -1;
+  int s = -1, e = -1, c = -1, s_dir;
+  int *zone_dir;
   long unsigned int strErr;
 
   char events_dir[128];
@@ -191,141 +341,87 @@ static int _powercap_init_component( int cidx )
   // store number of sockets for adding events
   num_sockets = hw_info->sockets;
 
+  // zones were found by an earlier init, only the files need reopening
+  if (zones_discovered) goto open_events;
+
+  // Find the directory corresponding to each socket number.  There may be other top-level entries in there
+  // besides packages, such as "psys", that mess up the numbering, so all of them are looked at once.
+  zone_dir = papi_calloc(num_sockets > 0 ? num_sockets : 1, sizeof(int));
+  if (zone_dir == NULL) {
+    strCpy=strncpy(_powercap_vector.cmp_info.disabled_reason, "Out of memory", PAPI_MAX_STR_LEN);
+    if (strCpy == NULL) HANDLE_STRING_ERROR;
+    retval = PAPI_ENOMEM;
+    goto fn_fail;
+  }
+  for(s = 0; s < num_sockets; s++) zone_dir[s] = -1;
+
+  for(s_dir = 0; ; s_dir++) {
+    strErr=snprintf(event_path, sizeof(event_path), POWERCAP_SYSFS "/intel-rapl:%d/%s", s_dir, pkg_sys_names[PKG_NAME]);
+    event_path[sizeof(event_path)-1]=0;
+    if (strErr > sizeof(event_path)) HANDLE_STRING_ERROR;
+
+    int event_fd;
+    event_fd = open(event_path, pkg_sys_flags[PKG_NAME]);
+    if (event_fd == -1) { break; }
+
+    int sz = pread(event_fd, read_buff, PAPI_MAX_STR_LEN - 1, 0);
+    read_buff[sz > 0 ? sz : 0] = '\0';
+    close(event_fd);
+
+    if (strncmp(read_buff, "package-", strlen("package-")) == 0) {
+      s = strtol(read_buff + strlen("package-"), NULL, 10);
+      if (s >= 0 && s < num_sockets && zone_dir[s] == -1) zone_dir[s] = s_dir;
+    }
+  }
+
   num_events = 0;
   for(s = 0; s < num_sockets; s++) {
 
-    // Find the directory corresponding to the socket number.  There may be other top-level entries in there
-    // besides packages, such as "psys", that mess up the numbering, so we conduct an exhaustive search.
-    int s_dir, found = 0;
-    for(s_dir = 0; ; s_dir++) {
-      strErr=snprintf(event_path, sizeof(event_path), "/sys/class/powercap/intel-rapl:%d/%s", s_dir, pkg_sys_names[PKG_NAME]);
-      event_path[sizeof(event_path)-1]=0;
-      if (strErr > sizeof(event_path)) HANDLE_STRING_ERROR;
-
-      int event_fd;
-      event_fd = open(event_path, pkg_sys_flags[PKG_NAME]);
-      if (event_fd == -1) { break; }
-
-      int sz = pread(event_fd, read_buff, PAPI_MAX_STR_LEN, 0);
-      read_buff[sz] = '\0';
-      close(event_fd);
-
-      if (strncmp(read_buff, "package-", strlen("package-")) == 0 && strtol(read_buff + strlen("package-"), NULL, 10) == s) {
-        found = 1;
-	break;
-      }
-    }
-    if (!found) { continue; }
+    if (zone_dir[s] == -1) { continue; }
 
     // compose string of a pkg directory path
-    strErr=snprintf(events_dir, sizeof(events_dir), "/sys/class/powercap/intel-rapl:%d/", s_dir);
+    strErr=snprintf(events_dir, sizeof(events_dir), POWERCAP_SYSFS "/intel-rapl:%d/", zone_dir[s]);
     events_dir[sizeof(events_dir)-1]=0;
     if (strErr > sizeof(events_dir)) HANDLE_STRING_ERROR;
 
-    // open directory to make sure it exists
-    events = opendir(events_dir);
-
-    // not a valid pkg/component directory so continue
-    if (events == NULL) { continue; }
-    closedir(events);                                                // opendir has mallocs; so clean up.
-
     // loop through pkg events and create powercap event entries
     for (e = 0; e < PKG_NUM_EVENTS; e++) {
-
-      // compose string to individual event
-      strErr=snprintf(event_path, sizeof(event_path), "%s%s", events_dir, pkg_sys_names[e]);
-      event_path[sizeof(event_path)-1]=0;
-      if (strErr > sizeof(event_path)) HANDLE_STRING_ERROR;
-      // not a valid pkg event path so continue
-
-      if (access(event_path, R_OK) == -1) { continue; }
-
-      strErr=snprintf(powercap_ntv_events[num_events].name, sizeof(powercap_ntv_events[num_events].name), "%s:ZONE%d", pkg_event_names[e], s);
-      powercap_ntv_events[num_events].name[sizeof(powercap_ntv_events[num_events].name)-1]=0;
-      if (strErr > sizeof(powercap_ntv_events[num_events].name)) HANDLE_STRING_ERROR;
-      //snprintf(powercap_ntv_events[num_events].description, sizeof(powercap_ntv_events[num_events].name), "%s:ZONE%d", pkg_event_names[e], s);
-      //snprintf(powercap_ntv_events[num_events].units, sizeof(powercap_ntv_events[num_events].name), "%s:ZONE%d", pkg_event_names[e], s);
-      powercap_ntv_events[num_events].return_type = PAPI_DATATYPE_UINT64;
-      powercap_ntv_events[num_events].type = pkg_events[e];
-
-      powercap_ntv_events[num_events].resources.selector = num_events + 1;
-
-      event_fds[num_events] = open(event_path, O_SYNC|pkg_sys_flags[e]);
-
-      if(powercap_ntv_events[num_events].type == PKG_NAME) {
-        int sz = pread(event_fds[num_events], read_buff, PAPI_MAX_STR_LEN, 0);
-        read_buff[sz] = '\0';
-        strErr=snprintf(powercap_ntv_events[num_events].description, sizeof(powercap_ntv_events[num_events].description), "%s", read_buff);
-        powercap_ntv_events[num_events].description[sizeof(powercap_ntv_events[num_events].description)-1]=0;
-        if (strErr > sizeof(powercap_ntv_events[num_events].description)) HANDLE_STRING_ERROR;
-      }
-
-      if(powercap_ntv_events[num_events].type == PKG_MAX_ENERGY_RANGE) {
-        int sz = pread(event_fds[num_events], read_buff, PAPI_MAX_STR_LEN, 0);
-        read_buff[sz] = '\0';
-        max_pkg_energy_count = atoll(read_buff);
-      }
-
-      num_events++;
+      add_powercap_event(events_dir, pkg_sys_names[e], pkg_events[e],
+                         pkg_sys_flags[e], "%s:ZONE%d", pkg_event_names[e], s, 0);
     }
 
     // reset component count for each socket
     c = 0;
-    strErr=snprintf(events_dir, sizeof(events_dir), "/sys/class/powercap/intel-rapl:%d:%d/", s_dir, c);
+    strErr=snprintf(events_dir, sizeof(events_dir), POWERCAP_SYSFS "/intel-rapl:%d:%d/", zone_dir[s], c);
     events_dir[sizeof(events_dir)-1]=0;
     if (strErr > sizeof(events_dir)) HANDLE_STRING_ERROR;
     while((events = opendir(events_dir)) != NULL) {
       closedir(events);                                                // opendir has mallocs; so clean up.
 
-      // loop through pkg events and create powercap event entries
+      // loop through component events and create powercap event entries
       for (e = 0; e < COMPONENT_NUM_EVENTS; e++) {
-
-        // compose string to individual event
-        strErr=snprintf(event_path, sizeof(event_path), "%s%s", events_dir, component_sys_names[e]);
-        event_path[sizeof(event_path)-1]=0;
-        if (strErr > sizeof(event_path)) HANDLE_STRING_ERROR;
-
-        // not a valid pkg event path so continue
-        if (access(event_path, R_OK) == -1) { continue; }
-
-        strErr=snprintf(powercap_ntv_events[num_events].name, sizeof(powercap_ntv_events[num_events].name), "%s:ZONE%d_SUBZONE%d", component_event_names[e], s, c);
-        powercap_ntv_events[num_events].name[sizeof(powercap_ntv_events[num_events].name)-1]=0;
-        if (strErr > sizeof(powercap_ntv_events[num_events].name)) HANDLE_STRING_ERROR;
-        //snprintf(powercap_ntv_events[num_events].description, sizeof(powercap_ntv_events[num_events].name), "%s:ZONE%d_SUBZONE%d", component_event_names[e], s, c);
-        //snprintf(powercap_ntv_events[num_events].units, sizeof(powercap_ntv_events[num_events].name), "%s:ZONE%d_SUBZONE%d", component_event_names[e], s, c);
-        powercap_ntv_events[num_events].return_type = PAPI_DATATYPE_UINT64;
-        powercap_ntv_events[num_events].type = component_events[e];
-
-        powercap_ntv_events[num_events].resources.selector = num_events + 1;
-
-        event_fds[num_events] = open(event_path, O_SYNC|component_sys_flags[e]);
-
-        if(powercap_ntv_events[num_events].type == COMPONENT_NAME) {
-          int sz = pread(event_fds[num_events], read_buff, PAPI_MAX_STR_LEN, 0);
-          read_buff[sz] = '\0';
-          strErr=snprintf(powercap_ntv_events[num_events].description, sizeof(powercap_ntv_events[num_events].description), "%s", read_buff);
-          powercap_ntv_events[num_events].description[sizeof(powercap_ntv_events[num_events].description)-1]=0;
-          if (strErr > sizeof(powercap_ntv_events[num_events].description)) HANDLE_STRING_ERROR;
-        }
-
-        if(powercap_ntv_events[num_events].type == COMPONENT_MAX_ENERGY_RANGE) {
-          int sz = pread(event_fds[num_events], read_buff, PAPI_MAX_STR_LEN, 0);
-          read_buff[sz] = '\0';
-          max_component_energy_count = atoll(read_buff);
-        }
-
-        num_events++;
+        add_powercap_event(events_dir, component_sys_names[e], component_events[e],
+                           component_sys_flags[e], "%s:ZONE%d_SUBZONE%d", component_event_names[e], s, c);
       }
 
       // test for next component
       c++;
 
       // compose string of an pkg directory path
-      strErr=snprintf(events_dir, sizeof(events_dir), "/sys/class/powercap/intel-rapl:%d:%d/", s_dir, c);
+      strErr=snprintf(events_dir, sizeof(events_dir), POWERCAP_SYSFS "/intel-rapl:%d:%d/", zone_dir[s], c);
       events_dir[sizeof(events_dir)-1]=0;
       if (strErr > sizeof(events_dir)) HANDLE_STRING_ERROR;
     }
   }
+  papi_free(zone_dir);
+  zones_discovered = 1;
+
+open_events:
+  // the files stay open so a read is a single pread() per counter
+  for (e = 0; e < num_events; e++) {
+    event_fds[e] = open(powercap_ntv_events[e].path, O_SYNC|powercap_ntv_events[e].flags);
+  }
+  start_powercap_sampler();
 
   /* Export the total number of events available */
   _powercap_vector.cmp_info.num_native_events = num_events;
@@ -352,26 +448,20 @@ static int _powercap_init_control_state( hwd_control_state_t *ctl )
     _powercap_control_state_t* control = ( _powercap_control_state_t* ) ctl;
     memset( control, 0, sizeof ( _powercap_control_state_t ) );
 
-
-    /* if an event is a counter, set its corresponding flag to 1  */
-    int i;
-    for (i = 0; i < num_events; i++) {
-        if ((powercap_ntv_events[i].type == PKG_ENERGY) || (powercap_ntv_events[i].type == COMPONENT_ENERGY)) {
-            control->need_difference[i] = 1;
-        }
-    }
-
     return PAPI_OK;
 }
 
 static int _powercap_start( hwd_context_t *ctx, hwd_control_state_t *ctl )
 {
     _powercap_context_t* context = ( _powercap_context_t* ) ctx;
-    (void) ctl;
+    _powercap_control_state_t* control = ( _powercap_control_state_t* ) ctl;
+
+    int c, retval;
 
-    int b;
-    for( b = 0; b < num_events; b++ ) {
-      context->start_value[b]=read_powercap_value(b);
+    retval = read_powercap_values(control);
+    if (retval != PAPI_OK) return retval;
+    for( c = 0; c < control->active_counters; c++ ) {
+      context->start_value[control->which_counter[c]]=control->value[c];
     }
 
     return PAPI_OK;
@@ -406,40 +496,24 @@ _powercap_read( hwd_context_t *ctx, hwd_control_state_t *ctl,
 
   long long start_val = 0;
   long long curr_val = 0;
-  int c, i;
+  int c, i, retval;
+
+  retval = read_powercap_values(control);
+  if (retval != PAPI_OK) return retval;
 
   for( c = 0; c < control->active_counters; c++ ) {
     i = map_index_to_counter(ctl, c);
     start_val = context->start_value[i];
-    curr_val = read_powercap_value(i);
+    curr_val = control->value[c];
 
     SUBDBG("%d, start value: %lld, current value %lld\n", i, start_val, curr_val);
 
-    if(start_val) {
-
-      /* Make sure an event is a counter. */
-      if (control->need_difference[i] == 1) {
-
-        /* Wraparound. */
-        if(start_val > curr_val) {
-          SUBDBG("Wraparound!\nstart value:\t%lld,\tcurrent value:%lld\n", start_val, curr_val);
-          if( powercap_ntv_events[i].type == PKG_ENERGY ) {
-            curr_val += (max_pkg_energy_count - start_val);
-          } else if( powercap_ntv_events[i].type == COMPONENT_ENERGY ) {
-            curr_val += (max_component_energy_count - start_val);
-          } else {
-            curr_val += (0x100000000 - start_val);
-          }
-        }
-
-        /* Normal subtraction. */
-        else if (start_val < curr_val) {
-          SUBDBG("Normal subtraction!\nstart value:\t%lld,\tcurrent value:%lld\n", start_val, curr_val);
-          curr_val -= start_val;
-        }
-        SUBDBG("Final value: %lld\n", curr_val);
-
-      }
+    /* Energy counters report what was used since start */
+    if (control->need_difference[c] && sampler) {
+      curr_val -= start_val;
+    } else if (control->need_difference[c]) {
+      curr_val = powercap_difference(start_val, curr_val, control->max_range[c]);
+      SUBDBG("Final value: %lld\n", curr_val);
     }
     control->count[c]=curr_val;
   }
@@ -473,9 +547,13 @@ static int _powercap_shutdown_component( void )
 {
   int i;
 
-  /* Read counters into expected slot */
+  _papi_energy_sampler_stop(sampler);
+  sampler = NULL;
+
+  /* the event table is kept for the next init, only the files close */
   for(i=0;i<num_events;i++) {
-    close(event_fds[i]);
+    if (event_fds[i] != -1) close(event_fds[i]);
+    event_fds[i] = -1;
   }
     return PAPI_OK;
 }
@@ -512,6 +590,13 @@ static int _powercap_update_control_state( hwd_control_state_t *ctl,
     index = native[i].ni_event;
     control->which_counter[i]=index;
     native[i].ni_position = i;
+
+    /* read plan: the file, and for counters where they wrap */
+    control->fd[i] = event_fds[index];
+    control->need_difference[i] =
+      (powercap_ntv_events[index].type == PKG_ENERGY) ||
+      (powercap_ntv_events[index].type == COMPONENT_ENERGY);
+    control->max_range[i] = powercap_ntv_events[index].max_range;
   }
 
   return PAPI_OK;
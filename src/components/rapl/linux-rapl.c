@@ -28,6 +28,7 @@
 #include "papi_internal.h"
 #include "papi_vector.h"
 #include "papi_memory.h"
+#include "energy_sampler.h"
 
 // The following macro follows if a string function has an error. It should 
 // never happen; but it is necessary to prevent compiler warnings. We print 
@@ -160,6 +161,9 @@ static int num_events		= 0;
 struct fd_array_t *fd_array=NULL;
 static int num_packages=0,num_cpus=0;
 
+/* set when PAPI_RAPL_SAMPLE_INTERVAL asks for background sampling */
+static energy_sampler_t *sampler=NULL;
+
 int power_divisor,time_divisor;
 int cpu_energy_divisor,dram_energy_divisor;
 unsigned int msr_rapl_power_unit;
@@ -228,6 +232,45 @@ static long long read_rapl_value(int index) {
 
 }
 
+static int is_rapl_energy(int index) {
+
+   return (rapl_native_events[index].type==PACKAGE_ENERGY ||
+           rapl_native_events[index].type==DRAM_ENERGY ||
+           rapl_native_events[index].type==PLATFORM_ENERGY ||
+           rapl_native_events[index].type==PACKAGE_ENERGY_CNT);
+}
+
+static long long sample_rapl_value(int index) {
+
+   return read_rapl_value(index) & 0xFFFFFFFF;
+}
+
+/* The energy status MSRs are 32 bits wide and can wrap within minutes, */
+/* too fast for an application that reads rarely.  The sampler polls   */
+/* them and keeps 64-bit totals that start and stop only subtract.      */
+static void start_rapl_sampler(void) {
+
+   energy_channel_t *channel;
+   int i;
+
+   channel=papi_calloc(num_events, sizeof(energy_channel_t));
+   if (channel==NULL) return;
+
+   for(i=0;i<num_events;i++) {
+      channel[i].name=rapl_native_events[i].name;
+      if (!is_rapl_energy(i)) continue;
+      channel[i].range=0x100000000LL;
+      if (rapl_native_events[i].msr==MSR_DRAM_ENERGY_STATUS) {
+         channel[i].joules=1.0/dram_energy_divisor;
+      } else {
+         channel[i].joules=1.0/cpu_energy_divisor;
+      }
+   }
+   sampler=_papi_energy_sampler_start("PAPI_RAPL", channel, num_events,
+                                      sample_rapl_value);
+   papi_free(channel);
+}
+
 static long long convert_rapl_energy(int index, long long value) {
 
    union {
@@ -1021,6 +1064,8 @@ _rapl_init_component( int cidx )
      /* Export the component id */
      _rapl_vector.cmp_info.CmpIdx = cidx;
 
+     start_rapl_sampler();
+
   fn_exit:
     _papi_hwd[cidx]->cmp_info.disabled = retval;
      return retval;
@@ -1058,7 +1103,11 @@ _rapl_start( hwd_context_t *ctx, hwd_control_state_t *ctl)
   
   for( i = 0; i < RAPL_MAX_COUNTERS; i++ ) {
      if ((control->being_measured[i]) && (control->need_difference[i])) {
-        context->start_value[i]=(read_rapl_value(i) & 0xFFFFFFFF);
+        if (sampler) {
+           context->start_value[i]=_papi_energy_sampler_total(sampler, i);
+        } else {
+           context->start_value[i]=(read_rapl_value(i) & 0xFFFFFFFF);
+        }
         context->accumulated_value[i]=0;
      }
   }
@@ -1080,6 +1129,12 @@ _rapl_stop( hwd_context_t *ctx, hwd_control_state_t *ctl )
 
    for ( i = 0; i < RAPL_MAX_COUNTERS; i++ ) {
       if (control->being_measured[i]) {
+         if (sampler && control->need_difference[i]) {
+            /* the sampler already accumulated across wraps */
+            temp = _papi_energy_sampler_total(sampler, i) - context->start_value[i];
+            control->count[i] = convert_rapl_energy( i, temp );
+            continue;
+         }
          temp = read_rapl_value(i);
          if (control->need_difference[i]) {
             temp &= 0xFFFFFFFF;
@@ -1136,6 +1191,9 @@ _rapl_shutdown_component( void )
 {
     int i;
 
+    _papi_energy_sampler_stop(sampler);
+    sampler=NULL;
+
     if (rapl_native_events) papi_free(rapl_native_events);
     if (fd_array) {
        for(i=0;i<num_cpus;i++) {
@@ -1186,11 +1244,7 @@ _rapl_update_control_state( hwd_control_state_t *ctl,
        control->being_measured[index]=1;
 
        /* Only need to subtract if it's a PACKAGE_ENERGY or ENERGY_CNT type */
-       control->need_difference[index]=
-	 	(rapl_native_events[index].type==PACKAGE_ENERGY ||
-		rapl_native_events[index].type==DRAM_ENERGY ||
-		rapl_native_events[index].type==PLATFORM_ENERGY ||
-	 	rapl_native_events[index].type==PACKAGE_ENERGY_CNT);
+       control->need_difference[index]=is_rapl_energy(index);
     }
 
     return PAPI_OK;
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sde_lib.h"
+#include "papi.h"
+#include "papi_test.h"
+
+// Enough distinct elements for every shard to grow several times, so inserts and
+// removes keep landing on shards whose previous table is still being drained.
+#define NUM_KEYS 150000
+#define REMOVE_LAG 16
+
+typedef struct key_type_s{
+    int id;
+    double weight;
+} key_type_t;
+
+static uint32_t expected[NUM_KEYS];
+
+static void insert_key(void *cset, int id){
+    key_type_t element;
+
+    element.id = id;
+    element.weight = (double)id/7.0;
+    papi_sde_counting_set_insert( cset, sizeof(element), sizeof(int), &element, 0);
+    expected[id]++;
+}
+
+static void remove_key(void *cset, int id){
+    papi_sde_counting_set_remove( cset, sizeof(int), &id, 0);
+    expected[id]--;
+}
+
+// Compare the listed set against the expected counts of the first num_keys keys.
+static int check_set(cset_list_object_t *list_head, int num_keys){
+    cset_list_object_t *list_runner;
+    key_type_t *ptr;
+    char *seen;
+    int i, listed = 0, nonzero = 0, errors = 0;
+
+    seen = (char *)calloc(num_keys, sizeof(char));
+    for(list_runner = list_head; NULL != list_runner; list_runner=list_runner->next){
+        ptr = (key_type_t *)(list_runner->ptr);
+        ++listed;
+        if( (list_runner->type_size != sizeof(key_type_t)) || (ptr->id < 0) || (ptr->id >= num_keys) ||
+            seen[ptr->id] || (list_runner->count != expected[ptr->id]) || (ptr->weight != (double)ptr->id/7.0) ){
+            ++errors;
+            continue;
+        }
+        seen[ptr->id] = 1;
+    }
+    for(i=0; i<num_keys; i++){
+        if( expected[i] )
+            ++nonzero;
+    }
+    free(seen);
+
+    return (errors || (listed != nonzero)) ? -1 : nonzero;
+}
+
+static void free_list(cset_list_object_t *list_head){
+    cset_list_object_t *next;
+
+    for(; NULL != list_head; list_head = next){
+        next = list_head->next;
+        free(list_head->ptr);
+        free(list_head);
+    }
+}
+
+int main(int argc, char **argv){
+    int i, j, id, ret, quiet, event_set = PAPI_NULL;
+    int mid_cnt = 0, cnt;
+    long long counter_values[1];
+    papi_handle_t handle;
+    void *cset;
+
+    quiet = tests_quiet(argc, argv);
+
+    handle = papi_sde_init("CSET_GROWTH");
+    papi_sde_create_counting_set( handle, "growing set", &cset );
+    if( NULL == cset ){
+        test_fail( __FILE__, __LINE__, "papi_sde_create_counting_set", 0 );
+    }
+
+    // --- Setup PAPI
+    if((ret=PAPI_library_init(PAPI_VER_CURRENT)) != PAPI_VER_CURRENT){
+        test_fail( __FILE__, __LINE__, "PAPI_library_init", ret );
+    }
+    if((ret=PAPI_create_eventset(&event_set)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_create_eventset", ret );
+    }
+    if((ret=PAPI_add_named_event(event_set, "sde:::CSET_GROWTH::growing set")) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_add_named_event", ret );
+    }
+    if((ret=PAPI_start(event_set)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_start", ret );
+    }
+
+    // Key i is inserted 1-3 times. Every 4th key is removed once a few keys later,
+    // and every 8th one is removed completely, so removes hit both the table being
+    // drained and the new one.
+    for(i=0; i<NUM_KEYS; i++){
+        for(j=0; j<=i%3; j++)
+            insert_key(cset, i);
+
+        id = i-REMOVE_LAG;
+        if( (id >= 0) && (0 == id%4) ){
+            remove_key(cset, id);
+            if( 0 == id%8 ){
+                while( expected[id] )
+                    remove_key(cset, id);
+            }
+        }
+
+        // Read the set once while the shards are in the middle of growing.
+        if( i == NUM_KEYS/2 ){
+            if((ret=PAPI_read(event_set, counter_values)) != PAPI_OK){
+                test_fail( __FILE__, __LINE__, "PAPI_read", ret );
+            }
+            mid_cnt = check_set((cset_list_object_t *)counter_values[0], NUM_KEYS);
+            free_list((cset_list_object_t *)counter_values[0]);
+        }
+    }
+
+    if((ret=PAPI_stop(event_set, counter_values)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_stop", ret );
+    }
+    cnt = check_set((cset_list_object_t *)counter_values[0], NUM_KEYS);
+    free_list((cset_list_object_t *)counter_values[0]);
+
+    if( !quiet ){
+        printf("Distinct elements: %d halfway, %d at the end\n", mid_cnt, cnt);
+    }
+
+    if( (mid_cnt <= 0) || (cnt <= 0) ){
+        test_fail( __FILE__, __LINE__, "CountingSet contains wrong elements or counts", 0 );
+    }
+
+    papi_sde_shutdown(handle);
+    test_pass(__FILE__);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+#include "papi.h"
+#include "papi_test.h"
+#include "sde_lib.h"
+#include "sde_lib.hpp"
+
+#define NUM_THREADS 4
+#define NUM_INCREMENTS 100000
+
+papi_sde::PapiSde::FastCounter<long long int> *per_thread_cntr;
+papi_sde::PapiSde::FastCounter<long long int, papi_sde::SharedAtomic> *shared_cntr;
+// More threads than slots, so some of them share the overflow slot.
+papi_sde::PapiSde::FastCounter<int, papi_sde::PerThread<2> > *small_cntr;
+
+void fasttest_init(void){
+    papi_sde::PapiSde sde("Fast Counter Example");
+
+    per_thread_cntr = sde.create_fast_counter<long long int>("PER_THREAD", PAPI_SDE_RO|PAPI_SDE_DELTA);
+    shared_cntr = sde.create_fast_counter<long long int, papi_sde::SharedAtomic>("SHARED", PAPI_SDE_RO|PAPI_SDE_DELTA);
+    small_cntr = sde.create_fast_counter<int, papi_sde::PerThread<2> >("SMALL", PAPI_SDE_RO|PAPI_SDE_INSTANT);
+}
+
+void fasttest_dowork(void){
+    for(int i=0; i<NUM_INCREMENTS; i++){
+        ++(*per_thread_cntr);
+        *shared_cntr += 2;
+        ++(*small_cntr);
+    }
+    --(*small_cntr);
+}
+
+int main(int argc, char **argv){
+    int ret, i, quiet, Eventset = PAPI_NULL;
+    long long counter_values[3];
+    std::vector<std::thread> threads;
+
+    quiet = tests_quiet(argc, argv);
+
+    fasttest_init();
+    if( (nullptr == per_thread_cntr) || (nullptr == shared_cntr) || (nullptr == small_cntr) ){
+        test_fail( __FILE__, __LINE__, "create_fast_counter", 0 );
+    }
+
+    // --- Setup PAPI
+    if((ret=PAPI_library_init(PAPI_VER_CURRENT)) != PAPI_VER_CURRENT){
+        test_fail( __FILE__, __LINE__, "PAPI_library_init", ret );
+        exit(-1);
+    }
+
+    if((ret=PAPI_create_eventset(&Eventset)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_create_eventset", ret );
+        exit(-1);
+    }
+
+    if((ret=PAPI_add_named_event(Eventset, "sde:::Fast Counter Example::PER_THREAD")) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_add_named_event", ret );
+        exit(-1);
+    }
+    if((ret=PAPI_add_named_event(Eventset, "sde:::Fast Counter Example::SHARED")) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_add_named_event", ret );
+        exit(-1);
+    }
+    if((ret=PAPI_add_named_event(Eventset, "sde:::Fast Counter Example::SMALL")) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_add_named_event", ret );
+        exit(-1);
+    }
+
+    // Something counted before PAPI_start() must not show up in a DELTA counter.
+    *per_thread_cntr += 5;
+
+    // --- Start PAPI
+    if((ret=PAPI_start(Eventset)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_start", ret );
+        exit(-1);
+    }
+
+    for(i=0; i<NUM_THREADS; i++)
+        threads.push_back(std::thread(fasttest_dowork));
+    for(i=0; i<NUM_THREADS; i++)
+        threads[i].join();
+
+    // --- Stop PAPI
+    if((ret=PAPI_stop(Eventset, counter_values)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_stop", ret );
+        exit(-1);
+    }
+
+    if( !quiet ){
+        printf("PER_THREAD: %lld SHARED: %lld SMALL: %lld\n", counter_values[0], counter_values[1], counter_values[2]);
+    }
+
+    if( (counter_values[0] != NUM_THREADS*NUM_INCREMENTS) ||
+        (counter_values[1] != 2*NUM_THREADS*NUM_INCREMENTS) ||
+        (counter_values[2] != NUM_THREADS*(NUM_INCREMENTS-1)) ||
+        (per_thread_cntr->read() != NUM_THREADS*NUM_INCREMENTS+5) ){
+        test_fail( __FILE__, __LINE__, "SDE counter values are wrong!", 0 );
+    }
+
+    if((ret=PAPI_cleanup_eventset(Eventset)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_cleanup_eventset", ret );
+        exit(-1);
+    }
+
+    // Deleting a counter unregisters it, so PAPI no longer calls into the deleted object.
+    delete per_thread_cntr;
+    delete shared_cntr;
+    delete small_cntr;
+
+    if( (PAPI_OK == PAPI_add_named_event(Eventset, "sde:::Fast Counter Example::SHARED")) &&
+        (PAPI_OK == PAPI_start(Eventset)) ){
+        PAPI_stop(Eventset, counter_values);
+        // Reading an unregistered event gives -1.
+        if( -1 != counter_values[0] ){
+            test_fail( __FILE__, __LINE__, "Deleted FastCounter is still read", 0 );
+        }
+    }
+
+    test_pass(__FILE__);
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "papi.h"
+#include "papi_test.h"
+#include "sde_lib.h"
+#include "sde_lib.hpp"
+
+#define NUM_THREADS 4
+#define NUM_VALUES 200000
+#define BATCH 100
+// The value recorded by a thread carries the thread number above THREAD_SHIFT.
+#define THREAD_SHIFT 32
+
+papi_sde::PapiSde::Recorder *rcrd;
+std::atomic<int> running;
+
+// Every other batch is recorded one value at a time, the rest with a single record_n() call.
+void recordtest_dowork(long long t){
+    long long values[BATCH];
+    int i, j;
+
+    for(i=0; i<NUM_VALUES; i+=BATCH){
+        for(j=0; j<BATCH; j++)
+            values[j] = (t << THREAD_SHIFT) + i + j;
+        if( (i/BATCH)%2 ){
+            rcrd->record(values, BATCH);
+        }else{
+            for(j=0; j<BATCH; j++)
+                rcrd->record(values[j]);
+        }
+    }
+    running--;
+}
+
+// Every thread's values must all be there, in the order the thread recorded them.
+int check_recording(long long *ptr, long long count){
+    long long next[NUM_THREADS] = {0};
+    long long i, t;
+
+    for(i=0; i<count; i++){
+        t = ptr[i] >> THREAD_SHIFT;
+        if( (t < 0) || (t >= NUM_THREADS) || ((ptr[i] & 0xffffffffLL) != next[t]) )
+            return -1;
+        next[t]++;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    int ret, i, quiet, reads = 0, Eventset = PAPI_NULL;
+    long long counter_values[4], min, max;
+    std::vector<std::thread> threads;
+
+    quiet = tests_quiet(argc, argv);
+
+    papi_sde::PapiSde sde("Threaded Recorder Example");
+    rcrd = sde.create_recorder("VALUES", sizeof(long long), papi_sde_compare_long_long);
+    if( nullptr == rcrd ){
+        test_fail( __FILE__, __LINE__, "create_recorder", 0 );
+    }
+
+    // --- Setup PAPI
+    if((ret=PAPI_library_init(PAPI_VER_CURRENT)) != PAPI_VER_CURRENT){
+        test_fail( __FILE__, __LINE__, "PAPI_library_init", ret );
+    }
+    if((ret=PAPI_create_eventset(&Eventset)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_create_eventset", ret );
+    }
+    if( (PAPI_OK != (ret=PAPI_add_named_event(Eventset, "sde:::Threaded Recorder Example::VALUES:CNT"))) ||
+        (PAPI_OK != (ret=PAPI_add_named_event(Eventset, "sde:::Threaded Recorder Example::VALUES"))) ||
+        (PAPI_OK != (ret=PAPI_add_named_event(Eventset, "sde:::Threaded Recorder Example::VALUES:MIN"))) ||
+        (PAPI_OK != (ret=PAPI_add_named_event(Eventset, "sde:::Threaded Recorder Example::VALUES:MAX"))) ){
+        test_fail( __FILE__, __LINE__, "PAPI_add_named_event", ret );
+    }
+
+    if((ret=PAPI_start(Eventset)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_start", ret );
+    }
+
+    running = NUM_THREADS;
+    for(i=0; i<NUM_THREADS; i++)
+        threads.push_back(std::thread(recordtest_dowork, (long long)i));
+
+    // Merge the thread buffers while the threads are still recording.
+    while( running > 0 ){
+        if((ret=PAPI_read(Eventset, counter_values)) != PAPI_OK){
+            test_fail( __FILE__, __LINE__, "PAPI_read", ret );
+        }
+        if( check_recording((long long *)counter_values[1], counter_values[0]) ){
+            test_fail( __FILE__, __LINE__, "Recorder lost values or their order while recording", 0 );
+        }
+        free((void *)counter_values[1]);
+        free((void *)counter_values[2]);
+        free((void *)counter_values[3]);
+        reads++;
+    }
+
+    for(i=0; i<NUM_THREADS; i++)
+        threads[i].join();
+
+    if((ret=PAPI_stop(Eventset, counter_values)) != PAPI_OK){
+        test_fail( __FILE__, __LINE__, "PAPI_stop", ret );
+    }
+
+    // The :MIN and :MAX values are returned through pointers that the caller frees.
+    min = *(long long *)counter_values[2];
+    max = *(long long *)counter_values[3];
+    free((void *)counter_values[2]);
+    free((void *)counter_values[3]);
+
+    if( !quiet ){
+        printf("CNT: %lld MIN: %lld MAX: %lld after %d concurrent reads\n", counter_values[0], min, max, reads);
+    }
+
+    if( (counter_values[0] != (long long)NUM_THREADS*NUM_VALUES) ||
+        check_recording((long long *)counter_values[1], counter_values[0]) ||
+        (min != 0) ||
+        (max != ((long long)(NUM_THREADS-1) << THREAD_SHIFT) + NUM_VALUES-1) ){
+        test_fail( __FILE__, __LINE__, "SDE recorder values are wrong!", 0 );
+    }
+    free((void *)counter_values[1]);
+
+    test_pass(__FILE__);
+
+    return 0;
+}
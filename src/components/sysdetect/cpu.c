@@ -118,9 +118,16 @@ fill_cpu_info( _sysdetect_cpu_info_t *info )
                  info->numa_memory[a] = 0);
     }
 
-    for (a = 0; a < info->threads * info->cores * info->sockets; ++a) {
+    for (a = 0; a < info->threads * info->cores * info->sockets &&
+                a < PAPI_MAX_NUM_THREADS; ++a) {
         CPU_CALL(cpu_get_attribute_at(CPU_ATTR__HWTHREAD_NUMA_AFFINITY, a, &info->numa_affinity[a]),
                  info->numa_affinity[a] = 0);
+        CPU_CALL(cpu_get_attribute_at(CPU_ATTR__HWTHREAD_CORE_AFFINITY, a, &info->core_affinity[a]),
+                 info->core_affinity[a] = a);
+        CPU_CALL(cpu_get_attribute_at(CPU_ATTR__HWTHREAD_LLC_AFFINITY, a, &info->llc_affinity[a]),
+                 info->llc_affinity[a] = a);
+        CPU_CALL(cpu_get_attribute_at(CPU_ATTR__HWTHREAD_SOCKET_AFFINITY, a, &info->socket_affinity[a]),
+                 info->socket_affinity[a] = 0);
     }
 
     info->cache_levels = level;
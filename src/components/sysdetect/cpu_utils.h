@@ -32,6 +32,9 @@ typedef enum {
     CPU_ATTR__CACHE_UNIF_ASSOCIATIVITY,
     /* Hardware Thread Affinity Attributes */
     CPU_ATTR__HWTHREAD_NUMA_AFFINITY,
+    CPU_ATTR__HWTHREAD_CORE_AFFINITY,
+    CPU_ATTR__HWTHREAD_LLC_AFFINITY,
+    CPU_ATTR__HWTHREAD_SOCKET_AFFINITY,
     /* Memory Attributes */
     CPU_ATTR__NUMA_MEM_SIZE,
 } CPU_attr_e;
@@ -42,6 +42,7 @@ static int get_cache_partition_count( const char *dirname, int *value );
 static int get_cache_set_count( const char *dirname, int *value );
 static int get_mem_info( int node, int *value );
 static int get_thread_affinity( int thread, int *value );
+static int get_thread_topology( CPU_attr_e attr, int thread, int *value );
 static int path_sibling( const char *path, ... );
 static char *search_cpu_info( FILE *fp, const char *key );
 static int path_exist( const char *path, ... );
@@ -248,6 +249,11 @@ linux_cpu_get_attribute_at( CPU_attr_e attr, int loc, int *value )
         case CPU_ATTR__HWTHREAD_NUMA_AFFINITY:
             status = get_thread_affinity(loc, value);
             break;
+        case CPU_ATTR__HWTHREAD_CORE_AFFINITY:
+        case CPU_ATTR__HWTHREAD_LLC_AFFINITY:
+        case CPU_ATTR__HWTHREAD_SOCKET_AFFINITY:
+            status = get_thread_topology(attr, loc, value);
+            break;
         default:
             status = CPU_ERROR;
     }
@@ -771,6 +777,52 @@ get_thread_affinity( int thread, int *val )
     return CPU_SUCCESS;
 }
 
+int
+get_thread_topology( CPU_attr_e attr, int thread, int *val )
+{
+    char filename[PATH_MAX];
+    int index = 0, dflt;
+    FILE *fp;
+
+    /* Cores and caches are named by the first hardware thread in their
+     * sibling list, which is the lowest numbered one */
+    switch(attr) {
+        case CPU_ATTR__HWTHREAD_CORE_AFFINITY:
+            sprintf(filename, _PATH_SYS_SYSTEM "/cpu/cpu%d/topology/thread_siblings_list", thread);
+            dflt = thread;
+            break;
+        case CPU_ATTR__HWTHREAD_LLC_AFFINITY:
+            /* the last cache index is the last level cache */
+            while (path_exist(_PATH_SYS_SYSTEM "/cpu/cpu%d/cache/index%d", thread, index)) {
+                ++index;
+            }
+            sprintf(filename, _PATH_SYS_SYSTEM "/cpu/cpu%d/cache/index%d/shared_cpu_list", thread, index - 1);
+            dflt = thread;
+            break;
+        case CPU_ATTR__HWTHREAD_SOCKET_AFFINITY:
+            sprintf(filename, _PATH_SYS_SYSTEM "/cpu/cpu%d/topology/physical_package_id", thread);
+            dflt = 0;
+            break;
+        default:
+            return CPU_ERROR;
+    }
+
+    *val = dflt;
+
+    fp = fopen(filename, "r");
+    if (!fp) {
+        return CPU_SUCCESS;
+    }
+
+    if (fscanf(fp, "%d", val) != 1 || *val < 0) {
+        *val = dflt;
+    }
+
+    fclose(fp);
+
+    return CPU_SUCCESS;
+}
+
 static char pathbuf[PATH_MAX] = "/";
 
 FILE *
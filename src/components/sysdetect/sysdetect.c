@@ -238,6 +238,26 @@ _sysdetect_get_dev_attr( void *handle, int id, PAPI_dev_attr_e attr, void *val )
     _sysdetect_gpu_info_u *gpu_info =
         (_sysdetect_gpu_info_u *) (dev_type_info->dev_info_arr) + id;
 
+    /* per-thread and per-node cpu attributes index fixed size arrays */
+    switch(attr) {
+        case PAPI_DEV_ATTR__CPU_UINT_THR_NUMA_AFFINITY:
+        case PAPI_DEV_ATTR__CPU_UINT_THR_CORE_AFFINITY:
+        case PAPI_DEV_ATTR__CPU_UINT_THR_LLC_AFFINITY:
+        case PAPI_DEV_ATTR__CPU_UINT_THR_SOCKET_AFFINITY:
+            if (id < 0 || id >= PAPI_MAX_NUM_THREADS) {
+                return PAPI_EINVAL;
+            }
+            break;
+        case PAPI_DEV_ATTR__CPU_UINT_THR_PER_NUMA:
+        case PAPI_DEV_ATTR__CPU_UINT_NUMA_MEM_SIZE:
+            if (id < 0 || id >= PAPI_MAX_NUM_NODES) {
+                return PAPI_EINVAL;
+            }
+            break;
+        default:
+            break;
+    }
+
     switch(attr) {
         /* CPU attributes */
         case PAPI_DEV_ATTR__CPU_UINT_L1I_CACHE_SIZE:
@@ -319,6 +339,15 @@ _sysdetect_get_dev_attr( void *handle, int id, PAPI_dev_attr_e attr, void *val )
             get_num_threads_per_numa(cpu_info);
             *(int *) val = cpu_info->num_threads_per_numa[id];
             break;
+        case PAPI_DEV_ATTR__CPU_UINT_THR_CORE_AFFINITY:
+            *(int *) val = cpu_info->core_affinity[id];
+            break;
+        case PAPI_DEV_ATTR__CPU_UINT_THR_LLC_AFFINITY:
+            *(int *) val = cpu_info->llc_affinity[id];
+            break;
+        case PAPI_DEV_ATTR__CPU_UINT_THR_SOCKET_AFFINITY:
+            *(int *) val = cpu_info->socket_affinity[id];
+            break;
         case PAPI_DEV_ATTR__CPU_UINT_NUMA_MEM_SIZE:
             *(unsigned int *) val = (cpu_info->numa_memory[id] >> 10);
             break;
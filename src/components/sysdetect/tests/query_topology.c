@@ -0,0 +1,130 @@
+/**
+ * @file    query_topology.c
+ *
+ * @brief
+ *  Map every CPU to its core, last level cache, NUMA node and package,
+ *  check the domains nest, and count on one CPU per domain with event
+ *  sets rolled up to the whole node.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+static const char *level_name[PAPI_TOPO_LEVEL__MAX_NUM] = {
+    "cpu", "core", "llc", "numa", "package", "node"
+};
+
+int main(int argc, char *argv[])
+{
+    int quiet, retval, cpu, level, cidx, num, num_up, i;
+    int domains[PAPI_TOPO_LEVEL__MAX_NUM], count[PAPI_TOPO_LEVEL__MAX_NUM];
+    int *cpus, *sets;
+    long long node, *per_package;
+
+    quiet = tests_quiet(argc, argv);
+
+    retval = PAPI_library_init(PAPI_VER_CURRENT);
+    if (retval != PAPI_VER_CURRENT) {
+        test_fail(__FILE__, __LINE__, "PAPI_library_init", retval);
+    }
+
+    for (level = 0; level < PAPI_TOPO_LEVEL__MAX_NUM; ++level) {
+        count[level] = PAPI_get_topo_domains(level, NULL, 0);
+        if (count[level] == PAPI_ENOSUPP) {
+            test_skip(__FILE__, __LINE__, "CPU topology not known", 0);
+        }
+        if (count[level] <= 0) {
+            test_fail(__FILE__, __LINE__, "PAPI_get_topo_domains", count[level]);
+        }
+        if (!quiet) {
+            printf("%-8s domains: %d\n", level_name[level], count[level]);
+        }
+    }
+    if (count[PAPI_TOPO_LEVEL__NODE] != 1 ||
+        count[PAPI_TOPO_LEVEL__CORE] > count[PAPI_TOPO_LEVEL__CPU] ||
+        count[PAPI_TOPO_LEVEL__PACKAGE] > count[PAPI_TOPO_LEVEL__CORE]) {
+        test_fail(__FILE__, __LINE__, "domain counts", 1);
+    }
+
+    /* the designated CPU of a domain is its lowest and is in the domain */
+    num = count[PAPI_TOPO_LEVEL__CPU];
+    cpus = malloc(num * sizeof(int));
+    sets = malloc(num * sizeof(int));
+    per_package = malloc(num * sizeof(long long));
+    if (!cpus || !sets || !per_package) {
+        test_fail(__FILE__, __LINE__, "malloc", PAPI_ENOMEM);
+    }
+    for (level = 0; level < PAPI_TOPO_LEVEL__MAX_NUM; ++level) {
+        PAPI_get_topo_domains(level, cpus, num);
+        for (cpu = 0; cpu < num; ++cpu) {
+            retval = PAPI_get_cpu_topology(cpu, domains);
+            if (retval != PAPI_OK) {
+                test_fail(__FILE__, __LINE__, "PAPI_get_cpu_topology", retval);
+            }
+            if (domains[PAPI_TOPO_LEVEL__CPU] != cpu ||
+                cpus[domains[level]] > cpu) {
+                test_fail(__FILE__, __LINE__, level_name[level], cpu);
+            }
+            if (!quiet && level == 0) {
+                printf("cpu %3d: core %3d llc %3d numa %2d package %2d\n", cpu,
+                       domains[PAPI_TOPO_LEVEL__CORE], domains[PAPI_TOPO_LEVEL__LLC],
+                       domains[PAPI_TOPO_LEVEL__NUMA], domains[PAPI_TOPO_LEVEL__PACKAGE]);
+            }
+        }
+    }
+
+    /* per-CPU counts summed per package and for the node must agree */
+    cidx = PAPI_get_component_index("perf_event");
+    num = PAPI_create_topo_eventsets(cidx, PAPI_TOPO_LEVEL__CPU, sets, num);
+    if (num < 0) {
+        if (!quiet) {
+            printf("Cannot count per CPU (%s)\n", PAPI_strerror(num));
+        }
+        test_pass(__FILE__);
+    }
+    for (i = 0; i < num; ++i) {
+        retval = PAPI_add_named_event(sets[i], "perf::CPU-CLOCK");
+        if (retval == PAPI_OK) {
+            retval = PAPI_start(sets[i]);
+        }
+        if (retval != PAPI_OK) {
+            if (!quiet) {
+                printf("Cannot count on cpu %d (%s)\n", i, PAPI_strerror(retval));
+            }
+            test_pass(__FILE__);
+        }
+    }
+    for (i = 0; i < num; ++i) {
+        PAPI_stop(sets[i], NULL);
+    }
+
+    num_up = PAPI_read_topo_eventsets(sets, PAPI_TOPO_LEVEL__CPU, num,
+                                      PAPI_TOPO_LEVEL__PACKAGE, per_package);
+    if (num_up != count[PAPI_TOPO_LEVEL__PACKAGE]) {
+        test_fail(__FILE__, __LINE__, "PAPI_read_topo_eventsets", num_up);
+    }
+    retval = PAPI_read_topo_eventsets(sets, PAPI_TOPO_LEVEL__CPU, num,
+                                      PAPI_TOPO_LEVEL__NODE, &node);
+    if (retval != 1) {
+        test_fail(__FILE__, __LINE__, "PAPI_read_topo_eventsets", retval);
+    }
+    for (i = 0; i < num_up; ++i) {
+        node -= per_package[i];
+    }
+    if (node != 0) {
+        test_fail(__FILE__, __LINE__, "package counts do not add up", 1);
+    }
+
+    for (i = 0; i < num; ++i) {
+        PAPI_cleanup_eventset(sets[i]);
+        PAPI_destroy_eventset(&sets[i]);
+    }
+    free(cpus);
+    free(sets);
+    free(per_package);
+
+    test_pass(__FILE__);
+    return 0;
+}
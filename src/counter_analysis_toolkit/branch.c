@@ -12,24 +12,19 @@ volatile int iter_count, global_var1, global_var2;
 volatile int result;
 volatile unsigned int b, z1, z2, z3, z4;
 
-void branch_driver(char *papi_event_name, int junk, hw_desc_t *hw_desc, char* outdir){
+void branch_driver(evbatch *batch, int junk, hw_desc_t *hw_desc, char* outdir){
     int papi_eventset = PAPI_NULL;
-    int i, iter, sz, ret_val, max_iter = 16*1024;
-    long long int cnt;
-    double avg, round;
-    FILE* ofp_papi;
-    const char *sufx = ".branch";
-    int l = strlen(outdir)+strlen(papi_event_name)+strlen(sufx);
+    int i, e, iter, sz, ret_val, failed = 0, max_iter = 16*1024;
+    int nevts = batch->size;
+    long long int cnt[MAX_BATCH_EVENTS];
+    double avg[MAX_BATCH_EVENTS], round;
+    FILE** ofp_papi;
 
     (void)hw_desc;
 
-    char *papiFileName = (char *)calloc( 1+l, sizeof(char) );
-    if (l != (sprintf(papiFileName, "%s%s%s", outdir, papi_event_name, sufx))) {
-        goto error0;
-    }
-    if (NULL == (ofp_papi = fopen(papiFileName,"w"))) {
-        fprintf(stderr, "Unable to open file %s.\n", papiFileName);
-        goto error0;
+    // One output file per event, as when every event is measured on its own.
+    if (NULL == (ofp_papi = batch_open_files(batch, outdir, ".branch"))) {
+        return;
     }
 
     // Initialize undecidible values for the BRNG macro.
@@ -38,14 +33,9 @@ void branch_driver(char *papi_event_name, int junk, hw_desc_t *hw_desc, char* ou
     z3 = junk;
     z4 = (z3+z2)/z1;
 
-    ret_val = PAPI_create_eventset( &papi_eventset );
-    if (ret_val != PAPI_OK){
-        goto error1;
-    }
-
-    ret_val = PAPI_add_named_event( papi_eventset, papi_event_name );
+    ret_val = batch_eventset( batch, &papi_eventset );
     if (ret_val != PAPI_OK){
-        goto error1;
+        goto error0;
     }
 
     BRANCH_BENCH(1);
@@ -64,25 +54,16 @@ void branch_driver(char *papi_event_name, int junk, hw_desc_t *hw_desc, char* ou
         printf("Random side effect\n");
     }
 
-    ret_val = PAPI_cleanup_eventset( papi_eventset );
-    if (ret_val != PAPI_OK ){
-        goto error1;
-    }
-    ret_val = PAPI_destroy_eventset( &papi_eventset );
-    if (ret_val != PAPI_OK ){
-        goto error1;
-    }
-
 error1:
-    fclose(ofp_papi);
+    PAPI_cleanup_eventset( papi_eventset );
+    PAPI_destroy_eventset( &papi_eventset );
 error0:
-    free(papiFileName);
+    batch_close_files(batch, ofp_papi);
     return;
 }
 
-long long int branch_char_b1(int size, int event_set){
+long long int branch_char_b1(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -107,17 +88,16 @@ long long int branch_char_b1(int size, int event_set){
         iter_count++;
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b2(int size, int event_set){
+long long int branch_char_b2(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -143,16 +123,15 @@ long long int branch_char_b2(int size, int event_set){
     }while(iter_count<size);
 
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b3(int size, int event_set){
+long long int branch_char_b3(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -178,16 +157,15 @@ long long int branch_char_b3(int size, int event_set){
     }while(iter_count<size);
 
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b4(int size, int event_set){
+long long int branch_char_b4(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -213,17 +191,16 @@ long long int branch_char_b4(int size, int event_set){
         BUSY_WORK();
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b4a(int size, int event_set){
+long long int branch_char_b4a(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -244,17 +221,16 @@ long long int branch_char_b4a(int size, int event_set){
         BUSY_WORK();
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b4b(int size, int event_set){
+long long int branch_char_b4b(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -275,17 +251,16 @@ long long int branch_char_b4b(int size, int event_set){
         BUSY_WORK();
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b5(int size, int event_set){
+long long int branch_char_b5(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -311,17 +286,16 @@ long long int branch_char_b5(int size, int event_set){
         }
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b5a(int size, int event_set){
+long long int branch_char_b5a(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -343,17 +317,16 @@ long long int branch_char_b5a(int size, int event_set){
         }
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b5b(int size, int event_set){
+long long int branch_char_b5b(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -375,17 +348,16 @@ long long int branch_char_b5b(int size, int event_set){
         }
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
 
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b6(int size, int event_set){
+long long int branch_char_b6(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -414,16 +386,15 @@ long long int branch_char_b6(int size, int event_set){
     }while(iter_count<size);
 
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
-    return value;
+    return values[0];
 
 }
 
-long long int branch_char_b7(int size, int event_set){
+long long int branch_char_b7(int size, int event_set, long long int *values){
     int retval;
-    long long int value;
 
     if ( (retval=PAPI_start(event_set)) != PAPI_OK){
         return -1;
@@ -444,9 +415,9 @@ long long int branch_char_b7(int size, int event_set){
         iter_count++;
     }while(iter_count<size);
 
-    if ( (retval=PAPI_stop(event_set, &value)) != PAPI_OK){
+    if ( (retval=PAPI_stop(event_set, values)) != PAPI_OK){
         return -1;
     }
-    return value;
+    return values[0];
 
 }
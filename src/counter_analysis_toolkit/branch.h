@@ -2,32 +2,35 @@
 #define _BRANCH_
 
 #include "hw_desc.h"
+#include "eventbatch.h"
+
+#define BRANCH_SAMPLE(_I_, _SZ_) {\
+    sz = (_SZ_);\
+    if( branch_char_b ## _I_ (sz, papi_eventset, cnt) < 0 )\
+        failed = 1;\
+    for(e=0; e<nevts; e++)\
+        avg[e] += (double)cnt[e]/(double)sz;\
+}
 
 #define BRANCH_BENCH(_I_) {\
     iter = 0;\
-    avg = 0.0;\
+    for(e=0; e<nevts; e++)\
+        avg[e] = 0.0;\
     for(i=512; i<max_iter; i*=2){\
         iter++;\
-        sz = i;\
-        cnt = branch_char_b ## _I_ (sz, papi_eventset);\
-        avg += (double)cnt/(double)sz;\
-        sz = (int)((double)i*1.1892);\
-        cnt = branch_char_b ## _I_ (sz, papi_eventset);\
-        avg += (double)cnt/(double)sz;\
-        sz = (int)((double)i*1.4142);\
-        cnt = branch_char_b ## _I_ (sz, papi_eventset);\
-        avg += (double)cnt/(double)sz;\
-        sz = (int)((double)i*1.6818);\
-        cnt = branch_char_b ## _I_ (sz, papi_eventset);\
-        avg += (double)cnt/(double)sz;\
+        BRANCH_SAMPLE(_I_, i);\
+        BRANCH_SAMPLE(_I_, (int)((double)i*1.1892));\
+        BRANCH_SAMPLE(_I_, (int)((double)i*1.4142));\
+        BRANCH_SAMPLE(_I_, (int)((double)i*1.6818));\
+    }\
+    if(failed){\
+        goto error1;\
     }\
-    if(avg < 0.0){\
-        fclose(ofp_papi);\
-        return;\
+    for(e=0; e<nevts; e++){\
+        avg[e] = avg[e]/(4.0*(double)iter);\
+        round = floor(avg[e]*4.0+0.499)/4.0;\
+        fprintf(ofp_papi[e],"%.2lf\n", round);\
     }\
-    avg = avg/(4.0*(double)iter);\
-    round = floor(avg*4.0+0.499)/4.0;\
-    fprintf(ofp_papi,"%.2lf\n", round);\
 }
 
 #define BRNG() {\
@@ -48,17 +51,17 @@
 extern volatile int result;
 extern volatile unsigned int b, z1, z2, z3, z4;
 
-void branch_driver(char *papi_event_name, int junk, hw_desc_t *hw_desc, char* outdir);
-long long int branch_char_b1(int size, int papi_eventset);
-long long int branch_char_b2(int size, int papi_eventset);
-long long int branch_char_b3(int size, int papi_eventset);
-long long int branch_char_b4(int size, int papi_eventset);
-long long int branch_char_b4a(int size, int papi_eventset);
-long long int branch_char_b4b(int size, int papi_eventset);
-long long int branch_char_b5(int size, int papi_eventset);
-long long int branch_char_b5a(int size, int papi_eventset);
-long long int branch_char_b5b(int size, int papi_eventset);
-long long int branch_char_b6(int size, int papi_eventset);
-long long int branch_char_b7(int size, int papi_eventset);
+void branch_driver(evbatch *batch, int junk, hw_desc_t *hw_desc, char* outdir);
+long long int branch_char_b1(int size, int papi_eventset, long long int *values);
+long long int branch_char_b2(int size, int papi_eventset, long long int *values);
+long long int branch_char_b3(int size, int papi_eventset, long long int *values);
+long long int branch_char_b4(int size, int papi_eventset, long long int *values);
+long long int branch_char_b4a(int size, int papi_eventset, long long int *values);
+long long int branch_char_b4b(int size, int papi_eventset, long long int *values);
+long long int branch_char_b5(int size, int papi_eventset, long long int *values);
+long long int branch_char_b5a(int size, int papi_eventset, long long int *values);
+long long int branch_char_b5b(int size, int papi_eventset, long long int *values);
+long long int branch_char_b6(int size, int papi_eventset, long long int *values);
+long long int branch_char_b7(int size, int papi_eventset, long long int *values);
 
 #endif
@@ -5,7 +5,6 @@
 #include "params.h"
 #include <math.h>
 
-static void print_header(FILE *ofp_papi, hw_desc_t *hw_desc);
 static void print_cache_sizes(FILE *ofp_papi, hw_desc_t *hw_desc);
 static void print_core_affinities(FILE *ofp);
 
@@ -60,7 +59,7 @@ void d_cache_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_de
         cache_line = hw_desc->dcache_line_size[0];
 
     // Print meta-data about this run in the first few lines of the output file.
-    print_header(ofp_papi, hw_desc);
+    d_cache_print_header(ofp_papi, hw_desc);
 
     // Go through each parameter variant.
     for(pattern = 3; pattern <= 4; ++pattern)
@@ -419,7 +418,7 @@ int get_thread_count() {
     return threadNum;
 }
 
-void print_header(FILE *ofp, hw_desc_t *hw_desc){
+void d_cache_print_header(FILE *ofp, hw_desc_t *hw_desc){
     // Print the core to which each thread is pinned.
     print_core_affinities(ofp);
     // Print the size of each cache divided by the number of cores that share it.
@@ -10,6 +10,7 @@
 
 int varyBufferSizes(long long *values, double **rslts, double **counter, hw_desc_t *hw_desc, long long line_size_in_bytes, float pages_per_block, int pattern, int latency_only, int mode, int ONT);
 int get_thread_count();
+void d_cache_print_header(FILE *ofp, hw_desc_t *hw_desc);
 void d_cache_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc, int latency_only, int mode);
 int d_cache_test(int pattern, int max_iter, hw_desc_t *hw_desc, long long stride_in_bytes, float pages_per_block, char* papi_event_name, int latency_only, int mode, FILE* ofp);
 
@@ -5,6 +5,7 @@
 #include "flops.h"
 #include "vec.h"
 #include "instr.h"
+#include "memsys.h"
 #include "hw_desc.h"
 #include "params.h"
 
@@ -18,6 +19,9 @@
 #define BENCH_ICACHE_READ  0x10
 #define BENCH_VEC          0x20
 #define BENCH_INSTR        0x40
+#define BENCH_MEM_BW       0x80
+#define BENCH_TLB          0x100
+#define BENCH_SHARE        0x200
 
 int parseArgs(int argc, char **argv, cat_params_t *params);
 int setup_evts(char* inputfile, char*** basenames, int** cards);
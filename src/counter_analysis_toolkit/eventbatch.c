@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "papi.h"
+#include "eventbatch.h"
+
+// Number of events of a component that can be counted at once, if it says.
+static int batch_limit(char* evt, int maxsize)
+{
+    int code, cid, limit = MAX_BATCH_EVENTS;
+    const PAPI_component_info_t *cmp_info;
+
+    if( PAPI_OK != PAPI_event_name_to_code(evt, &code) )
+        return 1;
+
+    cid = PAPI_get_event_component(code);
+    cmp_info = PAPI_get_component_info(cid);
+    if( NULL != cmp_info && cmp_info->num_cntrs > 0 && cmp_info->num_cntrs < limit )
+        limit = cmp_info->num_cntrs;
+
+    if( maxsize > 0 && maxsize < limit )
+        limit = maxsize;
+
+    return limit;
+}
+
+// Pack allevts[low..cap-1] into groups that PAPI accepts in one event set.
+// An event that fits nowhere, because PAPI rejects it even on its own, gets
+// a group of its own so its driver reports it as it would without batching.
+// Returns the number of groups, or -1.
+int build_batches(char** allevts, int low, int cap, int maxsize, evbatch** batches)
+{
+    int i, ret, nbatches = 0, limit = 0;
+    int eventset = PAPI_NULL;
+    evbatch *list, *cur = NULL;
+
+    if( cap <= low )
+    {
+        *batches = NULL;
+        return 0;
+    }
+
+    list = (evbatch*)calloc(cap-low, sizeof(evbatch));
+    if( NULL == list )
+        return -1;
+
+    if( PAPI_OK != PAPI_create_eventset(&eventset) )
+    {
+        free(list);
+        return -1;
+    }
+
+    for(i = low; i < cap; ++i)
+    {
+        if( NULL == allevts[i] )
+            continue;
+
+        // Try the open group first.
+        if( NULL != cur && cur->size < limit )
+        {
+            ret = PAPI_add_named_event(eventset, allevts[i]);
+            if( PAPI_OK == ret )
+            {
+                cur->evts[cur->size++] = allevts[i];
+                continue;
+            }
+        }
+
+        // Start a new group with this event.
+        PAPI_cleanup_eventset(eventset);
+        cur = &list[nbatches++];
+        cur->first = i;
+        cur->evts[cur->size++] = allevts[i];
+        limit = batch_limit(allevts[i], maxsize);
+
+        ret = PAPI_add_named_event(eventset, allevts[i]);
+        if( PAPI_OK != ret )
+        {
+            // Nothing can join an event PAPI does not take.
+            cur = NULL;
+        }
+    }
+
+    PAPI_cleanup_eventset(eventset);
+    PAPI_destroy_eventset(&eventset);
+
+    *batches = list;
+    return nbatches;
+}
+
+// Create an event set with all the events of the group.
+int batch_eventset(evbatch* batch, int* eventset)
+{
+    int i, ret;
+
+    *eventset = PAPI_NULL;
+    ret = PAPI_create_eventset(eventset);
+    if( PAPI_OK != ret )
+        return ret;
+
+    for(i = 0; i < batch->size; ++i)
+    {
+        ret = PAPI_add_named_event(*eventset, batch->evts[i]);
+        if( PAPI_OK != ret )
+        {
+            PAPI_cleanup_eventset(*eventset);
+            PAPI_destroy_eventset(eventset);
+            return ret;
+        }
+    }
+
+    return PAPI_OK;
+}
+
+// Open the output file of every event in the group, named as without batching.
+FILE** batch_open_files(evbatch* batch, char* outdir, const char* sufx)
+{
+    int i, l;
+    char *name;
+    FILE **ofp = (FILE**)calloc(batch->size, sizeof(FILE*));
+
+    if( NULL == ofp )
+        return NULL;
+
+    for(i = 0; i < batch->size; ++i)
+    {
+        l = strlen(outdir)+strlen(batch->evts[i])+strlen(sufx);
+        name = (char*)calloc(1+l, sizeof(char));
+        if( NULL == name || l != sprintf(name, "%s%s%s", outdir, batch->evts[i], sufx) )
+        {
+            free(name);
+            batch_close_files(batch, ofp);
+            return NULL;
+        }
+        ofp[i] = fopen(name, "w");
+        if( NULL == ofp[i] )
+        {
+            fprintf(stderr, "Unable to open file %s.\n", name);
+            free(name);
+            batch_close_files(batch, ofp);
+            return NULL;
+        }
+        free(name);
+    }
+
+    return ofp;
+}
+
+void batch_close_files(evbatch* batch, FILE** ofp)
+{
+    int i;
+
+    if( NULL == ofp )
+        return;
+
+    for(i = 0; i < batch->size; ++i)
+    {
+        if( NULL != ofp[i] )
+            fclose(ofp[i]);
+    }
+    free(ofp);
+}
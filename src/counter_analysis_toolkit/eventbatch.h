@@ -0,0 +1,21 @@
+#ifndef _EVENT_BATCH_
+#define _EVENT_BATCH_
+
+// No core PMU has more counters than this.
+#define MAX_BATCH_EVENTS 32
+
+// A group of events that can be counted together, so a kernel has to run
+// only once for all of them.
+typedef struct
+{
+    int size;
+    int first;  // index in allevts of evts[0]
+    char* evts[MAX_BATCH_EVENTS];
+} evbatch;
+
+int     build_batches(char** allevts, int low, int cap, int maxsize, evbatch** batches);
+int     batch_eventset(evbatch* batch, int* eventset);
+FILE**  batch_open_files(evbatch* batch, char* outdir, const char* sufx);
+void    batch_close_files(evbatch* batch, FILE** ofp);
+
+#endif
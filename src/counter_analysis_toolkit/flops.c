@@ -17,6 +17,9 @@
 
 #define MAXDIM 51
 
+// Number of events, and output files, of the group being measured.
+static int num_evts;
+
 #if defined(mips)
 #define FMA 1
 #elif (defined(sparc) && defined(sun))
@@ -26,49 +29,52 @@
 #endif
 
 /* Function prototypes. */
-void print_header( FILE *fp, char *prec, char *kernel );
-void resultline( int i, int kernel, int EventSet, FILE *fp );
-void exec_flops( int precision, int EventSet, FILE *fp );
+void print_header( FILE **fp, char *prec, char *kernel );
+void resultline( int i, int kernel, int EventSet, FILE **fp );
+void exec_flops( int precision, int EventSet, FILE **fp );
 
 double normalize_double( int n, double *xd );
 void cholesky_double( int n, double *ld, double *ad );
-void exec_double_norm( int EventSet, FILE *fp );
-void exec_double_cholesky( int EventSet, FILE *fp );
-void exec_double_gemm( int EventSet, FILE *fp );
+void exec_double_norm( int EventSet, FILE **fp );
+void exec_double_cholesky( int EventSet, FILE **fp );
+void exec_double_gemm( int EventSet, FILE **fp );
 void keep_double_vec_res( int n, double *xd );
 void keep_double_mat_res( int n, double *ld );
 
 float normalize_single( int n, float *xs );
 void cholesky_single( int n, float  *ls, float *as );
-void exec_single_norm( int EventSet, FILE *fp );
-void exec_single_cholesky( int EventSet, FILE *fp );
-void exec_single_gemm( int EventSet, FILE *fp );
+void exec_single_norm( int EventSet, FILE **fp );
+void exec_single_cholesky( int EventSet, FILE **fp );
+void exec_single_gemm( int EventSet, FILE **fp );
 void keep_single_vec_res( int n, float *xs );
 void keep_single_mat_res( int n, float *ls );
 
 #if defined(ARM)
 half normalize_half( int n, half *xh );
 void cholesky_half( int n, half *lh, half *ah );
-void exec_half_norm( int EventSet, FILE *fp );
-void exec_half_cholesky( int EventSet, FILE *fp );
-void exec_half_gemm( int EventSet, FILE *fp );
+void exec_half_norm( int EventSet, FILE **fp );
+void exec_half_cholesky( int EventSet, FILE **fp );
+void exec_half_gemm( int EventSet, FILE **fp );
 void keep_half_vec_res( int n, half *xh );
 void keep_half_mat_res( int n, half *lh );
 #endif
 
-void print_header( FILE *fp, char *prec, char *kernel ) {
+void print_header( FILE **fp, char *prec, char *kernel ) {
+    int e;
 
-    fprintf(fp, "#%s %s\n", prec, kernel);
-    fprintf(fp, "#N RawEvtCnt NormdEvtCnt ExpectedAdd ExpectedSub ExpectedMul ExpectedDiv ExpectedSqrt ExpectedFMA ExpectedTotal\n");
+    for ( e = 0; e < num_evts; e++ ) {
+        fprintf(fp[e], "#%s %s\n", prec, kernel);
+        fprintf(fp[e], "#N RawEvtCnt NormdEvtCnt ExpectedAdd ExpectedSub ExpectedMul ExpectedDiv ExpectedSqrt ExpectedFMA ExpectedTotal\n");
+    }
 }
 
-void resultline( int i, int kernel, int EventSet, FILE *fp ) {
+void resultline( int i, int kernel, int EventSet, FILE **fp ) {
 
-    long long flpins = 0, denom;
+    long long flpins[MAX_BATCH_EVENTS] = {0}, denom;
     long long papi, all, add, sub, mul, div, sqrt, fma;
-    int retval;
+    int retval, e;
 
-    if ( (retval=PAPI_stop(EventSet, &flpins)) != PAPI_OK ) {
+    if ( (retval=PAPI_stop(EventSet, flpins)) != PAPI_OK ) {
         return;
     }
 
@@ -126,9 +132,11 @@ void resultline( int i, int kernel, int EventSet, FILE *fp ) {
           fma   = -1;
     }
 
-    papi = flpins << FMA;
+    for ( e = 0; e < num_evts; e++ ) {
+        papi = flpins[e] << FMA;
 
-    fprintf(fp, "%d %lld %.17g %lld %lld %lld %lld %lld %lld %lld\n", i, papi, ((double)papi)/((double)denom), add, sub, mul, div, sqrt, fma, all);
+        fprintf(fp[e], "%d %lld %.17g %lld %lld %lld %lld %lld %lld %lld\n", i, papi, ((double)papi)/((double)denom), add, sub, mul, div, sqrt, fma, all);
+    }
 }
 
 #if defined(ARM)
@@ -313,7 +321,7 @@ void gemm_double( int n, double *cd, double *ad, double *bd ) {
     }
 }
 
-void exec_double_norm( int EventSet, FILE *fp ) {
+void exec_double_norm( int EventSet, FILE **fp ) {
 
     int i, n, retval;
     double *xd=NULL;
@@ -350,7 +358,7 @@ void exec_double_norm( int EventSet, FILE *fp ) {
     free( xd );
 }
 
-void exec_double_cholesky( int EventSet, FILE *fp ) {
+void exec_double_cholesky( int EventSet, FILE **fp ) {
 
     int i, j, n, retval;
     double *ad=NULL, *ld=NULL;
@@ -406,7 +414,7 @@ void exec_double_cholesky( int EventSet, FILE *fp ) {
     free( ld );
 }
 
-void exec_double_gemm( int EventSet, FILE *fp ) {
+void exec_double_gemm( int EventSet, FILE **fp ) {
 
     int i, j, n, retval;
     double *ad=NULL, *bd=NULL, *cd=NULL;
@@ -478,7 +486,7 @@ void keep_double_mat_res( int n, double *ld ) {
     }
 }
 
-void exec_single_norm( int EventSet, FILE *fp ) {
+void exec_single_norm( int EventSet, FILE **fp ) {
 
     int i, n, retval;
     float *xs=NULL;
@@ -515,7 +523,7 @@ void exec_single_norm( int EventSet, FILE *fp ) {
     free( xs );
 }
 
-void exec_single_cholesky( int EventSet, FILE *fp ) {
+void exec_single_cholesky( int EventSet, FILE **fp ) {
 
     int i, j, n, retval;
     float *as=NULL, *ls=NULL;
@@ -571,7 +579,7 @@ void exec_single_cholesky( int EventSet, FILE *fp ) {
     free( ls );
 }
 
-void exec_single_gemm( int EventSet, FILE *fp ) {
+void exec_single_gemm( int EventSet, FILE **fp ) {
 
     int i, j, n, retval;
     float *as=NULL, *bs=NULL, *cs=NULL;
@@ -644,7 +652,7 @@ void keep_single_mat_res( int n, float *ls ) {
 }
 
 #if defined(ARM)
-void exec_half_norm( int EventSet, FILE *fp ) {
+void exec_half_norm( int EventSet, FILE **fp ) {
 
     int i, n, retval;
     half *xh=NULL;
@@ -681,7 +689,7 @@ void exec_half_norm( int EventSet, FILE *fp ) {
     free( xh );
 }
 
-void exec_half_cholesky( int EventSet, FILE *fp ) {
+void exec_half_cholesky( int EventSet, FILE **fp ) {
 
     int i, j, n, retval;
     half *ah=NULL, *lh=NULL;
@@ -737,7 +745,7 @@ void exec_half_cholesky( int EventSet, FILE *fp ) {
     free( lh );
 }
 
-void exec_half_gemm( int EventSet, FILE *fp ) {
+void exec_half_gemm( int EventSet, FILE **fp ) {
 
     int i, j, n, retval;
     half *ah=NULL, *bh=NULL, *ch=NULL;
@@ -810,7 +818,7 @@ void keep_half_mat_res( int n, half *lh ) {
 }
 #endif
 
-void exec_flops( int precision, int EventSet, FILE *fp ) {
+void exec_flops( int precision, int EventSet, FILE **fp ) {
 
     /* Vector Normalization and Cholesky Decomposition tests. */
     switch(precision) {
@@ -838,35 +846,22 @@ void exec_flops( int precision, int EventSet, FILE *fp ) {
     return;
 }
 
-void flops_driver( char* papi_event_name, hw_desc_t *hw_desc, char* outdir ) {
+void flops_driver( evbatch *batch, hw_desc_t *hw_desc, char* outdir ) {
     int retval = PAPI_OK;
     int EventSet = PAPI_NULL;
-    FILE* ofp_papi;
-    const char *sufx = ".flops";
-    char *papiFileName;
+    FILE** ofp_papi;
 
     (void)hw_desc;
 
-    int l = strlen(outdir)+strlen(papi_event_name)+strlen(sufx);
-    if (NULL == (papiFileName = (char *)calloc( 1+l, sizeof(char)))) {
+    // One output file per event, as when every event is measured on its own.
+    if (NULL == (ofp_papi = batch_open_files(batch, outdir, ".flops"))) {
         return;
     }
-    if (l != (sprintf(papiFileName, "%s%s%s", outdir, papi_event_name, sufx))) {
-        goto error0;
-    }
-    if (NULL == (ofp_papi = fopen(papiFileName,"w"))) {
-        fprintf(stderr, "Failed to open file %s.\n", papiFileName);
-        goto error0;
-    }
-  
-    retval = PAPI_create_eventset( &EventSet );
-    if (retval != PAPI_OK ){
-        goto error1;
-    }
+    num_evts = batch->size;
 
-    retval = PAPI_add_named_event( EventSet, papi_event_name );
+    retval = batch_eventset( batch, &EventSet );
     if (retval != PAPI_OK ){
-        goto error1;
+        goto error0;
     }
 
     exec_flops(HALF,   EventSet, ofp_papi);
@@ -875,16 +870,14 @@ void flops_driver( char* papi_event_name, hw_desc_t *hw_desc, char* outdir ) {
 
     retval = PAPI_cleanup_eventset( EventSet );
     if (retval != PAPI_OK ){
-        goto error1;
+        goto error0;
     }
     retval = PAPI_destroy_eventset( &EventSet );
     if (retval != PAPI_OK ){
-        goto error1;
+        goto error0;
     }
 
-error1:
-    fclose(ofp_papi);
 error0:
-    free(papiFileName);
+    batch_close_files(batch, ofp_papi);
     return;
 }
@@ -3,7 +3,8 @@
 
 #include "hw_desc.h"
 #include "cat_arch.h"
+#include "eventbatch.h"
 
-void flops_driver(char* papi_event_str, hw_desc_t *hw_desc, char* outdir);
+void flops_driver(evbatch *batch, hw_desc_t *hw_desc, char* outdir);
 
 #endif
@@ -20,7 +20,7 @@ int main(int argc, char*argv[])
     int *cards = NULL, *indexmemo = NULL;
     char **allevts = NULL, **basenames = NULL;
     evstock *data = NULL;
-    cat_params_t params = {-1,0,1,0,0,0,NULL,NULL,NULL};
+    cat_params_t params = {-1,0,1,0,0,0,0,NULL,NULL,NULL};
     int nprocs = 1, myid = 0;
 
 #if defined(USE_MPI)
@@ -828,7 +828,8 @@ static void print_progress2(int prg)
 
 void testbench(char** allevts, int cmbtotal, hw_desc_t *hw_desc, cat_params_t params, int myid, int nprocs)
 {
-    int i;
+    int i, b, nbatches;
+    evbatch *batches;
     int junk=((int)getpid()+123)/456;
     int low = myid*(cmbtotal/nprocs);
     int cap = (myid+1)*(cmbtotal/nprocs);
@@ -854,17 +855,29 @@ void testbench(char** allevts, int cmbtotal, hw_desc_t *hw_desc, cat_params_t pa
         fprintf(stderr, "Warning: No benchmark specified. Running 'branch' by default.\n");
     }
 
+    if( params.batch && (params.bench_type & ~(BENCH_BRANCH|BENCH_FLOPS)) )
+    {
+        fprintf(stderr, "Warning: -batch only applies to 'branch' and 'flops'. The other benchmarks measure one event at a time.\n");
+    }
+
+    // Group the events that can be counted together, or give each its own group.
+    nbatches = build_batches(allevts, low, cap, params.batch ? 0 : 1, &batches);
+    if( nbatches < 0 )
+    {
+        fprintf(stderr, "Failed to group the events.\n");
+        return;
+    }
+
     /* Benchmark I - Branch*/
     if( params.bench_type & BENCH_BRANCH )
     {
         if(params.show_progress) printf("Branch Benchmarks: ");
 
-        for(i = low; i < cap; ++i)
+        for(b = 0; b < nbatches; ++b)
         {
-            if(params.show_progress) print_progress((100*i)/cmbtotal);
+            if(params.show_progress) print_progress((100*batches[b].first)/cmbtotal);
 
-            if( allevts[i] != NULL )
-                branch_driver(allevts[i], junk, hw_desc, params.outputdir);
+            branch_driver(&batches[b], junk, hw_desc, params.outputdir);
         }
         if(params.show_progress) print_progress(100);
     }
@@ -927,12 +940,11 @@ void testbench(char** allevts, int cmbtotal, hw_desc_t *hw_desc, cat_params_t pa
     {
         if(params.show_progress) printf("FLOP Benchmarks: ");
 
-        for(i = low; i < cap; ++i)
+        for(b = 0; b < nbatches; ++b)
         {
-            if(params.show_progress) print_progress((100*i)/cmbtotal);
+            if(params.show_progress) print_progress((100*batches[b].first)/cmbtotal);
 
-            if( allevts[i] != NULL )
-                flops_driver(allevts[i], hw_desc, params.outputdir);
+            flops_driver(&batches[b], hw_desc, params.outputdir);
         }
         if(params.show_progress) print_progress(100);
     }
@@ -982,6 +994,53 @@ void testbench(char** allevts, int cmbtotal, hw_desc_t *hw_desc, cat_params_t pa
         if(params.show_progress) print_progress(100);
     }
 
+    /* Benchmark VIII - Memory Bandwidth*/
+    if( params.bench_type & BENCH_MEM_BW )
+    {
+        if(params.show_progress) printf("Memory Bandwidth Benchmarks: ");
+
+        for(i = low; i < cap; ++i)
+        {
+            if(params.show_progress) print_progress((100*i)/cmbtotal);
+
+            if( allevts[i] != NULL )
+                bw_driver(allevts[i], params, hw_desc);
+        }
+        if(params.show_progress) print_progress(100);
+    }
+
+    /* Benchmark IX - TLB*/
+    if( params.bench_type & BENCH_TLB )
+    {
+        if(params.show_progress) printf("TLB Benchmarks: ");
+
+        for(i = low; i < cap; ++i)
+        {
+            if(params.show_progress) print_progress((100*i)/cmbtotal);
+
+            if( allevts[i] != NULL )
+                tlb_driver(allevts[i], params, hw_desc);
+        }
+        if(params.show_progress) print_progress(100);
+    }
+
+    /* Benchmark X - Cache Line Sharing*/
+    if( params.bench_type & BENCH_SHARE )
+    {
+        if(params.show_progress) printf("Cache Line Sharing Benchmarks: ");
+
+        for(i = low; i < cap; ++i)
+        {
+            if(params.show_progress) print_progress((100*i)/cmbtotal);
+
+            if( allevts[i] != NULL )
+                share_driver(allevts[i], params, hw_desc);
+        }
+        if(params.show_progress) print_progress(100);
+    }
+
+    free(batches);
+
     return;
 }
 
@@ -1050,6 +1109,10 @@ int parseArgs(int argc, char **argv, cat_params_t *params){
             params->quick = 1;
             continue;
         }
+        if( !strcmp(argv[0],"-batch") ){
+            params->batch = 1;
+            continue;
+        }
         if( !strcmp(argv[0],"-branch") ){
             params->bench_type |= BENCH_BRANCH;
             continue;
@@ -1078,6 +1141,18 @@ int parseArgs(int argc, char **argv, cat_params_t *params){
             params->bench_type |= BENCH_INSTR;
             continue;
         }
+        if( !strcmp(argv[0],"-bw") ){
+            params->bench_type |= BENCH_MEM_BW;
+            continue;
+        }
+        if( !strcmp(argv[0],"-tlb") ){
+            params->bench_type |= BENCH_TLB;
+            continue;
+        }
+        if( !strcmp(argv[0],"-share") ){
+            params->bench_type |= BENCH_SHARE;
+            continue;
+        }
 
         print_usage(name);
         return -1;
@@ -1158,6 +1233,8 @@ void print_usage(char* name)
     fprintf(stdout, "  -conf    <path>   Configuration file location.\n");
     fprintf(stdout, "  -verbose          Show benchmark progress in the standard output.\n");
     fprintf(stdout, "  -quick            Skip latency tests.\n");
+    fprintf(stdout, "  -batch            Measure as many events per kernel run as the counters allow.\n");
+    fprintf(stdout, "                    Only -branch and -flops; the other kernels ignore it.\n");
     fprintf(stdout, "  -n       <value>  Number of iterations for data cache kernels.\n");
     fprintf(stdout, "  -branch           Branch kernels.\n");
     fprintf(stdout, "  -dcr              Data cache reading kernels.\n");
@@ -1166,6 +1243,9 @@ void print_usage(char* name)
     fprintf(stdout, "  -ic               Instruction cache kernels.\n");
     fprintf(stdout, "  -vec              Vector FLOPs kernels.\n");
     fprintf(stdout, "  -instr            Instructions kernels.\n");
+    fprintf(stdout, "  -bw               Memory bandwidth (read, write, copy) kernels.\n");
+    fprintf(stdout, "  -tlb              TLB kernels (random page walks).\n");
+    fprintf(stdout, "  -share            Cache line sharing kernels (needs 2+ threads).\n");
 
     fprintf(stdout, "\n");
     fprintf(stdout, "EXAMPLE: %s -in event_list.txt -out OUTPUT_DIRECTORY -branch -dcw\n", name);
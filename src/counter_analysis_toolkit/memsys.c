@@ -0,0 +1,584 @@
+#include <sys/mman.h>
+#include <math.h>
+#include "papi.h"
+#include "caches.h"
+#include "prepareArray.h"
+#include "timing_kernels.h"
+#include "dcache.h"
+#include "memsys.h"
+
+typedef struct mem_state_s mem_state_t;
+
+// Prepares one point of a sweep and returns the units of work per thread.
+typedef double (*mem_setup_t)(mem_state_t *st, long long x);
+typedef void (*mem_kernel_t)(mem_state_t *st, int idx);
+
+struct mem_state_s{
+    int ONT;
+    int kernel;
+    long long line;
+    long long len;
+    long long reps;
+    long long stride;
+    double *a[MAXTHREADS];
+    double *b[MAXTHREADS];
+    uintptr_t *chain[MAXTHREADS];
+    void *map[MAXTHREADS];
+    size_t map_len;
+    uintptr_t *shared;
+    size_t shared_len;
+    uintptr_t sink[MAXTHREADS];
+};
+
+extern char* eventname;
+
+static int mem_is_core = 0;
+
+static FILE* mem_open(char* papi_event_name, char* outdir, const char* sufx);
+static int mem_sizes(long long min, long long max, long long unit, long long *xs);
+static int mem_measure(mem_state_t *st, mem_kernel_t kernel, double units, double *rslt);
+static int mem_sweep(FILE *ofp, mem_state_t *st, mem_setup_t setup, mem_kernel_t kernel, long long *xs, int npts, int max_iter);
+
+static long long line_size(hw_desc_t *hw_desc)
+{
+    if( (NULL==hw_desc) || (0==hw_desc->dcache_line_size[0]) )
+        return 64;
+    return hw_desc->dcache_line_size[0];
+}
+
+/* Bandwidth: stream-style read, write and copy of a private buffer per
+ * thread, from the size of L1 to well past each thread's share of the LLC.
+ */
+static double bw_setup(mem_state_t *st, long long x)
+{
+    // "x" is the number of bytes each thread touches per pass.
+    if( MEM_COPY == st->kernel )
+        st->len = x/(2*sizeof(double));
+    else
+        st->len = x/sizeof(double);
+
+    st->reps = MEM_MIN_TRAFFIC/x;
+    if( st->reps < 1 )
+        st->reps = 1;
+
+    // Count per cache line touched.
+    return (double)st->reps*x/st->line;
+}
+
+static void bw_kernel(mem_state_t *st, int idx)
+{
+    double *a = st->a[idx], *b = st->b[idx], s = 0.0;
+    long long i, r, len = st->len;
+
+    switch(st->kernel){
+        case MEM_READ:
+            for(r=0; r<st->reps; ++r)
+                for(i=0; i<len; ++i)
+                    s += a[i];
+            break;
+        case MEM_WRITE:
+            for(r=0; r<st->reps; ++r)
+                for(i=0; i<len; ++i)
+                    a[i] = (double)r;
+            break;
+        case MEM_COPY:
+            for(r=0; r<st->reps; ++r){
+                for(i=0; i<len; ++i)
+                    b[i] = a[i];
+                s += b[r%len];
+            }
+            break;
+    }
+
+    st->sink[idx] = (uintptr_t)s;
+}
+
+void bw_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc)
+{
+    const char *names[] = {"read", "write", "copy"};
+    long long xs[MEM_MAX_PTS], min_size, max_size;
+    int k, npts, allocErr = 0;
+    mem_state_t st;
+    FILE *ofp;
+
+    if( NULL == (ofp = mem_open(papi_event_name, params.outputdir, ".mem.bw")) )
+        return;
+
+    memset(&st, 0, sizeof(st));
+    st.ONT = get_thread_count();
+    st.line = line_size(hw_desc);
+
+    // Span the caches as the data cache benchmarks do, up to memory.
+    if( (NULL==hw_desc) || (hw_desc->cache_levels<=0) ){
+        min_size = 16LL*1024;
+        max_size = 512LL*1024*1024;
+    }else{
+        int llc_idx = hw_desc->cache_levels-1;
+        min_size = hw_desc->dcache_size[0]/hw_desc->split[0];
+        max_size = 16LL*(hw_desc->dcache_size[llc_idx])/hw_desc->mmsplit;
+    }
+    npts = mem_sizes(min_size, max_size, 2*st.line, xs);
+
+    // Each thread touches its own buffers first, so they are local to it.
+    #pragma omp parallel default(shared)
+    {
+        int idx = omp_get_thread_num();
+
+        st.a[idx] = (double *)malloc(max_size+st.line);
+        st.b[idx] = (double *)malloc(max_size/2+st.line);
+        if( !st.a[idx] || !st.b[idx] ){
+            #pragma omp critical
+            {
+                allocErr = -1;
+            }
+        }else{
+            memset(st.a[idx], 0, max_size+st.line);
+            memset(st.b[idx], 0, max_size/2+st.line);
+        }
+    }
+    if( allocErr != 0 ){
+        fprintf(stderr, "Error: cannot allocate space for experiment.\n");
+        goto error;
+    }
+
+    d_cache_print_header(ofp, hw_desc);
+
+    for(k = MEM_READ; k <= MEM_COPY; ++k){
+        st.kernel = k;
+        fprintf(ofp, "# KERNEL=%s, LINE=%lld, ThreadCount=%d\n", names[k], st.line, st.ONT);
+        if( mem_sweep(ofp, &st, bw_setup, bw_kernel, xs, npts, params.max_iter) < 0 )
+            break;
+    }
+
+error:
+    for(k=0; k<st.ONT; ++k){
+        free(st.a[k]);
+        free(st.b[k]);
+    }
+    fclose(ofp);
+    return;
+}
+
+/* TLB: a random walk over pages, one access per page, backed by base pages
+ * or by transparent huge pages. The stride is a page plus a line, so the
+ * accesses do not all fall in the same cache set.
+ */
+static double tlb_setup(mem_state_t *st, long long x)
+{
+    int status = 0;
+
+    // "x" is the number of bytes each thread's walk spans.
+    st->len = x/sizeof(uintptr_t);
+
+    #pragma omp parallel reduction(+:status) default(shared)
+    {
+        int idx = omp_get_thread_num();
+
+        status += prepareArray(st->chain[idx], st->len, st->stride, st->len, SECRND);
+    }
+    if( status != 0 )
+        return -1;
+
+    // Walk every page several times, and no fewer than 1M steps.
+    st->reps = 16LL*(x/(st->stride*sizeof(uintptr_t)));
+    if( st->reps < 1024LL*1024 )
+        st->reps = 1024LL*1024;
+    st->reps = 128*((st->reps+127)/128);
+
+    // Count per page visited.
+    return (double)st->reps;
+}
+
+static void tlb_kernel(mem_state_t *st, int idx)
+{
+    register uintptr_t *p = st->chain[idx];
+    long long count = st->reps;
+
+    while(count > 0){
+        N_128;
+        count -= 128;
+    }
+
+    st->sink[idx] = (uintptr_t)p;
+}
+
+static int tlb_map(mem_state_t *st, int pages)
+{
+    int allocErr = 0;
+
+    #pragma omp parallel default(shared)
+    {
+        int idx = omp_get_thread_num();
+        uintptr_t start;
+
+        st->map[idx] = mmap(NULL, st->map_len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if( MAP_FAILED == st->map[idx] ){
+            st->map[idx] = NULL;
+            #pragma omp critical
+            {
+                allocErr = -1;
+            }
+        }else{
+            start = MEM_HUGE_ALIGN*(((uintptr_t)st->map[idx]+MEM_HUGE_ALIGN-1)/MEM_HUGE_ALIGN);
+            st->chain[idx] = (uintptr_t *)start;
+#if defined(MADV_HUGEPAGE)
+            // Only advice: the kernel may not have huge pages to give.
+            madvise((void *)start, st->map_len-MEM_HUGE_ALIGN, (MEM_HUGE_PAGES == pages) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#else
+            (void)pages;
+#endif
+        }
+    }
+
+    return allocErr;
+}
+
+static void tlb_unmap(mem_state_t *st)
+{
+    int k;
+
+    for(k=0; k<st->ONT; ++k){
+        if( NULL != st->map[k] )
+            munmap(st->map[k], st->map_len);
+        st->map[k] = NULL;
+    }
+}
+
+void tlb_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc)
+{
+    long long xs[MEM_MAX_PTS], page_size, stride_in_bytes;
+    int pages, npts;
+    mem_state_t st;
+    FILE *ofp;
+
+    page_size = sysconf(_SC_PAGESIZE);
+    if( page_size <= 0 ){
+        fprintf(stderr,"Cannot determine pagesize, sysconf() returned an error code.\n");
+        return;
+    }
+
+    if( NULL == (ofp = mem_open(papi_event_name, params.outputdir, ".mem.tlb")) )
+        return;
+
+    memset(&st, 0, sizeof(st));
+    st.ONT = get_thread_count();
+    st.line = line_size(hw_desc);
+
+    stride_in_bytes = page_size+st.line;
+    st.stride = stride_in_bytes/sizeof(uintptr_t);
+    npts = mem_sizes(16*stride_in_bytes, MEM_MAX_PAGES*stride_in_bytes, stride_in_bytes, xs);
+    st.map_len = MEM_MAX_PAGES*stride_in_bytes+2*MEM_HUGE_ALIGN;
+
+    d_cache_print_header(ofp, hw_desc);
+
+    for(pages = MEM_BASE_PAGES; pages <= MEM_HUGE_PAGES; ++pages){
+#if !defined(MADV_HUGEPAGE)
+        if( MEM_HUGE_PAGES == pages )
+            break;
+#endif
+        if( tlb_map(&st, pages) < 0 ){
+            fprintf(stderr, "Error: cannot allocate space for experiment.\n");
+            tlb_unmap(&st);
+            break;
+        }
+
+        fprintf(ofp, "# PAGES=%s, PAGESIZE=%lld, STRIDE=%lld, ThreadCount=%d\n", (MEM_HUGE_PAGES == pages) ? "huge" : "base", page_size, stride_in_bytes, st.ONT);
+        if( mem_sweep(ofp, &st, tlb_setup, tlb_kernel, xs, npts, params.max_iter) < 0 ){
+            tlb_unmap(&st);
+            break;
+        }
+        tlb_unmap(&st);
+    }
+
+    fclose(ofp);
+    return;
+}
+
+/* Sharing: pairs of threads hand cache lines back and forth, producer to
+ * consumer, and every thread increments a counter that sits at a varying
+ * distance from those of the other threads. The sharing kernels need at
+ * least two threads; with an odd count, the last one has no partner in the
+ * ping-pong and idles.
+ */
+static inline void share_wait(uintptr_t *flag, uintptr_t val)
+{
+    long long spins = 0;
+
+    while( __atomic_load_n(flag, __ATOMIC_ACQUIRE) != val ){
+        // Let the partner run, in case both threads share a core.
+        if( 0 == (++spins & 0xfff) )
+            sched_yield();
+    }
+}
+
+static double share_setup(mem_state_t *st, long long x)
+{
+    memset(st->shared, 0, st->shared_len);
+
+    if( MEM_PINGPONG == st->kernel ){
+        // "x" is the number of bytes handed over at a time.
+        st->len = x/st->line;
+        st->reps = MEM_HANDOFFS;
+        // Count per line handed over.
+        return (double)st->reps*st->len;
+    }
+
+    // "x" is the distance between the counters of two threads.
+    st->len = x/sizeof(uintptr_t);
+    st->reps = 1024LL*1024;
+    // Count per increment.
+    return (double)st->reps;
+}
+
+static void share_kernel(mem_state_t *st, int idx)
+{
+    long long r, l, step = st->line/sizeof(uintptr_t);
+    uintptr_t s = 0, *flag, *data;
+    volatile uintptr_t *cnt;
+
+    if( MEM_FALSESHARE == st->kernel ){
+        cnt = st->shared + idx*st->len;
+        for(r=0; r<st->reps; ++r)
+            (*cnt)++;
+        return;
+    }
+
+    if( 2*(idx/2)+1 >= st->ONT )
+        return;
+
+    flag = st->shared + (idx/2)*(1+MEM_MAX_LINES)*step;
+    data = flag + step;
+
+    for(r=0; r<st->reps; ++r){
+        if( 0 == idx%2 ){
+            share_wait(flag, 0);
+            for(l=0; l<st->len; ++l)
+                data[l*step] = r;
+            __atomic_store_n(flag, 1, __ATOMIC_RELEASE);
+        }else{
+            share_wait(flag, 1);
+            for(l=0; l<st->len; ++l)
+                s += data[l*step];
+            __atomic_store_n(flag, 0, __ATOMIC_RELEASE);
+        }
+    }
+
+    st->sink[idx] = s;
+}
+
+void share_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc)
+{
+    long long xs[MEM_MAX_PTS];
+    size_t pingpong_len, falseshare_len;
+    int npts;
+    mem_state_t st;
+    FILE *ofp;
+
+    memset(&st, 0, sizeof(st));
+    st.ONT = get_thread_count();
+    st.line = line_size(hw_desc);
+
+    if( st.ONT < 2 ){
+        fprintf(stderr, "The sharing kernels need at least two threads. Skipping event %s.\n", papi_event_name);
+        return;
+    }
+
+    if( NULL == (ofp = mem_open(papi_event_name, params.outputdir, ".mem.share")) )
+        return;
+
+    pingpong_len = (size_t)((st.ONT+1)/2)*(1+MEM_MAX_LINES)*st.line;
+    falseshare_len = (size_t)st.ONT*2*st.line;
+    st.shared_len = (pingpong_len > falseshare_len) ? pingpong_len : falseshare_len;
+    if( posix_memalign((void **)&st.shared, st.line, st.shared_len) ){
+        fprintf(stderr, "Error: cannot allocate space for experiment.\n");
+        goto error;
+    }
+
+    d_cache_print_header(ofp, hw_desc);
+
+    fprintf(ofp, "# KERNEL=pingpong, LINE=%lld, ThreadCount=%d\n", st.line, st.ONT);
+    st.kernel = MEM_PINGPONG;
+    for(npts = 0; npts < 1+(int)log2(MEM_MAX_LINES); ++npts)
+        xs[npts] = st.line << npts;
+    if( mem_sweep(ofp, &st, share_setup, share_kernel, xs, npts, params.max_iter) < 0 )
+        goto error;
+
+    fprintf(ofp, "# KERNEL=falseshare, LINE=%lld, ThreadCount=%d\n", st.line, st.ONT);
+    st.kernel = MEM_FALSESHARE;
+    for(npts = 0; (long long)sizeof(uintptr_t) << npts <= 2*st.line; ++npts)
+        xs[npts] = sizeof(uintptr_t) << npts;
+    mem_sweep(ofp, &st, share_setup, share_kernel, xs, npts, params.max_iter);
+
+error:
+    free(st.shared);
+    fclose(ofp);
+    return;
+}
+
+/* Common to the three families.
+ */
+static FILE* mem_open(char* papi_event_name, char* outdir, const char* sufx)
+{
+    int status, evtCode;
+    char *papiFileName;
+    FILE *ofp = NULL;
+
+    // Use component ID to check if event is a core event.
+    if( PAPI_OK != (status = PAPI_event_name_to_code(papi_event_name, &evtCode)) ) {
+        error_handler(status, __LINE__);
+        return NULL;
+    }
+    mem_is_core = (0 == PAPI_get_event_component(evtCode));
+
+    // Set the name of the event to be monitored during the benchmark.
+    eventname = papi_event_name;
+
+    int l = strlen(outdir)+strlen(papi_event_name)+strlen(sufx);
+    papiFileName = (char *)calloc( 1+l, sizeof(char) );
+    if (!papiFileName) {
+        fprintf(stderr, "Unable to allocate memory. Skipping event %s.\n", papi_event_name);
+        return NULL;
+    }
+    if (l != (sprintf(papiFileName, "%s%s%s", outdir, papi_event_name, sufx))) {
+        fprintf(stderr, "sprintf error. Skipping event %s.\n", papi_event_name);
+        goto error;
+    }
+    if (NULL == (ofp = fopen(papiFileName,"w"))) {
+        fprintf(stderr, "Unable to open file %s. Skipping event %s.\n", papiFileName, papi_event_name);
+    }
+
+error:
+    free(papiFileName);
+    return ofp;
+}
+
+// Sizes from "min" to "max", two per doubling, in multiples of "unit".
+static int mem_sizes(long long min, long long max, long long unit, long long *xs)
+{
+    int npts = 0;
+    double x;
+
+    for(x = (double)min; x <= (double)max && npts < MEM_MAX_PTS; x *= M_SQRT2){
+        xs[npts] = unit*(long long)(x/unit);
+        if( xs[npts] < unit )
+            xs[npts] = unit;
+        ++npts;
+    }
+
+    return npts;
+}
+
+// Run the kernel on all threads at once and store each thread's event count
+// per unit of work. As in probeBufferSize(), every thread counts a core event
+// on its own core, and thread 0 alone counts any other event, for all of them.
+static int mem_measure(mem_state_t *st, mem_kernel_t kernel, double units, double *rslt)
+{
+    int status = 0, ONT = st->ONT;
+    int error_line = -1, error_type = PAPI_OK;
+
+    #pragma omp parallel reduction(+:status) default(shared)
+    {
+        int idx = omp_get_thread_num();
+        int counts = (mem_is_core || 0 == idx);
+        int retval = PAPI_OK, _papi_eventset = PAPI_NULL;
+        long long counter = 0;
+        double divisor = units;
+
+        if( counts ){
+            retval = PAPI_create_eventset( &_papi_eventset );
+            if( PAPI_OK == retval )
+                retval = PAPI_add_named_event( _papi_eventset, eventname );
+            if( PAPI_OK == retval && !mem_is_core )
+                retval = PAPI_start( _papi_eventset );
+        }
+
+        // Start together, so the threads compete for the memory system.
+        #pragma omp barrier
+
+        if( counts && PAPI_OK == retval && mem_is_core )
+            retval = PAPI_start( _papi_eventset );
+
+        kernel(st, idx);
+
+        if( counts && PAPI_OK == retval && mem_is_core )
+            retval = PAPI_stop( _papi_eventset, &counter );
+
+        // Thread 0 counts for everybody, so it waits for everybody.
+        if( !mem_is_core ){
+            #pragma omp barrier
+        }
+
+        if( counts ){
+            if( PAPI_OK == retval && !mem_is_core )
+                retval = PAPI_stop( _papi_eventset, &counter );
+            if( PAPI_NULL != _papi_eventset ){
+                PAPI_cleanup_eventset( _papi_eventset );
+                PAPI_destroy_eventset( &_papi_eventset );
+            }
+            if( !mem_is_core )
+                divisor *= ONT;
+        }
+
+        if( counts && PAPI_OK != retval ){
+            #pragma omp critical
+            {
+                error_type = retval;
+                error_line = __LINE__;
+            }
+            status = -1;
+        }
+        rslt[idx] = (counts && PAPI_OK == retval) ? (1.0*counter)/divisor : -1;
+    }
+
+    if( status < 0 ){
+        error_handler(error_type, error_line);
+        return -1;
+    }
+    return 0;
+}
+
+// Measure every point "max_iter" times and print each thread's smallest
+// count per point, in the format of the data cache benchmarks.
+static int mem_sweep(FILE *ofp, mem_state_t *st, mem_setup_t setup, mem_kernel_t kernel, long long *xs, int npts, int max_iter)
+{
+    int i, j, k, status = 0;
+    double units, *rslt, *best;
+
+    rslt = (double *)malloc(st->ONT*sizeof(double));
+    best = (double *)malloc(npts*st->ONT*sizeof(double));
+    if( !rslt || !best ){
+        fprintf(stderr, "Error: cannot allocate space for experiment.\n");
+        status = -1;
+        goto cleanup;
+    }
+
+    for(j=0; j<npts; ++j){
+        units = setup(st, xs[j]);
+        if( units <= 0 ){
+            status = -1;
+            goto cleanup;
+        }
+        for(i=0; i<max_iter; ++i){
+            status = mem_measure(st, kernel, units, rslt);
+            if( status < 0 )
+                goto cleanup;
+            for(k=0; k<st->ONT; ++k){
+                if( 0 == i || rslt[k] < best[j*st->ONT+k] )
+                    best[j*st->ONT+k] = rslt[k];
+            }
+        }
+    }
+
+    for(j=0; j<npts; ++j){
+        fprintf(ofp, "%lld", xs[j]);
+        for(k=0; k<st->ONT; ++k){
+            fprintf(ofp, " %lf", best[j*st->ONT+k]);
+        }
+        fprintf(ofp, "\n");
+    }
+
+cleanup:
+    free(rslt);
+    free(best);
+    return status;
+}
@@ -0,0 +1,37 @@
+#ifndef _MEMSYS_
+#define _MEMSYS_
+
+#include <stdio.h>
+#include <omp.h>
+#include "hw_desc.h"
+#include "params.h"
+
+// Stream kernels.
+#define MEM_READ  0
+#define MEM_WRITE 1
+#define MEM_COPY  2
+
+// Page sizes for the page walks.
+#define MEM_BASE_PAGES 0
+#define MEM_HUGE_PAGES 1
+
+// Sharing kernels.
+#define MEM_PINGPONG   0
+#define MEM_FALSESHARE 1
+
+// Each thread streams at least this many bytes per measurement.
+#define MEM_MIN_TRAFFIC (64LL*1024*1024)
+// Page walks span up to this many pages per thread.
+#define MEM_MAX_PAGES 32768
+// Huge pages are this large, and buffers are aligned to it.
+#define MEM_HUGE_ALIGN (2LL*1024*1024)
+// A producer hands over up to this many lines at a time.
+#define MEM_MAX_LINES 64
+#define MEM_HANDOFFS  100000
+#define MEM_MAX_PTS   64
+
+void bw_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc);
+void tlb_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc);
+void share_driver(char* papi_event_name, cat_params_t params, hw_desc_t *hw_desc);
+
+#endif
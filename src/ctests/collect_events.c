@@ -0,0 +1,110 @@
+/*
+ * This counts a list of events over repeated runs of a small workload
+ * with PAPI_collect_events(), and checks the merged table: the made up
+ * event is left out, a repeated event gets the count of its first copy,
+ * and the task clock of every pass is counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#define PAGES 64
+#define REPEAT 3
+
+static char *names[] = {
+	"PAPI_TOT_INS", "PAPI_TOT_CYC", "PAPI_L1_DCM", "PAPI_BR_MSP",
+	"perf::TASK-CLOCK", "perf::PAGE-FAULTS", "perf::CONTEXT-SWITCHES",
+	"perf::PAGE-FAULTS", "NO_SUCH_EVENT_AT_ALL"
+};
+#define NUM_NAMES ( int ) ( sizeof ( names ) / sizeof ( names[0] ) )
+
+static int calls;
+
+/* Touch a buffer page by page */
+static void
+workload( void *arg )
+{
+	long page = *( long * ) arg;
+	char *buf;
+	int i;
+
+	buf = malloc( PAGES * page );
+	if ( buf == NULL )
+		return;
+	for ( i = 0; i < PAGES; i++ )
+		buf[i * page] = ( char ) i;
+	free( buf );
+	calls++;
+}
+
+int
+main( int argc, char **argv )
+{
+	long long values[NUM_NAMES];
+	double variance[NUM_NAMES];
+	int group[NUM_NAMES], pass[NUM_NAMES];
+	int retval, quiet, passes, i, faults = -1, clock = -1;
+	long page = 4096;
+
+	/* Set TESTS_QUIET variable */
+	quiet = tests_quiet( argc, argv );
+
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	retval = PAPI_plan_events( names, NUM_NAMES, group, pass );
+	if ( retval < 0 ) {
+		test_fail( __FILE__, __LINE__, "PAPI_plan_events", retval );
+	}
+	if ( retval == 0 ) {
+		test_skip( __FILE__, __LINE__, "No events could be planned", 0 );
+	}
+
+	passes = PAPI_collect_events( names, NUM_NAMES, workload, &page,
+								  REPEAT, values, variance );
+	if ( passes < 0 ) {
+		test_fail( __FILE__, __LINE__, "PAPI_collect_events", passes );
+	}
+	if ( passes != retval || calls != passes * REPEAT ) {
+		test_fail( __FILE__, __LINE__, "workload runs", calls );
+	}
+
+	for ( i = 0; i < NUM_NAMES; i++ ) {
+		if ( !quiet ) {
+			printf( "%-24s pass %2d %12lld variance %.1f\n", names[i],
+					pass[i], values[i], variance[i] );
+		}
+		if ( ( pass[i] < 0 ) != ( variance[i] < 0 ) ) {
+			test_fail( __FILE__, __LINE__, "uncounted events", 1 );
+		}
+		if ( !strcmp( names[i], "perf::TASK-CLOCK" ) )
+			clock = i;
+		if ( !strcmp( names[i], "perf::PAGE-FAULTS" ) ) {
+			if ( faults < 0 )
+				faults = i;
+			else if ( values[i] != values[faults] ||
+					  variance[i] != variance[faults] )
+				test_fail( __FILE__, __LINE__, "repeated event", 1 );
+		}
+	}
+
+	if ( variance[NUM_NAMES - 1] >= 0 ) {
+		test_fail( __FILE__, __LINE__, "made up event was counted", 1 );
+	}
+	if ( pass[clock] >= 0 && values[clock] <= 0 ) {
+		test_fail( __FILE__, __LINE__, "perf::TASK-CLOCK", 1 );
+	}
+
+	if ( !quiet )
+		printf( "%d passes of %d runs\n", passes, REPEAT );
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
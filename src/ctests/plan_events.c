@@ -0,0 +1,89 @@
+/*
+ * This plans a list of events, with a repeated and a made up one, with
+ * PAPI_plan_events() and checks the plan: the made up event is left out,
+ * the repeated one shares the group of its first copy, and the events
+ * of every group can be added to one EventSet together.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+static char *names[] = {
+	"PAPI_TOT_INS", "PAPI_TOT_CYC", "PAPI_L1_DCM", "PAPI_L2_TCM",
+	"PAPI_BR_MSP", "PAPI_BR_INS", "PAPI_LD_INS", "PAPI_SR_INS",
+	"perf::TASK-CLOCK", "perf::PAGE-FAULTS", "perf::CONTEXT-SWITCHES",
+	"PAPI_TOT_INS", "NO_SUCH_EVENT_AT_ALL"
+};
+#define NUM_NAMES ( int ) ( sizeof ( names ) / sizeof ( names[0] ) )
+
+int
+main( int argc, char **argv )
+{
+	int group[NUM_NAMES], pass[NUM_NAMES];
+	int retval, quiet, passes, groups = 0, i, g, EventSet;
+
+	/* Set TESTS_QUIET variable */
+	quiet = tests_quiet( argc, argv );
+
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	passes = PAPI_plan_events( names, NUM_NAMES, group, pass );
+	if ( passes < 0 ) {
+		test_fail( __FILE__, __LINE__, "PAPI_plan_events", passes );
+	}
+
+	if ( group[NUM_NAMES - 1] != -1 || pass[NUM_NAMES - 1] != -1 ) {
+		test_fail( __FILE__, __LINE__, "made up event was planned", 1 );
+	}
+	if ( group[NUM_NAMES - 2] != group[0] || pass[NUM_NAMES - 2] != pass[0] ) {
+		test_fail( __FILE__, __LINE__, "repeated event was planned apart", 1 );
+	}
+
+	for ( i = 0; i < NUM_NAMES; i++ ) {
+		if ( group[i] >= groups )
+			groups = group[i] + 1;
+		if ( ( group[i] < 0 ) != ( pass[i] < 0 ) ||
+			 pass[i] >= passes ) {
+			test_fail( __FILE__, __LINE__, "group and pass disagree", 1 );
+		}
+		if ( !quiet )
+			printf( "%-24s group %2d pass %2d\n", names[i], group[i], pass[i] );
+	}
+
+	if ( groups == 0 ) {
+		test_skip( __FILE__, __LINE__, "No events could be planned", 0 );
+	}
+
+	for ( g = 0; g < groups; g++ ) {
+		EventSet = PAPI_NULL;
+		retval = PAPI_create_eventset( &EventSet );
+		if ( retval != PAPI_OK ) {
+			test_fail( __FILE__, __LINE__, "PAPI_create_eventset", retval );
+		}
+		for ( i = 0; i < NUM_NAMES - 2; i++ ) {
+			if ( group[i] != g )
+				continue;
+			retval = PAPI_add_named_event( EventSet, names[i] );
+			if ( retval != PAPI_OK ) {
+				if ( !quiet )
+					printf( "Group %d refused %s\n", g, names[i] );
+				test_fail( __FILE__, __LINE__, "PAPI_add_named_event", retval );
+			}
+		}
+		PAPI_cleanup_eventset( EventSet );
+		PAPI_destroy_eventset( &EventSet );
+	}
+
+	if ( !quiet )
+		printf( "%d groups in %d passes\n", groups, passes );
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * This checks the read path array kernels (gather, delta, accumulate
+ * and multiplex scaling) against their scalar versions, and times both
+ * for EventSets of 64 to 384 counters.
+ *
+ * The kernels are internal to the library, so they are built into the
+ * test from the source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "papi.h"
+#include "papi_test.h"
+
+#include "papi_simd.h"
+
+#define REPEAT 20000
+
+static const int sizes[] = { 64, 128, 256, 384 };
+#define NUM_SIZES ( int ) ( sizeof ( sizes ) / sizeof ( sizes[0] ) )
+
+enum { GATHER, DELTA, ACCUM, SCALE, SCALE_MPX, NUM_KERNELS };
+static const char *kernel_name[NUM_KERNELS] =
+	{ "gather", "delta", "accum", "scale", "scale_mpx" };
+
+static long long src[384], start[384], enabled[384], running[384];
+static long long running_mpx[384];
+static int pos[384];
+
+static void
+run_kernel( int kernel, long long *dst, int n )
+{
+	switch ( kernel ) {
+	case GATHER:
+		_papi_simd_gather( dst, src, pos, n );
+		break;
+	case DELTA:
+		_papi_simd_delta( dst, src, start, n );
+		break;
+	case ACCUM:
+		_papi_simd_accum( dst, src, n );
+		break;
+	case SCALE:
+		_papi_simd_scale( dst, enabled, running, n );
+		break;
+	case SCALE_MPX:
+		_papi_simd_scale( dst, enabled, running_mpx, n );
+		break;
+	}
+}
+
+/* Nanoseconds per call, best of a few rounds */
+static double
+time_kernel( int kernel, long long *dst, int n )
+{
+	long long t, best = -1;
+	int round, r;
+
+	for ( round = 0; round < 5; round++ ) {
+		t = PAPI_get_real_nsec(  );
+		for ( r = 0; r < REPEAT; r++ ) {
+			run_kernel( kernel, dst, n );
+			/* keep the calls from being merged */
+			__asm__ __volatile__( "" : : "r"( dst ) : "memory" );
+		}
+		t = PAPI_get_real_nsec(  ) - t;
+		if ( best < 0 || t < best )
+			best = t;
+	}
+	return ( double ) best / REPEAT;
+}
+
+int
+main( int argc, char **argv )
+{
+	long long expect[384], got[384], init[384];
+	double scalar_ns, simd_ns;
+	int retval, quiet, level, i, k, s, n;
+
+	/* Set TESTS_QUIET variable */
+	quiet = tests_quiet( argc, argv );
+
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		test_fail( __FILE__, __LINE__, "PAPI_library_init", retval );
+	}
+
+	/* A scrambled mapping with unmapped events.  For scaling, no  */
+	/* counter was multiplexed, or every third one was (one in     */
+	/* nine of those was never scheduled).                         */
+	srand( 1 );
+	for ( i = 0; i < 384; i++ ) {
+		src[i] = ( ( long long ) rand(  ) << 20 ) + rand(  );
+		start[i] = rand(  );
+		init[i] = -i;
+		pos[i] = ( i % 17 == 5 ) ? -1 : ( i * 7 ) % 384;
+		enabled[i] = 1000000 + rand(  ) % 1000;
+		running[i] = enabled[i];
+		running_mpx[i] = ( i % 3 ) ? enabled[i] :
+			( i % 9 ) ? enabled[i] / 3 : 0;
+	}
+
+	level = _papi_simd_level(  );
+	if ( !quiet ) {
+		printf( "Kernel level: %s\n", level == PAPI_SIMD_AVX2 ? "AVX2" :
+			level == PAPI_SIMD_NEON ? "NEON" : "scalar" );
+		printf( "%-9s %6s %12s %12s %8s\n", "kernel", "events",
+			"scalar ns", "simd ns", "speedup" );
+	}
+
+	for ( k = 0; k < NUM_KERNELS; k++ ) {
+		for ( s = 0; s < NUM_SIZES; s++ ) {
+			n = sizes[s];
+
+			/* the results must not depend on the level */
+			_papi_simd_set_level( PAPI_SIMD_SCALAR );
+			memcpy( expect, init, sizeof ( init ) );
+			run_kernel( k, expect, n );
+			scalar_ns = time_kernel( k, got, n );
+
+			_papi_simd_set_level( level );
+			memcpy( got, init, sizeof ( init ) );
+			run_kernel( k, got, n );
+			if ( memcmp( got, expect, sizeof ( got ) ) ) {
+				test_fail( __FILE__, __LINE__, kernel_name[k], 1 );
+			}
+			simd_ns = time_kernel( k, got, n );
+
+			if ( !quiet ) {
+				printf( "%-9s %6d %12.1f %12.1f %7.2fx\n",
+					kernel_name[k], n, scalar_ns, simd_ns,
+					simd_ns > 0 ? scalar_ns / simd_ns : 0.0 );
+			}
+		}
+	}
+
+	test_pass( __FILE__ );
+
+	return 0;
+}
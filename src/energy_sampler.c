@@ -0,0 +1,383 @@
+/*
+* File:    energy_sampler.c
+*
+* A thread that polls the energy counters of a component so wraparound
+* is never missed, however rarely the application calls PAPI_read().
+* The component's read then only takes the accumulated total, which
+* costs a mutex and no system call.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "papi.h"
+#include "papi_internal.h"
+#include "papi_memory.h"
+#include "energy_sampler.h"
+
+#define ENERGY_SAMPLER_HISTORY 1024
+
+struct energy_sampler {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	int stop;
+	int running;			/* the sampler thread exists, not so in a forked child */
+	int forked;			/* in a child, which leaves the file to the parent */
+	long long interval_ns;
+
+	energy_sampler_read_t read;
+	energy_channel_t *channel;
+	int num_channels;
+
+	long long *raw;			/* scratch for one pass, sampler thread only */
+	long long *last;		/* raw value at the previous pass */
+	long long *total;		/* accumulated raw units */
+
+	/* ring of (time, totals) entries, num_channels + 1 each */
+	long long *history;
+	int history_len;
+	int history_next;
+	int history_count;
+	char *file;
+
+	energy_sampler_t *next;	/* on the list of running samplers */
+};
+
+/* Running samplers, so a fork can take their locks and reset them in the child */
+static pthread_mutex_t sampler_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t sampler_atfork_once = PTHREAD_ONCE_INIT;
+static energy_sampler_t *sampler_list;
+
+/* The sampler thread waits on a monotonic deadline */
+static void
+sampler_cond_init( energy_sampler_t * s )
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init( &attr );
+	pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+	pthread_cond_init( &s->wake, &attr );
+	pthread_condattr_destroy( &attr );
+}
+
+/* No pass may be half done when the address space is copied */
+static void
+sampler_fork_prepare( void )
+{
+	energy_sampler_t *s;
+
+	pthread_mutex_lock( &sampler_list_lock );
+	for ( s = sampler_list; s; s = s->next )
+		pthread_mutex_lock( &s->lock );
+}
+
+static void
+sampler_fork_parent( void )
+{
+	energy_sampler_t *s;
+
+	for ( s = sampler_list; s; s = s->next )
+		pthread_mutex_unlock( &s->lock );
+	pthread_mutex_unlock( &sampler_list_lock );
+}
+
+/* The sampler threads were not copied, and the condition still counts them
+   as waiters. The totals carry on from the parent's, and the next read in
+   the child starts a new thread. */
+static void
+sampler_fork_child( void )
+{
+	energy_sampler_t *s;
+
+	for ( s = sampler_list; s; s = s->next ) {
+		s->running = 0;
+		s->forked = 1;
+		s->history_next = 0;
+		s->history_count = 0;
+		sampler_cond_init( s );
+		pthread_mutex_unlock( &s->lock );
+	}
+	pthread_mutex_unlock( &sampler_list_lock );
+}
+
+static void
+sampler_atfork_init( void )
+{
+	pthread_atfork( sampler_fork_prepare, sampler_fork_parent,
+			sampler_fork_child );
+}
+
+static long long
+sampler_now( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ( long long ) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Read every sampled channel and fold the differences into the totals.
+   The first pass only sets the starting point. */
+static void
+sampler_pass( energy_sampler_t * s, int first )
+{
+	long long now, diff, *entry;
+	int i;
+
+	for ( i = 0; i < s->num_channels; i++ ) {
+		if ( s->channel[i].range )
+			s->raw[i] = s->read( i );
+	}
+	now = sampler_now(  );
+
+	pthread_mutex_lock( &s->lock );
+	for ( i = 0; i < s->num_channels; i++ ) {
+		if ( !s->channel[i].range || first )
+			continue;
+		diff = s->raw[i] - s->last[i];
+		if ( diff < 0 )
+			diff += s->channel[i].range;
+		s->total[i] += diff;
+	}
+	memcpy( s->last, s->raw, s->num_channels * sizeof ( long long ) );
+
+	if ( s->history ) {
+		entry = s->history + ( size_t ) s->history_next * ( s->num_channels + 1 );
+		entry[0] = now;
+		memcpy( entry + 1, s->total, s->num_channels * sizeof ( long long ) );
+		s->history_next = ( s->history_next + 1 ) % s->history_len;
+		if ( s->history_count < s->history_len )
+			s->history_count++;
+	}
+	pthread_mutex_unlock( &s->lock );
+}
+
+static void *
+sampler_thread( void *arg )
+{
+	energy_sampler_t *s = ( energy_sampler_t * ) arg;
+	struct timespec deadline;
+	long long next = sampler_now(  );
+
+	pthread_mutex_lock( &s->lock );
+	while ( !s->stop ) {
+		next += s->interval_ns;
+		deadline.tv_sec = next / 1000000000LL;
+		deadline.tv_nsec = next % 1000000000LL;
+		while ( !s->stop &&
+			pthread_cond_timedwait( &s->wake, &s->lock, &deadline ) != ETIMEDOUT );
+		if ( s->stop )
+			break;
+		pthread_mutex_unlock( &s->lock );
+		sampler_pass( s, 0 );
+		pthread_mutex_lock( &s->lock );
+	}
+	pthread_mutex_unlock( &s->lock );
+	return NULL;
+}
+
+/* Write the history ring as power per channel between entries */
+static void
+sampler_write_history( energy_sampler_t * s )
+{
+	long long *prev, *entry, t0;
+	double secs;
+	FILE *fff;
+	int e, i, first;
+
+	fff = fopen( s->file, "w" );
+	if ( fff == NULL ) {
+		PAPIERROR( "Could not open energy sample file %s", s->file );
+		return;
+	}
+
+	fprintf( fff, "# time_nsec" );
+	for ( i = 0; i < s->num_channels; i++ ) {
+		if ( s->channel[i].range )
+			fprintf( fff, " %s(W)", s->channel[i].name );
+	}
+	fprintf( fff, "\n" );
+
+	first = ( s->history_next - s->history_count + s->history_len ) % s->history_len;
+	prev = s->history + ( size_t ) first * ( s->num_channels + 1 );
+	t0 = prev[0];
+	for ( e = 1; e < s->history_count; e++ ) {
+		entry = s->history +
+			( size_t ) ( ( first + e ) % s->history_len ) * ( s->num_channels + 1 );
+		secs = ( double ) ( entry[0] - prev[0] ) / 1e9;
+		fprintf( fff, "%lld", entry[0] - t0 );
+		for ( i = 0; i < s->num_channels; i++ ) {
+			if ( !s->channel[i].range )
+				continue;
+			fprintf( fff, " %.3f", secs > 0 ?
+				 ( double ) ( entry[i + 1] - prev[i + 1] ) *
+				 s->channel[i].joules / secs : 0.0 );
+		}
+		fprintf( fff, "\n" );
+		prev = entry;
+	}
+	fclose( fff );
+}
+
+/* Keep overflow and timer signals on the application's threads */
+static int
+sampler_spawn( energy_sampler_t * s )
+{
+	sigset_t all, old;
+	int retval;
+
+	sigfillset( &all );
+	pthread_sigmask( SIG_SETMASK, &all, &old );
+	retval = pthread_create( &s->thread, NULL, sampler_thread, s );
+	pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+	return retval;
+}
+
+static void
+sampler_free( energy_sampler_t * s )
+{
+	papi_free( s->channel );
+	papi_free( s->raw );
+	papi_free( s->last );
+	papi_free( s->total );
+	if ( s->history )
+		papi_free( s->history );
+	if ( s->file )
+		papi_free( s->file );
+	papi_free( s );
+}
+
+static int
+sampler_env( const char *prefix, const char *name, char *buf, int len,
+	     const char **value )
+{
+	snprintf( buf, len, "%s_SAMPLE_%s", prefix, name );
+	*value = getenv( buf );
+	return *value != NULL && **value != '\0';
+}
+
+/* Start sampling if <prefix>_SAMPLE_INTERVAL asks for it, otherwise
+   return NULL and the component reads its counters itself. */
+energy_sampler_t *
+_papi_energy_sampler_start( const char *prefix,
+			    const energy_channel_t * channel, int num_channels,
+			    energy_sampler_read_t read )
+{
+	energy_sampler_t *s;
+	char name[PAPI_MIN_STR_LEN];
+	const char *value;
+	long long interval;
+	int len;
+
+	if ( !sampler_env( prefix, "INTERVAL", name, sizeof ( name ), &value ) )
+		return NULL;
+	interval = atoll( value );
+	if ( interval <= 0 || num_channels <= 0 )
+		return NULL;
+
+	s = papi_calloc( 1, sizeof ( energy_sampler_t ) );
+	if ( s == NULL )
+		return NULL;
+	s->interval_ns = interval * 1000000LL;
+	s->read = read;
+	s->num_channels = num_channels;
+	s->channel = papi_malloc( num_channels * sizeof ( energy_channel_t ) );
+	s->raw = papi_calloc( num_channels, sizeof ( long long ) );
+	s->last = papi_calloc( num_channels, sizeof ( long long ) );
+	s->total = papi_calloc( num_channels, sizeof ( long long ) );
+	if ( !s->channel || !s->raw || !s->last || !s->total )
+		goto fail;
+	memcpy( s->channel, channel, num_channels * sizeof ( energy_channel_t ) );
+
+	if ( sampler_env( prefix, "FILE", name, sizeof ( name ), &value ) ) {
+		s->file = papi_strdup( value );
+		len = ENERGY_SAMPLER_HISTORY;
+		if ( sampler_env( prefix, "HISTORY", name, sizeof ( name ), &value ) &&
+		     atoi( value ) > 1 )
+			len = atoi( value );
+		s->history_len = len;
+		s->history = papi_calloc( ( size_t ) len * ( num_channels + 1 ),
+					  sizeof ( long long ) );
+		if ( !s->file || !s->history )
+			goto fail;
+	}
+
+	pthread_mutex_init( &s->lock, NULL );
+	sampler_cond_init( s );
+
+	/* the starting point, taken here so files are opened on this thread */
+	sampler_pass( s, 1 );
+
+	pthread_once( &sampler_atfork_once, sampler_atfork_init );
+	pthread_mutex_lock( &sampler_list_lock );
+	if ( sampler_spawn( s ) ) {
+		pthread_mutex_unlock( &sampler_list_lock );
+		pthread_cond_destroy( &s->wake );
+		pthread_mutex_destroy( &s->lock );
+		goto fail;
+	}
+	s->running = 1;
+	s->next = sampler_list;
+	sampler_list = s;
+	pthread_mutex_unlock( &sampler_list_lock );
+
+	SUBDBG( "%s energy sampler every %lld ms\n", prefix, interval );
+	return s;
+
+  fail:
+	sampler_free( s );
+	return NULL;
+}
+
+/* Raw units accumulated on a channel since the sampler started */
+long long
+_papi_energy_sampler_total( energy_sampler_t * s, int channel )
+{
+	long long total;
+
+	pthread_mutex_lock( &s->lock );
+	if ( !s->running && !s->stop )
+		s->running = ( sampler_spawn( s ) == 0 );
+	total = s->total[channel];
+	pthread_mutex_unlock( &s->lock );
+
+	return total;
+}
+
+void
+_papi_energy_sampler_stop( energy_sampler_t * s )
+{
+	energy_sampler_t **p;
+
+	if ( s == NULL )
+		return;
+
+	pthread_mutex_lock( &sampler_list_lock );
+	for ( p = &sampler_list; *p; p = &( *p )->next ) {
+		if ( *p == s ) {
+			*p = s->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock( &sampler_list_lock );
+
+	pthread_mutex_lock( &s->lock );
+	s->stop = 1;
+	pthread_cond_signal( &s->wake );
+	pthread_mutex_unlock( &s->lock );
+	if ( s->running )
+		pthread_join( s->thread, NULL );
+
+	if ( s->history && !s->forked )
+		sampler_write_history( s );
+
+	pthread_cond_destroy( &s->wake );
+	pthread_mutex_destroy( &s->lock );
+	sampler_free( s );
+}
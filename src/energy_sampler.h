@@ -0,0 +1,32 @@
+#ifndef ENERGY_SAMPLER_H
+#define ENERGY_SAMPLER_H
+
+/* Background polling of energy counters that wrap, for components
+   whose users may read less often than the counters wrap.
+
+   A component describes one channel per native event and the sampler
+   thread reads them every <prefix>_SAMPLE_INTERVAL milliseconds,
+   adding the wrap-corrected differences into 64-bit totals.  If
+   <prefix>_SAMPLE_FILE is set, the totals are also kept in a ring of
+   <prefix>_SAMPLE_HISTORY entries (1024 by default) which is written
+   to that file as a power time series when the sampler stops. */
+
+typedef struct energy_channel {
+	const char *name;		/* column heading, must outlive the sampler */
+	long long range;		/* raw value wraps here, 0 = not sampled */
+	double joules;			/* joules per raw unit */
+} energy_channel_t;
+
+typedef long long ( *energy_sampler_read_t ) ( int channel );
+
+typedef struct energy_sampler energy_sampler_t;
+
+energy_sampler_t *_papi_energy_sampler_start( const char *prefix,
+					      const energy_channel_t * channel,
+					      int num_channels,
+					      energy_sampler_read_t read );
+long long _papi_energy_sampler_total( energy_sampler_t * sampler,
+				      int channel );
+void _papi_energy_sampler_stop( energy_sampler_t * sampler );
+
+#endif /* ENERGY_SAMPLER_H */
@@ -204,6 +204,8 @@ static void _internal_hl_json_threads(FILE* f, bool beautifier, unsigned long* t
 static int _internal_hl_cmpfunc(const void * a, const void * b);
 static int _internal_get_sorted_thread_list(unsigned long** tids, int* threads_num);
 static void _internal_hl_write_json_file(FILE* f, unsigned long* tids, int threads_num);
+static void _internal_hl_bin_string(FILE* f, const char *str);
+static void _internal_hl_write_binary_file(FILE* f, unsigned long* tids, int threads_num);
 static void _internal_hl_read_json_file(const char* path);
 static void _internal_hl_write_output();
 
@@ -1471,6 +1473,193 @@ static void _internal_hl_write_json_file(FILE* f, unsigned long* tids, int threa
    fprintf(f, "\n");
 }
 
+/* Binary output, selected with PAPI_OUTPUT_FORMAT=binary. Much smaller and
+ * faster to merge than JSON for runs with many ranks. Integers are in host
+ * byte order, given by the byte order mark, and strings are a uint16_t
+ * length followed by the characters:
+ *
+ *   char     magic[8]            "PAPI-HL"
+ *   uint32_t byte_order          0x01020304
+ *   uint32_t format_version      1
+ *   uint32_t papi_version
+ *   int32_t  max_cpu_rate_mhz, min_cpu_rate_mhz
+ *   string   cpu_info
+ *   uint32_t num_events, num_names, num_threads, num_records
+ *   num_events x { string name, string component, uint8_t type }
+ *   num_names  x string                       interned region names
+ *   uint32_t thread[num_records]              one column per field
+ *   uint32_t region_id[num_records]
+ *   int32_t  parent_region_id[num_records]
+ *   uint32_t name[num_records]                index into the names
+ *   num_events x int64_t region_value[num_records]
+ *   num_events x num_records x { uint32_t n, int64_t read[n] }
+ *
+ * Records are the regions of each thread in the order of the JSON output;
+ * the first two events are cycles and real_time_nsec, with no component.
+ * high-level/scripts/papi_hl_merge.py reads both formats. */
+#define PAPIHL_BINARY_MAGIC "PAPI-HL"
+#define PAPIHL_BINARY_VERSION 1
+
+static void _internal_hl_bin_string(FILE* f, const char *str)
+{
+   size_t len = strlen(str);
+   uint16_t n = len > UINT16_MAX ? UINT16_MAX : (uint16_t)len;
+   fwrite(&n, sizeof(n), 1, f);
+   fwrite(str, 1, n, f);
+}
+
+static void _internal_hl_write_binary_file(FILE* f, unsigned long* tids, int threads_num)
+{
+   char magic[8] = PAPIHL_BINARY_MAGIC;
+   uint32_t u32, num_events, num_names = 0, max_names = 0, num_records = 0, r;
+   int32_t i32;
+   uint8_t type;
+   const char **names = NULL;
+   regions_t **records = NULL, *regions;
+   uint32_t *record_thread = NULL, *record_name = NULL;
+   int i, j, k;
+
+   /* collect the records of all threads, oldest region first as in JSON */
+   for ( i = 0; i < threads_num; i++ ) {
+      threads_t* thread_node = _internal_hl_find_thread_node(tids[i]);
+      if ( thread_node == NULL )
+         continue;
+      for ( regions = thread_node->value; regions != NULL; regions = regions->next )
+         num_records++;
+   }
+   records = malloc((num_records ? num_records : 1) * sizeof(regions_t*));
+   record_thread = malloc((num_records ? num_records : 1) * sizeof(uint32_t));
+   record_name = malloc((num_records ? num_records : 1) * sizeof(uint32_t));
+   if ( records == NULL || record_thread == NULL || record_name == NULL ) {
+      verbose_fprintf(stdout, "PAPI-HL Error: OOM!\n");
+      goto out;
+   }
+
+   r = 0;
+   for ( i = 0; i < threads_num; i++ ) {
+      threads_t* thread_node = _internal_hl_find_thread_node(tids[i]);
+      if ( thread_node == NULL || thread_node->value == NULL )
+         continue;
+      regions = thread_node->value;
+      while ( regions->next != NULL )
+         regions = regions->next;
+      for ( ; regions != NULL; regions = regions->prev ) {
+         /* intern the region name */
+         for ( u32 = 0; u32 < num_names; u32++ ) {
+            if ( strcmp(names[u32], regions->region) == 0 )
+               break;
+         }
+         if ( u32 == num_names ) {
+            if ( num_names == max_names ) {
+               const char **tmp;
+               max_names = max_names ? 2 * max_names : 16;
+               if ( ( tmp = realloc(names, max_names * sizeof(char*)) ) == NULL ) {
+                  verbose_fprintf(stdout, "PAPI-HL Error: OOM!\n");
+                  goto out;
+               }
+               names = tmp;
+            }
+            names[num_names++] = regions->region;
+         }
+         records[r] = regions;
+         record_thread[r] = i;
+         record_name[r] = u32;
+         r++;
+      }
+   }
+   num_records = r;
+
+   /* header */
+   fwrite(magic, sizeof(magic), 1, f);
+   u32 = 0x01020304;
+   fwrite(&u32, sizeof(u32), 1, f);
+   u32 = PAPIHL_BINARY_VERSION;
+   fwrite(&u32, sizeof(u32), 1, f);
+   u32 = PAPI_VERSION;
+   fwrite(&u32, sizeof(u32), 1, f);
+   const PAPI_hw_info_t *hwinfo = PAPI_get_hardware_info(  );
+   i32 = hwinfo ? hwinfo->cpu_max_mhz : 0;
+   fwrite(&i32, sizeof(i32), 1, f);
+   i32 = hwinfo ? hwinfo->cpu_min_mhz : 0;
+   fwrite(&i32, sizeof(i32), 1, f);
+   if ( hwinfo ) {
+      char* cpu_info = _internal_hl_remove_spaces(strdup(hwinfo->model_string), 1);
+      _internal_hl_bin_string(f, cpu_info);
+      free(cpu_info);
+   } else {
+      _internal_hl_bin_string(f, "");
+   }
+   num_events = total_num_events + 2;
+   fwrite(&num_events, sizeof(num_events), 1, f);
+   fwrite(&num_names, sizeof(num_names), 1, f);
+   u32 = threads_num;
+   fwrite(&u32, sizeof(u32), 1, f);
+   fwrite(&num_records, sizeof(num_records), 1, f);
+
+   /* event definitions */
+   type = 0;
+   _internal_hl_bin_string(f, "cycles");
+   _internal_hl_bin_string(f, "");
+   fwrite(&type, sizeof(type), 1, f);
+   _internal_hl_bin_string(f, "real_time_nsec");
+   _internal_hl_bin_string(f, "");
+   fwrite(&type, sizeof(type), 1, f);
+   for ( i = 0; i < num_of_components; i++ ) {
+      const PAPI_component_info_t* cmpinfo;
+      cmpinfo = PAPI_get_component_info( components[i].component_id );
+      for ( j = 0; j < components[i].num_of_events; j++ ) {
+         _internal_hl_bin_string(f, components[i].event_names[j]);
+         _internal_hl_bin_string(f, cmpinfo->name);
+         type = components[i].event_types[j] == 1 ? 1 : 0;
+         fwrite(&type, sizeof(type), 1, f);
+      }
+   }
+
+   /* interned region names */
+   for ( u32 = 0; u32 < num_names; u32++ )
+      _internal_hl_bin_string(f, names[u32]);
+
+   /* columns */
+   fwrite(record_thread, sizeof(uint32_t), num_records, f);
+   for ( r = 0; r < num_records; r++ )
+      fwrite(&records[r]->region_id, sizeof(uint32_t), 1, f);
+   for ( r = 0; r < num_records; r++ ) {
+      i32 = records[r]->parent_region_id;
+      fwrite(&i32, sizeof(i32), 1, f);
+   }
+   fwrite(record_name, sizeof(uint32_t), num_records, f);
+   for ( k = 0; k < (int)num_events; k++ ) {
+      for ( r = 0; r < num_records; r++ ) {
+         int64_t value = records[r]->values[k].region_value;
+         fwrite(&value, sizeof(value), 1, f);
+      }
+   }
+
+   /* values of PAPI_hl_read, oldest first */
+   for ( k = 0; k < (int)num_events; k++ ) {
+      for ( r = 0; r < num_records; r++ ) {
+         reads_t* read_node = records[r]->values[k].read_values;
+         for ( u32 = 0; read_node != NULL; u32++ ) {
+            if ( read_node->next == NULL )
+               break;
+            read_node = read_node->next;
+         }
+         u32 = read_node ? u32 + 1 : 0;
+         fwrite(&u32, sizeof(u32), 1, f);
+         for ( ; read_node != NULL; read_node = read_node->prev ) {
+            int64_t value = read_node->value;
+            fwrite(&value, sizeof(value), 1, f);
+         }
+      }
+   }
+
+out:
+   free(names);
+   free(records);
+   free(record_thread);
+   free(record_name);
+}
+
 static void _internal_hl_read_json_file(const char* path)
 {
    /* print output to stdout */
@@ -1520,6 +1709,15 @@ static void _internal_hl_write_output()
          /* determine rank for output file */
          int rank = _internal_hl_determine_rank();
 
+         /* JSON, or binary with PAPI_OUTPUT_FORMAT=binary */
+         bool binary = false;
+         if ( getenv("PAPI_OUTPUT_FORMAT") != NULL ) {
+            if ( strcmp(getenv("PAPI_OUTPUT_FORMAT"), "binary") == 0 )
+               binary = true;
+            else if ( strcmp(getenv("PAPI_OUTPUT_FORMAT"), "json") != 0 )
+               verbose_fprintf(stdout, "PAPI-HL Warning: Unknown PAPI_OUTPUT_FORMAT %s, writing JSON.\n", getenv("PAPI_OUTPUT_FORMAT"));
+         }
+
          /* if system does not provide rank id, create a random id */
          if ( rank < 0 ) {
             srandom( time(NULL) + getpid() );
@@ -1542,7 +1740,8 @@ static void _internal_hl_write_output()
          /* create unique output file per process based on rank variable */
          while ( unique_output_file_created == 0 ) {
             rank += random_cnt;
-            sprintf(final_absolute_output_file_path, "%s/rank_%06d.json", absolute_output_file_path, rank);
+            sprintf(final_absolute_output_file_path, "%s/rank_%06d.%s", absolute_output_file_path, rank,
+                    binary ? "bin" : "json");
 
             fd = open(final_absolute_output_file_path, O_WRONLY|O_APPEND|O_CREAT|O_NONBLOCK, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
             if ( fd == -1 ) {
@@ -1575,13 +1774,19 @@ static void _internal_hl_write_output()
                      return;
                   }
 
-                  /* start writing json output */
-                  _internal_hl_write_json_file(fp, tids, threads_num);
+                  /* start writing output */
+                  if ( binary )
+                     _internal_hl_write_binary_file(fp, tids, threads_num);
+                  else
+                     _internal_hl_write_json_file(fp, tids, threads_num);
                   free(tids);
                   fclose(fp);
 
                   if ( getenv("PAPI_REPORT") != NULL ) {
-                     _internal_hl_read_json_file(final_absolute_output_file_path);
+                     if ( binary )
+                        printf("\n\nPAPI-HL Output: %s\n", final_absolute_output_file_path);
+                     else
+                        _internal_hl_read_json_file(final_absolute_output_file_path);
                   }
 
                } else {
@@ -2081,6 +2286,10 @@ PAPI_hl_read(const char* region)
  * For more convenience, the output can also be printed to stdout by setting PAPI_REPORT=1. This
  * is not recommended for MPI applications as each MPI rank tries to print the output concurrently.
  *
+ * For runs with many MPI ranks, PAPI_OUTPUT_FORMAT=binary writes a compact binary file per rank,
+ * with region names stored once, instead of JSON. The python script papi_hl_merge.py reduces the
+ * files of all ranks in parallel to statistics per region, from either format.
+ *
  * The generated measurement output can also be converted in a better readable output. The python
  * script papi_hl_output_writer.py enhances the output by creating some derived metrics, like IPC,
  * MFlops/s, and MFlips/s as well as real and processor time in case the corresponding PAPI events
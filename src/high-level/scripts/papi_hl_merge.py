@@ -0,0 +1,300 @@
+#!/usr/bin/python
+from __future__ import division
+from collections import OrderedDict
+
+import argparse
+import io
+import json
+import math
+import os
+import struct
+from multiprocessing import Pool, cpu_count
+
+# Make it work for Python 2+3 and with Unicode
+try:
+  to_unicode = unicode
+except NameError:
+  to_unicode = str
+
+# Rank files written with PAPI_OUTPUT_FORMAT=binary, see papi_hl.c
+BINARY_MAGIC = b'PAPI-HL\0'
+BINARY_VERSION = 1
+
+class Binary_Reader(object):
+  def __init__(self, data):
+    self.data = data
+    self.pos = 0
+    self.order = '<'
+
+  def values(self, fmt, count):
+    fmt = self.order + str(count) + fmt
+    values = struct.unpack_from(fmt, self.data, self.pos)
+    self.pos += struct.calcsize(fmt)
+    return values
+
+  def value(self, fmt):
+    return self.values(fmt, 1)[0]
+
+  def string(self):
+    n = self.value('H')
+    s = self.data[self.pos:self.pos + n].decode('utf-8', 'replace')
+    self.pos += n
+    return s
+
+def is_binary_file(file_name):
+  with open(file_name, 'rb') as f:
+    return f.read(len(BINARY_MAGIC)) == BINARY_MAGIC
+
+def read_binary_columns(file_name):
+  """Read a binary rank file into its header and columns."""
+  with open(file_name, 'rb') as f:
+    r = Binary_Reader(f.read())
+
+  if r.data[:len(BINARY_MAGIC)] != BINARY_MAGIC:
+    raise IOError("{} is not a PAPI-HL binary file".format(file_name))
+  r.pos = len(BINARY_MAGIC)
+  if r.value('I') != 0x01020304:
+    r.order = '>'
+  if r.value('I') != BINARY_VERSION:
+    raise IOError("{} has an unknown format version".format(file_name))
+
+  f = OrderedDict()
+  version = r.value('I')
+  f['papi_version'] = "{}.{}.{}.{}".format((version >> 24) & 0xff, (version >> 16) & 0xff,
+                                           (version >> 8) & 0xff, version & 0xff)
+  f['max_cpu_rate_mhz'] = r.value('i')
+  f['min_cpu_rate_mhz'] = r.value('i')
+  f['cpu_info'] = r.string()
+  num_events, num_names, num_threads, num_records = r.values('I', 4)
+
+  f['events'] = []
+  for i in range(num_events):
+    name = r.string()
+    component = r.string()
+    event_type = 'instant' if r.value('B') == 1 else 'delta'
+    f['events'].append((name, component, event_type))
+  f['names'] = [r.string() for i in range(num_names)]
+  f['num_threads'] = num_threads
+
+  f['thread'] = r.values('I', num_records)
+  f['region_id'] = r.values('I', num_records)
+  f['parent_region_id'] = r.values('i', num_records)
+  f['name'] = r.values('I', num_records)
+  f['values'] = [r.values('q', num_records) for i in range(num_events)]
+  f['reads'] = []
+  for i in range(num_events):
+    reads = []
+    for j in range(num_records):
+      reads.append(r.values('q', r.value('I')))
+    f['reads'].append(reads)
+  return f
+
+def read_binary_file(file_name):
+  """Read a binary rank file into the structure of a JSON rank file."""
+  f = read_binary_columns(file_name)
+  data = OrderedDict()
+  data['papi_version'] = f['papi_version']
+  data['cpu_info'] = f['cpu_info']
+  data['max_cpu_rate_mhz'] = str(f['max_cpu_rate_mhz'])
+  data['min_cpu_rate_mhz'] = str(f['min_cpu_rate_mhz'])
+
+  # cycles and real_time_nsec are not event definitions in JSON either
+  data['event_definitions'] = OrderedDict()
+  for name, component, event_type in f['events']:
+    if component:
+      data['event_definitions'][name] = OrderedDict([('component', component), ('type', event_type)])
+
+  threads = OrderedDict()
+  for j in range(len(f['thread'])):
+    regions = threads.setdefault(str(f['thread'][j]), OrderedDict([('regions', OrderedDict())]))['regions']
+    region = OrderedDict()
+    region['name'] = f['names'][f['name'][j]]
+    region['parent_region_id'] = str(f['parent_region_id'][j])
+    for i, (name, component, event_type) in enumerate(f['events']):
+      reads = f['reads'][i][j]
+      if reads:
+        region[name] = OrderedDict([('region_value', str(f['values'][i][j]))])
+        for k, value in enumerate(reads):
+          region[name]['read_' + str(k + 1)] = str(value)
+      else:
+        region[name] = str(f['values'][i][j])
+    regions[str(f['region_id'][j])] = region
+  data['threads'] = threads
+  return data
+
+# Statistics of one region across threads and ranks. Partial results of
+# different files are combined with merge_stats, in any order.
+def new_region():
+  return OrderedDict([('region_count', 0), ('ranks', 0), ('threads', 0),
+                      ('events', OrderedDict())])
+
+def add_value(region, event, value):
+  s = region['events'].get(event)
+  if s is None:
+    region['events'][event] = [1, value, value, value, value * value]
+  else:
+    s[0] += 1
+    s[1] += value
+    s[2] = min(s[2], value)
+    s[3] = max(s[3], value)
+    s[4] += value * value
+
+def rank_stats(file_name):
+  """Statistics per region of one rank file."""
+  stats = OrderedDict()
+  definitions = OrderedDict()
+  threads = {}
+
+  if is_binary_file(file_name):
+    f = read_binary_columns(file_name)
+    for name, component, event_type in f['events']:
+      definitions[name] = OrderedDict([('component', component), ('type', event_type)])
+    for j in range(len(f['thread'])):
+      name = f['names'][f['name'][j]]
+      region = stats.setdefault(name, new_region())
+      region['region_count'] += 1
+      threads.setdefault(name, set()).add(f['thread'][j])
+      for i, event in enumerate(f['events']):
+        add_value(region, event[0], f['values'][i][j])
+  else:
+    with open(file_name) as json_file:
+      data = json.load(json_file, object_pairs_hook=OrderedDict)
+    definitions.update(data['event_definitions'])
+    for thread, thread_value in data['threads'].items():
+      for region_id, region_value in thread_value['regions'].items():
+        name = region_value['name']
+        region = stats.setdefault(name, new_region())
+        region['region_count'] += 1
+        threads.setdefault(name, set()).add(thread)
+        for key, value in region_value.items():
+          if key == 'name' or key == 'parent_region_id':
+            continue
+          if isinstance(value, dict):
+            value = value['region_value']
+          add_value(region, key, int(value))
+
+  for name, region in stats.items():
+    region['ranks'] = 1
+    region['threads'] = len(threads[name])
+  return (definitions, stats)
+
+def merge_stats(a, b):
+  definitions = a[0]
+  for key, value in b[0].items():
+    definitions.setdefault(key, value)
+  stats = a[1]
+  for name, region in b[1].items():
+    if name not in stats:
+      stats[name] = region
+      continue
+    r = stats[name]
+    r['region_count'] += region['region_count']
+    r['ranks'] += region['ranks']
+    r['threads'] += region['threads']
+    for event, s in region['events'].items():
+      t = r['events'].get(event)
+      if t is None:
+        r['events'][event] = s
+      else:
+        t[0] += s[0]
+        t[1] += s[1]
+        t[2] = min(t[2], s[2])
+        t[3] = max(t[3], s[3])
+        t[4] += s[4]
+  return (definitions, stats)
+
+def reduce_files(file_names):
+  result = (OrderedDict(), OrderedDict())
+  for file_name in file_names:
+    result = merge_stats(result, rank_stats(file_name))
+  return result
+
+def merge_pair(pair):
+  return merge_stats(pair[0], pair[1])
+
+def merge_directory(source, jobs):
+  """Reduce all rank files of a measurement directory, first a chunk of
+  files per worker, then pairwise in a tree."""
+  file_names = sorted(os.path.join(source, item) for item in os.listdir(source)
+                      if item.startswith('rank_'))
+  if not file_names:
+    return (OrderedDict(), OrderedDict())
+
+  jobs = max(1, min(jobs, len(file_names)))
+  chunk = (len(file_names) + jobs - 1) // jobs
+  chunks = [file_names[i:i + chunk] for i in range(0, len(file_names), chunk)]
+
+  if jobs == 1:
+    return reduce_files(file_names)
+
+  pool = Pool(jobs)
+  try:
+    partials = pool.map(reduce_files, chunks)
+    while len(partials) > 1:
+      pairs = list(zip(partials[0::2], partials[1::2]))
+      odd = [partials[-1]] if len(partials) % 2 else []
+      partials = pool.map(merge_pair, pairs) + odd
+  finally:
+    pool.close()
+    pool.join()
+  return partials[0]
+
+def summary(result):
+  definitions, stats = result
+  json_object = OrderedDict()
+  for name, region in stats.items():
+    events = OrderedDict()
+    events['Region count'] = region['region_count']
+    events['Number of ranks'] = region['ranks']
+    events['Number of threads'] = region['threads']
+    for event, s in region['events'].items():
+      n, total, low, high, squares = s
+      mean = total / n
+      e = OrderedDict()
+      if definitions.get(event, {}).get('type', 'delta') == 'delta':
+        e['total'] = total
+      e['min'] = low
+      e['mean'] = mean
+      e['max'] = high
+      e['stddev'] = math.sqrt(max(0.0, squares / n - mean * mean))
+      events[event] = e
+    json_object[name] = events
+  return json_object
+
+def write_json_file(data, file_name):
+  with io.open(file_name, 'w', encoding='utf8') as outfile:
+    str_ = json.dumps(data,
+                      indent=4, sort_keys=False,
+                      separators=(',', ': '), ensure_ascii=False)
+    outfile.write(to_unicode(str_))
+    print (str_)
+
+def main(source, output, jobs):
+  write_json_file(summary(merge_directory(source, jobs)), output)
+
+def parse_args():
+  parser = argparse.ArgumentParser(
+    description='Merge the rank files of a PAPI-HL measurement, JSON or binary, '
+                'into statistics per region across all threads and ranks.')
+  parser.add_argument('--source', type=str, required=False, default="papi_hl_output",
+                      help='Measurement directory of raw data.')
+  parser.add_argument('--output', type=str, required=False, default='papi_merge.json',
+                      help='Output file.')
+  parser.add_argument('--jobs', type=int, required=False, default=cpu_count(),
+                      help='Number of worker processes.')
+
+  # check if papi directory exists
+  args = parser.parse_args()
+  if os.path.isdir(args.source) == False:
+    print("Measurement directory '{}' does not exist!\n".format(args.source))
+    parser.print_help()
+    parser.exit()
+
+  return args
+
+
+if __name__ == '__main__':
+  args = parse_args()
+  main(source=args.source,
+       output=args.output,
+       jobs=args.jobs)
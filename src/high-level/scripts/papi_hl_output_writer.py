@@ -4,6 +4,7 @@ from collections import OrderedDict
 
 import argparse
 import os
+import sys
 import json
 # Make it work for Python 2+3 and with Unicode
 import io
@@ -31,6 +32,15 @@ event_rate_names = OrderedDict([
       ('PAPI_DP_OPS','Double precision MFLOPS/s')
     ])
 
+def read_binary_file(file_name):
+  #the reader lives in papi_hl_merge.py, installed next to this script
+  try:
+    import papi_hl_merge
+  except ImportError:
+    sys.exit("Reading binary file {} needs papi_hl_merge.py next to this script".format(file_name))
+  return papi_hl_merge.read_binary_file(file_name)
+
+
 def merge_json_files(source):
   json_object = {}
   events_stored = False
@@ -54,9 +64,13 @@ def merge_json_files(source):
     file_name = str(source) + "/" + str(item)
 
     try:
-      with open(file_name) as json_file:
-        #keep order of all objects
-        data = json.load(json_file, object_pairs_hook=OrderedDict)
+      if item.endswith('.bin'):
+        #written with PAPI_OUTPUT_FORMAT=binary
+        data = read_binary_file(file_name)
+      else:
+        with open(file_name) as json_file:
+          #keep order of all objects
+          data = json.load(json_file, object_pairs_hook=OrderedDict)
     except IOError as ioe:
       print("Cannot open file {} ({})".format(file_name, repr(ioe)))
       return
@@ -566,3 +566,203 @@ _linux_get_virt_nsec_gettime( void )
 
     return retval;
 }
+
+
+/********************************************************************
+ * real time backends                                               *
+ ********************************************************************/
+
+/* PAPI_get_real_nsec() and PAPI_get_real_usec() can read the time three
+   ways, picked by PAPI_REAL_TIMER in the environment, or by
+   PAPI_DEFAULT_REAL_TIMER at build time:
+
+     syscall  the backend chosen by configure above (the default)
+     vdso     clock_gettime(CLOCK_REALTIME), served by the vDSO
+     tsc      an invariant TSC, scaled with time_mult/time_shift of
+              the perf_event mmap page and offset to CLOCK_REALTIME
+
+   All three are wall clock time.  tsc falls back to vdso when the TSC
+   is not invariant or the kernel does not publish the scaling
+   (cap_user_time_zero).                                              */
+
+#ifndef PAPI_DEFAULT_REAL_TIMER
+#define PAPI_DEFAULT_REAL_TIMER "syscall"
+#endif
+
+long long
+_linux_get_real_nsec_vdso( void )
+{
+   struct timespec foo;
+
+   clock_gettime( CLOCK_REALTIME, &foo );
+   return ( long long ) foo.tv_sec * ( long long ) 1000000000 +
+          ( long long ) foo.tv_nsec;
+}
+
+long long
+_linux_get_real_usec_vdso( void )
+{
+   struct timespec foo;
+
+   clock_gettime( CLOCK_REALTIME, &foo );
+   return ( long long ) foo.tv_sec * ( long long ) 1000000 +
+          ( long long ) ( foo.tv_nsec / 1000 );
+}
+
+#if defined(__x86_64__) && defined(PEINCLUDE)
+#include <sys/mman.h>
+#include PEINCLUDE
+
+static uint64_t tsc_mult;
+static uint16_t tsc_shift;
+static long long tsc_offset;
+
+/* Same conversion the kernel documents for perf_event_mmap_page */
+static inline long long
+tsc_to_nsec( uint64_t cyc )
+{
+   uint64_t quot = cyc >> tsc_shift;
+   uint64_t rem = cyc & ( ( ( uint64_t ) 1 << tsc_shift ) - 1 );
+
+   return tsc_offset + ( long long ) ( quot * tsc_mult +
+                                       ( ( rem * tsc_mult ) >> tsc_shift ) );
+}
+
+long long
+_linux_get_real_nsec_tsc( void )
+{
+   return tsc_to_nsec( ( uint64_t ) get_cycles(  ) );
+}
+
+long long
+_linux_get_real_usec_tsc( void )
+{
+   return tsc_to_nsec( ( uint64_t ) get_cycles(  ) ) / 1000;
+}
+
+/* constant_tsc: fixed rate, nonstop_tsc: keeps counting in C-states */
+static int
+tsc_invariant( void )
+{
+   char line[BUFSIZ * 4];
+   int found = 0;
+   FILE *fff;
+
+   fff = fopen( "/proc/cpuinfo", "r" );
+   if ( fff == NULL ) return 0;
+   while ( fgets( line, sizeof ( line ), fff ) ) {
+      if ( strncmp( line, "flags", 5 ) ) continue;
+      found = strstr( line, " constant_tsc" ) && strstr( line, " nonstop_tsc" );
+      break;
+   }
+   fclose( fff );
+   return found;
+}
+
+static int
+tsc_setup( void )
+{
+   struct perf_event_attr attr;
+   struct perf_event_mmap_page *pc;
+   uint32_t seq;
+   uint64_t zero;
+   long long t0, t1, best, mid;
+   uint64_t cyc;
+   int fd, cap, i;
+
+   if ( !tsc_invariant(  ) ) {
+      SUBDBG( "TSC is not invariant\n" );
+      return PAPI_ECMP;
+   }
+
+   /* any event of our own will do, only its mmap page is needed */
+   memset( &attr, 0, sizeof ( attr ) );
+   attr.size = sizeof ( attr );
+   attr.type = PERF_TYPE_SOFTWARE;
+   attr.config = PERF_COUNT_SW_DUMMY;
+   attr.disabled = 1;
+   attr.exclude_kernel = 1;
+   attr.exclude_hv = 1;
+
+   fd = syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+   if ( fd < 0 ) {
+      SUBDBG( "perf_event_open failed: %s\n", strerror( errno ) );
+      return PAPI_ESYS;
+   }
+   pc = mmap( NULL, getpagesize(  ), PROT_READ, MAP_SHARED, fd, 0 );
+   if ( pc == MAP_FAILED ) {
+      close( fd );
+      return PAPI_ESYS;
+   }
+
+   do {
+      seq = pc->lock;
+      __sync_synchronize(  );
+      cap = pc->cap_user_time_zero;
+      tsc_mult = pc->time_mult;
+      tsc_shift = pc->time_shift;
+      zero = pc->time_zero;
+      __sync_synchronize(  );
+   } while ( pc->lock != seq );
+
+   munmap( pc, getpagesize(  ) );
+   close( fd );
+
+   if ( !cap ) {
+      SUBDBG( "kernel does not publish TSC scaling\n" );
+      return PAPI_ECMP;
+   }
+
+   /* time_zero is on the perf clock; move it onto CLOCK_REALTIME   */
+   /* using the tightest of a few TSC reads bracketed by vDSO reads */
+   tsc_offset = ( long long ) zero;
+   best = -1;
+   mid = 0;
+   for ( i = 0; i < 16; i++ ) {
+      t0 = _linux_get_real_nsec_vdso(  );
+      cyc = ( uint64_t ) get_cycles(  );
+      t1 = _linux_get_real_nsec_vdso(  );
+      if ( best < 0 || t1 - t0 < best ) {
+         best = t1 - t0;
+         mid = t0 + best / 2 - tsc_to_nsec( cyc );
+      }
+   }
+   tsc_offset += mid;
+
+   SUBDBG( "TSC mult %llu shift %u offset %lld, calibrated within %lld ns\n",
+           ( unsigned long long ) tsc_mult, tsc_shift, tsc_offset, best );
+   return PAPI_OK;
+}
+#endif
+
+int
+_linux_timer_setup( void )
+{
+   const char *timer = getenv( "PAPI_REAL_TIMER" );
+   int requested = ( timer != NULL );
+
+   if ( timer == NULL ) timer = PAPI_DEFAULT_REAL_TIMER;
+
+   /* the configured backend is already in _papi_os_vector */
+   if ( !strcmp( timer, "syscall" ) ) return PAPI_OK;
+
+#if defined(__x86_64__) && defined(PEINCLUDE)
+   if ( !strcmp( timer, "tsc" ) ) {
+      if ( tsc_setup(  ) == PAPI_OK ) {
+         _papi_os_vector.get_real_nsec = _linux_get_real_nsec_tsc;
+         _papi_os_vector.get_real_usec = _linux_get_real_usec_tsc;
+         return PAPI_OK;
+      }
+      if ( requested ) PAPIWARN( "PAPI_REAL_TIMER=tsc unavailable, using vdso" );
+      timer = "vdso";
+   }
+#endif
+
+   if ( strcmp( timer, "vdso" ) ) {
+      if ( requested ) PAPIWARN( "Unknown PAPI_REAL_TIMER %s, using syscall", timer );
+      return PAPI_OK;
+   }
+   _papi_os_vector.get_real_nsec = _linux_get_real_nsec_vdso;
+   _papi_os_vector.get_real_usec = _linux_get_real_usec_vdso;
+   return PAPI_OK;
+}
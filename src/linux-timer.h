@@ -12,5 +12,11 @@ long long _linux_get_real_usec_cycles( void );
 long long _linux_get_real_nsec_gettime( void );
 long long _linux_get_virt_nsec_gettime( void );
 
+long long _linux_get_real_nsec_vdso( void );
+long long _linux_get_real_usec_vdso( void );
+long long _linux_get_real_nsec_tsc( void );
+long long _linux_get_real_usec_tsc( void );
+int _linux_timer_setup( void );
+
 int mmtimer_setup(void);
 int init_proc_thread_timer( hwd_context_t *thr_ctx );
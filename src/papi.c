@@ -76,6 +76,7 @@ static int _start_new_rate_call(float *real_time, float *proc_time, int *events,
 static int _rate_calls( float *real_time, float *proc_time, int *events, 
                  long long *values, long long *ins, float *rate, int mode );
 static int _internal_check_rate_state();
+static void topo_map_free( void );
 
 
 static void _internal_papi_init(void)
@@ -1022,6 +1023,13 @@ PAPI_set_thr_specific( int tag, void *ptr )
  *	It must be called before any low level PAPI functions can be used. 
  *	If your application is making use of threads PAPI_thread_init must also be 
  *	called prior to making any calls to the library other than PAPI_library_init() . 
+ *
+ *	Only the perf_event and perf_event_uncore components are initialized by
+ *	PAPI_library_init(). Every other component reports PAPI_EDELAY_INIT 
+ *	until it is first used: an event name lookup or enumeration, adding 
+ *	one of its events, or PAPI_get_component_info(). 
+ *	If the environment variable PAPI_COMPONENTS is set to a comma separated 
+ *	list of component names, components not in the list are disabled. 
  *	@par Examples:
  *	@code
  *		int retval;
@@ -1352,8 +1360,11 @@ PAPI_get_component_info( int cidx )
    APIDBG( "Entry: Component Index %d\n", cidx);
    if ( _papi_hwi_invalid_cmp( cidx ) )
       return ( NULL );
-   else
-      return ( &( _papi_hwd[cidx]->cmp_info ) );
+
+   /* Asking for the info is a use of the component */
+   _papi_hwi_component_check_n_initialize( cidx );
+
+   return ( &( _papi_hwd[cidx]->cmp_info ) );
 }
 
 /* PAPI_get_event_info:
@@ -1920,6 +1931,8 @@ PAPI_enum_cmp_event( int *EventCode, int modifier, int cidx )
 		return PAPI_ENOCMP;
 	}
 
+	_papi_hwi_component_check_n_initialize( cidx );
+
 	if (_papi_hwd[cidx]->cmp_info.disabled &&
         _papi_hwd[cidx]->cmp_info.disabled != PAPI_EDELAY_INIT) {
 	  return PAPI_ENOCMP;
@@ -3161,6 +3174,182 @@ PAPI_read( int EventSet, long long *values )
 	return ( PAPI_OK );
 }
 
+/** @class PAPI_read_vector
+ *  @brief Read every cpu of a replicated event set at once.
+ *
+ *  @par C Interface:
+ *  \#include <papi.h> @n
+ *  int PAPI_read_vector(int EventSet, long long *values, int *rows );
+ *
+ *  An event set replicated with the PAPI_CPU_VECTOR option, or attached
+ *  to a cgroup with PAPI_CGROUP_ATTACH, counts its events separately on
+ *  each cpu.  PAPI_read() and PAPI_stop() return
+ *  the sum over all cpus; PAPI_read_vector() returns one row per cpu,
+ *  in increasing cpu order, with a single call into the component.
+ *
+ *  An uncore event set with PAPI_UNCORE_AGGREGATE has one row per PMU
+ *  instance and socket, ordered by instance then by the socket's cpu,
+ *  or one row per socket if per_socket was requested.
+ *
+ *  @param[in] EventSet
+ *     -- an integer handle for a PAPI Event Set as created 
+ *        by PAPI_create_eventset()
+ *  @param[out] *values 
+ *     -- an array of (*rows) x (number of events) counter values,
+ *        stored row after row
+ *  @param[in,out] *rows
+ *     -- on input the number of rows values can hold, on output the
+ *        number of rows (cpus) read
+ *
+ *  @retval PAPI_EINVAL 
+ *	    One or more of the arguments is invalid, the event set is not
+ *          replicated, or values is too small; in the last case *rows is
+ *          set to the number of rows needed.
+ *  @retval PAPI_ENOTRUN 
+ *	    The event set is not running.
+ *  @retval PAPI_ESYS 
+ *	    A system or C library call failed inside PAPI, see the 
+ *          errno variable.
+ *  @retval PAPI_ENOEVST 
+ *	    The event set specified does not exist. 
+ *	
+ * @par Examples
+ * @code
+ * PAPI_option_t opt;
+ * opt.cpu_vector.eventset = EventSet;
+ * opt.cpu_vector.num_cpus = 0;          // all online cpus
+ * opt.cpu_vector.cpus = NULL;
+ * opt.cpu_vector.num_threads = 0;
+ * if (PAPI_set_opt(PAPI_CPU_VECTOR, &opt) != PAPI_OK)
+ *    handle_error(1);
+ * // add events, PAPI_start()
+ * rows = opt.cpu_vector.num_cpus;
+ * if (PAPI_read_vector(EventSet, values, &rows) != PAPI_OK)
+ *    handle_error(1);
+ * // values[cpu_row * num_events + event]
+ * @endcode
+ *
+ * @see PAPI_read 
+ * @see PAPI_set_opt 
+ */
+int
+PAPI_read_vector( int EventSet, long long *values, int *rows )
+{
+	APIDBG( "Entry: EventSet: %d, values: %p, rows: %p\n", EventSet, values, rows);
+	EventSetInfo_t *ESI;
+	hwd_context_t *context;
+	int cidx, retval;
+
+	ESI = _papi_hwi_lookup_EventSet( EventSet );
+	if ( ESI == NULL )
+		papi_return( PAPI_ENOEVST );
+
+	cidx = valid_ESI_component( ESI );
+	if ( cidx < 0 )
+		papi_return( cidx );
+
+	if ( values == NULL || rows == NULL ||
+		 ( ESI->cpu_vector.num_cpus == 0 && !ESI->cpu_vector.aggregate ) )
+		papi_return( PAPI_EINVAL );
+
+	if ( !( ESI->state & PAPI_RUNNING ) )
+		papi_return( PAPI_ENOTRUN );
+
+	/* get the context we should use for this event set */
+	context = _papi_hwi_get_context( ESI, NULL );
+	retval = _papi_hwi_read_vector( context, ESI, values, rows );
+
+	APIDBG( "PAPI_read_vector returns %d, rows %d\n", retval, *rows );
+	papi_return( retval );
+}
+
+/** @class PAPI_read_inherited
+ *  @brief Iterate over the counts of exited children of an inheriting event set.
+ *
+ *  @par C Interface:
+ *  \#include <papi.h> @n
+ *  int PAPI_read_inherited(int EventSet, int *index, unsigned long *tid, long long *values );
+ *
+ *  With PAPI_INHERIT set to PAPI_INHERIT_THREADS, the threads and
+ *  processes created after the event set was opened inherit its
+ *  counters, and PAPI_read() includes their counts once they exit.
+ *  In addition, each of them reports its own counts to PAPI when it
+ *  exits.  PAPI_read_inherited() returns these one child at a time,
+ *  in the order they exited, so work done by a forked worker pool can
+ *  be attributed to each worker without attaching to it.
+ *
+ *  Start with *index set to 0.  Every successful call fills in tid and
+ *  values for one child and advances *index.  Children exiting during
+ *  the iteration are appended.  PAPI_reset() and PAPI_start() forget
+ *  the children that exited before them.
+ *
+ *  @param[in] EventSet
+ *     -- an integer handle for a PAPI Event Set as created 
+ *        by PAPI_create_eventset()
+ *  @param[in,out] *index
+ *     -- position of the next child to return, 0 for the first
+ *  @param[out] *tid
+ *     -- thread id of the exited child
+ *  @param[out] *values 
+ *     -- an array to hold the counter values of the child
+ *
+ *  @retval PAPI_ENOEVNT 
+ *	    No more exited children.
+ *  @retval PAPI_EINVAL 
+ *	    One or more of the arguments is invalid, or the event set does
+ *          not inherit with PAPI_INHERIT_THREADS.
+ *  @retval PAPI_ESYS 
+ *	    A system or C library call failed inside PAPI, see the 
+ *          errno variable.
+ *  @retval PAPI_ENOEVST 
+ *	    The event set specified does not exist. 
+ *	
+ * @par Examples
+ * @code
+ * PAPI_option_t opt;
+ * opt.inherit.eventset = EventSet;
+ * opt.inherit.inherit = PAPI_INHERIT_THREADS;
+ * if (PAPI_set_opt(PAPI_INHERIT, &opt) != PAPI_OK)
+ *    handle_error(1);
+ * // add events, PAPI_start(), run and join workers
+ * index = 0;
+ * while (PAPI_read_inherited(EventSet, &index, &tid, values) == PAPI_OK)
+ *    printf("%lu: %lld\n", tid, values[0]);
+ * @endcode
+ *
+ * @see PAPI_read 
+ * @see PAPI_set_opt 
+ */
+int
+PAPI_read_inherited( int EventSet, int *index, unsigned long *tid, long long *values )
+{
+	APIDBG( "Entry: EventSet: %d, index: %p, tid: %p, values: %p\n", EventSet, index, tid, values);
+	EventSetInfo_t *ESI;
+	hwd_context_t *context;
+	int cidx, retval;
+
+	ESI = _papi_hwi_lookup_EventSet( EventSet );
+	if ( ESI == NULL )
+		papi_return( PAPI_ENOEVST );
+
+	cidx = valid_ESI_component( ESI );
+	if ( cidx < 0 )
+		papi_return( cidx );
+
+	if ( index == NULL || *index < 0 || tid == NULL || values == NULL ||
+		 ESI->inherit.inherit != PAPI_INHERIT_THREADS )
+		papi_return( PAPI_EINVAL );
+
+	/* get the context we should use for this event set */
+	context = _papi_hwi_get_context( ESI, NULL );
+	retval = _papi_hwi_read_inherited( context, ESI, *index, tid, values );
+	if ( retval == PAPI_OK )
+		( *index )++;
+
+	APIDBG( "PAPI_read_inherited returns %d, index %d\n", retval, *index );
+	return ( retval );
+}
+
 /** @class PAPI_read_ts
  *  @brief Read hardware counters with a timestamp.
  *	
@@ -3979,13 +4168,24 @@ PAPI_set_multiplex( int EventSet )
  *					specified in in ptr->attach.tid.
  * PAPI_CPU_ATTACH	Attach EventSet specified in ptr->cpu.eventset to cpu specified in in
  *					ptr->cpu.cpu_num.
+ * PAPI_CPU_VECTOR	Replicate EventSet specified in ptr->cpu_vector.eventset on the
+ *					ptr->cpu_vector.num_cpus cpus in ptr->cpu_vector.cpus (0 for all
+ *					online cpus, -1 to turn off), read with PAPI_read_vector.
+ * PAPI_CGROUP_ATTACH	Count only tasks of the cgroup directory ptr->cgroup.path (NULL to
+ *					detach) with EventSet ptr->cgroup.eventset, on every cpu of its
+ *					PAPI_CPU_VECTOR or on all online cpus.
+ * PAPI_UNCORE_AGGREGATE	Count every event of the uncore EventSet ptr->uncore_aggregate.eventset
+ *					on all instances and sockets of its PMU; PAPI_read_vector returns
+ *					one row per instance and socket, or per socket if
+ *					ptr->uncore_aggregate.per_socket is set.
  * PAPI_DETACH		Detach EventSet specified in ptr->attach.eventset from any thread
  *					or process id.
  * PAPI_DOMAIN		Set domain for EventSet specified in ptr->domain.eventset. 
  *					Will error if eventset is not bound to a component.
  * PAPI_GRANUL		Set granularity for EventSet specified in ptr->granularity.eventset. 
  *					Will error if eventset is not bound to a component.
- * PAPI_INHERIT		Enable or disable inheritance for specified EventSet.
+ * PAPI_INHERIT		Enable or disable inheritance for specified EventSet; PAPI_INHERIT_THREADS
+ *					also keeps the counts of each exited child for PAPI_read_inherited.
  * PAPI_DATA_ADDRESS	Set data address range to restrict event counting for EventSet specified
  *					in ptr->addr.eventset. Starting and ending addresses are specified in
  *					ptr->addr.start and ptr->addr.end, respectively. If exact addresses
@@ -4006,10 +4206,13 @@ PAPI_set_multiplex( int EventSet )
  * <tr><td>PAPI_DEF_ITIMER_NS</td><td>See PAPI_DEF_MPX_NS.</td></tr>
  * <tr><td>PAPI_ATTACH</td><td>Attach EventSet specified in ptr->attach.eventset to thread or process id specified in in ptr->attach.tid.</td></tr>
  * <tr><td>PAPI_CPU_ATTACH</td><td>Attach EventSet specified in ptr->cpu.eventset to cpu specified in in ptr->cpu.cpu_num.</td></tr>
+ * <tr><td>PAPI_CPU_VECTOR</td><td>Replicate EventSet specified in ptr->cpu_vector.eventset on the ptr->cpu_vector.num_cpus cpus in ptr->cpu_vector.cpus (0 for all online cpus, -1 to turn off), read with PAPI_read_vector.</td></tr>
+ * <tr><td>PAPI_CGROUP_ATTACH</td><td>Count only tasks of the cgroup directory ptr->cgroup.path (NULL to detach) with EventSet ptr->cgroup.eventset, on every cpu of its PAPI_CPU_VECTOR or on all online cpus.</td></tr>
+ * <tr><td>PAPI_UNCORE_AGGREGATE</td><td>Count every event of the uncore EventSet ptr->uncore_aggregate.eventset on all instances and sockets of its PMU; PAPI_read_vector returns one row per instance and socket, or per socket if ptr->uncore_aggregate.per_socket is set.</td></tr>
  * <tr><td>PAPI_DETACH</td><td>Detach EventSet specified in ptr->attach.eventset from any thread or process id.</td></tr>
  * <tr><td>PAPI_DOMAIN</td><td>Set domain for EventSet specified in ptr->domain.eventset. Will error if eventset is not bound to a component.</td></tr>
  * <tr><td>PAPI_GRANUL</td><td>Set granularity for EventSet specified in ptr->granularity.eventset. Will error if eventset is not bound to a component.</td></tr>
- * <tr><td>PAPI_INHERIT</td><td>Enable or disable inheritance for specified EventSet.</td></tr>
+ * <tr><td>PAPI_INHERIT</td><td>Enable or disable inheritance for specified EventSet; PAPI_INHERIT_THREADS also keeps the counts of each exited child for PAPI_read_inherited.</td></tr>
  * <tr><td>PAPI_DATA_ADDRESS</td><td>Set data address range to restrict event counting for EventSet specified in ptr->addr.eventset. Starting and ending addresses are specified in ptr->addr.start and ptr->addr.end, respectively. If exact addresses cannot be instantiated, offsets are returned in ptr->addr.start_off and ptr->addr.end_off. Currently implemented on Itanium only.</td></tr>
  * <tr><td>PAPI_INSTR_ADDRESS</td><td>Set instruction address range as described above. Itanium only.</td></tr>
  * </table>
@@ -4148,6 +4351,114 @@ PAPI_set_opt( int option, PAPI_option_t * ptr )
 		internal.cpu.ESI->state |= PAPI_CPU_ATTACHED;
 		return ( PAPI_OK );
 	}
+	case PAPI_CPU_VECTOR:
+	{
+		internal.cpu_vector.ESI = _papi_hwi_lookup_EventSet( ptr->cpu_vector.eventset );
+		if ( internal.cpu_vector.ESI == NULL )
+			papi_return( PAPI_ENOEVST );
+
+		cidx = valid_ESI_component( internal.cpu_vector.ESI );
+		if ( cidx < 0 )
+			papi_return( cidx );
+
+		if ( _papi_hwd[cidx]->cmp_info.cpu == 0 )
+			papi_return( PAPI_ECMP );
+
+		// each row counts everything on its cpu, so this excludes
+		// attaching to a process, a single cpu, or inheritance
+		if ( internal.cpu_vector.ESI->state &
+			 (PAPI_ATTACHED | PAPI_CPU_ATTACHED | PAPI_INHERIT) )
+			papi_return( PAPI_EINVAL );
+
+		if ( ( internal.cpu_vector.ESI->state & PAPI_STOPPED ) == 0 )
+			papi_return( PAPI_EISRUN );
+
+		if ( ptr->cpu_vector.num_cpus > 0 && ptr->cpu_vector.cpus == NULL )
+			papi_return( PAPI_EINVAL );
+
+		internal.cpu_vector.num_cpus = ptr->cpu_vector.num_cpus;
+		internal.cpu_vector.cpus = ptr->cpu_vector.cpus;
+		internal.cpu_vector.num_threads = ptr->cpu_vector.num_threads;
+
+		/* get the context we should use for this event set */
+		context = _papi_hwi_get_context( internal.cpu_vector.ESI, NULL );
+		retval = _papi_hwd[cidx]->ctl( context, PAPI_CPU_VECTOR, &internal );
+		if ( retval != PAPI_OK )
+			papi_return( retval );
+
+		/* the component reports how many cpus it resolved */
+		internal.cpu_vector.ESI->cpu_vector.num_cpus =
+			internal.cpu_vector.num_cpus < 0 ? 0 : internal.cpu_vector.num_cpus;
+		ptr->cpu_vector.num_cpus = internal.cpu_vector.ESI->cpu_vector.num_cpus;
+		return ( PAPI_OK );
+	}
+	case PAPI_CGROUP_ATTACH:
+	{
+		internal.cgroup.ESI = _papi_hwi_lookup_EventSet( ptr->cgroup.eventset );
+		if ( internal.cgroup.ESI == NULL )
+			papi_return( PAPI_ENOEVST );
+
+		cidx = valid_ESI_component( internal.cgroup.ESI );
+		if ( cidx < 0 )
+			papi_return( cidx );
+
+		if ( _papi_hwd[cidx]->cmp_info.attach == 0 ||
+			 _papi_hwd[cidx]->cmp_info.cpu == 0 )
+			papi_return( PAPI_ECMP );
+
+		if ( internal.cgroup.ESI->state &
+			 (PAPI_ATTACHED | PAPI_CPU_ATTACHED | PAPI_INHERIT) )
+			papi_return( PAPI_EINVAL );
+
+		if ( ( internal.cgroup.ESI->state & PAPI_STOPPED ) == 0 )
+			papi_return( PAPI_EISRUN );
+
+		internal.cgroup.path = ptr->cgroup.path;
+		internal.cgroup.num_cpus = 0;
+
+		/* get the context we should use for this event set */
+		context = _papi_hwi_get_context( internal.cgroup.ESI, NULL );
+		retval = _papi_hwd[cidx]->ctl( context, PAPI_CGROUP_ATTACH, &internal );
+		if ( retval != PAPI_OK )
+			papi_return( retval );
+
+		/* a cgroup is counted per cpu, so the rows can be read too */
+		internal.cgroup.ESI->cpu_vector.cgroup = ( ptr->cgroup.path != NULL );
+		internal.cgroup.ESI->cpu_vector.num_cpus = internal.cgroup.num_cpus;
+		ptr->cgroup.num_cpus = internal.cgroup.num_cpus;
+		return ( PAPI_OK );
+	}
+	case PAPI_UNCORE_AGGREGATE:
+	{
+		internal.uncore_aggregate.ESI =
+			_papi_hwi_lookup_EventSet( ptr->uncore_aggregate.eventset );
+		if ( internal.uncore_aggregate.ESI == NULL )
+			papi_return( PAPI_ENOEVST );
+
+		cidx = valid_ESI_component( internal.uncore_aggregate.ESI );
+		if ( cidx < 0 )
+			papi_return( cidx );
+
+		if ( internal.uncore_aggregate.ESI->state &
+			 (PAPI_ATTACHED | PAPI_CPU_ATTACHED | PAPI_INHERIT) )
+			papi_return( PAPI_EINVAL );
+
+		if ( ( internal.uncore_aggregate.ESI->state & PAPI_STOPPED ) == 0 )
+			papi_return( PAPI_EISRUN );
+
+		internal.uncore_aggregate.aggregate = ptr->uncore_aggregate.aggregate;
+		internal.uncore_aggregate.per_socket = ptr->uncore_aggregate.per_socket;
+
+		/* get the context we should use for this event set */
+		context = _papi_hwi_get_context( internal.uncore_aggregate.ESI, NULL );
+		retval = _papi_hwd[cidx]->ctl( context, PAPI_UNCORE_AGGREGATE, &internal );
+		if ( retval != PAPI_OK )
+			papi_return( retval );
+
+		internal.uncore_aggregate.ESI->cpu_vector.aggregate =
+			( ptr->uncore_aggregate.aggregate != 0 );
+		return ( PAPI_OK );
+	}
 	case PAPI_DEF_MPX_NS:
 	{
 		cidx = 0;			 /* xxxx for now, assume we only check against cpu component */
@@ -4648,6 +4959,9 @@ PAPI_get_multiplex( int EventSet )
  * PAPI_DEF_ITIMER_NS	See PAPI_DEF_MPX_NS.
  * PAPI_ATTACH		Get thread or process id to which event set is attached. Returns TRUE if currently attached.
  * PAPI_CPU_ATTACH	Get ptr->cpu.cpu_num and Attach state for EventSet specified in ptr->cpu.eventset.
+ * PAPI_CPU_VECTOR	Get ptr->cpu_vector.num_cpus and replication state for EventSet specified in ptr->cpu_vector.eventset.
+ * PAPI_CGROUP_ATTACH	Get ptr->cgroup.num_cpus and cgroup attach state for EventSet specified in ptr->cgroup.eventset.
+ * PAPI_UNCORE_AGGREGATE	Get the uncore aggregation state for EventSet specified in ptr->uncore_aggregate.eventset.
  * PAPI_DETACH		Get thread or process id to which event set is attached. Returns TRUE if currently attached.
  * PAPI_DOMAIN		Get domain for EventSet specified in ptr->domain.eventset. Will error if eventset is not bound to a component.
  * PAPI_GRANUL		Get granularity for EventSet specified in ptr->granularity.eventset. Will error if eventset is not bound to a component.
@@ -4676,6 +4990,9 @@ PAPI_get_multiplex( int EventSet )
  * <tr><td>PAPI_DEF_ITIMER_NS</td><td>See PAPI_DEF_MPX_NS.</td></tr>
  * <tr><td>PAPI_ATTACH</td><td>Get thread or process id to which event set is attached. Returns TRUE if currently attached.</td></tr>
  * <tr><td>PAPI_CPU_ATTACH</td><td>Get ptr->cpu.cpu_num and Attach state for EventSet specified in ptr->cpu.eventset.</td></tr>
+ * <tr><td>PAPI_CPU_VECTOR</td><td>Get ptr->cpu_vector.num_cpus and replication state for EventSet specified in ptr->cpu_vector.eventset.</td></tr>
+ * <tr><td>PAPI_CGROUP_ATTACH</td><td>Get ptr->cgroup.num_cpus and cgroup attach state for EventSet specified in ptr->cgroup.eventset.</td></tr>
+ * <tr><td>PAPI_UNCORE_AGGREGATE</td><td>Get the uncore aggregation state for EventSet specified in ptr->uncore_aggregate.eventset.</td></tr>
  * <tr><td>PAPI_DETACH</td><td>Get thread or process id to which event set is attached. Returns TRUE if currently attached.</td></tr>
  * <tr><td>PAPI_DOMAIN</td><td>Get domain for EventSet specified in ptr->domain.eventset. Will error if eventset is not bound to a component.</td></tr>
  * <tr><td>PAPI_GRANUL</td><td>Get granularity for EventSet specified in ptr->granularity.eventset. Will error if eventset is not bound to a component.</td></tr>
@@ -4739,6 +5056,36 @@ PAPI_get_opt( int option, PAPI_option_t * ptr )
 		ptr->cpu.cpu_num = ESI->CpuInfo->cpu_num;
 		return ( ( ESI->state & PAPI_CPU_ATTACHED ) != 0 );
 	}
+	case PAPI_CPU_VECTOR:
+	{
+		if ( ptr == NULL )
+			papi_return( PAPI_EINVAL );
+		ESI = _papi_hwi_lookup_EventSet( ptr->cpu_vector.eventset );
+		if ( ESI == NULL )
+			papi_return( PAPI_ENOEVST );
+		ptr->cpu_vector.num_cpus = ESI->cpu_vector.num_cpus;
+		return ( ESI->cpu_vector.num_cpus != 0 );
+	}
+	case PAPI_CGROUP_ATTACH:
+	{
+		if ( ptr == NULL )
+			papi_return( PAPI_EINVAL );
+		ESI = _papi_hwi_lookup_EventSet( ptr->cgroup.eventset );
+		if ( ESI == NULL )
+			papi_return( PAPI_ENOEVST );
+		ptr->cgroup.num_cpus = ESI->cpu_vector.num_cpus;
+		return ( ESI->cpu_vector.cgroup != 0 );
+	}
+	case PAPI_UNCORE_AGGREGATE:
+	{
+		if ( ptr == NULL )
+			papi_return( PAPI_EINVAL );
+		ESI = _papi_hwi_lookup_EventSet( ptr->uncore_aggregate.eventset );
+		if ( ESI == NULL )
+			papi_return( PAPI_ENOEVST );
+		ptr->uncore_aggregate.aggregate = ESI->cpu_vector.aggregate;
+		return ( ESI->cpu_vector.aggregate != 0 );
+	}
 	case PAPI_DEF_MPX_NS:
 	{
 		/* xxxx for now, assume we only check against cpu component */
@@ -4900,6 +5247,8 @@ PAPI_get_cmp_opt( int option, PAPI_option_t * ptr, int cidx )
      return PAPI_ECMP;
   }
 
+	_papi_hwi_component_check_n_initialize( cidx );
+
 	switch ( option ) {
 		/* For now, MAX_HWCTRS and MAX CTRS are identical.
 		   At some future point, they may map onto different values.
@@ -5094,6 +5443,8 @@ again:
 	memset (user_defined_events, '\0' , sizeof(user_defined_events));
 	user_defined_events_count = 0;
 
+	topo_map_free(  );
+
 	/* Shutdown the entire component */
 	//_papi_hwi_shutdown_highlevel(  );
 	_papi_hwi_shutdown_global_internal(  );
@@ -6593,6 +6944,422 @@ PAPI_list_events( int EventSet, int *Events, int *number )
 	return ( PAPI_OK );
 }
 
+/** @class PAPI_plan_events
+ *  @brief Partition a list of events into groups that can be counted together.
+ *
+ *  @par C Interface:
+ *  \#include <papi.h> @n
+ *  int PAPI_plan_events( char **Names, int number, int *group, int *pass );
+ *
+ *  PAPI_plan_events() packs a list of named events, which may be longer
+ *  than the hardware can count at once, into as few groups as it can find.
+ *  Each group is an event set that the component accepts: the events are
+ *  tried with PAPI_add_event(), so the component's counter count, its
+ *  scheduling constraints and, for perf_event, a trial open of the events
+ *  all decide.  Groups of different components are counted at the same
+ *  time, so the groups are further arranged in passes: pass k holds the
+ *  k-th group of every component.
+ *
+ *  The plan can be used in two ways.  Running the program once per pass,
+ *  with one event set per group of that pass, counts every event for the
+ *  whole run.  Alternatively, all the events of a component can go in one
+ *  multiplexed event set; with P passes, each event is then counted for
+ *  about 1/P of the run, which is the least multiplexing the events allow.
+ *
+ *  Events given more than once get the group of their first occurrence.
+ *  Events that do not exist, or that cannot be counted even on their own,
+ *  get group and pass -1 and do not make the plan fail.
+ *
+ *  @param[in] Names
+ *     -- an array of event names
+ *  @param[in] number
+ *     -- the number of names
+ *  @param[out] *group
+ *     -- for each name, the group it was placed in; groups are numbered
+ *        from 0 in the order they were created
+ *  @param[out] *pass
+ *     -- for each name, the pass of its group
+ *
+ *  @retval Non-negative-Integer
+ *     The number of passes; 0 if none of the events can be counted.
+ *  @retval PAPI_EINVAL
+ *     One or more of the arguments is invalid.
+ *  @retval PAPI_ENOMEM
+ *     Insufficient memory to complete the operation.
+ *  @retval PAPI_ENOINIT
+ *     The PAPI library has not been initialized.
+ *
+ *  @par Examples
+ *  @code
+ *  char *names[] = { "PAPI_TOT_INS", "PAPI_L1_DCM", "PAPI_L2_TCM", "PAPI_BR_MSP" };
+ *  int group[4], pass[4];
+ *  int passes = PAPI_plan_events( names, 4, group, pass );
+ *  if ( passes < 0 )
+ *     handle_error( passes );
+ *  // for p in 0..passes-1: create one event set per group of pass p,
+ *  // add names[i] for every i with pass[i] == p, and run the workload.
+ *  @endcode
+ *
+ *  @see PAPI_add_event
+ *  @see PAPI_set_multiplex
+ */
+int
+PAPI_plan_events( char **Names, int number, int *group, int *pass )
+{
+	APIDBG( "Entry: Names: %p, number: %d, group: %p, pass: %p\n", Names, number, group, pass);
+	int *codes = NULL, *sets = NULL, *sizes = NULL, *cmps = NULL, *renum = NULL;
+	int i, j, g, h, cidx, num_cntrs, retval;
+	int num_groups = 0, num_passes = 0;
+
+	if ( init_level == PAPI_NOT_INITED )
+		papi_return( PAPI_ENOINIT );
+
+	if ( Names == NULL || group == NULL || pass == NULL || number <= 0 )
+		papi_return( PAPI_EINVAL );
+
+	codes = papi_calloc( number, sizeof ( int ) );
+	sets = papi_calloc( number, sizeof ( int ) );
+	sizes = papi_calloc( number, sizeof ( int ) );
+	cmps = papi_calloc( number, sizeof ( int ) );
+	renum = papi_calloc( number, sizeof ( int ) );
+	if ( !codes || !sets || !sizes || !cmps || !renum ) {
+		retval = PAPI_ENOMEM;
+		goto done;
+	}
+
+	/* First fit: each event goes in the first group that takes it */
+	for ( i = 0; i < number; i++ ) {
+		group[i] = -1;
+		pass[i] = -1;
+
+		if ( Names[i] == NULL ||
+			 PAPI_event_name_to_code( Names[i], &codes[i] ) != PAPI_OK ) {
+			codes[i] = PAPI_NULL;
+			continue;
+		}
+
+		/* a second copy would only be refused, or take a counter */
+		for ( j = 0; j < i; j++ ) {
+			if ( codes[j] == codes[i] && codes[j] != PAPI_NULL )
+				break;
+		}
+		if ( j < i ) {
+			group[i] = group[j];
+			continue;
+		}
+
+		cidx = PAPI_get_event_component( codes[i] );
+		if ( cidx < 0 )
+			continue;
+		num_cntrs = _papi_hwd[cidx]->cmp_info.num_cntrs;
+
+		for ( g = 0; g < num_groups; g++ ) {
+			if ( cmps[g] != cidx )
+				continue;
+			if ( num_cntrs > 0 && sizes[g] >= num_cntrs )
+				continue;
+			if ( PAPI_add_event( sets[g], codes[i] ) == PAPI_OK )
+				break;
+		}
+
+		if ( g == num_groups ) {
+			sets[g] = PAPI_NULL;
+			retval = PAPI_create_eventset( &sets[g] );
+			if ( retval != PAPI_OK )
+				goto done;
+			if ( PAPI_add_event( sets[g], codes[i] ) != PAPI_OK ) {
+				/* not even on its own */
+				PAPI_destroy_eventset( &sets[g] );
+				continue;
+			}
+			cmps[g] = cidx;
+			num_groups++;
+		}
+
+		group[i] = g;
+		sizes[g]++;
+	}
+
+	/* Groups made late may now take events of earlier ones; try to
+	   empty the groups from the last, which first fit leaves smallest */
+	for ( g = num_groups - 1; g >= 0; g-- ) {
+		for ( i = 0; i < number; i++ ) {
+			if ( group[i] != g || codes[i] == PAPI_NULL )
+				continue;
+			for ( j = 0; j < i; j++ ) {
+				if ( codes[j] == codes[i] )
+					break;
+			}
+			if ( j < i )
+				continue;
+			num_cntrs = _papi_hwd[cmps[g]]->cmp_info.num_cntrs;
+			for ( h = 0; h < num_groups; h++ ) {
+				if ( h == g || sizes[h] == 0 || cmps[h] != cmps[g] )
+					continue;
+				if ( num_cntrs > 0 && sizes[h] >= num_cntrs )
+					continue;
+				if ( sizes[h] < sizes[g] )
+					continue;
+				if ( PAPI_add_event( sets[h], codes[i] ) == PAPI_OK )
+					break;
+			}
+			if ( h == num_groups )
+				continue;
+			PAPI_remove_event( sets[g], codes[i] );
+			sizes[g]--;
+			sizes[h]++;
+			for ( j = 0; j < number; j++ ) {
+				if ( codes[j] == codes[i] && group[j] == g )
+					group[j] = h;
+			}
+		}
+	}
+
+	/* Number the groups left, and the pass of each within its component */
+	for ( g = 0, h = 0; g < num_groups; g++ ) {
+		if ( sizes[g] == 0 ) {
+			renum[g] = -1;
+			continue;
+		}
+		renum[g] = h++;
+		for ( j = 0, sizes[g] = 0; j < g; j++ ) {
+			if ( renum[j] >= 0 && cmps[j] == cmps[g] )
+				sizes[g]++;
+		}
+		if ( sizes[g] + 1 > num_passes )
+			num_passes = sizes[g] + 1;
+	}
+	for ( i = 0; i < number; i++ ) {
+		if ( group[i] < 0 )
+			continue;
+		pass[i] = sizes[group[i]];
+		group[i] = renum[group[i]];
+	}
+	retval = num_passes;
+
+  done:
+	for ( g = 0; sets && g < num_groups; g++ ) {
+		if ( sets[g] != PAPI_NULL ) {
+			PAPI_cleanup_eventset( sets[g] );
+			PAPI_destroy_eventset( &sets[g] );
+		}
+	}
+	if ( codes ) papi_free( codes );
+	if ( sets ) papi_free( sets );
+	if ( sizes ) papi_free( sizes );
+	if ( cmps ) papi_free( cmps );
+	if ( renum ) papi_free( renum );
+
+	APIDBG( "PAPI_plan_events returns %d, %d groups\n", retval, num_groups );
+	if ( retval < 0 )
+		papi_return( retval );
+	return retval;
+}
+
+/** @class PAPI_collect_events
+ *  @brief Count a list of events over repeated runs of a workload, without multiplexing.
+ *
+ *  @par C Interface:
+ *  \#include <papi.h> @n
+ *  int PAPI_collect_events( char **Names, int number,
+ *      void (*workload)( void * ), void *arg, int repeat,
+ *      long long *values, double *variance );
+ *
+ *  PAPI_collect_events() plans the events with PAPI_plan_events() and
+ *  calls the workload once per pass of the plan, or @a repeat times per
+ *  pass, with the events of that pass counting.  There is one EventSet
+ *  per component, created on the first pass that needs it and refilled
+ *  with PAPI_cleanup_eventset() and PAPI_add_event() on the next ones.
+ *
+ *  The counts are merged into one table indexed like @a Names: values[i]
+ *  is the mean count of event i over the runs of its pass and variance[i]
+ *  the sample variance of those runs, which shows how far the passes can
+ *  be compared with each other.  The workload should do the same work on
+ *  every call for the table to make sense.
+ *
+ *  Events that cannot be counted get a value of 0 and a variance of -1.
+ *
+ *  @param[in] Names
+ *     -- an array of event names
+ *  @param[in] number
+ *     -- the number of names
+ *  @param[in] workload
+ *     -- the function to measure; it is called with @a arg
+ *  @param[in] arg
+ *     -- the argument of @a workload
+ *  @param[in] repeat
+ *     -- the number of runs per pass, at least 1
+ *  @param[out] *values
+ *     -- the mean count of each event
+ *  @param[out] *variance
+ *     -- the run to run variance of each event, or NULL
+ *
+ *  @retval Non-negative-Integer
+ *     The number of passes, each of which called @a workload @a repeat times.
+ *  @retval PAPI_EINVAL
+ *     One or more of the arguments is invalid.
+ *  @retval PAPI_ENOMEM
+ *     Insufficient memory to complete the operation.
+ *  @retval PAPI_ENOINIT
+ *     The PAPI library has not been initialized.
+ *  @retval PAPI_EISRUN
+ *     The events could not be started; another EventSet may be running.
+ *
+ *  @par Examples
+ *  @code
+ *  static void kernel( void *arg ) { solve( ( problem_t * ) arg ); }
+ *  ...
+ *  long long values[200];
+ *  double variance[200];
+ *  int passes = PAPI_collect_events( names, 200, kernel, &problem, 3,
+ *                                    values, variance );
+ *  if ( passes < 0 )
+ *     handle_error( passes );
+ *  @endcode
+ *
+ *  @see PAPI_plan_events
+ */
+int
+PAPI_collect_events( char **Names, int number, void ( *workload ) ( void * ),
+					 void *arg, int repeat, long long *values, double *variance )
+{
+	APIDBG( "Entry: Names: %p, number: %d, workload: %p, arg: %p, repeat: %d, values: %p, variance: %p\n", Names, number, workload, arg, repeat, values, variance);
+	int *group = NULL, *pass = NULL, *slot = NULL, *codes = NULL, *sets = NULL;
+	long long *counts = NULL;
+	double *mean = NULL, *m2 = NULL, delta;
+	int num_cmps, num_passes, i, j, p, r, c, retval;
+
+	if ( init_level == PAPI_NOT_INITED )
+		papi_return( PAPI_ENOINIT );
+
+	if ( Names == NULL || workload == NULL || values == NULL ||
+		 number <= 0 || repeat < 1 )
+		papi_return( PAPI_EINVAL );
+
+	num_cmps = PAPI_num_components(  );
+
+	group = papi_calloc( number, sizeof ( int ) );
+	pass = papi_calloc( number, sizeof ( int ) );
+	slot = papi_calloc( number, sizeof ( int ) );
+	codes = papi_calloc( number, sizeof ( int ) );
+	counts = papi_calloc( number, sizeof ( long long ) );
+	mean = papi_calloc( number, sizeof ( double ) );
+	m2 = papi_calloc( number, sizeof ( double ) );
+	sets = papi_calloc( num_cmps, sizeof ( int ) );
+	if ( !group || !pass || !slot || !codes || !counts || !mean || !m2 || !sets ) {
+		retval = PAPI_ENOMEM;
+		goto done;
+	}
+	for ( c = 0; c < num_cmps; c++ )
+		sets[c] = PAPI_NULL;
+
+	retval = PAPI_plan_events( Names, number, group, pass );
+	if ( retval < 0 )
+		goto done;
+	num_passes = retval;
+
+	for ( p = 0; p < num_passes; p++ ) {
+
+		/* Refill the EventSets; the plan puts at most one group of
+		   each component in a pass.  slot[i] is where event i is read,
+		   copies of an event read the slot of the first one. */
+		for ( c = 0; c < num_cmps; c++ ) {
+			if ( sets[c] != PAPI_NULL )
+				PAPI_cleanup_eventset( sets[c] );
+		}
+		for ( i = 0; i < number; i++ ) {
+			slot[i] = -1;
+			if ( pass[i] != p )
+				continue;
+			PAPI_event_name_to_code( Names[i], &codes[i] );
+			for ( j = 0; j < i; j++ ) {
+				if ( pass[j] == p && codes[j] == codes[i] )
+					break;
+			}
+			if ( j < i ) {
+				slot[i] = slot[j];
+				continue;
+			}
+			c = PAPI_get_event_component( codes[i] );
+			if ( sets[c] == PAPI_NULL ) {
+				retval = PAPI_create_eventset( &sets[c] );
+				if ( retval != PAPI_OK )
+					goto done;
+			}
+			retval = PAPI_add_event( sets[c], codes[i] );
+			if ( retval != PAPI_OK )
+				goto done;
+			retval = PAPI_num_events( sets[c] );
+			if ( retval < 0 )
+				goto done;
+			slot[i] = c * number + retval - 1;
+		}
+
+		for ( r = 0; r < repeat; r++ ) {
+			for ( c = 0; c < num_cmps; c++ ) {
+				if ( sets[c] == PAPI_NULL || PAPI_num_events( sets[c] ) <= 0 )
+					continue;
+				retval = PAPI_start( sets[c] );
+				if ( retval != PAPI_OK ) {
+					while ( --c >= 0 ) {
+						if ( sets[c] != PAPI_NULL &&
+							 PAPI_num_events( sets[c] ) > 0 )
+							PAPI_stop( sets[c], NULL );
+					}
+					goto done;
+				}
+			}
+
+			workload( arg );
+
+			for ( c = num_cmps - 1; c >= 0; c-- ) {
+				if ( sets[c] == PAPI_NULL || PAPI_num_events( sets[c] ) <= 0 )
+					continue;
+				retval = PAPI_stop( sets[c], counts );
+				if ( retval != PAPI_OK )
+					goto done;
+				for ( i = 0; i < number; i++ ) {
+					if ( slot[i] < c * number || slot[i] >= ( c + 1 ) * number )
+						continue;
+					/* running mean and sum of squares, as Welford */
+					delta = ( double ) counts[slot[i] - c * number] - mean[i];
+					mean[i] += delta / ( r + 1 );
+					m2[i] += delta * ( ( double ) counts[slot[i] - c * number] - mean[i] );
+				}
+			}
+		}
+	}
+
+	for ( i = 0; i < number; i++ ) {
+		values[i] = pass[i] < 0 ? 0 : ( long long ) ( mean[i] + 0.5 );
+		if ( variance )
+			variance[i] = pass[i] < 0 ? -1.0 :
+				repeat > 1 ? m2[i] / ( repeat - 1 ) : 0.0;
+	}
+	retval = num_passes;
+
+  done:
+	for ( c = 0; sets && c < num_cmps; c++ ) {
+		if ( sets[c] != PAPI_NULL ) {
+			PAPI_cleanup_eventset( sets[c] );
+			PAPI_destroy_eventset( &sets[c] );
+		}
+	}
+	if ( group ) papi_free( group );
+	if ( pass ) papi_free( pass );
+	if ( slot ) papi_free( slot );
+	if ( codes ) papi_free( codes );
+	if ( counts ) papi_free( counts );
+	if ( mean ) papi_free( mean );
+	if ( m2 ) papi_free( m2 );
+	if ( sets ) papi_free( sets );
+
+	APIDBG( "PAPI_collect_events returns %d\n", retval );
+	if ( retval < 0 )
+		papi_return( retval );
+	return retval;
+}
+
 /* xxx This is OS dependent, not component dependent, right? */
 /** @class PAPI_get_dmem_info
  *	@brief Get information about the dynamic memory usage of the current program. 
@@ -6787,6 +7554,12 @@ PAPI_get_real_cyc( void )
  *	The time is returned in nanoseconds. 
  *	This call is equivalent to wall clock time.
  *
+ *	On Linux the clock is chosen at PAPI_library_init() by the
+ *	PAPI_REAL_TIMER environment variable: "syscall" (the default) uses
+ *	the clock picked by configure, "vdso" reads CLOCK_REALTIME through
+ *	the vDSO and "tsc" scales the invariant TSC onto CLOCK_REALTIME.  The same clock
+ *	backs PAPI_get_real_usec().  papi_clockres reports the cost of each.
+ *
  *	@see PAPI_get_virt_usec 
  *	@see PAPI_get_virt_cyc 
  *	@see PAPI_library_init
@@ -7172,14 +7945,11 @@ int  PAPI_get_component_index(const char *name)
 	APIDBG( "Entry: name: %s\n", name);
   int cidx;
 
-  const PAPI_component_info_t *cinfo;
-
+  /* Look at the vectors directly, looking up an index must not */
+  /* trigger the deferred initialization of every component.     */
   for(cidx=0;cidx<papi_num_components;cidx++) {
 
-     cinfo=PAPI_get_component_info(cidx); 
-     if (cinfo==NULL) return PAPI_ENOCMP;
-
-     if (!strcmp(name,cinfo->name)) {
+     if (!strcmp(name,_papi_hwd[cidx]->cmp_info.name)) {
         return cidx;
      }
   }
@@ -7505,3 +8275,429 @@ PAPI_get_dev_attr(void *handle, int id, PAPI_dev_attr_e attr, void *val)
 {
     return _papi_hwi_get_dev_attr(handle, id, attr, val);
 }
+
+/* Domains of every CPU, from the sysdetect CPU attributes:
+ * map[cpu * PAPI_TOPO_LEVEL__MAX_NUM + level] is the domain of cpu at
+ * level.  Domains are numbered from 0 in the order of their lowest CPU,
+ * which is the CPU that counts for the domain.  The map is built on the
+ * first call and kept until PAPI_shutdown(). */
+
+/* sysdetect keeps the affinities of at most PAPI_MAX_NUM_THREADS cpus */
+#define TOPO_MAX_CPUS 512
+
+static int *topo_cache = NULL;
+static int topo_cache_cpus = 0;
+
+static int
+topo_map( const int **map, int *num_cpus )
+{
+    void *handle = NULL, *next;
+    int *m, *key, cpu, prev, level, num, n = 0;
+    PAPI_dev_attr_e attr;
+
+    if (topo_cache != NULL) {
+        *map = topo_cache;
+        *num_cpus = topo_cache_cpus;
+        return PAPI_OK;
+    }
+
+    /* run the enumeration to its end, so that it starts over next time */
+    while (PAPI_enum_dev_type(PAPI_DEV_TYPE_ENUM__CPU, &next) == PAPI_OK) {
+        handle = next;
+    }
+    if (handle == NULL ||
+        PAPI_get_dev_attr(handle, 0, PAPI_DEV_ATTR__CPU_UINT_THREAD_COUNT, &n) != PAPI_OK ||
+        n <= 0) {
+        return PAPI_ENOSUPP;
+    }
+    if (n > TOPO_MAX_CPUS) {
+        n = TOPO_MAX_CPUS;
+    }
+
+    m = papi_calloc(n * PAPI_TOPO_LEVEL__MAX_NUM, sizeof(int));
+    key = papi_calloc(n, sizeof(int));
+    if (m == NULL || key == NULL) {
+        if (m) papi_free(m);
+        if (key) papi_free(key);
+        return PAPI_ENOMEM;
+    }
+
+    for (level = 0; level < PAPI_TOPO_LEVEL__MAX_NUM; ++level) {
+        for (cpu = 0; cpu < n; ++cpu) {
+            switch (level) {
+                case PAPI_TOPO_LEVEL__CORE:
+                    attr = PAPI_DEV_ATTR__CPU_UINT_THR_CORE_AFFINITY;
+                    break;
+                case PAPI_TOPO_LEVEL__LLC:
+                    attr = PAPI_DEV_ATTR__CPU_UINT_THR_LLC_AFFINITY;
+                    break;
+                case PAPI_TOPO_LEVEL__NUMA:
+                    attr = PAPI_DEV_ATTR__CPU_UINT_THR_NUMA_AFFINITY;
+                    break;
+                case PAPI_TOPO_LEVEL__PACKAGE:
+                    attr = PAPI_DEV_ATTR__CPU_UINT_THR_SOCKET_AFFINITY;
+                    break;
+                default:
+                    key[cpu] = (level == PAPI_TOPO_LEVEL__CPU) ? cpu : 0;
+                    continue;
+            }
+            if (PAPI_get_dev_attr(handle, cpu, attr, &key[cpu]) != PAPI_OK) {
+                key[cpu] = 0;
+            }
+        }
+
+        for (cpu = 0, num = 0; cpu < n; ++cpu) {
+            for (prev = 0; prev < cpu && key[prev] != key[cpu]; ++prev);
+            m[cpu * PAPI_TOPO_LEVEL__MAX_NUM + level] = (prev < cpu) ?
+                m[prev * PAPI_TOPO_LEVEL__MAX_NUM + level] : num++;
+        }
+    }
+    papi_free(key);
+
+    /* another thread may have built it meanwhile */
+    _papi_hwi_lock(GLOBAL_LOCK);
+    if (topo_cache == NULL) {
+        topo_cache = m;
+        topo_cache_cpus = n;
+        m = NULL;
+    }
+    _papi_hwi_unlock(GLOBAL_LOCK);
+    if (m) papi_free(m);
+
+    *map = topo_cache;
+    *num_cpus = topo_cache_cpus;
+    return PAPI_OK;
+}
+
+static void
+topo_map_free( void )
+{
+    if (topo_cache) papi_free(topo_cache);
+    topo_cache = NULL;
+    topo_cache_cpus = 0;
+}
+
+/** \class PAPI_get_cpu_topology
+ *  \brief returns the topology domains of a CPU
+ *  \retval PAPI_OK
+ *  \retval PAPI_EINVAL
+ *      cpu is not a CPU of the system or domains is NULL
+ *  \retval PAPI_ENOSUPP
+ *      the CPU topology is not known
+ *  \param cpu
+ *      the CPU to look up
+ *  \param domains
+ *      array of PAPI_TOPO_LEVEL__MAX_NUM entries; domains[level] is set to
+ *      the domain of the CPU at each level of PAPI_topo_level_e
+ *  \par Example:
+ *  \code
+    int domains[PAPI_TOPO_LEVEL__MAX_NUM];
+    PAPI_get_cpu_topology(5, domains);
+    printf("cpu 5: core %d, llc %d, numa %d, package %d\n",
+           domains[PAPI_TOPO_LEVEL__CORE], domains[PAPI_TOPO_LEVEL__LLC],
+           domains[PAPI_TOPO_LEVEL__NUMA], domains[PAPI_TOPO_LEVEL__PACKAGE]);
+ *  \endcode
+ *  PAPI_get_cpu_topology() maps a CPU to its core, last level cache, NUMA
+ *  node and package, using the topology found by the sysdetect component.
+ *  The domains of each level are numbered from 0, in the order of their
+ *  lowest numbered CPU.
+ *
+ *  \bug none known
+ *  \see PAPI_get_topo_domains
+ *  \see PAPI_get_dev_attr
+ */
+int
+PAPI_get_cpu_topology(int cpu, int *domains)
+{
+    APIDBG("Entry: cpu: %d, domains: %p\n", cpu, domains);
+    const int *map;
+    int num_cpus, level, retval;
+
+    if (domains == NULL || cpu < 0) {
+        papi_return(PAPI_EINVAL);
+    }
+
+    retval = topo_map(&map, &num_cpus);
+    if (retval != PAPI_OK) {
+        papi_return(retval);
+    }
+
+    if (cpu < num_cpus) {
+        for (level = 0; level < PAPI_TOPO_LEVEL__MAX_NUM; ++level) {
+            domains[level] = map[cpu * PAPI_TOPO_LEVEL__MAX_NUM + level];
+        }
+    } else {
+        retval = PAPI_EINVAL;
+    }
+
+    papi_return(retval);
+}
+
+/** \class PAPI_get_topo_domains
+ *  \brief returns the domains of a topology level and the CPU that counts for each
+ *  \retval Non-negative-Integer
+ *      the number of domains at the level
+ *  \retval PAPI_EINVAL
+ *      invalid level
+ *  \retval PAPI_ENOSUPP
+ *      the CPU topology is not known
+ *  \param level
+ *      the topology level
+ *  \param cpus
+ *      array filled with the designated CPU of each domain, or NULL
+ *  \param len
+ *      the number of entries in cpus
+ *  \par Example:
+ *  \code
+    int cpus[64];
+    int num = PAPI_get_topo_domains(PAPI_TOPO_LEVEL__PACKAGE, cpus, 64);
+    // uncore and RAPL events of package d are counted on cpus[d]
+ *  \endcode
+ *  PAPI_get_topo_domains() designates one CPU per domain, its lowest
+ *  numbered one, to count the events the CPUs of the domain share.
+ *
+ *  \bug none known
+ *  \see PAPI_get_cpu_topology
+ *  \see PAPI_create_topo_eventsets
+ */
+int
+PAPI_get_topo_domains(PAPI_topo_level_e level, int *cpus, int len)
+{
+    APIDBG("Entry: level: %d, cpus: %p, len: %d\n", level, cpus, len);
+    const int *map;
+    int num_cpus, cpu, d, num = 0, retval;
+
+    if (level < 0 || level >= PAPI_TOPO_LEVEL__MAX_NUM) {
+        papi_return(PAPI_EINVAL);
+    }
+
+    retval = topo_map(&map, &num_cpus);
+    if (retval != PAPI_OK) {
+        papi_return(retval);
+    }
+
+    for (cpu = 0; cpu < num_cpus; ++cpu) {
+        d = map[cpu * PAPI_TOPO_LEVEL__MAX_NUM + level];
+        if (d == num) {
+            if (cpus && d < len) {
+                cpus[d] = cpu;
+            }
+            ++num;
+        }
+    }
+
+    return num;
+}
+
+/** \class PAPI_create_topo_eventsets
+ *  \brief creates one event set per domain of a topology level
+ *  \retval Non-negative-Integer
+ *      the number of event sets created
+ *  \retval PAPI_EINVAL
+ *      invalid level, or EventSets is too short
+ *  \retval PAPI_ENOCMP
+ *      invalid component index
+ *  \retval PAPI_ECMP
+ *      the component cannot count on a given CPU
+ *  \retval PAPI_ENOSUPP
+ *      the CPU topology is not known
+ *  \param cidx
+ *      the component of the event sets
+ *  \param level
+ *      the topology level
+ *  \param EventSets
+ *      array filled with the event sets, one per domain in domain order
+ *  \param len
+ *      the number of entries in EventSets
+ *  \par Example:
+ *  \code
+    int sets[64];
+    int cidx = PAPI_get_component_index("perf_event_uncore");
+    int num = PAPI_create_topo_eventsets(cidx, PAPI_TOPO_LEVEL__PACKAGE, sets, 64);
+    for (i = 0; i < num; ++i)
+        PAPI_add_named_event(sets[i], "skx_unc_imc0::UNC_M_CAS_COUNT:RD");
+ *  \endcode
+ *  PAPI_create_topo_eventsets() creates an event set for each domain of
+ *  the level, assigned to the component and attached to the designated
+ *  CPU of the domain, as returned by PAPI_get_topo_domains().  Uncore
+ *  events go at the package level, per-CPU events at the CPU level.
+ *  At the node level, components that count for the whole node whatever
+ *  the CPU, like rapl, get a single event set that is not attached.
+ *
+ *  \bug none known
+ *  \see PAPI_get_topo_domains
+ *  \see PAPI_read_topo_eventsets
+ */
+int
+PAPI_create_topo_eventsets(int cidx, PAPI_topo_level_e level, int *EventSets, int len)
+{
+    APIDBG("Entry: cidx: %d, level: %d, EventSets: %p, len: %d\n", cidx, level, EventSets, len);
+    PAPI_option_t opt;
+    int *cpus, num, d, retval;
+
+    if (cidx < 0 || cidx >= papi_num_components) {
+        papi_return(PAPI_ENOCMP);
+    }
+
+    num = PAPI_get_topo_domains(level, NULL, 0);
+    if (num < 0) {
+        papi_return(num);
+    }
+    if (EventSets == NULL || num > len) {
+        papi_return(PAPI_EINVAL);
+    }
+
+    cpus = papi_calloc(num, sizeof(int));
+    if (cpus == NULL) {
+        papi_return(PAPI_ENOMEM);
+    }
+    PAPI_get_topo_domains(level, cpus, num);
+
+    for (d = 0; d < num; ++d) {
+        EventSets[d] = PAPI_NULL;
+        retval = PAPI_create_eventset(&EventSets[d]);
+        if (retval == PAPI_OK) {
+            retval = PAPI_assign_eventset_component(EventSets[d], cidx);
+        }
+        if (retval == PAPI_OK) {
+            memset(&opt, 0, sizeof(opt));
+            opt.cpu.eventset = EventSets[d];
+            opt.cpu.cpu_num = cpus[d];
+            retval = PAPI_set_opt(PAPI_CPU_ATTACH, &opt);
+            if (retval == PAPI_ECMP && level == PAPI_TOPO_LEVEL__NODE) {
+                retval = PAPI_OK;
+            }
+        }
+        if (retval != PAPI_OK) {
+            do {
+                if (EventSets[d] != PAPI_NULL) {
+                    PAPI_destroy_eventset(&EventSets[d]);
+                }
+            } while (--d >= 0);
+            papi_free(cpus);
+            papi_return(retval);
+        }
+    }
+
+    papi_free(cpus);
+    return num;
+}
+
+/** \class PAPI_read_topo_eventsets
+ *  \brief reads the event sets of a topology level and sums them per domain of a coarser level
+ *  \retval Non-negative-Integer
+ *      the number of domains at the rollup level
+ *  \retval PAPI_EINVAL
+ *      invalid levels, the domains of level do not nest in those of
+ *      rollup, or the event sets do not match the domains or each other
+ *  \retval PAPI_ENOSUPP
+ *      the CPU topology is not known
+ *  \param EventSets
+ *      the event sets, one per domain of level in domain order, as made
+ *      by PAPI_create_topo_eventsets(); all with the same events
+ *  \param level
+ *      the topology level of the event sets
+ *  \param num_sets
+ *      the number of event sets
+ *  \param rollup
+ *      the level to sum to, the same as level or coarser
+ *  \param values
+ *      array of (domains at rollup) x (events per set) counts; the counts
+ *      of rollup domain r start at values[r * events per set]
+ *  \par Example:
+ *  \code
+    long long node[4];
+    // four uncore events per package, summed for the whole node
+    PAPI_read_topo_eventsets(sets, PAPI_TOPO_LEVEL__PACKAGE, num,
+                             PAPI_TOPO_LEVEL__NODE, node);
+ *  \endcode
+ *  PAPI_read_topo_eventsets() reads every event set once, whatever the
+ *  number of CPUs of its domain, and adds its counts to the domain of the
+ *  rollup level that contains it.  Shared counters are so read once per
+ *  domain that shares them, not once per CPU.
+ *
+ *  \bug none known
+ *  \see PAPI_create_topo_eventsets
+ *  \see PAPI_read
+ */
+int
+PAPI_read_topo_eventsets(const int *EventSets, PAPI_topo_level_e level, int num_sets,
+                         PAPI_topo_level_e rollup, long long *values)
+{
+    APIDBG("Entry: EventSets: %p, level: %d, num_sets: %d, rollup: %d, values: %p\n", EventSets, level, num_sets, rollup, values);
+    long long *counts = NULL;
+    const int *map;
+    int *up = NULL, num_cpus, cpu, d, e, num = 0, num_up = 0, num_events = -1, retval;
+
+    if (EventSets == NULL || values == NULL ||
+        level < 0 || rollup < level || rollup >= PAPI_TOPO_LEVEL__MAX_NUM) {
+        papi_return(PAPI_EINVAL);
+    }
+
+    retval = topo_map(&map, &num_cpus);
+    if (retval != PAPI_OK) {
+        papi_return(retval);
+    }
+
+    /* up[d] is the rollup domain of domain d; every CPU of d must agree */
+    up = papi_calloc(num_cpus, sizeof(int));
+    if (up == NULL) {
+        retval = PAPI_ENOMEM;
+        goto fn_exit;
+    }
+    for (cpu = 0; cpu < num_cpus; ++cpu) {
+        d = map[cpu * PAPI_TOPO_LEVEL__MAX_NUM + level];
+        e = map[cpu * PAPI_TOPO_LEVEL__MAX_NUM + rollup];
+        if (d == num) {
+            up[num++] = e;
+        } else if (up[d] != e) {
+            retval = PAPI_EINVAL;
+            goto fn_exit;
+        }
+        if (e >= num_up) {
+            num_up = e + 1;
+        }
+    }
+    if (num != num_sets) {
+        retval = PAPI_EINVAL;
+        goto fn_exit;
+    }
+
+    for (d = 0; d < num_sets; ++d) {
+        retval = PAPI_num_events(EventSets[d]);
+        if (retval < 0) {
+            goto fn_exit;
+        }
+        if (num_events >= 0 && retval != num_events) {
+            retval = PAPI_EINVAL;
+            goto fn_exit;
+        }
+        num_events = retval;
+    }
+
+    counts = papi_calloc(num_events > 0 ? num_events : 1, sizeof(long long));
+    if (counts == NULL) {
+        retval = PAPI_ENOMEM;
+        goto fn_exit;
+    }
+
+    memset(values, 0, num_up * num_events * sizeof(long long));
+    for (d = 0; d < num_sets; ++d) {
+        retval = PAPI_read(EventSets[d], counts);
+        if (retval != PAPI_OK) {
+            goto fn_exit;
+        }
+        for (e = 0; e < num_events; ++e) {
+            values[up[d] * num_events + e] += counts[e];
+        }
+    }
+    retval = num_up;
+
+  fn_exit:
+    if (up) papi_free(up);
+    if (counts) papi_free(counts);
+    if (retval < 0) {
+        papi_return(retval);
+    }
+    return retval;
+}
@@ -434,6 +434,7 @@ All of the functions in the PerfAPI should use the following set of constants.
 	@{ */
 #define PAPI_INHERIT_ALL  1     /**< The flag to this to inherit all children's counters */
 #define PAPI_INHERIT_NONE 0     /**< The flag to this to inherit none of the children's counters */
+#define PAPI_INHERIT_THREADS 2  /**< Inherit all children's counters and keep each one's counts, see PAPI_read_inherited */
 
 
 #define PAPI_DETACH			1		/**< Detach */
@@ -465,6 +466,9 @@ All of the functions in the PerfAPI should use the following set of constants.
 #define PAPI_CPU_ATTACH		27      /**< Specify a cpu number the event set should be tied to */
 #define PAPI_INHERIT		28      /**< Option to set counter inheritance flag */
 #define PAPI_USER_EVENTS_FILE 29	/**< Option to set file from where to parse user defined events */
+#define PAPI_CPU_VECTOR		30      /**< Replicate the event set on a set of cpus, read with PAPI_read_vector */
+#define PAPI_CGROUP_ATTACH	31      /**< Count only tasks in a cgroup, on every cpu */
+#define PAPI_UNCORE_AGGREGATE	32      /**< Count uncore events on every instance and socket of their PMU */
 
 #define PAPI_INIT_SLOTS    64     /*Number of initialized slots in
                                    DynamicArray of EventSets */
@@ -819,6 +823,31 @@ typedef char* PAPI_user_defined_events_file_t;
          unsigned int cpu_num;
       } PAPI_cpu_option_t;
 
+/**  @ingroup papi_data_structures
+  *	@brief cpus an event set is replicated on, see PAPI_read_vector() */
+      typedef struct _papi_cpu_vector_option {
+         int eventset;
+         int num_cpus;              /**< number of entries in cpus, 0 for all online cpus */
+         unsigned int *cpus;        /**< cpu numbers, one row of PAPI_read_vector() each */
+         int num_threads;           /**< helper threads used to read the cpus, 0 for none */
+      } PAPI_cpu_vector_option_t;
+
+/**  @ingroup papi_data_structures
+  *	@brief cgroup an event set is restricted to */
+      typedef struct _papi_cgroup_option {
+         int eventset;
+         char *path;                /**< cgroup directory, NULL to detach */
+         int num_cpus;              /**< out: number of cpus counted on */
+      } PAPI_cgroup_option_t;
+
+/**  @ingroup papi_data_structures
+  *	@brief uncore events counted on all instances and sockets of their PMU */
+      typedef struct _papi_uncore_aggregate_option {
+         int eventset;
+         int aggregate;             /**< 1 to expand events over all PMU instances, 0 to stop */
+         int per_socket;            /**< PAPI_read_vector rows: 0 per instance and socket, 1 per socket */
+      } PAPI_uncore_aggregate_option_t;
+
 /** @ingroup papi_data_structures */
    typedef struct _papi_multiplex_option {
       int eventset;
@@ -851,6 +880,9 @@ typedef char* PAPI_user_defined_events_file_t;
 		PAPI_domain_option_t defdomain;
 		PAPI_attach_option_t attach;
 		PAPI_cpu_option_t cpu;
+		PAPI_cpu_vector_option_t cpu_vector;
+		PAPI_cgroup_option_t cgroup;
+		PAPI_uncore_aggregate_option_t uncore_aggregate;
 		PAPI_multiplex_option_t multiplex;
 		PAPI_itimer_option_t itimer;
 		PAPI_hw_info_t *hw_info;
@@ -1131,8 +1163,27 @@ typedef enum {
     PAPI_DEV_ATTR__ROCM_UINT_SIMD_PER_CU,
     PAPI_DEV_ATTR__ROCM_UINT_COMP_CAP_MAJOR,
     PAPI_DEV_ATTR__ROCM_UINT_COMP_CAP_MINOR,
+    PAPI_DEV_ATTR__CPU_UINT_THR_CORE_AFFINITY,
+    PAPI_DEV_ATTR__CPU_UINT_THR_LLC_AFFINITY,
+    PAPI_DEV_ATTR__CPU_UINT_THR_SOCKET_AFFINITY,
 } PAPI_dev_attr_e;
 
+/** @ingroup papi_data_structures
+ * PAPI_topo_level_e - levels of the CPU topology, from the finest.
+ *
+ * Each level splits the CPUs into domains: the CPUs of a core, of a last
+ * level cache, of a NUMA node, of a package, and the whole node.
+ */
+typedef enum {
+    PAPI_TOPO_LEVEL__CPU,
+    PAPI_TOPO_LEVEL__CORE,
+    PAPI_TOPO_LEVEL__LLC,
+    PAPI_TOPO_LEVEL__NUMA,
+    PAPI_TOPO_LEVEL__PACKAGE,
+    PAPI_TOPO_LEVEL__NODE,
+    PAPI_TOPO_LEVEL__MAX_NUM
+} PAPI_topo_level_e;
+
 
 /** \internal
   * @defgroup low_api The Low Level API 
@@ -1179,6 +1230,8 @@ typedef enum {
    int   PAPI_overflow(int EventSet, int EventCode, int threshold,
                      int flags, PAPI_overflow_handler_t handler); /**< set up an event set to begin registering overflows */
    void  PAPI_perror(const char *msg ); /**< Print a PAPI error message */
+   int   PAPI_plan_events(char **Names, int number, int *group, int *pass); /**< partition a list of events into groups that can be counted together */
+   int   PAPI_collect_events(char **Names, int number, void (*workload)(void *), void *arg, int repeat, long long *values, double *variance); /**< count a list of events over repeated runs of a workload, one run per group */
    int   PAPI_profil(void *buf, unsigned bufsiz, vptr_t offset,
 					 unsigned scale, int EventSet, int EventCode,
 					 int threshold, int flags); /**< generate PC histogram data where hardware counter overflow occurs */
@@ -1186,6 +1239,8 @@ typedef enum {
    int   PAPI_query_named_event(const char *EventName); /**< query if a named PAPI event exists */
    int   PAPI_read(int EventSet, long long * values); /**< read hardware events from an event set with no reset */
    int   PAPI_read_ts(int EventSet, long long * values, long long *cyc); /**< read from an eventset with a real-time cycle timestamp */
+   int   PAPI_read_vector(int EventSet, long long * values, int *rows); /**< read every replica (row) of a replicated event set at once */
+   int   PAPI_read_inherited(int EventSet, int *index, unsigned long *tid, long long * values); /**< iterate over the counts of exited inherited children */
    int   PAPI_register_thread(void); /**< inform PAPI of the existence of a new thread */
    int   PAPI_remove_event(int EventSet, int EventCode); /**< remove a hardware event from a PAPI event set */
    int   PAPI_remove_named_event(int EventSet, const char *EventName); /**< remove a named event from a PAPI event set */
@@ -1226,6 +1281,10 @@ typedef enum {
    int PAPI_enum_dev_type(int enum_modifier, void **handle); /**< return the handler for the next device type available */
    int PAPI_get_dev_type_attr(void *handle, PAPI_dev_type_attr_e attr, void *value); /**< return the value of the queried attribute for the device type handle */
    int PAPI_get_dev_attr(void *handle, int id, PAPI_dev_attr_e attr, void *value); /**< return the value of the queried attribute for the device handle */
+   int PAPI_get_cpu_topology(int cpu, int *domains); /**< return the core, LLC, NUMA node and package domains of a cpu */
+   int PAPI_get_topo_domains(PAPI_topo_level_e level, int *cpus, int len); /**< return the number of domains at a topology level and the cpu that counts for each */
+   int PAPI_create_topo_eventsets(int cidx, PAPI_topo_level_e level, int *EventSets, int len); /**< create one event set per domain of a topology level */
+   int PAPI_read_topo_eventsets(const int *EventSets, PAPI_topo_level_e level, int num_sets, PAPI_topo_level_e rollup, long long *values); /**< read per domain event sets and sum them per domain of a coarser level */
 
    /** @} */
 
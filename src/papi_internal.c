@@ -42,6 +42,7 @@
 #include "extras.h"
 #include "papi_preset.h"
 #include "cpus.h"
+#include "papi_simd.h"
 
 #include "papi_common_strings.h"
 
@@ -748,7 +749,7 @@ create_EventSet( EventSetInfo_t ** here )
 {
    EventSetInfo_t *ESI;
 
-   ESI = ( EventSetInfo_t * ) papi_calloc( 1, sizeof ( EventSetInfo_t ) );
+   ESI = ( EventSetInfo_t * ) papi_pool_calloc( 1, sizeof ( EventSetInfo_t ) );
    if ( ESI == NULL ) {
       return PAPI_ENOMEM;
    }
@@ -770,6 +771,9 @@ _papi_hwi_assign_eventset( EventSetInfo_t *ESI, int cidx )
    /* If component doesn't exist... */
    if (_papi_hwi_invalid_cmp(cidx)) return PAPI_ECMP;
 
+   /* The control state sizes below come from init_component() */
+   _papi_hwi_component_check_n_initialize( cidx );
+
    /* Assigned at create time */
    ESI->domain.domain = _papi_hwd[cidx]->cmp_info.default_domain;
    ESI->granularity.granularity =
@@ -779,32 +783,32 @@ _papi_hwi_assign_eventset( EventSetInfo_t *ESI, int cidx )
    /* ??? */
    max_counters = ( size_t ) _papi_hwd[cidx]->cmp_info.num_mpx_cntrs;
 
-   ESI->ctl_state = (hwd_control_state_t *) papi_calloc( 1, (size_t)
+   ESI->ctl_state = (hwd_control_state_t *) papi_pool_calloc( 1, (size_t)
 				   _papi_hwd[cidx]->size.control_state );
-   ESI->sw_stop = (long long *) papi_calloc( ( size_t ) max_counters,
+   ESI->sw_stop = (long long *) papi_pool_calloc( ( size_t ) max_counters,
 						      sizeof ( long long ) );
-   ESI->hw_start = ( long long * ) papi_calloc( ( size_t ) max_counters,
+   ESI->hw_start = ( long long * ) papi_pool_calloc( ( size_t ) max_counters,
                                                       sizeof ( long long ) );
-   ESI->EventInfoArray = ( EventInfo_t * ) papi_calloc( (size_t) max_counters,
+   ESI->EventInfoArray = ( EventInfo_t * ) papi_pool_calloc( (size_t) max_counters,
                                                       sizeof ( EventInfo_t ) );
 
    /* allocate room for the native events and for the component-private */
    /* register structures */
    /* ugh is there a cleaner way to allocate this?  vmw */
    ESI->NativeInfoArray = ( NativeInfo_t * )
-     papi_calloc( ( size_t ) max_counters, sizeof ( NativeInfo_t ));
+     papi_pool_calloc( ( size_t ) max_counters, sizeof ( NativeInfo_t ));
 
-   ESI->NativeBits = papi_calloc(( size_t ) max_counters,
+   ESI->NativeBits = papi_pool_calloc(( size_t ) max_counters,
                                  ( size_t ) _papi_hwd[cidx]->size.reg_value );
 
    /* NOTE: the next two malloc allocate blocks of memory that are later */
    /* parcelled into overflow and profile arrays                         */
    ESI->overflow.deadline = ( long long * )
-		papi_malloc( ( sizeof ( long long ) +
+		papi_pool_calloc( 1, ( sizeof ( long long ) +
 					   sizeof ( int ) * 3 ) * ( size_t ) max_counters );
 
    ESI->profile.prof = ( PAPI_sprofil_t ** )
-		papi_malloc( ( sizeof ( PAPI_sprofil_t * ) * ( size_t ) max_counters +
+		papi_pool_calloc( 1, ( sizeof ( PAPI_sprofil_t * ) * ( size_t ) max_counters +
 					   ( size_t ) max_counters * sizeof ( int ) * 4 ) );
 
    /* If any of these allocations failed, free things up and fail */
@@ -818,15 +822,15 @@ _papi_hwi_assign_eventset( EventSetInfo_t *ESI, int cidx )
 	( ESI->profile.prof == NULL ) ||
         ( ESI->overflow.deadline == NULL ) ) {
 
-      if ( ESI->sw_stop ) papi_free( ESI->sw_stop );
-      if ( ESI->hw_start ) papi_free( ESI->hw_start );
-      if ( ESI->EventInfoArray ) papi_free( ESI->EventInfoArray );
-      if ( ESI->NativeInfoArray ) papi_free( ESI->NativeInfoArray );
-      if ( ESI->NativeBits ) papi_free( ESI->NativeBits );
-      if ( ESI->ctl_state ) papi_free( ESI->ctl_state );
-      if ( ESI->overflow.deadline ) papi_free( ESI->overflow.deadline );
-      if ( ESI->profile.prof ) papi_free( ESI->profile.prof );
-      papi_free( ESI );
+      if ( ESI->sw_stop ) papi_pool_free( ESI->sw_stop );
+      if ( ESI->hw_start ) papi_pool_free( ESI->hw_start );
+      if ( ESI->EventInfoArray ) papi_pool_free( ESI->EventInfoArray );
+      if ( ESI->NativeInfoArray ) papi_pool_free( ESI->NativeInfoArray );
+      if ( ESI->NativeBits ) papi_pool_free( ESI->NativeBits );
+      if ( ESI->ctl_state ) papi_pool_free( ESI->ctl_state );
+      if ( ESI->overflow.deadline ) papi_pool_free( ESI->overflow.deadline );
+      if ( ESI->profile.prof ) papi_pool_free( ESI->profile.prof );
+      papi_pool_free( ESI );
       return PAPI_ENOMEM;
    }
 
@@ -893,12 +897,16 @@ _papi_hwi_assign_eventset( EventSetInfo_t *ESI, int cidx )
 void
 _papi_hwi_free_EventSet( EventSetInfo_t * ESI )
 {
+	/* sets destroyed without PAPI_cleanup_eventset() still hold what */
+	/* the component allocated in their control state                 */
+	if ( !_papi_hwi_invalid_cmp( ESI->CmpIdx ) && ESI->ctl_state )
+		_papi_hwd[ESI->CmpIdx]->cleanup_eventset( ESI->ctl_state );
 	_papi_hwi_cleanup_eventset( ESI );
 
 #ifdef DEBUG
 	memset( ESI, 0x00, sizeof ( EventSetInfo_t ) );
 #endif
-	papi_free( ESI );
+	papi_pool_free( ESI );
 
 }
 
@@ -1073,6 +1081,44 @@ event_already_in_eventset( EventSetInfo_t * ESI, int papi_event )
    return PAPI_ENOEVNT;
 }
 
+/* Copy the counter position of every plain event into the compact
+   ReadPos array gathered by _papi_hwi_read(), and list the derived
+   events, which need their EventInfoArray entry.  If the arrays can't
+   be grown ReadCount no longer matches NumberOfEvents and reads fall
+   back to the EventInfoArray.  */
+static void
+update_read_info( EventSetInfo_t *ESI )
+{
+	int *info;
+	int i, size, pos;
+
+	if ( ESI->NumberOfEvents > ESI->ReadSize ) {
+		size = ( int ) ( ( ( ESI->NumberOfEvents * sizeof ( int ) +
+			PAPI_CACHE_LINE - 1 ) / PAPI_CACHE_LINE ) *
+			PAPI_CACHE_LINE / sizeof ( int ) );
+		info = papi_aligned_calloc( 2 * ( size_t ) size, sizeof ( int ) );
+		if ( info == NULL ) {
+			ESI->ReadCount = -1;
+			return;
+		}
+		papi_aligned_free( ESI->ReadPos );
+		ESI->ReadPos = info;
+		ESI->ReadDerived = info + size;
+		ESI->ReadSize = size;
+	}
+
+	ESI->ReadDerivedCount = 0;
+	for ( i = 0; i < ESI->NumberOfEvents; i++ ) {
+		pos = ESI->EventInfoArray[i].pos[0];
+		if ( pos != -1 && ESI->EventInfoArray[i].derived != NOT_DERIVED ) {
+			ESI->ReadDerived[ESI->ReadDerivedCount++] = i;
+			pos = -1;
+		}
+		ESI->ReadPos[i] = pos;
+	}
+	ESI->ReadCount = ESI->NumberOfEvents;
+}
+
 /* This function goes through the events in an EventSet's EventInfoArray */
 /* And maps each event (whether native or part of a preset) to           */
 /* an event in the EventSets NativeInfoArray.                            */
@@ -1161,6 +1207,7 @@ _papi_hwi_map_events_to_native( EventSetInfo_t *ESI)
 		}
 		event++;
 	}
+	update_read_info( ESI );
 	INTDBG("EXIT: \n");
 	return;
 }
@@ -1346,6 +1393,7 @@ _papi_hwi_add_event( EventSetInfo_t * ESI, int EventCode )
 	if (cidx<0) {
 		return PAPI_ENOCMP;
 	}
+	_papi_hwi_component_check_n_initialize( cidx );
 	if (_papi_hwd[cidx]->cmp_info.disabled &&
         _papi_hwd[cidx]->cmp_info.disabled != PAPI_EDELAY_INIT) {
 		return PAPI_ECMP_DISABLED;
@@ -1698,6 +1746,8 @@ _papi_hwi_remove_event( EventSetInfo_t * ESI, int EventCode )
 	array[thisindex].derived = NOT_DERIVED;
 	ESI->NumberOfEvents--;
 
+	update_read_info( ESI );
+
 	return ( PAPI_OK );
 }
 
@@ -1725,6 +1775,18 @@ _papi_hwi_read( hwd_context_t * context, EventSetInfo_t * ESI,
 	   changed.
 	 */
 
+	/* Common case: gather the plain events through the compact copy */
+	/* of the mapping, then compute the few derived ones             */
+	if ( ESI->ReadCount == ESI->NumberOfEvents ) {
+		_papi_simd_gather( values, dp, ESI->ReadPos, ESI->ReadCount );
+		for ( i = 0; i != ESI->ReadDerivedCount; i++ ) {
+			index = ESI->ReadDerived[i];
+			values[index] = handle_derived( &ESI->EventInfoArray[index], dp );
+		}
+		INTDBG("EXIT: PAPI_OK\n");
+		return PAPI_OK;
+	}
+
 	for ( i = 0; i != ESI->NumberOfEvents; i++ ) {
 
 		index = ESI->EventInfoArray[i].pos[0];
@@ -1754,6 +1816,90 @@ _papi_hwi_read( hwd_context_t * context, EventSetInfo_t * ESI,
 	return PAPI_OK;
 }
 
+/* Same distribution as _papi_hwi_read, applied to every row of a     */
+/* replicated (PAPI_CPU_VECTOR) event set.  On entry *rows holds the  */
+/* number of rows values[] can hold, on exit the number of rows read. */
+int
+_papi_hwi_read_vector( hwd_context_t * context, EventSetInfo_t * ESI,
+					   long long *values, int *rows )
+{
+	INTDBG("ENTER: context: %p, ESI: %p, values: %p, rows: %d\n", context, ESI, values, *rows);
+	int retval;
+	long long *dp = NULL;
+	int i, r, index, nrows = 0, rowlen = 0;
+
+	retval = _papi_hwd[ESI->CmpIdx]->read_vector( context, ESI->ctl_state,
+						      &dp, &nrows, &rowlen );
+	if ( retval != PAPI_OK ) {
+		INTDBG("EXIT: retval: %d\n", retval);
+		return retval;
+	}
+
+	if ( nrows > *rows ) {
+		*rows = nrows;
+		INTDBG("EXIT: PAPI_EINVAL, need %d rows\n", nrows);
+		return PAPI_EINVAL;
+	}
+
+	for ( r = 0; r < nrows; r++ ) {
+		long long *row = dp + ( size_t ) r * ( size_t ) rowlen;
+		long long *out = values + ( size_t ) r * ( size_t ) ESI->NumberOfEvents;
+
+		for ( i = 0; i != ESI->NumberOfEvents; i++ ) {
+			index = ESI->EventInfoArray[i].pos[0];
+			if ( index == -1 )
+				continue;
+			if ( ESI->EventInfoArray[i].derived == NOT_DERIVED )
+				out[i] = row[index];
+			else
+				out[i] = handle_derived( &ESI->EventInfoArray[i], row );
+		}
+	}
+	*rows = nrows;
+
+	INTDBG("EXIT: PAPI_OK\n");
+	return PAPI_OK;
+}
+
+/* Counts of the index'th exited child of an inheriting event set */
+int
+_papi_hwi_read_inherited( hwd_context_t * context, EventSetInfo_t * ESI,
+					   int index, unsigned long *tid, long long *values )
+{
+	INTDBG("ENTER: context: %p, ESI: %p, index: %d\n", context, ESI, index);
+	int retval;
+	int *tids = NULL;
+	long long *dp = NULL, *row;
+	int i, pos, nrows = 0, rowlen = 0;
+
+	retval = _papi_hwd[ESI->CmpIdx]->read_inherited( context, ESI->ctl_state,
+							 &tids, &dp, &nrows, &rowlen );
+	if ( retval != PAPI_OK ) {
+		INTDBG("EXIT: retval: %d\n", retval);
+		return retval;
+	}
+
+	if ( index >= nrows ) {
+		INTDBG("EXIT: PAPI_ENOEVNT, %d children\n", nrows);
+		return PAPI_ENOEVNT;
+	}
+
+	row = dp + ( size_t ) index * ( size_t ) rowlen;
+	for ( i = 0; i != ESI->NumberOfEvents; i++ ) {
+		pos = ESI->EventInfoArray[i].pos[0];
+		if ( pos == -1 )
+			continue;
+		if ( ESI->EventInfoArray[i].derived == NOT_DERIVED )
+			values[i] = row[pos];
+		else
+			values[i] = handle_derived( &ESI->EventInfoArray[i], row );
+	}
+	*tid = ( unsigned long ) tids[index];
+
+	INTDBG("EXIT: PAPI_OK\n");
+	return PAPI_OK;
+}
+
 int
 _papi_hwi_cleanup_eventset( EventSetInfo_t * ESI )
 {
@@ -1822,28 +1968,35 @@ _papi_hwi_cleanup_eventset( EventSetInfo_t * ESI )
 		   _papi_hwi_shutdown_cpu( ESI->CpuInfo );
 
    if ( ESI->ctl_state )
-      papi_free( ESI->ctl_state );
+      papi_pool_free( ESI->ctl_state );
 
    if ( ESI->sw_stop )
-      papi_free( ESI->sw_stop );
+      papi_pool_free( ESI->sw_stop );
 
    if ( ESI->hw_start )
-      papi_free( ESI->hw_start );
+      papi_pool_free( ESI->hw_start );
 
    if ( ESI->EventInfoArray )
-      papi_free( ESI->EventInfoArray );
+      papi_pool_free( ESI->EventInfoArray );
 
    if ( ESI->NativeInfoArray )
-      papi_free( ESI->NativeInfoArray );
+      papi_pool_free( ESI->NativeInfoArray );
 
    if ( ESI->NativeBits )
-      papi_free( ESI->NativeBits );
+      papi_pool_free( ESI->NativeBits );
 
    if ( ESI->overflow.deadline )
-      papi_free( ESI->overflow.deadline );
+      papi_pool_free( ESI->overflow.deadline );
 
    if ( ESI->profile.prof )
-      papi_free( ESI->profile.prof );
+      papi_pool_free( ESI->profile.prof );
+
+   papi_aligned_free( ESI->ReadPos );
+   ESI->ReadPos = NULL;
+   ESI->ReadDerived = NULL;
+   ESI->ReadSize = 0;
+   ESI->ReadCount = 0;
+   ESI->ReadDerivedCount = 0;
 
    ESI->ctl_state = NULL;
    ESI->sw_stop = NULL;
@@ -1927,12 +2080,75 @@ _papi_hwi_convert_eventset_to_multiplex( _papi_int_multiplex_t * mpx )
 
 int papi_num_components = ( sizeof ( _papi_hwd ) / sizeof ( *_papi_hwd ) ) - 1;
 
+/* Components whose init_component() has been deferred to first use.
+ * Cleared by _papi_hwi_component_check_n_initialize().               */
+static volatile int cmp_init_pending[PAPI_NUM_COMP];
+
+/*
+ * Returns 1 if the component name appears in the comma separated
+ * PAPI_COMPONENTS allow-list, or if PAPI_COMPONENTS is not set.
+ */
+static int
+component_is_allowed( const char *name )
+{
+	char *list, *tok, *saveptr = NULL;
+	int found = 0;
+
+	if ( getenv( "PAPI_COMPONENTS" ) == NULL ) {
+		return 1;
+	}
+
+	list = strdup( getenv( "PAPI_COMPONENTS" ) );
+	if ( list == NULL ) {
+		return 1;
+	}
+
+	for ( tok = strtok_r( list, ", ", &saveptr ); tok != NULL;
+	      tok = strtok_r( NULL, ", ", &saveptr ) ) {
+		if ( strcmp( tok, name ) == 0 ) {
+			found = 1;
+			break;
+		}
+	}
+
+	free( list );
+	return found;
+}
+
+static int
+init_component( int cidx )
+{
+	int retval;
+
+	retval = _papi_hwd[cidx]->init_component( cidx );
+
+	/* Do some sanity checking */
+	if (retval==PAPI_OK) {
+		if (_papi_hwd[cidx]->cmp_info.num_cntrs >
+		    _papi_hwd[cidx]->cmp_info.num_mpx_cntrs) {
+			fprintf(stderr,"Warning!  num_cntrs %d is more than num_mpx_cntrs %d for component %s\n",
+			        _papi_hwd[cidx]->cmp_info.num_cntrs,
+			        _papi_hwd[cidx]->cmp_info.num_mpx_cntrs,
+			        _papi_hwd[cidx]->cmp_info.name);
+		}
+	}
+
+	return retval;
+}
+
 /*
  * Routine that initializes all available components.
  * A component is available if a pointer to its info vector
  * appears in the NULL terminated_papi_hwd table.
  * Modified to accept an arg: 0=do not init perf_event or 
  * perf_event_uncore. 1=init ONLY perf_event or perf_event_uncore.
+ *
+ * Components not listed in the PAPI_COMPONENTS environment variable
+ * (when it is set) are disabled. Except for perf_event and
+ * perf_event_uncore, which provide the presets, components are not
+ * initialized here: they are marked PAPI_EDELAY_INIT and their
+ * init_component() runs on first use, see
+ * _papi_hwi_component_check_n_initialize().
  */
 int
 _papi_hwi_init_global( int PE_OR_PEU )
@@ -1953,20 +2169,34 @@ _papi_hwi_init_global( int PE_OR_PEU )
 	      return retval;
 	   }
 
+	   if (PE_OR_PEU == is_pe_peu) {
+	      cmp_init_pending[i] = 0;
+
+	      /* Left over from a previous PAPI_library_init() */
+	      if (_papi_hwd[i]->cmp_info.disabled == PAPI_EDELAY_INIT) {
+	         _papi_hwd[i]->cmp_info.disabled = PAPI_OK;
+	      }
+
+	      if (!_papi_hwd[i]->cmp_info.disabled &&
+	          !component_is_allowed(_papi_hwd[i]->cmp_info.name)) {
+	         _papi_hwd[i]->cmp_info.disabled = PAPI_ECMP_DISABLED;
+	         strcpy(_papi_hwd[i]->cmp_info.disabled_reason,
+	                "Not listed in PAPI_COMPONENTS");
+	      }
+	   }
+
 	   /* We can be disabled by user before init */
 	   if (!_papi_hwd[i]->cmp_info.disabled && (PE_OR_PEU == is_pe_peu)) {
-	      retval = _papi_hwd[i]->init_component( i );
-
-	      /* Do some sanity checking */
-	      if (retval==PAPI_OK) {
-		if (_papi_hwd[i]->cmp_info.num_cntrs >
-		    _papi_hwd[i]->cmp_info.num_mpx_cntrs) {
-		  fprintf(stderr,"Warning!  num_cntrs %d is more than num_mpx_cntrs %d for component %s\n",
-                        _papi_hwd[i]->cmp_info.num_cntrs,
-                        _papi_hwd[i]->cmp_info.num_mpx_cntrs,
-                        _papi_hwd[i]->cmp_info.name);
-		}
-
+	      if (is_pe_peu) {
+	         init_component( i );
+	      } else {
+	         INTDBG("Deferring initialization of component %s\n",
+	                _papi_hwd[i]->cmp_info.name);
+	         _papi_hwd[i]->cmp_info.CmpIdx = i;
+	         _papi_hwd[i]->cmp_info.disabled = PAPI_EDELAY_INIT;
+	         strcpy(_papi_hwd[i]->cmp_info.disabled_reason,
+	                "Not initialized. Access component events to initialize it.");
+	         cmp_init_pending[i] = 1;
 	      }
 	   }
 
@@ -1975,6 +2205,57 @@ _papi_hwi_init_global( int PE_OR_PEU )
 	return PAPI_OK;
 }
 
+/* Returns 1 if the component's init_component() has been deferred and */
+/* has not run yet.                                                     */
+int
+_papi_hwi_component_init_pending( int cidx )
+{
+	return cmp_init_pending[cidx];
+}
+
+/*
+ * Run the deferred init_component() of a component, then init_thread()
+ * for every thread PAPI already knows about. Does nothing if the
+ * component was initialized already. Returns the component's
+ * cmp_info.disabled value: PAPI_OK (or PAPI_EDELAY_INIT for components
+ * that delay their own initialization) if the component is usable.
+ */
+int
+_papi_hwi_component_check_n_initialize( int cidx )
+{
+	int retval;
+
+	if ( !cmp_init_pending[cidx] ) {
+		return _papi_hwd[cidx]->cmp_info.disabled;
+	}
+
+	_papi_hwi_lock( CMPINIT_LOCK );
+
+	if ( cmp_init_pending[cidx] ) {
+		INTDBG("Running deferred initialization of component %s\n",
+		       _papi_hwd[cidx]->cmp_info.name);
+
+		_papi_hwd[cidx]->cmp_info.disabled = PAPI_OK;
+		_papi_hwd[cidx]->cmp_info.disabled_reason[0] = '\0';
+
+		retval = init_component( cidx );
+		if ( retval == PAPI_OK || retval == PAPI_EDELAY_INIT ) {
+			retval = _papi_hwi_init_component_threads( cidx );
+			if ( retval != PAPI_OK ) {
+				_papi_hwd[cidx]->cmp_info.disabled = retval;
+				strcpy(_papi_hwd[cidx]->cmp_info.disabled_reason,
+				       "Per-thread initialization failed");
+			}
+		}
+
+		cmp_init_pending[cidx] = 0;
+	}
+
+	_papi_hwi_unlock( CMPINIT_LOCK );
+
+	return _papi_hwd[cidx]->cmp_info.disabled;
+}
+
 /* Machine info struct initialization using defaults */
 /* See _papi_mdi definition in papi_internal.h       */
 
@@ -2033,6 +2314,9 @@ _papi_hwi_shutdown_global_internal( void )
 	}
 	memset( &_papi_hwi_system_info, 0x0, sizeof ( _papi_hwi_system_info ) );
 
+	papi_pool_release_thread(  );
+	papi_pool_shutdown(  );
+
 }
 
 
@@ -2448,7 +2732,7 @@ _papi_hwi_native_name_to_code( const char *in, int *out )
 	char name[PAPI_HUGE_STR_LEN];	/* make sure it's big enough */
 
 	unsigned int i;
-	int cidx;
+	int cidx, pass;
 	char *full_event_name;
 
 	if (in == NULL) {
@@ -2460,76 +2744,90 @@ _papi_hwi_native_name_to_code( const char *in, int *out )
 
 	in = _papi_hwi_strip_component_prefix(in);
 
-	// look in each component
-	for(cidx=0; cidx < papi_num_components; cidx++) {
+	// look in each component, the ones already initialized first.
+	// Components whose initialization was deferred are only initialized
+	// (and searched) when no initialized component knows the event, and
+	// never while PAPI_library_init() itself is looking up presets.
+	for(pass=0; pass < 2; pass++) {
+		for(cidx=0; cidx < papi_num_components; cidx++) {
 
-		if (_papi_hwd[cidx]->cmp_info.disabled &&
-            _papi_hwd[cidx]->cmp_info.disabled != PAPI_EDELAY_INIT)
-            continue;
+			if (_papi_hwi_component_init_pending(cidx) != pass)
+				continue;
 
-		// if this component does not support the pmu
-		// which defines this event, no need to call it
-		if (is_supported_by_component(cidx, full_event_name) == 0) {
-			continue;
-		}
+			// if this component does not support the pmu
+			// which defines this event, no need to call it
+			if (is_supported_by_component(cidx, full_event_name) == 0) {
+				continue;
+			}
 
-		INTDBG("cidx: %d, name: %s, event: %s\n",
-			cidx, _papi_hwd[cidx]->cmp_info.name, in);
+			if (pass == 1) {
+				if (init_level == PAPI_NOT_INITED)
+					continue;
+				_papi_hwi_component_check_n_initialize(cidx);
+			}
 
-		// show that we do not have an event code yet
-		// (the component may create one and update this info)
-		// this also clears any values left over from a previous call
-		_papi_hwi_set_papi_event_code(-1, -1);
+			if (_papi_hwd[cidx]->cmp_info.disabled &&
+			    _papi_hwd[cidx]->cmp_info.disabled != PAPI_EDELAY_INIT)
+				continue;
 
+			INTDBG("cidx: %d, name: %s, event: %s\n",
+				cidx, _papi_hwd[cidx]->cmp_info.name, in);
 
-		// if component has a ntv_name_to_code function, use it to get event code
-		if (_papi_hwd[cidx]->ntv_name_to_code != NULL) {
-			// try and get this events event code
-			retval = _papi_hwd[cidx]->ntv_name_to_code( in, ( unsigned * ) out );
-			if (retval==PAPI_OK) {
-				*out = _papi_hwi_native_to_eventcode(cidx, *out, -1, in);
-				free (full_event_name);
-				INTDBG("EXIT: PAPI_OK  event: %s code: %#x\n", in, *out);
-				return PAPI_OK;
-			}
-		} else {
-			// force the code through the work around
-			retval = PAPI_ECMP;
-		}
+			// show that we do not have an event code yet
+			// (the component may create one and update this info)
+			// this also clears any values left over from a previous call
+			_papi_hwi_set_papi_event_code(-1, -1);
 
-		/* If not implemented, work around */
-		if ( retval==PAPI_ECMP) {
-			i = 0;
-			retval = _papi_hwd[cidx]->ntv_enum_events( &i, PAPI_ENUM_FIRST );
-			if (retval != PAPI_OK) {
-				free (full_event_name);
-				INTDBG("EXIT: retval: %d\n", retval);
-				return retval;
+
+			// if component has a ntv_name_to_code function, use it to get event code
+			if (_papi_hwd[cidx]->ntv_name_to_code != NULL) {
+				// try and get this events event code
+				retval = _papi_hwd[cidx]->ntv_name_to_code( in, ( unsigned * ) out );
+				if (retval==PAPI_OK) {
+					*out = _papi_hwi_native_to_eventcode(cidx, *out, -1, in);
+					free (full_event_name);
+					INTDBG("EXIT: PAPI_OK  event: %s code: %#x\n", in, *out);
+					return PAPI_OK;
+				}
+			} else {
+				// force the code through the work around
+				retval = PAPI_ECMP;
 			}
 
-//			_papi_hwi_lock( INTERNAL_LOCK );
-
-			do {
-				// save event code so components can get it with call to: _papi_hwi_get_papi_event_code()
-				_papi_hwi_set_papi_event_code(i, 0);
-				retval = _papi_hwd[cidx]->ntv_code_to_name(i, name, sizeof(name));
-				/* printf("%#x\nname =|%s|\ninput=|%s|\n", i, name, in); */
-				if ( retval == PAPI_OK && in != NULL) {
-					if ( strcasecmp( name, in ) == 0 ) {
-						*out = _papi_hwi_native_to_eventcode(cidx, i, -1, name);
-						free (full_event_name);
-						INTDBG("EXIT: PAPI_OK, event: %s, code: %#x\n", in, *out);
-						return PAPI_OK;
-					}
-					retval = PAPI_ENOEVNT;
-				} else {
-					*out = 0;
-					retval = PAPI_ENOEVNT;
-					break;
+			/* If not implemented, work around */
+			if ( retval==PAPI_ECMP) {
+				i = 0;
+				retval = _papi_hwd[cidx]->ntv_enum_events( &i, PAPI_ENUM_FIRST );
+				if (retval != PAPI_OK) {
+					free (full_event_name);
+					INTDBG("EXIT: retval: %d\n", retval);
+					return retval;
 				}
-			} while ( ( _papi_hwd[cidx]->ntv_enum_events( &i, PAPI_ENUM_EVENTS ) == PAPI_OK ) );
 
-//			_papi_hwi_unlock( INTERNAL_LOCK );
+//				_papi_hwi_lock( INTERNAL_LOCK );
+
+				do {
+					// save event code so components can get it with call to: _papi_hwi_get_papi_event_code()
+					_papi_hwi_set_papi_event_code(i, 0);
+					retval = _papi_hwd[cidx]->ntv_code_to_name(i, name, sizeof(name));
+					/* printf("%#x\nname =|%s|\ninput=|%s|\n", i, name, in); */
+					if ( retval == PAPI_OK && in != NULL) {
+						if ( strcasecmp( name, in ) == 0 ) {
+							*out = _papi_hwi_native_to_eventcode(cidx, i, -1, name);
+							free (full_event_name);
+							INTDBG("EXIT: PAPI_OK, event: %s, code: %#x\n", in, *out);
+							return PAPI_OK;
+						}
+						retval = PAPI_ENOEVNT;
+					} else {
+						*out = 0;
+						retval = PAPI_ENOEVNT;
+						break;
+					}
+				} while ( ( _papi_hwd[cidx]->ntv_enum_events( &i, PAPI_ENUM_EVENTS ) == PAPI_OK ) );
+
+//				_papi_hwi_unlock( INTERNAL_LOCK );
+			}
 		}
 	}
 
@@ -2553,6 +2851,8 @@ _papi_hwi_native_code_to_name( unsigned int EventCode,
   cidx = _papi_hwi_component_index( EventCode );
   if (cidx<0) return PAPI_ENOEVNT;
 
+  _papi_hwi_component_check_n_initialize( cidx );
+
   if ( EventCode & PAPI_NATIVE_MASK ) {
 	  // save event code so components can get it with call to: _papi_hwi_get_papi_event_code()
 	  _papi_hwi_set_papi_event_code(EventCode, 0);
@@ -2591,6 +2891,8 @@ _papi_hwi_get_native_event_info( unsigned int EventCode,
     cidx = _papi_hwi_component_index( EventCode );
     if (cidx<0) return PAPI_ENOCMP;
 
+    _papi_hwi_component_check_n_initialize( cidx );
+
     if (_papi_hwd[cidx]->cmp_info.disabled &&
         _papi_hwd[cidx]->cmp_info.disabled != PAPI_EDELAY_INIT)
         return PAPI_ENOCMP;
@@ -2763,6 +3065,7 @@ _papi_hwi_enum_dev_type(int enum_modifier, void **handle)
 
     int cidx = get_component_index("sysdetect");
     assert(cidx < papi_num_components);
+    _papi_hwi_component_check_n_initialize(cidx);
 
     return _papi_hwd[cidx]->user(0, &args, handle);
 }
@@ -2777,6 +3080,7 @@ _papi_hwi_get_dev_type_attr(void *handle, PAPI_dev_type_attr_e attr, void *value
 
     int cidx = get_component_index("sysdetect");
     assert(cidx < papi_num_components);
+    _papi_hwi_component_check_n_initialize(cidx);
 
     return _papi_hwd[cidx]->user(0, &args, value);
 }
@@ -2792,6 +3096,7 @@ _papi_hwi_get_dev_attr(void *handle, int id, PAPI_dev_attr_e attr, void *value)
 
     int cidx = get_component_index("sysdetect");
     assert(cidx < papi_num_components);
+    _papi_hwi_component_check_n_initialize(cidx);
 
     return _papi_hwd[cidx]->user(0, &args, value);
 }
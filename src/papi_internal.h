@@ -91,6 +91,7 @@ extern char **_papi_errlist;
 #define GLOBAL_LOCK          	PAPI_NUM_LOCK+6	/* papi.c for global variable (static and non) initialization/shutdown */
 #define CPUS_LOCK		PAPI_NUM_LOCK+7	/* cpus.c */
 #define NAMELIB_LOCK            PAPI_NUM_LOCK+8 /* papi_pfm4_events.c */
+#define CMPINIT_LOCK            PAPI_NUM_LOCK+9 /* papi_internal.c deferred component init */
 
 /* extras related */
 
@@ -149,6 +150,12 @@ typedef struct _EventSetCpuInfo {
   unsigned int cpu_num;
 } EventSetCpuInfo_t;
 
+typedef struct _EventSetCpuVectorInfo {
+  int num_cpus;                 /**< rows of PAPI_read_vector, 0 if not replicated */
+  int cgroup;                   /**< rows only count tasks of a cgroup */
+  int aggregate;                /**< rows are uncore PMU instances */
+} EventSetCpuVectorInfo_t;
+
 typedef struct _EventSetInheritInfo
 {
 	int inherit;
@@ -281,6 +288,17 @@ typedef struct _EventSetInfo {
 
   int NumberOfEvents;          /**< Number of events added to EventSet */
 
+  int ReadCount;               /**< Entries in ReadPos, equal to
+                                    NumberOfEvents while it is valid */
+  int ReadSize;                /**< Entries allocated in ReadPos and
+                                    ReadDerived */
+  int *ReadPos;                /**< Cache line aligned pos[0] of every
+                                    plain event, -1 for derived or
+                                    unmapped ones, for the gather in
+                                    _papi_hwi_read() */
+  int ReadDerivedCount;        /**< Entries in ReadDerived */
+  int *ReadDerived;            /**< Indexes of the mapped derived events */
+
   long long *hw_start;         /**< Array of length num_mpx_cntrs to hold
 				    unprocessed, out of order,
                                     long long counter registers */
@@ -303,6 +321,7 @@ typedef struct _EventSetInfo {
   EventSetMultiplexInfo_t multiplex;
   EventSetAttachInfo_t attach;
   EventSetCpuInfo_t cpu;
+  EventSetCpuVectorInfo_t cpu_vector;
   EventSetProfileInfo_t profile;
   EventSetInheritInfo_t inherit;
 } EventSetInfo_t;
@@ -328,6 +347,25 @@ typedef struct _papi_int_cpu {
    EventSetInfo_t *ESI;
 } _papi_int_cpu_t;
 
+typedef struct _papi_int_cpu_vector {
+   int num_cpus;
+   unsigned int *cpus;
+   int num_threads;
+   EventSetInfo_t *ESI;
+} _papi_int_cpu_vector_t;
+
+typedef struct _papi_int_cgroup {
+   char *path;
+   int num_cpus;
+   EventSetInfo_t *ESI;
+} _papi_int_cgroup_t;
+
+typedef struct _papi_int_uncore_aggregate {
+   int aggregate;
+   int per_socket;
+   EventSetInfo_t *ESI;
+} _papi_int_uncore_aggregate_t;
+
 typedef struct _papi_int_multiplex {
    int flags;
    unsigned long ns;
@@ -389,6 +427,9 @@ typedef union _papi_int_option_t {
    _papi_int_domain_t domain;
    _papi_int_attach_t attach;
    _papi_int_cpu_t cpu;
+   _papi_int_cpu_vector_t cpu_vector;
+   _papi_int_cgroup_t cgroup;
+   _papi_int_uncore_aggregate_t uncore_aggregate;
    _papi_int_multiplex_t multiplex;
    _papi_int_itimer_t itimer;
 	_papi_int_inherit_t inherit;
@@ -465,9 +506,15 @@ int _papi_hwi_add_event( EventSetInfo_t * ESI, int EventCode );
 int _papi_hwi_remove_event( EventSetInfo_t * ESI, int EventCode );
 int _papi_hwi_read( hwd_context_t * context, EventSetInfo_t * ESI,
 		    long long *values );
+int _papi_hwi_read_vector( hwd_context_t * context, EventSetInfo_t * ESI,
+		    long long *values, int *rows );
+int _papi_hwi_read_inherited( hwd_context_t * context, EventSetInfo_t * ESI,
+			   int index, unsigned long *tid, long long *values );
 int _papi_hwi_cleanup_eventset( EventSetInfo_t * ESI );
 int _papi_hwi_convert_eventset_to_multiplex( _papi_int_multiplex_t * mpx );
 int _papi_hwi_init_global( int PE_OR_PEU );
+int _papi_hwi_component_init_pending( int cidx );
+int _papi_hwi_component_check_n_initialize( int cidx );
 int _papi_hwi_init_global_internal( void );
 int _papi_hwi_init_os(void);
 void _papi_hwi_init_errors(void);
@@ -484,3 +484,201 @@ _papi_mem_check_all_overflow(  )
 #endif
 	return ( fnd );
 }
+
+/** Zeroed block of nmemb*size bytes starting on a cache line, rounded
+ *  up to whole lines so nothing else shares its last line.  Release it
+ *  with papi_aligned_free().
+ */
+void *
+_papi_aligned_calloc( size_t nmemb, size_t size )
+{
+	size_t bytes = ( nmemb * size + PAPI_CACHE_LINE - 1 ) &
+		~( ( size_t ) PAPI_CACHE_LINE - 1 );
+	void *ptr;
+
+	if ( bytes == 0 )
+		bytes = PAPI_CACHE_LINE;
+	if ( posix_memalign( &ptr, PAPI_CACHE_LINE, bytes ) != 0 )
+		return NULL;
+	memset( ptr, 0, bytes );
+	return ptr;
+}
+
+/**********************************************************************
+ * Pool allocator for PAPI's own objects                              *
+ **********************************************************************/
+
+/* Event sets, their per-counter arrays and control states, and thread
+ * structures come and go in a handful of sizes.  _papi_pool_calloc()
+ * rounds a request up to a power of two size class and freed blocks
+ * are kept in a small cache per class in the freeing thread, so event
+ * set create/destroy churn neither calls malloc() nor takes a lock.
+ * Requests above the largest class go to calloc() directly.  A thread
+ * that exits gives its cached blocks back through a key destructor.
+ */
+#define POOL_MIN_SHIFT		6	/* smallest class, 64 bytes */
+#define POOL_CLASSES		12	/* largest class, 128 KB, fits pe_control_t */
+#define POOL_CACHE_DEPTH	16	/* cached blocks per class per thread */
+#define POOL_CACHE_BYTES	( 256 * 1024 )	/* and bytes per class per thread */
+
+/* Header in front of every pool block, sized like MEM_PROLOG */
+typedef union pool_block
+{
+	union pool_block *next;		/* while in a cache */
+	int cls;					/* while handed out, POOL_CLASSES if large */
+	char align[MEM_PROLOG];
+} pool_block_t;
+
+#ifdef HAVE_THREAD_LOCAL_STORAGE
+#include <pthread.h>
+
+/* Weak like pthread_once in papi.c, to not need libpthread */
+#pragma weak pthread_key_create
+#pragma weak pthread_key_delete
+#pragma weak pthread_setspecific
+
+static THREAD_LOCAL_STORAGE_KEYWORD pool_block_t *pool_cache[POOL_CLASSES];
+static THREAD_LOCAL_STORAGE_KEYWORD int pool_cached[POOL_CLASSES];
+/* pool_key_gen of the key this thread's destructor is armed with */
+static THREAD_LOCAL_STORAGE_KEYWORD int pool_keyed;
+
+/* The key is created on first use and deleted by _papi_pool_shutdown();
+ * each new key gets a new generation, 0 while there is none */
+static pthread_key_t pool_key;
+static int pool_key_gen;
+static int pool_key_count;
+
+static void
+pool_thread_exit( void *arg )
+{
+	( void ) arg;
+	_papi_pool_release_thread(  );
+}
+
+/* Arm the destructor of the calling thread before it caches a block;
+ * without pthreads the caches are only released by
+ * _papi_pool_release_thread() */
+static int
+pool_keep( void )
+{
+	int gen = pool_key_gen;
+
+	if ( pool_keyed && pool_keyed == gen )
+		return 1;
+	if ( !pthread_key_create || !pthread_key_delete || !pthread_setspecific )
+		return 0;
+	if ( gen == 0 ) {
+		_papi_hwi_lock( MEMORY_LOCK );
+		if ( pool_key_gen == 0 &&
+			 pthread_key_create( &pool_key, pool_thread_exit ) == 0 )
+			pool_key_gen = ++pool_key_count;
+		gen = pool_key_gen;
+		_papi_hwi_unlock( MEMORY_LOCK );
+		if ( gen == 0 )
+			return 0;
+	}
+	if ( pthread_setspecific( pool_key, &pool_keyed ) != 0 )
+		return 0;
+	pool_keyed = gen;
+	return 1;
+}
+#endif
+
+static int
+pool_class( size_t size )
+{
+	size_t cap = ( size_t ) 1 << POOL_MIN_SHIFT;
+	int cls = 0;
+
+	while ( cap < size && cls < POOL_CLASSES ) {
+		cap <<= 1;
+		cls++;
+	}
+	return cls;
+}
+
+void *
+_papi_pool_calloc( size_t nmemb, size_t size )
+{
+	size_t bytes = nmemb * size;
+	pool_block_t *blk;
+	int cls = pool_class( bytes );
+
+#ifdef HAVE_THREAD_LOCAL_STORAGE
+	if ( cls < POOL_CLASSES && ( blk = pool_cache[cls] ) != NULL ) {
+		pool_cache[cls] = blk->next;
+		pool_cached[cls]--;
+		blk->cls = cls;
+		memset( blk + 1, 0, bytes );
+		return blk + 1;
+	}
+#endif
+
+	if ( cls < POOL_CLASSES )
+		bytes = ( size_t ) 1 << ( cls + POOL_MIN_SHIFT );
+	blk = ( pool_block_t * ) calloc( 1, sizeof ( pool_block_t ) + bytes );
+	if ( blk == NULL )
+		return NULL;
+	blk->cls = cls;
+	return blk + 1;
+}
+
+void
+_papi_pool_free( void *ptr )
+{
+	pool_block_t *blk;
+
+	if ( ptr == NULL )
+		return;
+	blk = ( pool_block_t * ) ptr - 1;
+
+#ifdef HAVE_THREAD_LOCAL_STORAGE
+	int cls = blk->cls;
+	if ( cls < POOL_CLASSES && pool_cached[cls] < POOL_CACHE_DEPTH &&
+		 ( ( size_t ) pool_cached[cls] << ( cls + POOL_MIN_SHIFT ) ) <
+		 POOL_CACHE_BYTES && pool_keep(  ) ) {
+		blk->next = pool_cache[cls];
+		pool_cache[cls] = blk;
+		pool_cached[cls]++;
+		return;
+	}
+#endif
+	free( blk );
+}
+
+/** Give the calling thread's cached blocks back to the system */
+void
+_papi_pool_release_thread( void )
+{
+#ifdef HAVE_THREAD_LOCAL_STORAGE
+	pool_block_t *blk;
+	int cls;
+
+	for ( cls = 0; cls < POOL_CLASSES; cls++ ) {
+		while ( ( blk = pool_cache[cls] ) != NULL ) {
+			pool_cache[cls] = blk->next;
+			free( blk );
+		}
+		pool_cached[cls] = 0;
+	}
+	/* disarm, so the key can be deleted without this thread on it */
+	if ( pool_keyed && pool_keyed == pool_key_gen )
+		pthread_setspecific( pool_key, NULL );
+	pool_keyed = 0;
+#endif
+}
+
+/** Delete the thread exit key at library shutdown.  Threads that still
+ *  cache blocks arm a new key the next time they free one. */
+void
+_papi_pool_shutdown( void )
+{
+#ifdef HAVE_THREAD_LOCAL_STORAGE
+	_papi_hwi_lock( MEMORY_LOCK );
+	if ( pool_key_gen != 0 ) {
+		pthread_key_delete( pool_key );
+		pool_key_gen = 0;
+	}
+	_papi_hwi_unlock( MEMORY_LOCK );
+#endif
+}
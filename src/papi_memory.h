@@ -17,8 +17,13 @@ typedef struct pmem
 	struct pmem *prev;
 } pmem_t;
 
+/* Allocations are only tracked in DEBUG builds with memory management */
+#if defined(DEBUG) && !defined(PAPI_NO_MEMORY_MANAGEMENT)
+#define PAPI_MEM_TRACKING
+#endif
+
 #ifndef IN_MEM_FILE
-#ifdef PAPI_NO_MEMORY_MANAGEMENT
+#ifndef PAPI_MEM_TRACKING
 #define papi_malloc(a) malloc(a)
 #define papi_free(a)   free(a)
 #define papi_realloc(a,b) realloc(a,b)
@@ -45,6 +50,25 @@ typedef struct pmem
 #endif
 #endif
 
+/* Zeroed blocks for PAPI's own short-lived objects, see papi_memory.c.
+   Tracked builds use the tracker instead so leaks are still reported. */
+#ifdef PAPI_MEM_TRACKING
+#define papi_pool_calloc(a,b) papi_calloc(a,b)
+#define papi_pool_free(a) papi_free(a)
+#define papi_pool_release_thread() ;
+#define papi_pool_shutdown() ;
+#else
+#define papi_pool_calloc(a,b) _papi_pool_calloc(a,b)
+#define papi_pool_free(a) _papi_pool_free(a)
+#define papi_pool_release_thread() _papi_pool_release_thread()
+#define papi_pool_shutdown() _papi_pool_shutdown()
+#endif
+
+/* Zeroed, cache line aligned blocks for state walked on every read */
+#define PAPI_CACHE_LINE 64
+#define papi_aligned_calloc(a,b) _papi_aligned_calloc(a,b)
+#define papi_aligned_free(a) free(a)
+
 void *_papi_malloc( char *, int, size_t );
 void _papi_free( char *, int, void * );
 void *_papi_realloc( char *, int, void *, size_t );
@@ -56,6 +80,11 @@ void _papi_mem_print_info( void *ptr );
 void _papi_mem_print_stats(  );
 int _papi_mem_overhead( int );
 int _papi_mem_check_all_overflow(  );
+void *_papi_aligned_calloc( size_t, size_t );
+void *_papi_pool_calloc( size_t, size_t );
+void _papi_pool_free( void * );
+void _papi_pool_release_thread( void );
+void _papi_pool_shutdown( void );
 
 #define PAPI_MEM_LIB_OVERHEAD	1	/* PAPI Library Overhead */
 #define PAPI_MEM_OVERHEAD	2	/* Memory Overhead */
@@ -0,0 +1,299 @@
+/*
+* File:    papi_simd.c
+*
+* Gather, delta, accumulate and multiplex scaling over counter arrays.
+* EventSets of hundreds of uncore or multiplexed counters spend a
+* measurable part of each read in these loops.
+*
+* The file only needs its own header, so tests can build it on its own.
+*/
+
+#include "papi_simd.h"
+
+#if defined(__x86_64__) && ( defined(__clang__) || ( defined(__GNUC__) && __GNUC__ >= 5 ) )
+#define HAVE_SIMD_AVX2
+#include <immintrin.h>
+#define AVX2_FUNC __attribute__ (( target( "avx2" ) ))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+static int simd_level = -1;
+
+static int
+simd_detect( void )
+{
+#if defined(HAVE_SIMD_AVX2)
+	__builtin_cpu_init(  );
+	if ( __builtin_cpu_supports( "avx2" ) )
+		return PAPI_SIMD_AVX2;
+#elif defined(HAVE_SIMD_NEON)
+	return PAPI_SIMD_NEON;
+#endif
+	return PAPI_SIMD_SCALAR;
+}
+
+int
+_papi_simd_level( void )
+{
+	if ( simd_level < 0 )
+		simd_level = simd_detect(  );
+	return simd_level;
+}
+
+int
+_papi_simd_set_level( int level )
+{
+	int old = _papi_simd_level(  );
+
+	if ( level != PAPI_SIMD_SCALAR && level != simd_detect(  ) )
+		return -1;
+	simd_level = level;
+	return old;
+}
+
+/*********************************/
+/* Scalar versions, and the tail */
+/*********************************/
+
+static void
+gather_scalar( long long *dst, const long long *src, const int *pos,
+	       int i, int n )
+{
+	for ( ; i < n; i++ ) {
+		if ( pos[i] >= 0 )
+			dst[i] = src[pos[i]];
+	}
+}
+
+static void
+delta_scalar( long long *dst, const long long *end, const long long *start,
+	      int i, int n )
+{
+	for ( ; i < n; i++ )
+		dst[i] = end[i] - start[i];
+}
+
+static void
+accum_scalar( long long *dst, const long long *src, int i, int n )
+{
+	for ( ; i < n; i++ )
+		dst[i] += src[i];
+}
+
+static void
+scale_scalar( long long *count, const long long *enabled,
+	      const long long *running, int i, int n )
+{
+	long long scale;
+
+	for ( ; i < n; i++ ) {
+		if ( running[i] == enabled[i] || !running[i] || !enabled[i] )
+			continue;
+		/* Why use 100?  Would 128 be faster? */
+		scale = ( enabled[i] * 100LL ) / running[i];
+		scale = scale * count[i];
+		count[i] = scale / 100LL;
+	}
+}
+
+/*****************/
+/* AVX2 versions */
+/*****************/
+
+#if defined(HAVE_SIMD_AVX2)
+
+AVX2_FUNC static void
+gather_avx2( long long *dst, const long long *src, const int *pos, int n )
+{
+	__m128i idx, valid;
+	__m256i old, mask;
+	int i;
+
+	for ( i = 0; i + 4 <= n; i += 4 ) {
+		idx = _mm_loadu_si128( ( const __m128i * ) ( pos + i ) );
+		valid = _mm_cmpgt_epi32( idx, _mm_set1_epi32( -1 ) );
+		mask = _mm256_cvtepi32_epi64( valid );
+		old = _mm256_loadu_si256( ( const __m256i * ) ( dst + i ) );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + i ),
+				     _mm256_mask_i32gather_epi64( old,
+					( const long long int * ) src, idx, mask, 8 ) );
+	}
+	gather_scalar( dst, src, pos, i, n );
+}
+
+AVX2_FUNC static void
+delta_avx2( long long *dst, const long long *end, const long long *start,
+	    int n )
+{
+	__m256i a, b;
+	int i;
+
+	for ( i = 0; i + 4 <= n; i += 4 ) {
+		a = _mm256_loadu_si256( ( const __m256i * ) ( end + i ) );
+		b = _mm256_loadu_si256( ( const __m256i * ) ( start + i ) );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + i ),
+				     _mm256_sub_epi64( a, b ) );
+	}
+	delta_scalar( dst, end, start, i, n );
+}
+
+AVX2_FUNC static void
+accum_avx2( long long *dst, const long long *src, int n )
+{
+	__m256i a, b;
+	int i;
+
+	for ( i = 0; i + 4 <= n; i += 4 ) {
+		a = _mm256_loadu_si256( ( const __m256i * ) ( dst + i ) );
+		b = _mm256_loadu_si256( ( const __m256i * ) ( src + i ) );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + i ),
+				     _mm256_add_epi64( a, b ) );
+	}
+	accum_scalar( dst, src, i, n );
+}
+
+/* There is no 64-bit vector division, so only the search for the first
+   counter that needs scaling is vectorized.  When nothing is being
+   multiplexed that is the whole job; when something is, the rest goes
+   through the scalar arithmetic. */
+AVX2_FUNC static void
+scale_avx2( long long *count, const long long *enabled,
+	    const long long *running, int n )
+{
+	__m256i e, r;
+	int i;
+
+	for ( i = 0; i + 4 <= n; i += 4 ) {
+		e = _mm256_loadu_si256( ( const __m256i * ) ( enabled + i ) );
+		r = _mm256_loadu_si256( ( const __m256i * ) ( running + i ) );
+		if ( _mm256_movemask_epi8( _mm256_cmpeq_epi64( e, r ) ) != -1 )
+			break;
+	}
+	scale_scalar( count, enabled, running, i, n );
+}
+
+#endif
+
+/*****************/
+/* NEON versions */
+/*****************/
+
+#if defined(HAVE_SIMD_NEON)
+
+static void
+delta_neon( long long *dst, const long long *end, const long long *start,
+	    int n )
+{
+	int i;
+
+	for ( i = 0; i + 2 <= n; i += 2 )
+		vst1q_s64( ( int64_t * ) ( dst + i ),
+			   vsubq_s64( vld1q_s64( ( const int64_t * ) ( end + i ) ),
+				      vld1q_s64( ( const int64_t * ) ( start + i ) ) ) );
+	delta_scalar( dst, end, start, i, n );
+}
+
+static void
+accum_neon( long long *dst, const long long *src, int n )
+{
+	int i;
+
+	for ( i = 0; i + 2 <= n; i += 2 )
+		vst1q_s64( ( int64_t * ) ( dst + i ),
+			   vaddq_s64( vld1q_s64( ( const int64_t * ) ( dst + i ) ),
+				      vld1q_s64( ( const int64_t * ) ( src + i ) ) ) );
+	accum_scalar( dst, src, i, n );
+}
+
+static void
+scale_neon( long long *count, const long long *enabled,
+	    const long long *running, int n )
+{
+	uint64x2_t eq;
+	int i;
+
+	for ( i = 0; i + 2 <= n; i += 2 ) {
+		eq = vceqq_s64( vld1q_s64( ( const int64_t * ) ( enabled + i ) ),
+				vld1q_s64( ( const int64_t * ) ( running + i ) ) );
+		if ( ( vgetq_lane_u64( eq, 0 ) & vgetq_lane_u64( eq, 1 ) ) != ~0ULL )
+			break;
+	}
+	scale_scalar( count, enabled, running, i, n );
+}
+
+#endif
+
+/********************/
+/* Public functions */
+/********************/
+
+void
+_papi_simd_gather( long long *dst, const long long *src, const int *pos,
+		   int n )
+{
+#if defined(HAVE_SIMD_AVX2)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_AVX2 ) {
+		gather_avx2( dst, src, pos, n );
+		return;
+	}
+#endif
+	/* NEON has no gather, the scalar loop is as good */
+	gather_scalar( dst, src, pos, 0, n );
+}
+
+void
+_papi_simd_delta( long long *dst, const long long *end,
+		  const long long *start, int n )
+{
+#if defined(HAVE_SIMD_AVX2)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_AVX2 ) {
+		delta_avx2( dst, end, start, n );
+		return;
+	}
+#elif defined(HAVE_SIMD_NEON)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_NEON ) {
+		delta_neon( dst, end, start, n );
+		return;
+	}
+#endif
+	delta_scalar( dst, end, start, 0, n );
+}
+
+void
+_papi_simd_accum( long long *dst, const long long *src, int n )
+{
+#if defined(HAVE_SIMD_AVX2)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_AVX2 ) {
+		accum_avx2( dst, src, n );
+		return;
+	}
+#elif defined(HAVE_SIMD_NEON)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_NEON ) {
+		accum_neon( dst, src, n );
+		return;
+	}
+#endif
+	accum_scalar( dst, src, 0, n );
+}
+
+void
+_papi_simd_scale( long long *count, const long long *enabled,
+		  const long long *running, int n )
+{
+#if defined(HAVE_SIMD_AVX2)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_AVX2 ) {
+		scale_avx2( count, enabled, running, n );
+		return;
+	}
+#elif defined(HAVE_SIMD_NEON)
+	if ( _papi_simd_level(  ) == PAPI_SIMD_NEON ) {
+		scale_neon( count, enabled, running, n );
+		return;
+	}
+#endif
+	scale_scalar( count, enabled, running, 0, n );
+}
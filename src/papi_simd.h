@@ -0,0 +1,31 @@
+#ifndef PAPI_SIMD_H
+#define PAPI_SIMD_H
+
+/* Array kernels for the read path.  Each has a scalar version and,
+   where the machine has one, an AVX2 (x86_64, picked at run time) or
+   NEON (aarch64) version that gives bit for bit the same results. */
+
+#define PAPI_SIMD_SCALAR	0
+#define PAPI_SIMD_AVX2		1
+#define PAPI_SIMD_NEON		2
+
+/* dst[i] = src[pos[i]] for every pos[i] >= 0, other dst[i] are kept */
+void _papi_simd_gather( long long *dst, const long long *src,
+			const int *pos, int n );
+/* dst[i] = end[i] - start[i] */
+void _papi_simd_delta( long long *dst, const long long *end,
+		       const long long *start, int n );
+/* dst[i] += src[i] */
+void _papi_simd_accum( long long *dst, const long long *src, int n );
+/* count[i] scaled by enabled[i] / running[i] as perf_event multiplexing
+   has always done it: in whole percent, and only when both are set */
+void _papi_simd_scale( long long *count, const long long *enabled,
+		       const long long *running, int n );
+
+/* Level the kernels use, the best one available unless forced */
+int _papi_simd_level( void );
+/* Force a level for testing, returns the previous one or -1 if the
+   machine can't run the one asked for */
+int _papi_simd_set_level( int level );
+
+#endif /* PAPI_SIMD_H */
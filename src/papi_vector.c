@@ -192,6 +192,16 @@ _papi_hwi_innoculate_vector( papi_vector_t * v )
 		v->shutdown_component = ( int ( * )( void ) ) vec_int_ok_dummy;
 	if ( !v->user )
 		v->user = ( int ( * )( int, void *, void * ) ) vec_int_dummy;
+	if ( !v->read_vector )
+		v->read_vector =
+			( int ( * )
+			  ( hwd_context_t *, hwd_control_state_t *, long long **, int *,
+				int * ) ) vec_int_dummy;
+	if ( !v->read_inherited )
+		v->read_inherited =
+			( int ( * )
+			  ( hwd_context_t *, hwd_control_state_t *, int **, long long **,
+				int *, int * ) ) vec_int_dummy;
 	return PAPI_OK;
 }
 
@@ -53,6 +53,10 @@ typedef struct papi_vectors {
     int		(*shutdown_thread)	(hwd_context_t *);								/**< */
     int		(*shutdown_component)	(void);									/**< */
     int		(*user)			(int, void *, void *);							/**< */
+    int		(*read_vector)		(hwd_context_t *, hwd_control_state_t *, long long **, int *, int *);
+    int		(*read_inherited)	(hwd_context_t *, hwd_control_state_t *, int **, long long **, int *, int *);
+		/**< read all replicas of a replicated control state:
+		     returns the counts as rows, the number of rows and the row length */
 }papi_vector_t;
 
 extern papi_vector_t *_papi_hwd[];
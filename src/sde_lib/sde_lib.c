@@ -20,6 +20,7 @@
         }                                \
     } while (0)
 
+static long long sdei_compute_cnt(void *param);
 static long long sdei_compute_q1(void *param);
 static long long sdei_compute_med(void *param);
 static long long sdei_compute_q3(void *param);
@@ -334,6 +335,9 @@ papi_sde_register_counter_cb( papi_handle_t handle, const char *event_name, int
 }
 
 /** This function unregisters (removes) an event name and counter from the SDE data structures.
+  Recording into a recorder does not take the global lock, so unregistering a recorder is
+  not serialized against papi_sde_record() and papi_sde_record_n(). The caller must make sure
+  that no thread records into it, or will record into it again, before unregistering it.
   @param[in] handle -- pointer (of opaque type papi_handle_t) to sde structure for an individual library.
   @param[in] event_name -- (const char *) name of the event that is being unregistered.
   @param[out] -- (int) the return value is SDE_OK on success, or an error code on failure.
@@ -705,7 +709,7 @@ papi_sde_create_counting_set( papi_handle_t handle, const char *cset_name, void
     SDEDBG("Adding counting set: '%s' in SDE library: %s.\n", cset_name, lib_handle->libraryName);
 
     // Allocate the structure for the hash table.
-    cntr_union.cntr_cset.data = (cset_hash_table_t *)calloc(1,sizeof(cset_hash_table_t));
+    cntr_union.cntr_cset.data = cset_new();
     if( NULL == cntr_union.cntr_cset.data )
         return SDE_ENOMEM;
 
@@ -744,19 +748,14 @@ papi_sde_counting_set_remove( void *cset_handle, size_t hashable_size, const voi
     if( (NULL==tmp_cset) || (NULL==tmp_cset->which_lib) || tmp_cset->which_lib->disabled || (NULL==gctl) || gctl->disabled)
         return SDE_OK;
 
-    sde_lock();
-
     if( !IS_CNTR_CSET(tmp_cset) || (NULL == tmp_cset->u.cntr_cset.data) ){
         SDE_ERROR("papi_sde_counting_set_remove(): Counting set is clobbered. Unable to remove element.");
-        ret_val = SDE_EINVAL;
-        goto fn_exit;
+        return SDE_EINVAL;
     }
 
     SDEDBG("Preparing to remove element from counting set: '%s::%s'.\n", tmp_cset->which_lib->libraryName, tmp_cset->name);
     ret_val = cset_remove_elem(tmp_cset->u.cntr_cset.data, hashable_size, element, type_id);
 
-fn_exit:
-    sde_unlock();
     return ret_val;
 }
 
@@ -773,19 +772,16 @@ papi_sde_counting_set_insert( void *cset_handle, size_t element_size, size_t has
     if( (NULL==tmp_cset) || (NULL==tmp_cset->which_lib) || tmp_cset->which_lib->disabled || (NULL==gctl) || gctl->disabled)
         return SDE_OK;
 
-    sde_lock();
-
+    // The counting set locks the shard the element falls in, so inserts from
+    // different threads don't serialize on the global sde_lock().
     if( !IS_CNTR_CSET(tmp_cset) || (NULL == tmp_cset->u.cntr_cset.data) ){
         SDE_ERROR("papi_sde_counting_set_insert(): Counting set is clobbered. Unable to insert element.");
-        ret_val = SDE_EINVAL;
-        goto fn_exit;
+        return SDE_EINVAL;
     }
 
     SDEDBG("Preparing to insert element in counting set: '%s::%s'.\n", tmp_cset->which_lib->libraryName, tmp_cset->name);
     ret_val = cset_insert_elem(tmp_cset->u.cntr_cset.data, element_size, hashable_size, element, type_id);
 
-fn_exit:
-    sde_unlock();
     return ret_val;
 }
 
@@ -800,6 +796,7 @@ papi_sde_create_recorder( papi_handle_t handle, const char *event_name, size_t t
     size_t str_len;
     char *full_event_name;
     cntr_class_specific_t cntr_union;
+    sde_sorting_params_t *sorting_params;
 #define _SDE_MODIFIER_COUNT 6
     const char *modifiers[_SDE_MODIFIER_COUNT] = {":CNT",":MIN",":Q1",":MED",":Q3",":MAX"};
     // Add a NULL pointer for symmetry with the 'modifiers' vector, since the modifier ':CNT' does not have a function pointer.
@@ -820,13 +817,13 @@ papi_sde_create_recorder( papi_handle_t handle, const char *event_name, size_t t
 
     SDEDBG("Preparing to create recorder: '%s' with typesize: '%d' in SDE library: %s.\n", event_name, (int)typesize, lib_handle->libraryName);
 
-    // Allocate the "Exponential Storage" structure for the recorder data and meta-data.
-    cntr_union.cntr_recorder.data = (recorder_data_t *)calloc(1,sizeof(recorder_data_t));
-    // Allocate the first chunk of recorder data.
-    cntr_union.cntr_recorder.data->ptr_array[0] = malloc(EXP_CONTAINER_MIN_SIZE*typesize);
-    cntr_union.cntr_recorder.data->total_entries = EXP_CONTAINER_MIN_SIZE;
-    cntr_union.cntr_recorder.data->typesize = typesize;
-    cntr_union.cntr_recorder.data->used_entries = 0;
+    // Allocate the structure for the recorder data and meta-data. The per-thread
+    // buffers are allocated by the threads that record into it.
+    cntr_union.cntr_recorder.data = recorder_new(typesize);
+    if( NULL == cntr_union.cntr_recorder.data ){
+        ret_val = SDE_ENOMEM;
+        goto fn_exit;
+    }
 
     ret_val = sdei_setup_counter_internals( lib_handle, event_name, PAPI_SDE_DELTA|PAPI_SDE_RO, PAPI_SDE_long_long, CNTR_CLASS_RECORDER, cntr_union );
     if( SDE_OK != ret_val )
@@ -864,9 +861,14 @@ papi_sde_create_recorder( papi_handle_t handle, const char *event_name, size_t t
     snprintf(aux_event_name, str_len, "%s%s", event_name, modifiers[0]);
     SDEDBG("papi_sde_create_recorder(): Preparing to register aux counter: '%s' in SDE library: %s.\n", aux_event_name, lib_handle->libraryName);
 
-    // The field that holds the number of used entries in the recorder structure will become the counter of the new auxiliary event.
-    aux_cntr_union.cntr_basic.data = &(tmp_rec_handle->u.cntr_recorder.data->used_entries);
-    ret_val = sdei_setup_counter_internals( lib_handle, (const char *)aux_event_name, PAPI_SDE_INSTANT|PAPI_SDE_RO, PAPI_SDE_long_long, CNTR_CLASS_REGISTERED, aux_cntr_union );
+    // The count has to include what the threads recorded since the last read, so it is
+    // computed by a callback that merges their buffers first.
+    sorting_params = (sde_sorting_params_t *)malloc(sizeof(sde_sorting_params_t));
+    sorting_params->recording = tmp_rec_handle;
+    sorting_params->cmpr_func_ptr = cmpr_func_ptr;
+    aux_cntr_union.cntr_cb.callback = sdei_compute_cnt;
+    aux_cntr_union.cntr_cb.param = sorting_params;
+    ret_val = sdei_setup_counter_internals( lib_handle, (const char *)aux_event_name, PAPI_SDE_INSTANT|PAPI_SDE_RO, PAPI_SDE_long_long, CNTR_CLASS_CB, aux_cntr_union );
     if( SDE_OK != ret_val ){
         SDEDBG("papi_sde_create_recorder(): Registration of aux counter: '%s' in SDE library: %s FAILED.\n", aux_event_name, lib_handle->libraryName);
         free(aux_event_name);
@@ -876,8 +878,6 @@ papi_sde_create_recorder( papi_handle_t handle, const char *event_name, size_t t
     // If the caller passed NULL as the function pointer, then they do _not_ want the quantiles. Otherwise, create them.
     if( NULL != cmpr_func_ptr ){
         for(i=1; i<_SDE_MODIFIER_COUNT; i++){
-            sde_sorting_params_t *sorting_params;
-
             sorting_params = (sde_sorting_params_t *)malloc(sizeof(sde_sorting_params_t)); // This will be free()-ed by papi_sde_unregister_counter()
             sorting_params->recording = tmp_rec_handle;
             sorting_params->cmpr_func_ptr = cmpr_func_ptr;
@@ -907,30 +907,38 @@ fn_exit:
 
 int
 papi_sde_record( void *record_handle, size_t typesize, const void *value)
+{
+    return papi_sde_record_n(record_handle, typesize, 1, value);
+}
+
+
+// Values are appended to a buffer that belongs to the calling thread, so recording
+// does not take the global lock. Recording many values in one call amortizes the
+// remaining per-call work. Because of that, the recorder must not be unregistered
+// while any thread may still record into it (see papi_sde_unregister_counter()).
+int
+papi_sde_record_n( void *record_handle, size_t typesize, size_t count, const void *values)
 {
     sde_counter_t *tmp_rcrd;
-    int ret_val;
 
     tmp_rcrd = (sde_counter_t *)record_handle;
     papisde_control_t *gctl = _papisde_global_control;
     if( (NULL==tmp_rcrd) || (NULL==tmp_rcrd->which_lib) || tmp_rcrd->which_lib->disabled || (NULL==gctl) || gctl->disabled)
         return SDE_OK;
 
-    SDEDBG("Preparing to record value of size %lu at address: %p\n",typesize, value);
-
-    sde_lock();
+    SDEDBG("Preparing to record %lu values of size %lu at address: %p\n", count, typesize, values);
 
     if( !IS_CNTR_RECORDER(tmp_rcrd) || (NULL == tmp_rcrd->u.cntr_recorder.data) ){
-        SDE_ERROR("papi_sde_record(): 'record_handle' is clobbered. Unable to record value.");
-        ret_val = SDE_EINVAL;
-        goto fn_exit;
+        SDE_ERROR("papi_sde_record_n(): 'record_handle' is clobbered. Unable to record value.");
+        return SDE_EINVAL;
     }
 
-    ret_val = exp_container_insert_element(tmp_rcrd->u.cntr_recorder.data, typesize, value);
+    if( typesize != tmp_rcrd->u.cntr_recorder.data->typesize ){
+        SDE_ERROR("papi_sde_record_n(): 'typesize' does not match the size the recorder was created with.");
+        return SDE_EINVAL;
+    }
 
-fn_exit:
-    sde_unlock();
-    return ret_val;
+    return recorder_insert_elements(tmp_rcrd->u.cntr_recorder.data, count, values);
 }
 
 
@@ -955,11 +963,8 @@ papi_sde_reset_recorder( void *record_handle )
         goto fn_exit;
     }
 
-    // NOTE: do _not_ free the chunks and do _not_ reset "cntr_recorder.data->total_entries"
-    tmp_rcrdr->u.cntr_recorder.data->used_entries = 0;
-    free( tmp_rcrdr->u.cntr_recorder.data->sorted_buffer );
-    tmp_rcrdr->u.cntr_recorder.data->sorted_buffer = NULL;
-    tmp_rcrdr->u.cntr_recorder.data->sorted_entries = 0;
+    // NOTE: the snapshot is kept, so it can be reused by the values recorded after the reset.
+    recorder_reset(tmp_rcrdr->u.cntr_recorder.data);
 
     ret_val = SDE_OK;
 fn_exit:
@@ -1100,18 +1105,16 @@ papi_sde_compare_float(const void *p1, const void *p2){
 // for all types of data, not only integers.
 static inline long long sdei_compute_edge(void *param, int which_edge){
     void *edge = NULL, *edge_copy;
-    long long elem_cnt;
-    long long current_size, cumul_size = 0;
-    void *src;
-    int i, chunk;
+    long long elem_cnt, i;
     size_t typesize;
-    sde_counter_t *rcrd;
+    recorder_data_t *rcrd_data;
     int (*cmpr_func_ptr)(const void *p1, const void *p2);
 
 
-    rcrd = ((sde_sorting_params_t *)param)->recording;
-    elem_cnt = rcrd->u.cntr_recorder.data->used_entries;
-    typesize = rcrd->u.cntr_recorder.data->typesize;
+    rcrd_data = ((sde_sorting_params_t *)param)->recording->u.cntr_recorder.data;
+    recorder_merge(rcrd_data);
+    elem_cnt = rcrd_data->used_entries;
+    typesize = rcrd_data->typesize;
 
     cmpr_func_ptr = ((sde_sorting_params_t *)param)->cmpr_func_ptr;
 
@@ -1120,52 +1123,39 @@ static inline long long sdei_compute_edge(void *param, int which_edge){
     if( (0 == elem_cnt) || (NULL == cmpr_func_ptr) )
         return 0;
 
-    // If there is a sorted (contiguous) buffer, but it's stale, we need to free it.
-    // The value of elem_cnt (rcrd->u.cntr_recorder.data->used_entries) can
+    // If there is a sorted buffer, but it's stale, we need to free it.
+    // The value of elem_cnt (rcrd_data->used_entries) can
     // only increase, or be reset to zero, but when it is reset to zero
     // (by papi_sde_reset_recorder()) the buffer will be freed (by the same function).
-    if( (NULL != rcrd->u.cntr_recorder.data->sorted_buffer) &&
-        (rcrd->u.cntr_recorder.data->sorted_entries < elem_cnt) ){
+    if( (NULL != rcrd_data->sorted_buffer) &&
+        (rcrd_data->sorted_entries < elem_cnt) ){
 
-        free( rcrd->u.cntr_recorder.data->sorted_buffer );
-        rcrd->u.cntr_recorder.data->sorted_buffer = NULL;
-        rcrd->u.cntr_recorder.data->sorted_entries = 0;
+        free( rcrd_data->sorted_buffer );
+        rcrd_data->sorted_buffer = NULL;
+        rcrd_data->sorted_entries = 0;
     }
 
-    // Check if a sorted contiguous buffer is already there. If there is, return
+    // Check if a sorted buffer is already there. If there is, return
     // the first or last element (for MIN, or MAX respectively).
-    if( NULL != rcrd->u.cntr_recorder.data->sorted_buffer ){
+    if( NULL != rcrd_data->sorted_buffer ){
         if( _SDE_CMP_MIN == which_edge )
-            edge = rcrd->u.cntr_recorder.data->sorted_buffer;
+            edge = rcrd_data->sorted_buffer;
         if( _SDE_CMP_MAX == which_edge )
-            edge = (char *)(rcrd->u.cntr_recorder.data->sorted_buffer) + (elem_cnt-1)*typesize;
+            edge = (char *)(rcrd_data->sorted_buffer) + (elem_cnt-1)*typesize;
     }else{
-        // Make "edge" point to the beginning of the first chunk.
-        edge = rcrd->u.cntr_recorder.data->ptr_array[0];
-        if ( NULL == edge )
-            return 0;
-
-        cumul_size = 0;
-        for(chunk=0; chunk<EXP_CONTAINER_ENTRIES; chunk++){
-           current_size = ((long long)1<<chunk) * EXP_CONTAINER_MIN_SIZE;
-           src = rcrd->u.cntr_recorder.data->ptr_array[chunk];
-
-           for(i=0; (i < (elem_cnt-cumul_size)) && (i < current_size); i++){
-               void *next_elem = (char *)src + i*typesize;
-               int rslt = cmpr_func_ptr(next_elem, edge);
-
-               // If the new element is smaller than the current min and we are looking for the min, then keep it.
-               if( (rslt < 0) && (_SDE_CMP_MIN == which_edge) )
-                   edge = next_elem;
-               // If the new element is larger than the current max and we are looking for the max, then keep it.
-               if( (rslt > 0) && (_SDE_CMP_MAX == which_edge) )
-                   edge = next_elem;
-           }
-
-           cumul_size += current_size;
-
-           if( cumul_size >= elem_cnt )
-               break;
+        // Otherwise scan the snapshot, starting from its first element.
+        edge = rcrd_data->snapshot;
+
+        for(i=1; i < elem_cnt; i++){
+            void *next_elem = (char *)rcrd_data->snapshot + i*typesize;
+            int rslt = cmpr_func_ptr(next_elem, edge);
+
+            // If the new element is smaller than the current min and we are looking for the min, then keep it.
+            if( (rslt < 0) && (_SDE_CMP_MIN == which_edge) )
+                edge = next_elem;
+            // If the new element is larger than the current max and we are looking for the max, then keep it.
+            if( (rslt > 0) && (_SDE_CMP_MAX == which_edge) )
+                edge = next_elem;
         }
     }
 
@@ -1195,12 +1185,13 @@ static inline long long sdei_compute_quantile(void *param, int percent){
     long long quantile, elem_cnt;
     void *result_data;
     size_t typesize;
-    sde_counter_t *rcrd;
+    recorder_data_t *rcrd_data;
     int (*cmpr_func_ptr)(const void *p1, const void *p2);
 
-    rcrd = ((sde_sorting_params_t *)param)->recording;
-    elem_cnt = rcrd->u.cntr_recorder.data->used_entries;
-    typesize = rcrd->u.cntr_recorder.data->typesize;
+    rcrd_data = ((sde_sorting_params_t *)param)->recording->u.cntr_recorder.data;
+    recorder_merge(rcrd_data);
+    elem_cnt = rcrd_data->used_entries;
+    typesize = rcrd_data->typesize;
 
     cmpr_func_ptr = ((sde_sorting_params_t *)param)->cmpr_func_ptr;
 
@@ -1209,26 +1200,27 @@ static inline long long sdei_compute_quantile(void *param, int percent){
     if( (0 == elem_cnt) || (NULL == cmpr_func_ptr) )
         return 0;
 
-    // If there is a sorted (contiguous) buffer, but it's stale, we need to free it.
-    // The value of elem_cnt (rcrd->u.cntr_recorder.data->used_entries) can
+    // If there is a sorted buffer, but it's stale, we need to free it.
+    // The value of elem_cnt (rcrd_data->used_entries) can
     // only increase, or be reset to zero, but when it is reset to zero
     // (by papi_sde_reset_recorder()) the buffer will be freed (by the same function).
-    if( (NULL != rcrd->u.cntr_recorder.data->sorted_buffer) &&
-        (rcrd->u.cntr_recorder.data->sorted_entries < elem_cnt) ){
+    if( (NULL != rcrd_data->sorted_buffer) &&
+        (rcrd_data->sorted_entries < elem_cnt) ){
 
-        free( rcrd->u.cntr_recorder.data->sorted_buffer );
-        rcrd->u.cntr_recorder.data->sorted_buffer = NULL;
-        rcrd->u.cntr_recorder.data->sorted_entries = 0;
+        free( rcrd_data->sorted_buffer );
+        rcrd_data->sorted_buffer = NULL;
+        rcrd_data->sorted_entries = 0;
     }
 
-    // Check if a sorted buffer is already there. If there isn't, allocate one.
-    if( NULL == rcrd->u.cntr_recorder.data->sorted_buffer ){
-        rcrd->u.cntr_recorder.data->sorted_buffer = malloc(elem_cnt * typesize);
-        exp_container_to_contiguous(rcrd->u.cntr_recorder.data, rcrd->u.cntr_recorder.data->sorted_buffer);
+    // Check if a sorted buffer is already there. If there isn't, make one from the snapshot,
+    // which must keep the order in which the values were recorded.
+    if( NULL == rcrd_data->sorted_buffer ){
+        rcrd_data->sorted_buffer = malloc(elem_cnt * typesize);
+        memcpy(rcrd_data->sorted_buffer, rcrd_data->snapshot, elem_cnt * typesize);
         // We set this field so we can test later to see if the allocated buffer is stale.
-        rcrd->u.cntr_recorder.data->sorted_entries = elem_cnt;
+        rcrd_data->sorted_entries = elem_cnt;
     }
-    void *sorted_buffer = rcrd->u.cntr_recorder.data->sorted_buffer;
+    void *sorted_buffer = rcrd_data->sorted_buffer;
 
     qsort(sorted_buffer, elem_cnt, typesize, cmpr_func_ptr);
     void *tmp_ptr = (char *)sorted_buffer + typesize*((elem_cnt*percent)/100);
@@ -1248,6 +1240,12 @@ static inline long long sdei_compute_quantile(void *param, int percent){
 }
 
 
+static long long sdei_compute_cnt(void *param){
+    recorder_data_t *rcrd_data = ((sde_sorting_params_t *)param)->recording->u.cntr_recorder.data;
+
+    recorder_merge(rcrd_data);
+    return rcrd_data->used_entries;
+}
 static long long sdei_compute_q1(void *param){
     return sdei_compute_quantile(param, 25);
 }
@@ -117,6 +117,7 @@ typedef struct papi_sde_fptr_struct_s {
     int (*reset_recorder)(void *record_handle );
     int (*reset_counter)( void *cntr_handle );
     void *(*get_counter_handle)(papi_handle_t handle, const char *event_name);
+    int (*record_n)( void *record_handle, size_t typesize, size_t count, const void *values );
 }papi_sde_fptr_struct_t;
 
 
@@ -134,6 +135,7 @@ int papi_sde_create_counting_set( papi_handle_t handle, const char *cset_name, v
 int papi_sde_counting_set_insert( void *cset_handle, size_t element_size, size_t hashable_size, const void *element, uint32_t type_id );
 int papi_sde_counting_set_remove( void *cset_handle, size_t hashable_size, const void *element, uint32_t type_id );
 int papi_sde_record( void *record_handle, size_t typesize, const void *value );
+int papi_sde_record_n( void *record_handle, size_t typesize, size_t count, const void *values );
 int papi_sde_reset_recorder(void *record_handle );
 int papi_sde_reset_counter( void *cntr_handle );
 void *papi_sde_get_counter_handle( papi_handle_t handle, const char *event_name);
@@ -161,6 +163,7 @@ papi_handle_t papi_sde_hook_list_events( papi_sde_fptr_struct_t *fptr_struct);
     _A_.reset_recorder = papi_sde_reset_recorder;\
     _A_.reset_counter = papi_sde_reset_counter;\
     _A_.get_counter_handle = papi_sde_get_counter_handle;\
+    _A_.record_n = papi_sde_record_n;\
 }while(0)
 
 #ifdef __cplusplus
@@ -11,9 +11,106 @@
 
 #include <type_traits>
 #include <exception>
+#include <atomic>
+#include <string>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <new>
+#include <stdlib.h>
 
 namespace papi_sde
 {
+    // Storage policies for PapiSde::FastCounter. A policy provides a nested
+    // template storage<T> with add(), sum() and reset().
+
+    // Every thread adds to the same atomic variable. This is the smallest
+    // storage, and cheap as long as few threads increment the counter at once.
+    struct SharedAtomic {
+        template <typename T>
+        class storage {
+            private:
+              std::atomic<T> value;
+
+            public:
+              storage() : value(0) {}
+              void add(T increment){ value.fetch_add(increment, std::memory_order_relaxed); }
+              T sum() const { return value.load(std::memory_order_relaxed); }
+              void reset(void){ value.store(0, std::memory_order_relaxed); }
+        };
+    };
+
+    // The number of a thread for FastCounter. It is taken the first time the thread
+    // increments a FastCounter and given back when the thread exits; new threads get
+    // the lowest number given back, so the slots of exited threads are used again.
+    class fast_counter_index {
+        private:
+          typedef std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int> > free_list_t;
+          static std::mutex &lock(void){ static std::mutex m; return m; }
+          static free_list_t &free_list(void){ static free_list_t f; return f; }
+          static unsigned int &next(void){ static unsigned int n = 0; return n; }
+
+        public:
+          unsigned int value;
+
+          fast_counter_index(){
+              std::lock_guard<std::mutex> guard(lock());
+              if( free_list().empty() ){
+                  value = next()++;
+              }else{
+                  value = free_list().top();
+                  free_list().pop();
+              }
+          }
+          ~fast_counter_index(){
+              std::lock_guard<std::mutex> guard(lock());
+              free_list().push(value);
+          }
+    };
+
+    inline unsigned int fast_counter_thread_index(void){
+        static thread_local fast_counter_index index;
+        return index.value;
+    }
+
+    // Each of the first 'Slots' threads owns a cache line of the counter and adds to it
+    // with a plain load and store. Any further threads share one more line, with atomic
+    // adds. Reading sums all the lines.
+    template <unsigned int Slots = 64>
+    struct PerThread {
+        template <typename T>
+        class storage {
+            private:
+              struct alignas(64) slot {
+                  std::atomic<T> value;
+              };
+              slot slots[Slots + 1];
+
+            public:
+              storage(){ reset(); }
+              void add(T increment){
+                  unsigned int index = fast_counter_thread_index();
+                  if( index < Slots ){
+                      std::atomic<T> &v = slots[index].value;
+                      v.store(v.load(std::memory_order_relaxed) + increment, std::memory_order_relaxed);
+                  }else{
+                      slots[Slots].value.fetch_add(increment, std::memory_order_relaxed);
+                  }
+              }
+              T sum() const {
+                  T total = 0;
+                  for(unsigned int i=0; i<=Slots; i++)
+                      total += slots[i].value.load(std::memory_order_relaxed);
+                  return total;
+              }
+              void reset(void){
+                  for(unsigned int i=0; i<=Slots; i++)
+                      slots[i].value.store(0, std::memory_order_relaxed);
+              }
+        };
+    };
+
     class PapiSde {
         private:
           papi_handle_t sde_handle;
@@ -26,6 +123,7 @@ namespace papi_sde
           class CreatedCounter;
           class Recorder;
           class CountingSet;
+          template <typename T = long long int, typename Policy = PerThread<> > class FastCounter;
 
           template <typename T>
           int register_counter(const char *event_name, int cntr_mode, T &counter ){
@@ -71,6 +169,17 @@ namespace papi_sde
                return ptr;
           }
 
+          template <typename T = long long int, typename Policy = PerThread<> >
+          FastCounter<T, Policy> *create_fast_counter(const char *event_name, int cntr_mode){
+               FastCounter<T, Policy> *ptr;
+               try{
+                   ptr = new FastCounter<T, Policy>(sde_handle, event_name, cntr_mode);
+               }catch(std::exception const &e){
+                   return nullptr;
+               }
+               return ptr;
+          }
+
           Recorder *create_recorder(const char *event_name, size_t typesize, int (*cmpr_func_ptr)(const void *p1, const void *p2)){
               Recorder *ptr;
               try{
@@ -109,6 +218,14 @@ namespace papi_sde
                       return SDE_EINVAL;
               }
 
+              template <typename T>
+              int record(T const *values, size_t count){
+                  if( nullptr != recorder_handle )
+                      return papi_sde_record_n(recorder_handle, sizeof(T), count, values);
+                  else
+                      return SDE_EINVAL;
+              }
+
               int reset(void){
                   if( nullptr != recorder_handle )
                       return papi_sde_reset_recorder(recorder_handle);
@@ -150,6 +267,74 @@ namespace papi_sde
 
         }; // class CreatedCounter
 
+        // A counter that lives in the library and is incremented inline, without calling into
+        // libsde. PAPI reads it through a callback that sums the storage of the Policy.
+        template <typename T, typename Policy>
+        class FastCounter {
+            static_assert(std::is_integral<T>::value, "FastCounter only supports integer types.");
+
+            private:
+              typename Policy::template storage<T> value;
+              papi_handle_t sde_handle;
+              std::string event_name;
+
+              static long long int read_counter(void *param){
+                  return (long long int)static_cast<FastCounter *>(param)->value.sum();
+              }
+
+            public:
+              // The cache line slots of PerThread need more alignment than new gives before C++17.
+              static void *operator new(std::size_t size){
+                  void *ptr;
+                  std::size_t align = alignof(FastCounter) < sizeof(void *) ? sizeof(void *) : alignof(FastCounter);
+                  if( posix_memalign(&ptr, align, size) )
+                      throw std::bad_alloc();
+                  return ptr;
+              }
+              static void operator delete(void *ptr){
+                  free(ptr);
+              }
+
+              FastCounter(papi_handle_t sde_handle, const char *event_name, int cntr_mode) : sde_handle(sde_handle), event_name(event_name){
+                  if( SDE_OK != papi_sde_register_counter_cb(sde_handle, event_name, cntr_mode, PAPI_SDE_long_long, read_counter, this) )
+                      throw std::exception();
+              }
+
+              // PAPI holds a pointer to this object, so it can be neither copied nor outlive its registration.
+              FastCounter(const FastCounter &) = delete;
+              FastCounter &operator=(const FastCounter &) = delete;
+              ~FastCounter(){
+                  papi_sde_unregister_counter(sde_handle, event_name.c_str());
+              }
+
+              void increment(T const &increment){
+                  value.add(increment);
+              }
+
+              T read(void) const {
+                  return value.sum();
+              }
+
+              void reset(void){
+                  value.reset();
+              }
+
+              FastCounter &operator+=(T const &increment){
+                  value.add(increment);
+                  return *this;
+              }
+              // Prefix increment ++x;
+              FastCounter &operator++(){
+                  value.add(1);
+                  return *this;
+              }
+              // Prefix decrement --x;
+              FastCounter &operator--(){
+                  value.add(-1);
+                  return *this;
+              }
+        }; // class FastCounter
+
         class CountingSet {
             private:
               void *cset_handle=nullptr;
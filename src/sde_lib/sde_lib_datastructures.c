@@ -199,365 +199,546 @@ sde_counter_t *ht_lookup_by_id(papisde_list_entry_t *hash_table, uint32_t uniq_i
 
 
 /******************************************************************************/
-/* Functions related to the exponential container used for recorders.         */
+/* Functions related to the storage of recorders. Every thread that records   */
+/* into a recorder gets its own chain of blocks and appends to it without any */
+/* lock. Reads merge whatever has been published since the previous read into */
+/* one contiguous snapshot, which is kept and grown across reads.             */
 /******************************************************************************/
-void exp_container_to_contiguous(recorder_data_t *exp_container, void *cont_buffer){
-    long long current_size, typesize, used_entries, tmp_size = 0;
-    void *src, *dst;
-    int i;
 
-    typesize = exp_container->typesize;
-    used_entries = exp_container->used_entries;
-
-    for(i=0; i<EXP_CONTAINER_ENTRIES; i++){
-       current_size = ((long long)1<<i) * EXP_CONTAINER_MIN_SIZE;
-       src = exp_container->ptr_array[i];
-       dst = (char *)cont_buffer + tmp_size*typesize;
-       if ( (tmp_size+current_size) <= used_entries){
-           memcpy(dst, src, current_size*typesize);
-           if ( (tmp_size+current_size) == used_entries){
-               return;
-           }
-       }else{
-           memcpy(dst, src, (used_entries-tmp_size)*typesize);
-           return;
-       }
-       tmp_size += current_size;
+// Cache of the buffer this thread uses for each recorder, keyed by the recorder's uid.
+#define RECORDER_TLS_CACHE 8
+static __thread struct {
+    uint64_t uid;
+    recorder_thread_buf_t *buf;
+} recorder_tls_cache[RECORDER_TLS_CACHE];
+
+static uint64_t recorder_next_uid = 1;
+
+static recorder_block_t *recorder_block_new(recorder_data_t *recorder){
+    void *block;
+
+    if( posix_memalign(&block, 64, sizeof(recorder_block_t) + recorder->block_entries*recorder->typesize) )
+        return NULL;
+    ((recorder_block_t *)block)->next = NULL;
+    return (recorder_block_t *)block;
+}
+
+// Called with sde_lock() held.
+recorder_data_t *recorder_new(size_t typesize){
+    recorder_data_t *recorder;
+
+    if( 0 == typesize )
+        return NULL;
+
+    recorder = (recorder_data_t *)calloc(1, sizeof(recorder_data_t));
+    if( NULL == recorder )
+        return NULL;
+
+    recorder->uid = recorder_next_uid++;
+    recorder->typesize = typesize;
+    recorder->block_entries = RECORDER_BLOCK_BYTES/typesize;
+    if( recorder->block_entries < 1 )
+        recorder->block_entries = 1;
+    recorder->snapshot_size = RECORDER_MIN_SIZE;
+    if( posix_memalign(&recorder->snapshot, 64, RECORDER_MIN_SIZE*typesize) ){
+        free(recorder);
+        return NULL;
     }
+    return recorder;
 }
 
-int exp_container_insert_element(recorder_data_t *exp_container, size_t typesize, const void *value){
-    long long used_entries, total_entries, prev_entries, offset;
-    int i, chunk;
-    long long tmp_size;
+// Find, or create, the buffer of the calling thread.
+static recorder_thread_buf_t *recorder_thread_buf(recorder_data_t *recorder){
+    recorder_thread_buf_t *tbuf;
+    pthread_t self = pthread_self();
+    int slot = recorder->uid % RECORDER_TLS_CACHE;
 
-    if( NULL == exp_container || NULL == exp_container->ptr_array[0]){
-        SDE_ERROR("exp_container_insert_element(): Exponential container is clobbered. Unable to insert element.");
-        return SDE_EINVAL;
+    if( recorder->uid == recorder_tls_cache[slot].uid )
+        return recorder_tls_cache[slot].buf;
+
+    sde_lock();
+    for(tbuf = recorder->threads; NULL != tbuf; tbuf = tbuf->next){
+        if( pthread_equal(tbuf->owner, self) )
+            break;
+    }
+    if( NULL == tbuf ){
+        if( posix_memalign((void **)&tbuf, 64, sizeof(recorder_thread_buf_t)) ){
+            sde_unlock();
+            return NULL;
+        }
+        memset(tbuf, 0, sizeof(recorder_thread_buf_t));
+        tbuf->owner = self;
+        tbuf->tail = recorder_block_new(recorder);
+        if( NULL == tbuf->tail ){
+            free(tbuf);
+            sde_unlock();
+            return NULL;
+        }
+        tbuf->head = tbuf->tail;
+        tbuf->next = recorder->threads;
+        recorder->threads = tbuf;
     }
+    sde_unlock();
+
+    recorder_tls_cache[slot].uid = recorder->uid;
+    recorder_tls_cache[slot].buf = tbuf;
+    return tbuf;
+}
+
+int recorder_insert_elements(recorder_data_t *recorder, size_t count, const void *values){
+    recorder_thread_buf_t *tbuf;
+    const char *src = (const char *)values;
+    size_t typesize = recorder->typesize;
+    long long done = 0, n;
 
-    used_entries = exp_container->used_entries;
-    total_entries = exp_container->total_entries;
-    assert(used_entries <= total_entries);
+    tbuf = recorder_thread_buf(recorder);
+    if( NULL == tbuf )
+        return SDE_ENOMEM;
 
-    // Find how many chunks we have already allocated
-    tmp_size = 0;
-    for(i=0; i<EXP_CONTAINER_ENTRIES; i++){
-       long long factor = (long long)1<<i; // 2^i;
-       prev_entries = tmp_size;
-       tmp_size += factor * EXP_CONTAINER_MIN_SIZE;
-       // At least the first chunk "exp_container->ptr_array[0]"
-       // must have been already allocated when creating the recorder, so we can
-       // compare the total size after we add the "i-th" size.
-       if (total_entries == tmp_size)
-           break;
+    while( done < (long long)count ){
+        if( tbuf->tail_pos == recorder->block_entries ){
+            recorder_block_t *block = recorder_block_new(recorder);
+            if( NULL == block )
+                break;
+            // Readers only follow 'next' once 'published' says there are entries past the
+            // end of this block, and the release below orders the two.
+            tbuf->tail->next = block;
+            tbuf->tail = block;
+            tbuf->tail_pos = 0;
+        }
+        n = recorder->block_entries - tbuf->tail_pos;
+        if( n > (long long)count - done )
+            n = (long long)count - done;
+        (void)memcpy(tbuf->tail->data + tbuf->tail_pos*typesize, src + done*typesize, n*typesize);
+        tbuf->tail_pos += n;
+        done += n;
     }
-    chunk = i;
 
-    // Find how many entries down the last chunk we are.
-    offset = used_entries - prev_entries;
+    __atomic_store_n(&tbuf->published, tbuf->published + done, __ATOMIC_RELEASE);
+
+    return (done == (long long)count) ? SDE_OK : SDE_ENOMEM;
+}
+
+// Take 'count' of the entries a thread has published since the last call, copying them
+// to 'dst' if it is not NULL, and free the blocks that are done with.
+static void recorder_thread_buf_drain(recorder_data_t *recorder, recorder_thread_buf_t *tbuf, char *dst, long long count){
+    size_t typesize = recorder->typesize;
+    long long n;
+
+    tbuf->consumed += count;
+    while( count > 0 ){
+        if( tbuf->head_pos == recorder->block_entries ){
+            // There are entries past the end of this block, so the writer has moved on.
+            recorder_block_t *done = tbuf->head;
+            tbuf->head = done->next;
+            tbuf->head_pos = 0;
+            free(done);
+        }
+        n = recorder->block_entries - tbuf->head_pos;
+        if( n > count )
+            n = count;
+        if( NULL != dst ){
+            (void)memcpy(dst, tbuf->head->data + tbuf->head_pos*typesize, n*typesize);
+            dst += n*typesize;
+        }
+        tbuf->head_pos += n;
+        count -= n;
+    }
+}
 
-    if( used_entries == total_entries ){
-        long long new_segment_size;
+// Called with sde_lock() held.
+void recorder_merge(recorder_data_t *recorder){
+    recorder_thread_buf_t *tbuf;
+    long long pending = 0, n;
+    void *bigger;
 
-        // If we had used all the available entries (and thus we are allocating more), we start from the beginning of the new chunk.
-        offset = 0;
+    for(tbuf = recorder->threads; NULL != tbuf; tbuf = tbuf->next)
+        pending += __atomic_load_n(&tbuf->published, __ATOMIC_ACQUIRE) - tbuf->consumed;
+    if( 0 == pending )
+        return;
 
-        chunk += 1; // we need to allocate the next chunk from the last one we found.
-        new_segment_size = ((long long)1<<chunk) * EXP_CONTAINER_MIN_SIZE;
-        exp_container->ptr_array[chunk] = malloc(new_segment_size*typesize);
-        exp_container->total_entries += new_segment_size;
+    if( recorder->used_entries + pending > recorder->snapshot_size ){
+        long long new_size = recorder->snapshot_size;
+        while( new_size < recorder->used_entries + pending )
+            new_size *= 2;
+        if( posix_memalign(&bigger, 64, new_size*recorder->typesize) ){
+            SDE_ERROR("recorder_merge(): Unable to grow the recorder snapshot.");
+            return;
+        }
+        (void)memcpy(bigger, recorder->snapshot, recorder->used_entries*recorder->typesize);
+        free(recorder->snapshot);
+        recorder->snapshot = bigger;
+        recorder->snapshot_size = new_size;
     }
 
-    void *dest = (char *)(exp_container->ptr_array[chunk]) + offset*typesize;
+    // Threads may have published more since we counted. That is left for the next merge,
+    // because the snapshot only has room for 'pending' more entries.
+    for(tbuf = recorder->threads; (NULL != tbuf) && (pending > 0); tbuf = tbuf->next){
+        n = __atomic_load_n(&tbuf->published, __ATOMIC_ACQUIRE) - tbuf->consumed;
+        if( n > pending )
+            n = pending;
+        recorder_thread_buf_drain(recorder, tbuf, (char *)recorder->snapshot + recorder->used_entries*recorder->typesize, n);
+        recorder->used_entries += n;
+        pending -= n;
+    }
+}
 
-    (void)memcpy( dest, value, typesize );
-    exp_container->used_entries++;
+// Called with sde_lock() held. Values recorded while the reset runs may land on either side of it.
+void recorder_reset(recorder_data_t *recorder){
+    recorder_thread_buf_t *tbuf;
 
-    return SDE_OK;
+    for(tbuf = recorder->threads; NULL != tbuf; tbuf = tbuf->next)
+        recorder_thread_buf_drain(recorder, tbuf, NULL, __atomic_load_n(&tbuf->published, __ATOMIC_ACQUIRE) - tbuf->consumed);
+
+    recorder->used_entries = 0;
+    free( recorder->sorted_buffer );
+    recorder->sorted_buffer = NULL;
+    recorder->sorted_entries = 0;
+}
+
+void recorder_delete(recorder_data_t *recorder){
+    recorder_thread_buf_t *tbuf, *next_tbuf;
+    recorder_block_t *block, *next_block;
+
+    if( NULL == recorder )
+        return;
+
+    for(tbuf = recorder->threads; NULL != tbuf; tbuf = next_tbuf){
+        next_tbuf = tbuf->next;
+        for(block = tbuf->head; NULL != block; block = next_block){
+            next_block = block->next;
+            free(block);
+        }
+        free(tbuf);
+    }
+    free(recorder->snapshot);
+    free(recorder->sorted_buffer);
+    free(recorder);
 }
 
 /******************************************************************************/
-/* Functions related to the F14 inspired hash-table that we used to implement */
-/* the counting set.                                                          */
+/* Functions related to the hash-table that we used to implement the counting */
+/* set. The elements are spread over _SDE_CSET_SHARDS_ shards by the top bits */
+/* of their hash, and every shard is a linear probing table with its own lock */
+/* that doubles when it is 3/4 full. The growth is incremental: the previous  */
+/* table is drained into the new one CSET_MIGRATE_STEP slots at a time by the */
+/* operations on that shard, so the cost of an insert stays flat.             */
 /******************************************************************************/
 
-int cset_insert_elem(cset_hash_table_t *hash_ptr, size_t element_size, size_t hashable_size, const void *element, uint32_t type_id){
-    cset_hash_bucket_t *bucket_ptr;
-    int element_found = 0;
-    uint32_t i, occupied;
-    int ret_val;
-
-    if( NULL == hash_ptr ){
-        ret_val = SDE_EINVAL;
-        goto fn_exit;
+#define CSET_SEED ((uint64_t)79365) // decided to be a good seed by a committee.
+#define CSET_SHARD(_K_) ((int)((_K_) >> 60) % _SDE_CSET_SHARDS_)
+#define CSET_MIGRATE_STEP 8
+
+// Marks a slot of a table that is being drained whose element has moved on. Probes
+// walk past it, unlike past an empty slot.
+static char cset_moved_marker;
+#define CSET_MOVED ((void *)&cset_moved_marker)
+
+static int cset_table_init(cset_table_t *table, uint32_t slots){
+    table->keys = (uint64_t *)calloc(slots, sizeof(uint64_t));
+    table->objects = (cset_hash_decorated_object_t *)calloc(slots, sizeof(cset_hash_decorated_object_t));
+    if( (NULL == table->keys) || (NULL == table->objects) ){
+        free(table->keys);
+        free(table->objects);
+        table->keys = NULL;
+        table->objects = NULL;
+        return SDE_ENOMEM;
     }
-    bucket_ptr = hash_ptr->buckets;
-
-    uint64_t seed = (uint64_t)79365; // decided to be a good seed by a committee.
-    uint64_t key = fasthash64(element, hashable_size, seed);
-    int bucket_idx = (int)(key % _SDE_HASH_BUCKET_COUNT_);
-    uint64_t *key_ptr = bucket_ptr[bucket_idx].keys;
-    cset_hash_decorated_object_t *obj_ptr = bucket_ptr[bucket_idx].objects;
-    occupied = bucket_ptr[bucket_idx].occupied;
-    if( occupied > _SDE_HASH_BUCKET_WIDTH_ ){
-        SDE_ERROR("cset_insert_elem(): Counting set is clobbered, bucket %d has exceeded capacity.",bucket_idx);
-        ret_val = SDE_ECMP;
-        goto fn_exit;
+    table->mask = slots-1;
+    table->used = 0;
+    return SDE_OK;
+}
+
+static void cset_table_free(cset_table_t *table){
+    uint32_t i;
+
+    if( NULL == table->keys )
+        return;
+    for(i=0; i<=table->mask; i++){
+        if( (NULL != table->objects[i].ptr) && (CSET_MOVED != table->objects[i].ptr) )
+            free(table->objects[i].ptr);
     }
+    free(table->keys);
+    free(table->objects);
+    table->keys = NULL;
+    table->objects = NULL;
+}
 
-    // First look in the bucket where the hash function told us to look.
-    for(i=0; i<occupied; i++){
+// Return the slot that holds the element, or -1. If the element is missing and 'empty'
+// is not NULL, it is set to the empty slot where the element belongs.
+static int64_t cset_table_find(cset_table_t *table, uint64_t key, size_t hashable_size, const void *element, uint32_t type_id, int64_t *empty){
+    uint32_t idx = (uint32_t)key & table->mask;
+    cset_hash_decorated_object_t *obj_ptr;
+
+    while( 1 ){
+        obj_ptr = &table->objects[idx];
+        if( NULL == obj_ptr->ptr ){
+            if( NULL != empty )
+                *empty = idx;
+            return -1;
+        }
         // If the key and type_id match a stored element and the hashable_size is less or equal to
-        // the size of the stored element, then we are onto something.
-        if( (key == key_ptr[i]) && (type_id == obj_ptr[i].type_id) && (hashable_size <= obj_ptr[i].type_size) ){
-            // If the actual element matches too (or if we don't care about perfect matches),
-            // then we update the count for this entry and we are done.
-            if( SDE_HASH_IS_FUZZY || !memcmp(element, obj_ptr[i].ptr, hashable_size) ){
-                obj_ptr[i].count += 1;
-                element_found = 1;
-                break;
-            }
+        // the size of the stored element, then we are onto something. If the actual element
+        // matches too (or if we don't care about perfect matches), we found it.
+        if( (CSET_MOVED != obj_ptr->ptr) && (key == table->keys[idx]) && (type_id == obj_ptr->type_id) &&
+            (hashable_size <= obj_ptr->type_size) && (SDE_HASH_IS_FUZZY || !memcmp(element, obj_ptr->ptr, hashable_size)) ){
+            return idx;
         }
+        idx = (idx+1) & table->mask;
     }
+}
 
-    // If we didn't find the element in the appropriate bucket, then we need to add it (or look in the overflow list).
-    if( !element_found ){
-        // If the overflow list is empty, then we are certainly dealing with a new element.
-        if( NULL == hash_ptr->overflow_list ){
-            // Check if we still have room in the bucket, and if so, add the new element to the bucket.
-            if( i < _SDE_HASH_BUCKET_WIDTH_ ){
-                key_ptr[i] = key;
-                obj_ptr[i].count = 1;
-                obj_ptr[i].type_id = type_id;
-                obj_ptr[i].type_size = element_size;
-                obj_ptr[i].ptr = malloc(element_size);
-                (void)memcpy(obj_ptr[i].ptr, element, element_size);
-                // Let the bucket know that it now has one more element.
-                bucket_ptr[bucket_idx].occupied += 1;
-            }else{
-                // If the overflow list is empty and the bucket does not have room,
-                // then we add the new element at the head of the overflow list.
-                cset_list_object_t *new_list_element = (cset_list_object_t *)malloc(sizeof(cset_list_object_t));
-                new_list_element->next = NULL;
-                new_list_element->count = 1;
-                new_list_element->type_id = type_id;
-                new_list_element->type_size = element_size;
-                new_list_element->ptr = malloc(element_size);
-                (void)memcpy(new_list_element->ptr, element, element_size);
-                // Make the head point to the new element.
-                hash_ptr->overflow_list = new_list_element;
-            }
-        }else{
-            // Since there are elements in the overflow list, we need to search there for the one we are looking for.
-            cset_list_object_t *list_runner;
-            for( list_runner = hash_ptr->overflow_list; list_runner != NULL; list_runner = list_runner->next){
-                // if we find the element in the overflow list, increment the counter and exit the loop.
-                // When we traverse the overflow list we can _not_ use the SDE_HASH_IS_FUZZY flag, because we
-                // don't have matching hashes to indicate that the two elements are close; we are traversing the whole list.
-                if( (hashable_size <= list_runner->type_size) && (type_id == list_runner->type_id) && !memcmp(element, list_runner->ptr, hashable_size) ){
-                    list_runner->count += 1;
-                    break;
-                }
-            }
-            // If we traversed the entire list and didn't find our element, insert it before the current head of the list.
-            if( NULL == list_runner ){
-                cset_list_object_t *new_list_element = (cset_list_object_t *)malloc(sizeof(cset_list_object_t));
-                // Make the new element's "next" pointer be the current head of the list.
-                new_list_element->next = hash_ptr->overflow_list;
-                new_list_element->count = 1;
-                new_list_element->type_id = type_id;
-                new_list_element->type_size = element_size;
-                new_list_element->ptr = malloc(element_size);
-                (void)memcpy(new_list_element->ptr, element, element_size);
-                // Update the head of the list to point to the new element.
-                hash_ptr->overflow_list = new_list_element;
-            }
+// Put an element that is known not to be in the table into it.
+static void cset_table_place(cset_table_t *table, uint64_t key, const cset_hash_decorated_object_t *obj){
+    uint32_t idx = (uint32_t)key & table->mask;
+
+    while( NULL != table->objects[idx].ptr )
+        idx = (idx+1) & table->mask;
+    table->keys[idx] = key;
+    table->objects[idx] = *obj;
+    table->used++;
+}
+
+// Empty a slot and shift the rest of its probe run back, so that no element ends
+// up behind an empty slot that its probes would stop at.
+static void cset_table_erase(cset_table_t *table, uint32_t idx){
+    uint32_t next = (idx+1) & table->mask;
+    uint32_t home;
+
+    while( NULL != table->objects[next].ptr ){
+        home = (uint32_t)table->keys[next] & table->mask;
+        // Move the element back if its home slot is not cyclically in (idx, next].
+        if( ((next - home) & table->mask) >= ((next - idx) & table->mask) ){
+            table->keys[idx] = table->keys[next];
+            table->objects[idx] = table->objects[next];
+            idx = next;
         }
+        next = (next+1) & table->mask;
     }
+    table->objects[idx].ptr = NULL;
+    table->used--;
+}
 
-    ret_val = SDE_OK;
-fn_exit:
-    return ret_val;
+// Move up to 'steps' slots of the table being drained into the current one.
+static void cset_shard_migrate(cset_shard_t *shard, uint32_t steps){
+    cset_table_t *old = &shard->old;
+    cset_hash_decorated_object_t *obj_ptr;
+
+    while( (NULL != old->keys) && steps-- ){
+        obj_ptr = &old->objects[shard->migrate_pos];
+        if( (NULL != obj_ptr->ptr) && (CSET_MOVED != obj_ptr->ptr) ){
+            cset_table_place(&shard->cur, old->keys[shard->migrate_pos], obj_ptr);
+            obj_ptr->ptr = CSET_MOVED;
+            old->used--;
+        }
+        if( ++shard->migrate_pos > old->mask ){
+            free(old->keys);
+            free(old->objects);
+            old->keys = NULL;
+            old->objects = NULL;
+        }
+    }
 }
 
+// Make room for one more element, starting a new table if this one is 3/4 full.
+static int cset_shard_reserve(cset_shard_t *shard){
+    cset_table_t bigger;
+    uint32_t slots = shard->cur.mask+1;
 
-int cset_remove_elem(cset_hash_table_t *hash_ptr, size_t hashable_size, const void *element, uint32_t type_id){
-    cset_hash_bucket_t *bucket_ptr;
-    int element_found = 0;
-    uint32_t i, occupied;
-    int ret_val;
+    if( 4*(shard->cur.used+1) <= 3*slots )
+        return SDE_OK;
 
-    if( NULL == hash_ptr ){
-        ret_val = SDE_EINVAL;
-        goto fn_exit;
+    // The previous growth is normally drained long before this, but finish it if not.
+    cset_shard_migrate(shard, UINT32_MAX);
+
+    if( SDE_OK != cset_table_init(&bigger, 2*slots) )
+        return SDE_ENOMEM;
+    shard->old = shard->cur;
+    shard->cur = bigger;
+    shard->migrate_pos = 0;
+    return SDE_OK;
+}
+
+cset_hash_table_t *cset_new(void){
+    cset_hash_table_t *hash_ptr;
+    int i;
+
+    if( posix_memalign((void **)&hash_ptr, 64, sizeof(cset_hash_table_t)) )
+        return NULL;
+    memset(hash_ptr, 0, sizeof(cset_hash_table_t));
+
+    for(i=0; i<_SDE_CSET_SHARDS_; i++){
+        sde_stripe_lock_init(&hash_ptr->shards[i].lock);
+        if( SDE_OK != cset_table_init(&hash_ptr->shards[i].cur, _SDE_CSET_INIT_SLOTS_) ){
+            cset_delete(hash_ptr);
+            return NULL;
+        }
     }
-    bucket_ptr = hash_ptr->buckets;
-
-    uint64_t seed = (uint64_t)79365; // decided to be a good seed by a committee.
-    uint64_t key = fasthash64(element, hashable_size, seed);
-    int bucket_idx = (int)(key % _SDE_HASH_BUCKET_COUNT_);
-    uint64_t *key_ptr = bucket_ptr[bucket_idx].keys;
-    cset_hash_decorated_object_t *obj_ptr = bucket_ptr[bucket_idx].objects;
-    occupied = bucket_ptr[bucket_idx].occupied;
-    if( occupied > _SDE_HASH_BUCKET_WIDTH_ ){
-        SDE_ERROR("cset_remove_elem(): Counting set is clobbered, bucket %d has exceeded capacity.",bucket_idx);
-        ret_val = SDE_EINVAL;
-        goto fn_exit;
+    return hash_ptr;
+}
+
+int cset_insert_elem(cset_hash_table_t *hash_ptr, size_t element_size, size_t hashable_size, const void *element, uint32_t type_id){
+    cset_shard_t *shard;
+    cset_hash_decorated_object_t new_obj;
+    int64_t idx, empty = -1;
+    int ret_val = SDE_OK;
+
+    if( NULL == hash_ptr ){
+        return SDE_EINVAL;
     }
 
-    // First look in the bucket where the hash function told us to look.
-    for(i=0; i<occupied; i++){
-        // If the key and type_id match a stored element and the hashable_size is less or equal to
-        // the size of the stored element, then we are onto something.
-        if( (key == key_ptr[i]) && (type_id == obj_ptr[i].type_id) && (hashable_size <= obj_ptr[i].type_size) ){
-            // If the actual element matches too (or if we don't care about perfect matches),
-            // then we update the count for this entry.
-            if( SDE_HASH_IS_FUZZY || !memcmp(element, obj_ptr[i].ptr, hashable_size) ){
-                obj_ptr[i].count -= 1;
-                // If the element reached a count of zero after we removed it, then shift all the other keys and entries in the bucket.
-                if( 0 == obj_ptr[i].count ){
-                    uint32_t j;
-                    // free the memory taken by the user object.
-                    free(obj_ptr[i].ptr);
-                    // now shift the remaining entries in this bucket.
-                    for(j=i; j<occupied-1; j++){
-                        key_ptr[j] = key_ptr[j+1];
-                        obj_ptr[j] = obj_ptr[j+1];
-                    }
-                    bucket_ptr[bucket_idx].occupied -= 1;
-                }
-                // since we found the element, we don't need to look further.
-                element_found = 1;
-                break;
-            }
+    uint64_t key = fasthash64(element, hashable_size, CSET_SEED);
+    shard = &hash_ptr->shards[CSET_SHARD(key)];
+
+    sde_stripe_lock(&shard->lock);
+    cset_shard_migrate(shard, CSET_MIGRATE_STEP);
+
+    // Elements that have not been moved yet are counted where they are.
+    if( NULL != shard->old.keys ){
+        idx = cset_table_find(&shard->old, key, hashable_size, element, type_id, NULL);
+        if( idx >= 0 ){
+            shard->old.objects[idx].count += 1;
+            goto fn_exit;
         }
     }
 
-    // If we didn't find the element in the appropriate bucket, then we need to look for it in the overflow list.
-    if( !element_found ){
-        // If the overflow list is empty, then something went wrong.
-        if( NULL == hash_ptr->overflow_list ){
-            SDE_ERROR("cset_remove_elem(): Attempted to remove element that is NOT in the counting set.");
-        }else{
-            // Since there are elements in the overflow list, we need to search there for the one we are looking for.
-            cset_list_object_t *list_runner, *prev;
-            prev = hash_ptr->overflow_list;
-            for( list_runner = hash_ptr->overflow_list; list_runner != NULL; list_runner = list_runner->next){
-                // if we find the element in the overflow list
-                if( (hashable_size <= list_runner->type_size) && (type_id == list_runner->type_id) && !memcmp(element, list_runner->ptr, hashable_size) ){
-                    list_runner->count -= 1;
-                    // If the element reached a count of zero, then remove it from the list, and connect the list around it.
-                    if( 0 == list_runner->count ){
-                        // free the memory taken by the user object.
-                        free(list_runner->ptr);
-                        if( list_runner == hash_ptr->overflow_list ){
-                            hash_ptr->overflow_list = NULL;
-                        }else{
-                            prev->next = list_runner->next;
-                        }
-                        // free the memory taken by the link node. We can do this here safely
-                        // because we will break out of the loop, so we will not need the "next" pointer.
-                        free(list_runner);
-                    }
-                    // since we found the element, we don't need to look at the rest of the list.
-                    break;
-                }
-                prev = list_runner;
-            }
+    idx = cset_table_find(&shard->cur, key, hashable_size, element, type_id, &empty);
+    if( idx >= 0 ){
+        shard->cur.objects[idx].count += 1;
+        goto fn_exit;
+    }
+
+    // This is a new element.
+    new_obj.count = 1;
+    new_obj.type_id = type_id;
+    new_obj.type_size = element_size;
+    new_obj.ptr = malloc(element_size);
+    if( NULL == new_obj.ptr ){
+        ret_val = SDE_ENOMEM;
+        goto fn_exit;
+    }
+    (void)memcpy(new_obj.ptr, element, element_size);
+
+    if( 4*(shard->cur.used+1) <= 3*(shard->cur.mask+1) ){
+        // The probe already found the slot.
+        shard->cur.keys[empty] = key;
+        shard->cur.objects[empty] = new_obj;
+        shard->cur.used++;
+    }else{
+        ret_val = cset_shard_reserve(shard);
+        if( SDE_OK != ret_val ){
+            free(new_obj.ptr);
+            goto fn_exit;
         }
+        cset_table_place(&shard->cur, key, &new_obj);
     }
 
-    ret_val = SDE_OK;
 fn_exit:
+    sde_stripe_unlock(&shard->lock);
     return ret_val;
 }
 
-cset_list_object_t *cset_to_list(cset_hash_table_t *hash_ptr){
-    cset_hash_bucket_t *bucket_ptr;
-    int bucket_idx;
-    uint32_t i, occupied;
-    cset_list_object_t *head_ptr = NULL;
+
+int cset_remove_elem(cset_hash_table_t *hash_ptr, size_t hashable_size, const void *element, uint32_t type_id){
+    cset_shard_t *shard;
+    cset_table_t *table;
+    int64_t idx = -1;
 
     if( NULL == hash_ptr ){
-        return NULL;
+        return SDE_EINVAL;
+    }
+
+    uint64_t key = fasthash64(element, hashable_size, CSET_SEED);
+    shard = &hash_ptr->shards[CSET_SHARD(key)];
+
+    sde_stripe_lock(&shard->lock);
+    cset_shard_migrate(shard, CSET_MIGRATE_STEP);
+
+    table = &shard->old;
+    if( NULL != table->keys )
+        idx = cset_table_find(table, key, hashable_size, element, type_id, NULL);
+    if( idx < 0 ){
+        table = &shard->cur;
+        idx = cset_table_find(table, key, hashable_size, element, type_id, NULL);
     }
-    bucket_ptr = hash_ptr->buckets;
-
-    for( bucket_idx = 0; bucket_idx < _SDE_HASH_BUCKET_COUNT_; bucket_idx++){
-        cset_hash_decorated_object_t *obj_ptr = bucket_ptr[bucket_idx].objects;
-        occupied = bucket_ptr[bucket_idx].occupied;
-
-        for(i=0; i<occupied; i++){
-            int type_size = obj_ptr[i].type_size;
-            cset_list_object_t *new_list_element = (cset_list_object_t *)malloc(sizeof(cset_list_object_t));
-            // make the current list head be the element after the new one we are creating.
-            new_list_element->next = head_ptr;
-            new_list_element->count = obj_ptr[i].count;
-            new_list_element->type_id = obj_ptr[i].type_id;
-            new_list_element->type_size = type_size;
-            new_list_element->ptr = malloc(type_size);
-            (void)memcpy(new_list_element->ptr, obj_ptr[i].ptr, type_size);
-            // Update the head of the list to point to the new element.
-            head_ptr = new_list_element;
+
+    if( idx < 0 ){
+        SDE_ERROR("cset_remove_elem(): Attempted to remove element that is NOT in the counting set.");
+    }else if( 0 == --table->objects[idx].count ){
+        // free the memory taken by the user object.
+        free(table->objects[idx].ptr);
+        if( table == &shard->cur ){
+            cset_table_erase(table, (uint32_t)idx);
+        }else{
+            // Probes in the table being drained must still walk past this slot.
+            table->objects[idx].ptr = CSET_MOVED;
+            table->used--;
         }
-     }
+    }
+
+    sde_stripe_unlock(&shard->lock);
+    return SDE_OK;
+}
+
+static cset_list_object_t *cset_table_to_list(cset_table_t *table, cset_list_object_t *head_ptr){
+    uint32_t i;
+
+    if( NULL == table->keys )
+        return head_ptr;
+
+    for(i=0; i<=table->mask; i++){
+        cset_hash_decorated_object_t *obj_ptr = &table->objects[i];
+        if( (NULL == obj_ptr->ptr) || (CSET_MOVED == obj_ptr->ptr) )
+            continue;
 
-    cset_list_object_t *list_runner;
-    // Since there are elements in the overflow list, we need to search for ours.
-    for( list_runner = hash_ptr->overflow_list; list_runner != NULL; list_runner = list_runner->next){
-        int type_size = list_runner->type_size;
+        int type_size = obj_ptr->type_size;
         cset_list_object_t *new_list_element = (cset_list_object_t *)malloc(sizeof(cset_list_object_t));
         // make the current list head be the element after the new one we are creating.
         new_list_element->next = head_ptr;
-        new_list_element->count = list_runner->count;
-        new_list_element->type_id = list_runner->type_id;
+        new_list_element->count = obj_ptr->count;
+        new_list_element->type_id = obj_ptr->type_id;
         new_list_element->type_size = type_size;
         new_list_element->ptr = malloc(type_size);
-        (void)memcpy(new_list_element->ptr, list_runner->ptr, type_size);
+        (void)memcpy(new_list_element->ptr, obj_ptr->ptr, type_size);
         // Update the head of the list to point to the new element.
         head_ptr = new_list_element;
     }
+    return head_ptr;
+}
+
+cset_list_object_t *cset_to_list(cset_hash_table_t *hash_ptr){
+    cset_list_object_t *head_ptr = NULL;
+    int i;
+
+    if( NULL == hash_ptr ){
+        return NULL;
+    }
+
+    for(i=0; i<_SDE_CSET_SHARDS_; i++){
+        cset_shard_t *shard = &hash_ptr->shards[i];
+        sde_stripe_lock(&shard->lock);
+        head_ptr = cset_table_to_list(&shard->old, head_ptr);
+        head_ptr = cset_table_to_list(&shard->cur, head_ptr);
+        sde_stripe_unlock(&shard->lock);
+    }
 
     return head_ptr;
 }
 
 
 int cset_delete(cset_hash_table_t *hash_ptr){
-    cset_hash_bucket_t *bucket_ptr;
-    int bucket_idx;
-    uint32_t i, occupied;
+    int i;
 
     if( NULL == hash_ptr ){
         return SDE_EINVAL;
     }
-    bucket_ptr = hash_ptr->buckets;
-
-    for( bucket_idx = 0; bucket_idx < _SDE_HASH_BUCKET_COUNT_; bucket_idx++){
-        cset_hash_decorated_object_t *obj_ptr = bucket_ptr[bucket_idx].objects;
-        occupied = bucket_ptr[bucket_idx].occupied;
-        // Free all the elements that occupy entries in this bucket.
-        for(i=0; i<occupied; i++){
-            free(obj_ptr[i].ptr);
-        }
-        bucket_ptr[bucket_idx].occupied = 0;
-     }
-
-    cset_list_object_t *list_runner, *ptr_to_free=NULL;
-    // Since there are elements in the overflow list, we need to search for ours.
-    for( list_runner = hash_ptr->overflow_list; list_runner != NULL; list_runner = list_runner->next){
-        // Free the list element from the previous iteration.
-        free(ptr_to_free);
-        free(list_runner->ptr);
-        // Keep a reference to this element so we can free it _after_ this iteration, because we need the list_runner->next for now.
-        ptr_to_free = list_runner;
-        // If the current element is at the head of the overflow list, then we should mark the head as NULL.
-        if( list_runner == hash_ptr->overflow_list )
-            hash_ptr->overflow_list = NULL;
 
+    for(i=0; i<_SDE_CSET_SHARDS_; i++){
+        cset_table_free(&hash_ptr->shards[i].old);
+        cset_table_free(&hash_ptr->shards[i].cur);
+        sde_stripe_lock_destroy(&hash_ptr->shards[i].lock);
     }
-    free(ptr_to_free);
+    free(hash_ptr);
 
     return SDE_OK;
 }
-
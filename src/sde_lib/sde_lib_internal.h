@@ -19,10 +19,13 @@
 #include <time.h>
 #include <dlfcn.h>
 #include <assert.h>
+#include <pthread.h>
 #include "sde_lib.h"
+#include "sde_lib_lock.h"
 
-#define EXP_CONTAINER_ENTRIES 52
-#define EXP_CONTAINER_MIN_SIZE 2048
+#define RECORDER_MIN_SIZE 2048
+// Recorded values are appended to per-thread chains of blocks of this many bytes.
+#define RECORDER_BLOCK_BYTES (64*1024)
 
 #define PAPISDE_HT_SIZE 512
 
@@ -41,13 +44,14 @@ typedef struct recorder_data_s recorder_data_t;
 /** This global variable is defined in sde_lib.c and points to the head of the control state list **/
 extern papisde_control_t *_papisde_global_control;
 
-// _SDE_HASH_BUCKET_COUNT_ should not be a power of two, and even better it should be a prime.
-#if defined(SDE_HASH_SMALL) // 7.4KB storage
-  #define _SDE_HASH_BUCKET_COUNT_ 61
-  #define _SDE_HASH_BUCKET_WIDTH_ 5
-#else                        // 124KB storage (5222 elements)
-  #define _SDE_HASH_BUCKET_COUNT_ 373
-  #define _SDE_HASH_BUCKET_WIDTH_ 14
+// A counting set is split into _SDE_CSET_SHARDS_ independently locked shards, each an
+// open addressing table that starts with _SDE_CSET_INIT_SLOTS_ slots and doubles as it fills.
+#if defined(SDE_HASH_SMALL) // 4KB initial storage
+  #define _SDE_CSET_SHARDS_ 16
+  #define _SDE_CSET_INIT_SLOTS_ 8
+#else                        // 32KB initial storage (1536 elements before the first growth)
+  #define _SDE_CSET_SHARDS_ 16
+  #define _SDE_CSET_INIT_SLOTS_ 64
 #endif
 
 // defining SDE_HASH_IS_FUZZY to 1 will make the comparisons operation of the hash table
@@ -72,15 +76,25 @@ struct sde_list_object_s {
 };
 */
 
-typedef struct cset_hash_bucket_s {
-    uint32_t occupied;
-    uint64_t keys[_SDE_HASH_BUCKET_WIDTH_];
-    cset_hash_decorated_object_t objects[_SDE_HASH_BUCKET_WIDTH_];
-} cset_hash_bucket_t;
+// One linear probing table. A slot is empty when its object's ptr is NULL.
+typedef struct cset_table_s {
+    uint64_t *keys;
+    cset_hash_decorated_object_t *objects;
+    uint32_t mask;  // number of slots - 1, the number of slots is a power of two
+    uint32_t used;
+} cset_table_t;
+
+// When a shard grows, its elements are moved from 'old' to 'cur' a few slots at a
+// time by the operations that follow, so no single insert pays for the whole rehash.
+typedef struct cset_shard_s {
+    sde_stripe_lock_t lock;
+    cset_table_t cur;
+    cset_table_t old;       // still being drained into 'cur' while old.keys != NULL
+    uint32_t migrate_pos;   // next slot of 'old' to move
+} __attribute__((aligned(64))) cset_shard_t;
 
 typedef struct cset_hash_table_s {
-    cset_hash_bucket_t buckets[_SDE_HASH_BUCKET_COUNT_];
-    cset_list_object_t *overflow_list;
+    cset_shard_t shards[_SDE_CSET_SHARDS_];
 } cset_hash_table_t;
 
 
@@ -90,11 +104,36 @@ struct papisde_list_entry_s {
     papisde_list_entry_t *next;
 };
 
+typedef struct recorder_block_s recorder_block_t;
+struct recorder_block_s {
+   recorder_block_t *next;
+   char data[] __attribute__((aligned(64)));
+};
+
+// The values one thread records. The thread appends to 'tail' without taking any lock
+// and publishes the new total in 'published'. Readers, which hold sde_lock(), copy the
+// entries after 'consumed' into the snapshot and free the blocks they have finished.
+typedef struct recorder_thread_buf_s recorder_thread_buf_t;
+struct recorder_thread_buf_s {
+   pthread_t owner;
+   recorder_block_t *tail;
+   long long tail_pos;
+   long long published;
+   recorder_block_t *head __attribute__((aligned(64)));
+   long long head_pos;
+   long long consumed;
+   recorder_thread_buf_t *next;
+};
+
 struct recorder_data_s{
-   void *ptr_array[EXP_CONTAINER_ENTRIES];
-   long long total_entries;
-   long long used_entries;
+   uint64_t uid;               // never reused, so threads can cache their buffer by it
    size_t typesize;
+   long long block_entries;
+   recorder_thread_buf_t *threads;
+   // Everything recorded so far, contiguous, merged from the thread buffers on read.
+   void *snapshot;
+   long long snapshot_size;
+   long long used_entries;
    void *sorted_buffer;
    long long sorted_entries;
 };
@@ -205,10 +244,13 @@ uint32_t ht_hash_name(const char *str);
 uint32_t ht_hash_id(uint32_t uniq_id);
 papi_handle_t do_sde_init(const char *name_of_library, papisde_control_t *gctl);
 sde_counter_t *allocate_and_insert(papisde_control_t *gctl, papisde_library_desc_t* lib_handle, const char *name, uint32_t uniq_id, int cntr_mode, int cntr_type, enum CNTR_CLASS cntr_class, cntr_class_specific_t cntr_union);
-void exp_container_to_contiguous(recorder_data_t *exp_container, void *cont_buffer);
-int exp_container_insert_element(recorder_data_t *exp_container, size_t typesize, const void *value);
-void exp_container_init(sde_counter_t *handle, size_t typesize);
+recorder_data_t *recorder_new(size_t typesize);
+int recorder_insert_elements(recorder_data_t *recorder, size_t count, const void *values);
+void recorder_merge(recorder_data_t *recorder);
+void recorder_reset(recorder_data_t *recorder);
+void recorder_delete(recorder_data_t *recorder);
 void papi_sde_counting_set_to_list(void *cset_handle, cset_list_object_t **list_head);
+cset_hash_table_t *cset_new(void);
 int cset_insert_elem(cset_hash_table_t *hash_ptr, size_t element_size, size_t hashable_size, const void *element, uint32_t type_id);
 int cset_remove_elem(cset_hash_table_t *hash_ptr, size_t hashable_size, const void *element, uint32_t type_id);
 cset_list_object_t *cset_to_list(cset_hash_table_t *hash_ptr);
@@ -247,7 +289,7 @@ static inline uint64_t fasthash64(const void *buf, size_t len, uint64_t seed)
     const uint64_t    m = 0x880355f21e6d1965ULL;
     const uint64_t *pos = (const uint64_t *)buf;
     const uint64_t *end = pos + (len / 8);
-    const uint32_t *pos2;
+    const unsigned char *pos2;
     uint64_t h = seed ^ (len * m);
     uint64_t v;
 
@@ -257,7 +299,7 @@ static inline uint64_t fasthash64(const void *buf, size_t len, uint64_t seed)
         h *= m;
     }
 
-    pos2 = (const uint32_t*)pos;
+    pos2 = (const unsigned char *)pos;
     v = 0;
 
     switch (len & 7) {
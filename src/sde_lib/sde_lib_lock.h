@@ -15,6 +15,13 @@ extern AO_TS_t _sde_hwd_lock_data;
 #define sde_lock() {while (AO_test_and_set_acquire(&_sde_hwd_lock_data) != AO_TS_CLEAR) { ; } }
 #define sde_unlock() { AO_CLEAR(&_sde_hwd_lock_data); }
 
+/* Locks for structures that are guarded piecewise, such as the shards of a counting set. */
+typedef AO_TS_t sde_stripe_lock_t;
+#define sde_stripe_lock_init(l) { *(l) = AO_TS_INITIALIZER; }
+#define sde_stripe_lock_destroy(l) { (void)(l); }
+#define sde_stripe_lock(l) {while (AO_test_and_set_acquire(l) != AO_TS_CLEAR) { ; } }
+#define sde_stripe_unlock(l) { AO_CLEAR(l); }
+
 #else //defined(USE_LIBAO_ATOMICS)
 
 #include <pthread.h>
@@ -31,6 +38,13 @@ do{                                          \
   pthread_mutex_unlock(&_sde_hwd_lock_data); \
 } while(0)
 
+/* Locks for structures that are guarded piecewise, such as the shards of a counting set. */
+typedef pthread_mutex_t sde_stripe_lock_t;
+#define sde_stripe_lock_init(l) pthread_mutex_init((l), NULL)
+#define sde_stripe_lock_destroy(l) pthread_mutex_destroy(l)
+#define sde_stripe_lock(l) pthread_mutex_lock(l)
+#define sde_stripe_unlock(l) pthread_mutex_unlock(l)
+
 #endif //defined(USE_LIBAO_ATOMICS)
 
 
@@ -349,7 +349,7 @@ fn_exit:
 }
 
 int free_counter_resources(sde_counter_t *counter){
-    int i, ret_val = SDE_OK;
+    int ret_val = SDE_OK;
 
     if( NULL == counter )
         return SDE_OK;
@@ -362,11 +362,7 @@ int free_counter_resources(sde_counter_t *counter){
                 break;
             case CNTR_CLASS_RECORDER:
                 SDEDBG(" + Freeing Recorder Data.\n");
-                free(counter->u.cntr_recorder.data->sorted_buffer);
-                for(i=0; i<EXP_CONTAINER_ENTRIES; i++){
-                    free(counter->u.cntr_recorder.data->ptr_array[i]);
-                }
-                free(counter->u.cntr_recorder.data);
+                recorder_delete(counter->u.cntr_recorder.data);
                 break;
             case CNTR_CLASS_CSET:
                 SDEDBG(" + Freeing CountingSet Data.\n");
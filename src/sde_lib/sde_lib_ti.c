@@ -84,23 +84,14 @@ sde_ti_read_counter( uint32_t counter_id, long long int *rslt_ptr){
         // to this buffer cast as a long long.
         case CNTR_CLASS_RECORDER:
             {
-            long long used_entries;
-            size_t typesize;
+            recorder_data_t *rcrd_data = counter->u.cntr_recorder.data;
             void *out_buffer;
 
-            // At least the first chunk should have been allocated at creation.
-            if( NULL == counter->u.cntr_recorder.data->ptr_array[0] ){
-                SDE_ERROR( "No space has been allocated for recorder %s\n",counter->name);
-                ret_val = SDE_EINVAL;
-                break;
-            }
-
-            used_entries = counter->u.cntr_recorder.data->used_entries;
-            typesize = counter->u.cntr_recorder.data->typesize;
+            recorder_merge(rcrd_data);
 
             // NOTE: After returning this buffer we loose track of it, so it's the user's responsibility to free it.
-            out_buffer = malloc( used_entries*typesize );
-            exp_container_to_contiguous(counter->u.cntr_recorder.data, out_buffer);
+            out_buffer = malloc( rcrd_data->used_entries*rcrd_data->typesize );
+            memcpy(out_buffer, rcrd_data->snapshot, rcrd_data->used_entries*rcrd_data->typesize);
             *rslt_ptr = (long long)out_buffer;
             break;
             }
@@ -101,41 +101,38 @@ allocate_thread( int tid )
 	/* The Thread EventSet is special. It is not in the EventSet list, but is pointed
 	   to by each EventSet of that particular thread. */
 
-	thread = ( ThreadInfo_t * ) papi_malloc( sizeof ( ThreadInfo_t ) );
+	thread = ( ThreadInfo_t * ) papi_pool_calloc( 1, sizeof ( ThreadInfo_t ) );
 	if ( thread == NULL )
 		return ( NULL );
-	memset( thread, 0x00, sizeof ( ThreadInfo_t ) );
 
 	thread->context =
-		( hwd_context_t ** ) papi_malloc( sizeof ( hwd_context_t * ) *
+		( hwd_context_t ** ) papi_pool_calloc( 1, sizeof ( hwd_context_t * ) *
 										  ( size_t ) papi_num_components );
 	if ( !thread->context ) {
-		papi_free( thread );
+		papi_pool_free( thread );
 		return ( NULL );
 	}
 
 	thread->running_eventset =
-		( EventSetInfo_t ** ) papi_malloc( sizeof ( EventSetInfo_t * ) *
+		( EventSetInfo_t ** ) papi_pool_calloc( 1, sizeof ( EventSetInfo_t * ) *
 										   ( size_t ) papi_num_components );
 	if ( !thread->running_eventset ) {
-		papi_free( thread->context );
-		papi_free( thread );
+		papi_pool_free( thread->context );
+		papi_pool_free( thread );
 		return ( NULL );
 	}
 
 	for ( i = 0; i < papi_num_components; i++ ) {
 		thread->context[i] =
-			( void * ) papi_malloc( ( size_t ) _papi_hwd[i]->size.context );
+			( void * ) papi_pool_calloc( 1, ( size_t ) _papi_hwd[i]->size.context );
 		thread->running_eventset[i] = NULL;
 		if ( thread->context[i] == NULL ) {
 			for ( i--; i >= 0; i-- )
-				papi_free( thread->context[i] );
-			papi_free( thread->context );
-			papi_free( thread );
+				papi_pool_free( thread->context[i] );
+			papi_pool_free( thread->context );
+			papi_pool_free( thread );
 			return ( NULL );
 		}
-		memset( thread->context[i], 0x00,
-				( size_t ) _papi_hwd[i]->size.context );
 	}
 
 	if ( _papi_hwi_thread_id_fn ) {
@@ -168,17 +165,17 @@ free_thread( ThreadInfo_t ** thread )
 
 	for ( i = 0; i < papi_num_components; i++ ) {
 		if ( ( *thread )->context[i] )
-			papi_free( ( *thread )->context[i] );
+			papi_pool_free( ( *thread )->context[i] );
 	}
 
 	if ( ( *thread )->context )
-		papi_free( ( *thread )->context );
+		papi_pool_free( ( *thread )->context );
 
 	if ( ( *thread )->running_eventset )
-		papi_free( ( *thread )->running_eventset );
+		papi_pool_free( ( *thread )->running_eventset );
 
 	memset( *thread, 0x00, sizeof ( ThreadInfo_t ) );
-	papi_free( *thread );
+	papi_pool_free( *thread );
 	*thread = NULL;
 }
 
@@ -291,13 +288,20 @@ _papi_hwi_initialize_thread( ThreadInfo_t ** dest, int tid )
    thread->tls_papi_event_code_changed = -1;
 
 	/* Call the component to fill in anything special. */
+	/* Components whose initialization is deferred get their init_thread() */
+	/* called by _papi_hwi_init_component_threads() once they initialize.  */
+
+	_papi_hwi_lock( CMPINIT_LOCK );
 
 	for ( i = 0; i < papi_num_components; i++ ) {
 	    if (_papi_hwd[i]->cmp_info.disabled &&
             _papi_hwd[i]->cmp_info.disabled != PAPI_EDELAY_INIT)
             continue;
+	    if (_papi_hwi_component_init_pending( i ))
+            continue;
 	    retval = _papi_hwd[i]->init_thread( thread->context[i] );
 	    if ( retval ) {
+	       _papi_hwi_unlock( CMPINIT_LOCK );
 	       free_thread( &thread );
 	       *dest = NULL;
 	       return retval;
@@ -306,6 +310,8 @@ _papi_hwi_initialize_thread( ThreadInfo_t ** dest, int tid )
 
 	insert_thread( thread, tid );
 
+	_papi_hwi_unlock( CMPINIT_LOCK );
+
 	*dest = thread;
 	return PAPI_OK;
 }
@@ -425,7 +431,7 @@ _papi_hwi_shutdown_thread( ThreadInfo_t * thread, int force_shutdown )
 {
 	int retval = PAPI_OK;
 	unsigned long tid;
-	int i, failure = 0;
+	int i, own, failure = 0;
 
    /* Clear event memory variables */
    thread->tls_papi_event_code = -1;
@@ -451,11 +457,17 @@ _papi_hwi_shutdown_thread( ThreadInfo_t * thread, int force_shutdown )
 		for( i = 0; i < papi_num_components; i++ ) {
 		   if (_papi_hwd[i]->cmp_info.disabled &&
                _papi_hwd[i]->cmp_info.disabled != PAPI_EDELAY_INIT)
+               continue;
+		   if (_papi_hwi_component_init_pending( i ))
                continue;
 		   retval = _papi_hwd[i]->shutdown_thread( thread->context[i]);
 		   if ( retval != PAPI_OK ) failure = retval;
 		}
+		own = ( thread->tid == tid );
 		free_thread( &thread );
+		/* a thread going away won't reuse its cached blocks */
+		if ( own )
+			papi_pool_release_thread(  );
 		return ( failure );
 	}
 
@@ -564,6 +576,33 @@ _papi_hwi_init_global_threads( void )
 	return ( retval );
 }
 
+/* Called with CMPINIT_LOCK held, right after a deferred init_component() */
+
+int
+_papi_hwi_init_component_threads( int cidx )
+{
+	int retval = PAPI_OK;
+	ThreadInfo_t *foo = NULL;
+
+	_papi_hwi_lock( THREADS_LOCK );
+
+	for ( foo = ( ThreadInfo_t * ) _papi_hwi_thread_head; foo != NULL;
+		  foo = foo->next ) {
+		THRDBG( "Running init_thread of component %d for thread %ld\n",
+				cidx, foo->tid );
+		retval = _papi_hwd[cidx]->init_thread( foo->context[cidx] );
+		if ( retval != PAPI_OK )
+			break;
+
+		if ( foo->next == _papi_hwi_thread_head )
+			break;
+	}
+
+	_papi_hwi_unlock( THREADS_LOCK );
+
+	return ( retval );
+}
+
 int
 _papi_hwi_gather_all_thrspec_data( int tag, PAPI_all_thr_spec_t * where )
 {
@@ -0,0 +1,595 @@
+/** file papi_bench.c
+  * @brief papi_bench utility.
+  *	@page papi_bench
+  * @section  NAME
+  *		papi_bench - measures the per-call cost of PAPI entry points as JSON.
+  *
+  *	@section Synopsis
+  *		papi_bench [-hl] [-c case] [-o file] [-t iterations]
+  *
+  *	@section Description
+  *		papi_bench times PAPI calls with PAPI_get_real_cyc() and reports
+  *		min / 25th / 50th / 75th / 99th percentile / max / mean cycles per
+  *		call for each case as a single JSON document, so results can be
+  *		compared from one release to the next.
+  *		The cases cover start/stop, read with rdpmc and with read() on
+  *		grouped and ungrouped events, accum, reset, derived presets,
+  *		sde, rapl and powercap reads, appio interposed I/O, high-level
+  *		regions and event name resolution.
+  *		Every case runs in its own child process with a fresh PAPI, so
+  *		environment settings such as PAPI_PERF_EVENT_RDPMC=0 can differ
+  *		per case.  A case that can't run on this system, because a
+  *		component, event or feature is missing, is reported with
+  *		"status":"skipped" and the reason.  Any other failure, including
+  *		a crash of the case, is reported with "status":"error" and makes
+  *		papi_bench exit with a nonzero status.
+  *
+  *	@section Options
+  *	<ul>
+  *		<li>-c < case >	Only run the cases whose name contains this string.
+  *		<li>-h	Display help information about this utility.
+  *		<li>-l	List the cases and exit.
+  *		<li>-o < file >	Write the JSON to a file instead of stdout.
+  *		<li>-t < iterations >	Set the number of timed calls per case.
+  *			The default is 100,000.
+  *	</ul>
+  *
+  *	@section Bugs
+  *		There are no known bugs in this utility. If you find a bug,
+  *		it should be reported to the PAPI Mailing List at <ptools-perfapi@icl.utk.edu>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "papi.h"
+#include "cost_utils.h"
+
+#if SDE
+#include "sde_lib/sde_lib.h"
+#endif
+
+#define BENCH_ITERS	100000
+#define MAX_VALUES	8
+
+typedef struct {
+	const char *name;
+	const char *env;			/* NAME=VALUE set before PAPI_library_init */
+	int ( *setup ) ( void );	/* PAPI_OK, or why the case can't run      */
+	void ( *call ) ( void );	/* the call being timed                    */
+} bench_case_t;
+
+/* What a child reports back to the parent through a pipe */
+typedef struct {
+	int status;
+	char reason[PAPI_MIN_STR_LEN];
+	long long min, max, p25, p50, p75, p99;
+	double mean, std;
+} bench_result_t;
+
+static int EventSet = PAPI_NULL;
+static long long values[MAX_VALUES];
+static int event_code;
+static int fd = -1;
+
+/* Search for a derived event of type "type" */
+static int
+find_derived( const char *type )
+{
+	PAPI_event_info_t info;
+	int i = PAPI_PRESET_MASK;
+
+	if ( PAPI_enum_event( &i, PAPI_ENUM_FIRST ) != PAPI_OK )
+		return PAPI_NULL;
+
+	do {
+		if ( PAPI_get_event_info( i, &info ) == PAPI_OK &&
+			 info.count > 1 && strcmp( info.derived, type ) == 0 )
+			return i;
+	} while ( PAPI_enum_event( &i, PAPI_PRESET_ENUM_AVAIL ) == PAPI_OK );
+
+	return PAPI_NULL;
+}
+
+/* Add the first event of a NULL terminated list that can be added */
+static int
+add_first( const char **names )
+{
+	int retval = PAPI_ENOEVNT;
+
+	for ( ; *names; names++ ) {
+		retval = PAPI_add_named_event( EventSet, *names );
+		if ( retval == PAPI_OK )
+			break;
+	}
+	return retval;
+}
+
+static int
+create_set( const char *component )
+{
+	int cidx, retval;
+
+	retval = PAPI_create_eventset( &EventSet );
+	if ( retval != PAPI_OK )
+		return retval;
+	if ( component == NULL )
+		return PAPI_OK;
+
+	cidx = PAPI_get_component_index( component );
+	if ( cidx < 0 )
+		return PAPI_ENOCMP;
+	if ( PAPI_get_component_info( cidx )->disabled )
+		return PAPI_ECMP_DISABLED;
+	return PAPI_assign_eventset_component( EventSet, cidx );
+}
+
+/* Two cpu events, core counters if there are any, else software ones */
+static int
+cpu_set( int inherit, int start )
+{
+	const char *first[] = { "PAPI_TOT_CYC", "perf::CPU-CLOCK", NULL };
+	const char *second[] = { "PAPI_TOT_INS", "perf::TASK-CLOCK", NULL };
+	PAPI_option_t opt;
+	int retval;
+
+	retval = create_set( "perf_event" );
+	if ( retval != PAPI_OK )
+		return retval;
+
+	if ( inherit ) {
+		memset( &opt, 0, sizeof ( opt ) );
+		opt.inherit.inherit = PAPI_INHERIT_ALL;
+		opt.inherit.eventset = EventSet;
+		retval = PAPI_set_opt( PAPI_INHERIT, &opt );
+		if ( retval != PAPI_OK )
+			return retval;
+	}
+
+	if ( ( retval = add_first( first ) ) != PAPI_OK ||
+		 ( retval = add_first( second ) ) != PAPI_OK )
+		return retval;
+
+	return start ? PAPI_start( EventSet ) : PAPI_OK;
+}
+
+/* The first native event of a component, started */
+static int
+component_set( const char *component )
+{
+	int retval, code = PAPI_NATIVE_MASK;
+
+	retval = create_set( component );
+	if ( retval != PAPI_OK )
+		return retval;
+	/* active but found nothing to count, e.g. no powercap zones */
+	if ( PAPI_get_component_info( PAPI_get_component_index( component ) )->
+		 num_native_events <= 0 )
+		return PAPI_ENOEVNT;
+
+	retval = PAPI_enum_cmp_event( &code, PAPI_ENUM_FIRST,
+		PAPI_get_component_index( component ) );
+	if ( retval != PAPI_OK )
+		return retval;
+	if ( ( retval = PAPI_add_event( EventSet, code ) ) != PAPI_OK )
+		return retval;
+
+	return PAPI_start( EventSet );
+}
+
+/*********************************************************************/
+/* The cases                                                         */
+/*********************************************************************/
+
+static int setup_nothing( void ) { return PAPI_OK; }
+static void call_nothing( void ) { }
+
+static int setup_stopped( void ) { return cpu_set( 0, 0 ); }
+static int setup_running( void ) { return cpu_set( 0, 1 ); }
+static int setup_inherit( void ) { return cpu_set( 1, 1 ); }
+
+static int
+setup_rdpmc( void )
+{
+	int cidx = PAPI_get_component_index( "perf_event" );
+
+	if ( cidx < 0 )
+		return PAPI_ENOCMP;
+	if ( !PAPI_get_component_info( cidx )->fast_counter_read )
+		return PAPI_ENOSUPP;
+	return cpu_set( 0, 1 );
+}
+
+static void
+call_start_stop( void )
+{
+	PAPI_start( EventSet );
+	PAPI_stop( EventSet, values );
+}
+
+static void call_read( void ) { PAPI_read( EventSet, values ); }
+static void call_accum( void ) { PAPI_accum( EventSet, values ); }
+static void call_reset( void ) { PAPI_reset( EventSet ); }
+
+static int
+setup_derived( const char *type )
+{
+	int retval, code;
+
+	if ( ( retval = create_set( NULL ) ) != PAPI_OK )
+		return retval;
+	code = find_derived( type );
+	if ( code == PAPI_NULL )
+		return PAPI_ENOEVNT;
+	if ( ( retval = PAPI_add_event( EventSet, code ) ) != PAPI_OK )
+		return retval;
+	return PAPI_start( EventSet );
+}
+
+static int setup_derived_add( void ) { return setup_derived( "DERIVED_ADD" ); }
+static int setup_derived_postfix( void ) { return setup_derived( "DERIVED_POSTFIX" ); }
+
+#if SDE
+static long long sde_counter;
+
+static int
+setup_sde( void )
+{
+	int retval;
+	papi_handle_t handle;
+
+	handle = papi_sde_init( "bench" );
+	papi_sde_register_counter( handle, "counter", PAPI_SDE_RO | PAPI_SDE_DELTA,
+		PAPI_SDE_long_long, &sde_counter );
+
+	if ( ( retval = create_set( "sde" ) ) != PAPI_OK )
+		return retval;
+	if ( ( retval = PAPI_add_named_event( EventSet, "sde:::bench::counter" ) ) != PAPI_OK )
+		return retval;
+	return PAPI_start( EventSet );
+}
+#else
+static int setup_sde( void ) { return PAPI_ENOSUPP; }
+#endif
+
+static int setup_rapl( void ) { return component_set( "rapl" ); }
+static int setup_powercap( void ) { return component_set( "powercap" ); }
+
+static int
+setup_appio( void )
+{
+	int retval;
+
+	fd = open( "/dev/zero", O_RDONLY );
+	if ( fd < 0 )
+		return PAPI_ESYS;
+	if ( ( retval = create_set( "appio" ) ) != PAPI_OK )
+		return retval;
+	if ( ( retval = PAPI_add_named_event( EventSet, "appio:::READ_CALLS" ) ) != PAPI_OK )
+		return retval;
+	return PAPI_start( EventSet );
+}
+
+static int
+setup_raw_read( void )
+{
+	fd = open( "/dev/zero", O_RDONLY );
+	return fd < 0 ? PAPI_ESYS : PAPI_OK;
+}
+
+static void
+call_read_fd( void )
+{
+	char c;
+
+	if ( read( fd, &c, 1 ) != 1 )
+		abort(  );
+}
+
+/* The same read() without going through an interposer, for reference */
+static void
+call_read_syscall( void )
+{
+	char c;
+
+	if ( syscall( SYS_read, fd, &c, 1 ) != 1 )
+		abort(  );
+}
+
+static void
+call_hl_region( void )
+{
+	PAPI_hl_region_begin( "bench" );
+	PAPI_hl_region_end( "bench" );
+}
+
+static int
+setup_hl( void )
+{
+	/* the first begin initializes the library and adds the events */
+	/* of PAPI_EVENTS, or the default ones                          */
+	if ( PAPI_hl_region_begin( "bench" ) != PAPI_OK )
+		return PAPI_ENOEVNT;
+	return PAPI_hl_region_end( "bench" );
+}
+
+static int
+setup_name( void )
+{
+	return PAPI_event_name_to_code( "perf::CPU-CLOCK", &event_code );
+}
+
+static void
+call_preset_name( void )
+{
+	int code;
+
+	PAPI_event_name_to_code( "PAPI_TOT_CYC", &code );
+}
+
+static void
+call_native_name( void )
+{
+	int code;
+
+	PAPI_event_name_to_code( "perf::CPU-CLOCK", &code );
+}
+
+static void
+call_code_to_name( void )
+{
+	char name[PAPI_MAX_STR_LEN];
+
+	PAPI_event_code_to_name( event_code, name );
+}
+
+static const bench_case_t cases[] = {
+	{ "loop_latency", NULL, setup_nothing, call_nothing },
+	{ "start_stop", NULL, setup_stopped, call_start_stop },
+	{ "read_rdpmc", NULL, setup_rdpmc, call_read },
+	{ "read_syscall_group", "PAPI_PERF_EVENT_RDPMC=0", setup_running, call_read },
+	{ "read_syscall_nogroup", "PAPI_PERF_EVENT_RDPMC=0", setup_inherit, call_read },
+	{ "accum", NULL, setup_running, call_accum },
+	{ "reset", NULL, setup_running, call_reset },
+	{ "read_derived_add", NULL, setup_derived_add, call_read },
+	{ "read_derived_postfix", NULL, setup_derived_postfix, call_read },
+	{ "read_sde", NULL, setup_sde, call_read },
+	{ "read_rapl", NULL, setup_rapl, call_read },
+	{ "read_powercap", NULL, setup_powercap, call_read },
+	{ "io_read_raw", NULL, setup_raw_read, call_read_syscall },
+	{ "io_read_appio", NULL, setup_appio, call_read_fd },
+	{ "hl_region", NULL, setup_hl, call_hl_region },
+	{ "name_to_code_preset", NULL, setup_nothing, call_preset_name },
+	{ "name_to_code_native", NULL, setup_name, call_native_name },
+	{ "code_to_name_native", NULL, setup_name, call_code_to_name },
+};
+
+#define NUM_CASES ( ( int ) ( sizeof ( cases ) / sizeof ( cases[0] ) ) )
+
+/* Runs in the child: set up, time num_iters calls, reduce */
+static void
+run_case( const bench_case_t *bc, bench_result_t *res )
+{
+	long long *array, t;
+	const char *msg;
+	int i, retval;
+
+	memset( res, 0, sizeof ( *res ) );
+
+	/* the high-level API initializes the library itself */
+	if ( bc->setup != setup_hl ) {
+		retval = PAPI_library_init( PAPI_VER_CURRENT );
+		if ( retval != PAPI_VER_CURRENT ) {
+			res->status = retval < 0 ? retval : PAPI_EINVAL;
+			strcpy( res->reason, "PAPI_library_init failed" );
+			return;
+		}
+	}
+
+	retval = bc->setup(  );
+	if ( retval != PAPI_OK ) {
+		res->status = retval;
+		msg = PAPI_strerror( retval );
+		snprintf( res->reason, sizeof ( res->reason ), "%s",
+			msg ? msg : "setup failed" );
+		return;
+	}
+
+	array = malloc( ( size_t ) num_iters * sizeof ( long long ) );
+	if ( array == NULL ) {
+		res->status = PAPI_ENOMEM;
+		strcpy( res->reason, "out of memory" );
+		return;
+	}
+
+	/* warm up */
+	for ( i = 0; i < num_iters / 100 + 1; i++ )
+		bc->call(  );
+
+	for ( i = 0; i < num_iters; i++ ) {
+		t = PAPI_get_real_cyc(  );
+		bc->call(  );
+		array[i] = PAPI_get_real_cyc(  ) - t;
+	}
+
+	res->std = do_stats( array, &res->min, &res->max, &res->mean );
+	do_percentile( array, &res->p25, &res->p50, &res->p75, &res->p99 );
+	free( array );
+}
+
+/* Run a case in a child so it gets a fresh PAPI and its own environment */
+static void
+fork_case( const bench_case_t *bc, bench_result_t *res )
+{
+	int pipefd[2], status;
+	ssize_t got = 0, n;
+	pid_t pid;
+
+	memset( res, 0, sizeof ( *res ) );
+	res->status = PAPI_ESYS;
+	strcpy( res->reason, "child failed" );
+
+	if ( pipe( pipefd ) < 0 )
+		return;
+
+	fflush( NULL );
+	pid = fork(  );
+	if ( pid < 0 ) {
+		close( pipefd[0] );
+		close( pipefd[1] );
+		return;
+	}
+
+	if ( pid == 0 ) {
+		bench_result_t mine;
+
+		close( pipefd[0] );
+		if ( bc->env )
+			putenv( ( char * ) bc->env );
+		run_case( bc, &mine );
+		if ( write( pipefd[1], &mine, sizeof ( mine ) ) != sizeof ( mine ) )
+			_exit( 1 );
+		/* skip atexit handlers, e.g. the high-level report */
+		_exit( 0 );
+	}
+
+	close( pipefd[1] );
+	while ( got < ( ssize_t ) sizeof ( *res ) ) {
+		n = read( pipefd[0], ( char * ) res + got, sizeof ( *res ) - got );
+		if ( n <= 0 )
+			break;
+		got += n;
+	}
+	close( pipefd[0] );
+	waitpid( pid, &status, 0 );
+
+	if ( got != ( ssize_t ) sizeof ( *res ) ) {
+		memset( res, 0, sizeof ( *res ) );
+		res->status = PAPI_ESYS;
+		snprintf( res->reason, sizeof ( res->reason ),
+			WIFSIGNALED( status ) ? "child killed by signal %d" :
+			"child exited with %d",
+			WIFSIGNALED( status ) ? WTERMSIG( status ) :
+			WEXITSTATUS( status ) );
+	}
+}
+
+/* Only a missing component, event or feature skips a case, any other
+   failure is an error */
+static int
+bench_skipped( int status )
+{
+	return status == PAPI_ENOSUPP || status == PAPI_ENOCMP ||
+		status == PAPI_ECMP_DISABLED || status == PAPI_ENOEVNT;
+}
+
+static void
+print_json_string( FILE *out, const char *s )
+{
+	fputc( '"', out );
+	for ( ; *s; s++ ) {
+		if ( *s == '"' || *s == '\\' )
+			fputc( '\\', out );
+		if ( ( unsigned char ) *s >= ' ' )
+			fputc( *s, out );
+	}
+	fputc( '"', out );
+}
+
+static void
+print_help( void )
+{
+	printf( "This is the PAPI benchmark program.\n" );
+	printf( "It reports cycles per call percentiles for PAPI entry points as JSON.  Usage:\n\n" );
+	printf( "    papi_bench [options]\n\n" );
+	printf( "Options:\n\n" );
+	printf( "  -c CASE       only run cases whose name contains CASE\n" );
+	printf( "  -h            print this help message\n" );
+	printf( "  -l            list the cases\n" );
+	printf( "  -o FILE       write the JSON to FILE instead of stdout\n" );
+	printf( "  -t ITERS      timed calls per case. Default: 100,000\n" );
+	printf( "\n" );
+}
+
+int
+main( int argc, char **argv )
+{
+	const char *filter = NULL;
+	FILE *out = stdout;
+	bench_result_t res;
+	int i, c, first = 1, errors = 0;
+
+	num_iters = BENCH_ITERS;
+
+	while ( ( c = getopt( argc, argv, "c:hlo:t:" ) ) != -1 ) {
+		switch ( c ) {
+		case 'c':
+			filter = optarg;
+			break;
+		case 'l':
+			for ( i = 0; i < NUM_CASES; i++ )
+				printf( "%s\n", cases[i].name );
+			return 0;
+		case 'o':
+			out = fopen( optarg, "w" );
+			if ( out == NULL ) {
+				perror( optarg );
+				return 1;
+			}
+			break;
+		case 't':
+			num_iters = atoi( optarg );
+			if ( num_iters < 2 ) {
+				fprintf( stderr, "Need at least 2 iterations\n" );
+				return 1;
+			}
+			break;
+		case 'h':
+		default:
+			print_help(  );
+			return 1;
+		}
+	}
+
+	fprintf( out, "{\n  \"papi_version\": \"%d.%d.%d.%d\",\n",
+		PAPI_VERSION_MAJOR( PAPI_VERSION ), PAPI_VERSION_MINOR( PAPI_VERSION ),
+		PAPI_VERSION_REVISION( PAPI_VERSION ), PAPI_VERSION_INCREMENT( PAPI_VERSION ) );
+	fprintf( out, "  \"unit\": \"cycles\",\n  \"iterations\": %d,\n", num_iters );
+	fprintf( out, "  \"cases\": [" );
+
+	for ( i = 0; i < NUM_CASES; i++ ) {
+		if ( filter && !strstr( cases[i].name, filter ) )
+			continue;
+
+		fork_case( &cases[i], &res );
+
+		fprintf( out, "%s\n    { \"name\": \"%s\", ", first ? "" : ",",
+			cases[i].name );
+		first = 0;
+		if ( res.status != PAPI_OK ) {
+			if ( !bench_skipped( res.status ) )
+				errors++;
+			fprintf( out, "\"status\": \"%s\", \"reason\": ",
+				bench_skipped( res.status ) ? "skipped" : "error" );
+			print_json_string( out, res.reason );
+			fprintf( out, " }" );
+			continue;
+		}
+		fprintf( out, "\"status\": \"ok\", \"min\": %lld, \"p25\": %lld, "
+			"\"p50\": %lld, \"p75\": %lld, \"p99\": %lld, \"max\": %lld, "
+			"\"mean\": %.1f, \"std\": %.1f }",
+			res.min, res.p25, res.p50, res.p75, res.p99, res.max,
+			res.mean, res.std );
+	}
+
+	fprintf( out, "\n  ]\n}\n" );
+	if ( out != stdout )
+		fclose( out );
+
+	return errors ? 1 : 0;
+}
@@ -11,6 +11,10 @@
   *	latency and resolution of the four PAPI timer functions:
   *	PAPI_get_real_cyc(), PAPI_get_virt_cyc(), PAPI_get_real_usec() and PAPI_get_virt_usec().
   *
+  *	It first reports the cost per call of PAPI_get_real_nsec() with each of
+  *	the real time backends (syscall, vdso, tsc) that PAPI_REAL_TIMER selects,
+  *	measuring each one in a child process.
+  *
   *	@section Options
   *		This utility has no command line options.
   *
@@ -22,11 +26,50 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "papi.h"
 
 #include "../testlib/clockcore.h"
 
+#define BACKEND_CALLS 1000000
+
+static const char *backends[] = { "syscall", "vdso", "tsc" };
+
+/* Cost per call and smallest step of PAPI_get_real_nsec() with one */
+/* backend; runs in a child because the backend is picked at init   */
+static void
+backend_cost( const char *backend )
+{
+	long long start, end, prev, now, step = 0;
+	int i;
+
+	setenv( "PAPI_REAL_TIMER", backend, 1 );
+	if ( PAPI_library_init( PAPI_VER_CURRENT ) != PAPI_VER_CURRENT ) {
+		printf( "%-10s: PAPI init failed\n", backend );
+		exit( 1 );
+	}
+
+	start = PAPI_get_real_nsec(  );
+	for ( i = 0; i < BACKEND_CALLS; i++ )
+		PAPI_get_real_nsec(  );
+	end = PAPI_get_real_nsec(  );
+
+	prev = PAPI_get_real_nsec(  );
+	for ( i = 0; i < 1000; i++ ) {
+		now = PAPI_get_real_nsec(  );
+		if ( now > prev && ( step == 0 || now - prev < step ) )
+			step = now - prev;
+		prev = now;
+	}
+
+	printf( "%-10s: %8.1f ns/call, resolution %lld ns\n", backend,
+			( double ) ( end - start ) / BACKEND_CALLS, step );
+	fflush( stdout );
+	exit( 0 );
+}
+
 int
 main( int argc, char **argv )
 {
@@ -34,6 +77,18 @@ main( int argc, char **argv )
 	(void) argv;
 
 	int retval;
+	unsigned int b;
+	pid_t pid;
+
+	printf( "PAPI_get_real_nsec() cost per real time backend.\n" );
+	printf( "-----------------------------------------------\n" );
+	fflush( stdout );
+	for ( b = 0; b < sizeof ( backends ) / sizeof ( backends[0] ); b++ ) {
+		pid = fork(  );
+		if ( pid == 0 ) backend_cost( backends[b] );
+		if ( pid > 0 ) waitpid( pid, NULL, 0 );
+	}
+	printf( "\n" );
 
 	retval = PAPI_library_init( PAPI_VER_CURRENT );
 	if (retval != PAPI_VER_CURRENT ) {
@@ -0,0 +1,195 @@
+/** file papi_plan_events.c
+  * @brief papi_plan_events utility.
+  *	@page papi_plan_events
+  *	@section NAME
+  *		papi_plan_events - splits a list of events into groups
+  *		that can be counted together.
+  *
+  *	@section Synopsis
+  *		papi_plan_events [-f file] < event > < event > ...
+  *
+  *	@section Description
+  *		papi_plan_events is a PAPI utility program that packs a list of
+  *		events, of any length, into as few groups as the hardware allows,
+  *		using PAPI_plan_events().  The groups are printed pass by pass;
+  *		running the program once per pass, with one EventSet per group,
+  *		counts every event.  The number of passes is also the least
+  *		multiplexing that counting all the events at once needs.
+  *
+  *	@section Options
+  *	<ul>
+  *		<li>-f file  Read event names from file, one or more per line;
+  *			everything after a '#' is ignored.
+  *		<li>-h  Display help information about this utility.
+  *	</ul>
+  *
+  *	@section Bugs
+  *		There are no known bugs in this utility.
+  *		If you find a bug, it should be reported to the
+  *		PAPI Mailing List at <ptools-perfapi@icl.utk.edu>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "papi.h"
+
+static void
+print_help( char **argv )
+{
+	printf( "Usage: %s [-f file] event [event ...]\n", argv[0] );
+	printf( "Split a list of events into groups that can be counted together.\n" );
+	printf( "  -f file  read event names from file ('#' starts a comment)\n" );
+	printf( "  -h       print this help message\n" );
+}
+
+static int
+add_name( char ***names, int *number, int *size, const char *name )
+{
+	char **tmp;
+
+	if ( *number == *size ) {
+		*size = *size ? 2 * *size : 64;
+		tmp = realloc( *names, *size * sizeof ( char * ) );
+		if ( tmp == NULL )
+			return -1;
+		*names = tmp;
+	}
+	if ( ( ( *names )[*number] = strdup( name ) ) == NULL )
+		return -1;
+	( *number )++;
+	return 0;
+}
+
+static int
+read_names( const char *file, char ***names, int *number, int *size )
+{
+	char line[PAPI_HUGE_STR_LEN], *tok, *hash;
+	FILE *fp;
+
+	if ( ( fp = fopen( file, "r" ) ) == NULL ) {
+		fprintf( stderr, "Cannot open %s\n", file );
+		return -1;
+	}
+	while ( fgets( line, sizeof ( line ), fp ) ) {
+		if ( ( hash = strchr( line, '#' ) ) != NULL )
+			*hash = '\0';
+		for ( tok = strtok( line, " \t\r\n," ); tok;
+			  tok = strtok( NULL, " \t\r\n," ) ) {
+			if ( add_name( names, number, size, tok ) ) {
+				fclose( fp );
+				return -1;
+			}
+		}
+	}
+	fclose( fp );
+	return 0;
+}
+
+int
+main( int argc, char **argv )
+{
+	char **names = NULL;
+	int *group, *pass;
+	int number = 0, size = 0;
+	int i, p, g, code, first, retval, passes, groups = 0, lost = 0;
+	const PAPI_component_info_t *cmpinfo;
+
+	for ( i = 1; i < argc; i++ ) {
+		if ( !strcmp( argv[i], "-h" ) || !strcmp( argv[i], "--help" ) ) {
+			print_help( argv );
+			exit( 0 );
+		} else if ( !strcmp( argv[i], "-f" ) ) {
+			if ( i + 1 >= argc ) {
+				print_help( argv );
+				exit( 1 );
+			}
+			if ( read_names( argv[++i], &names, &number, &size ) )
+				exit( 1 );
+		} else if ( add_name( &names, &number, &size, argv[i] ) ) {
+			fprintf( stderr, "Out of memory\n" );
+			exit( 1 );
+		}
+	}
+
+	if ( number == 0 ) {
+		print_help( argv );
+		exit( 1 );
+	}
+
+	retval = PAPI_library_init( PAPI_VER_CURRENT );
+	if ( retval != PAPI_VER_CURRENT ) {
+		fprintf( stderr, "Error! PAPI_library_init\n" );
+		exit( retval );
+	}
+
+	group = malloc( number * sizeof ( int ) );
+	pass = malloc( number * sizeof ( int ) );
+	if ( group == NULL || pass == NULL ) {
+		fprintf( stderr, "Out of memory\n" );
+		exit( 1 );
+	}
+
+	passes = PAPI_plan_events( names, number, group, pass );
+	if ( passes < 0 ) {
+		fprintf( stderr, "Error! PAPI_plan_events: %s\n",
+				 PAPI_strerror( passes ) );
+		exit( 1 );
+	}
+
+	for ( i = 0; i < number; i++ ) {
+		if ( group[i] >= groups )
+			groups = group[i] + 1;
+		if ( group[i] < 0 )
+			lost++;
+	}
+
+	printf( "Plan for %d events: %d groups in %d passes\n",
+			number - lost, groups, passes );
+	printf( "--------------------------------------------------------------------------------\n" );
+
+	for ( p = 0; p < passes; p++ ) {
+		printf( "Pass %d\n", p );
+		for ( g = 0; g < groups; g++ ) {
+			first = -1;
+			for ( i = 0; i < number; i++ ) {
+				if ( group[i] != g || pass[i] != p )
+					continue;
+				if ( first < 0 ) {
+					first = i;
+					PAPI_event_name_to_code( names[i], &code );
+					cmpinfo = PAPI_get_component_info(
+						PAPI_get_event_component( code ) );
+					printf( "  Group %d (%s):\n", g,
+							cmpinfo ? cmpinfo->name : "?" );
+				}
+				printf( "    %s\n", names[i] );
+			}
+		}
+	}
+
+	if ( lost ) {
+		printf( "--------------------------------------------------------------------------------\n" );
+		printf( "Events that cannot be counted:\n" );
+		for ( i = 0; i < number; i++ ) {
+			if ( group[i] < 0 )
+				printf( "    %s\n", names[i] );
+		}
+	}
+
+	if ( passes > 1 ) {
+		printf( "--------------------------------------------------------------------------------\n" );
+		printf( "Run once per pass to count every event for the whole run, or\n"
+				"multiplex them; each event is then counted about 1/%d of the time.\n",
+				passes );
+	}
+
+	for ( i = 0; i < number; i++ )
+		free( names[i] );
+	free( names );
+	free( group );
+	free( pass );
+	PAPI_shutdown(  );
+	return 0;
+}
@@ -0,0 +1,451 @@
+/** file papi_thread_bench.c
+  * @brief papi_thread_bench utility.
+  *	@page papi_thread_bench
+  * @section  NAME
+  *		papi_thread_bench - measures how PAPI calls scale with the number of threads.
+  *
+  *	@section Synopsis
+  *		papi_thread_bench [-h] [-n threads] [-s seconds] [-w workload] [-o file]
+  *
+  *	@section Description
+  *		papi_thread_bench runs 1, 2, 4, ... up to N threads that all
+  *		repeat the same PAPI workload for a fixed time, and reports the
+  *		operations per second for each thread count as JSON.  Throughput
+  *		that stops growing with the thread count points at contention
+  *		in the library, e.g. on its internal, thread, memory, high-level
+  *		or multiplex locks.
+  *		The workloads are:
+  *		<ul>
+  *		<li>lifecycle: PAPI_register_thread, create_eventset, add_event,
+  *			start, read, stop, cleanup, destroy and unregister_thread.
+  *		<li>read: PAPI_read of an event set each thread keeps running.
+  *		<li>multiplex: the lifecycle of a multiplexed event set.
+  *		<li>hl_region: PAPI_hl_region_begin/end pairs, counting the
+  *			events in PAPI_EVENTS or the high-level defaults.
+  *		</ul>
+  *		Each workload runs in its own child process.  A thread count at
+  *		which the workload fails is reported with the error.
+  *
+  *	@section Options
+  *	<ul>
+  *		<li>-h	Display help information about this utility.
+  *		<li>-n < threads >	The largest number of threads. The default is
+  *			the number of online cpus, but at least 4.
+  *		<li>-o < file >	Write the JSON to a file instead of stdout.
+  *		<li>-s < seconds >	How long each thread count runs. The default is 1.
+  *		<li>-w < workload >	Only run this workload.
+  *	</ul>
+  *
+  *	@section Bugs
+  *		There are no known bugs in this utility. If you find a bug,
+  *		it should be reported to the PAPI Mailing List at <ptools-perfapi@icl.utk.edu>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "papi.h"
+
+#define MAX_THREADS	1024
+
+typedef struct {
+	pthread_t thread;
+	int EventSet;
+	long long ops;
+	int error;
+} bench_thread_t;
+
+typedef struct {
+	const char *name;
+	int ( *setup ) ( bench_thread_t * );	/* per thread, before timing */
+	int ( *op ) ( bench_thread_t * );		/* one timed operation       */
+	void ( *teardown ) ( bench_thread_t * );
+	int multiplex;
+	int high_level;
+} workload_t;
+
+static const workload_t *workload;
+static pthread_barrier_t barrier;
+static volatile int stop;
+static int event_code[2];
+static int num_events;
+
+/*********************************************************************/
+/* Workloads                                                         */
+/*********************************************************************/
+
+static int
+open_set( bench_thread_t *me, int multiplex )
+{
+	int retval, i;
+
+	me->EventSet = PAPI_NULL;
+	if ( ( retval = PAPI_create_eventset( &me->EventSet ) ) != PAPI_OK )
+		return retval;
+	if ( multiplex ) {
+		if ( ( retval = PAPI_assign_eventset_component( me->EventSet, 0 ) ) != PAPI_OK ||
+			 ( retval = PAPI_set_multiplex( me->EventSet ) ) != PAPI_OK )
+			return retval;
+	}
+	for ( i = 0; i < num_events; i++ ) {
+		if ( ( retval = PAPI_add_event( me->EventSet, event_code[i] ) ) != PAPI_OK )
+			return retval;
+	}
+	return PAPI_OK;
+}
+
+static void
+close_set( bench_thread_t *me )
+{
+	long long values[2];
+
+	if ( me->EventSet == PAPI_NULL )
+		return;
+	PAPI_stop( me->EventSet, values );
+	PAPI_cleanup_eventset( me->EventSet );
+	PAPI_destroy_eventset( &me->EventSet );
+}
+
+static int
+no_setup( bench_thread_t *me )
+{
+	me->EventSet = PAPI_NULL;
+	return PAPI_OK;
+}
+
+static void no_teardown( bench_thread_t *me ) { ( void ) me; }
+
+static int
+lifecycle( bench_thread_t *me, int multiplex )
+{
+	long long values[2];
+	int retval;
+
+	if ( ( retval = PAPI_register_thread(  ) ) != PAPI_OK )
+		return retval;
+	if ( ( retval = open_set( me, multiplex ) ) != PAPI_OK ||
+		 ( retval = PAPI_start( me->EventSet ) ) != PAPI_OK ||
+		 ( retval = PAPI_read( me->EventSet, values ) ) != PAPI_OK ||
+		 ( retval = PAPI_stop( me->EventSet, values ) ) != PAPI_OK ||
+		 ( retval = PAPI_cleanup_eventset( me->EventSet ) ) != PAPI_OK ||
+		 ( retval = PAPI_destroy_eventset( &me->EventSet ) ) != PAPI_OK )
+		return retval;
+	return PAPI_unregister_thread(  );
+}
+
+static int op_lifecycle( bench_thread_t *me ) { return lifecycle( me, 0 ); }
+static int op_multiplex( bench_thread_t *me ) { return lifecycle( me, 1 ); }
+
+static int
+setup_read( bench_thread_t *me )
+{
+	int retval;
+
+	if ( ( retval = PAPI_register_thread(  ) ) != PAPI_OK ||
+		 ( retval = open_set( me, 0 ) ) != PAPI_OK )
+		return retval;
+	return PAPI_start( me->EventSet );
+}
+
+static int
+op_read( bench_thread_t *me )
+{
+	long long values[2];
+
+	return PAPI_read( me->EventSet, values );
+}
+
+static void
+teardown_read( bench_thread_t *me )
+{
+	close_set( me );
+	PAPI_unregister_thread(  );
+}
+
+static int
+op_hl_region( bench_thread_t *me )
+{
+	int retval;
+
+	( void ) me;
+	if ( ( retval = PAPI_hl_region_begin( "thread_bench" ) ) != PAPI_OK )
+		return retval;
+	return PAPI_hl_region_end( "thread_bench" );
+}
+
+static void
+teardown_hl( bench_thread_t *me )
+{
+	( void ) me;
+	PAPI_hl_stop(  );
+}
+
+static const workload_t workloads[] = {
+	{ "lifecycle", no_setup, op_lifecycle, no_teardown, 0, 0 },
+	{ "read", setup_read, op_read, teardown_read, 0, 0 },
+	{ "multiplex", no_setup, op_multiplex, no_teardown, 1, 0 },
+	{ "hl_region", no_setup, op_hl_region, teardown_hl, 0, 1 },
+};
+
+#define NUM_WORKLOADS ( ( int ) ( sizeof ( workloads ) / sizeof ( workloads[0] ) ) )
+
+/*********************************************************************/
+/* Driver                                                            */
+/*********************************************************************/
+
+static void *
+worker( void *arg )
+{
+	bench_thread_t *me = arg;
+	int retval;
+
+	me->error = workload->setup( me );
+	pthread_barrier_wait( &barrier );
+
+	if ( me->error == PAPI_OK ) {
+		while ( !stop ) {
+			retval = workload->op( me );
+			if ( retval != PAPI_OK ) {
+				me->error = retval;
+				break;
+			}
+			me->ops++;
+		}
+	}
+
+	/* every thread is done timing before any tears down */
+	pthread_barrier_wait( &barrier );
+	workload->teardown( me );
+	return NULL;
+}
+
+/* Run n threads for the given time, returns total ops or an error */
+static long long
+run_threads( bench_thread_t *threads, int n, double seconds, int *error )
+{
+	long long ops = 0;
+	int i;
+
+	stop = 0;
+	*error = PAPI_OK;
+	memset( threads, 0, ( size_t ) n * sizeof ( bench_thread_t ) );
+	pthread_barrier_init( &barrier, NULL, ( unsigned ) n + 1 );
+
+	for ( i = 0; i < n; i++ ) {
+		if ( pthread_create( &threads[i].thread, NULL, worker, &threads[i] ) ) {
+			fprintf( stderr, "pthread_create failed\n" );
+			exit( 1 );
+		}
+	}
+
+	pthread_barrier_wait( &barrier );
+	usleep( ( useconds_t ) ( seconds * 1000000.0 ) );
+	stop = 1;
+	pthread_barrier_wait( &barrier );
+
+	for ( i = 0; i < n; i++ ) {
+		pthread_join( threads[i].thread, NULL );
+		ops += threads[i].ops;
+		if ( threads[i].error != PAPI_OK )
+			*error = threads[i].error;
+	}
+	pthread_barrier_destroy( &barrier );
+	return ops;
+}
+
+static int
+find_events( void )
+{
+	const char *names[2][2] = {
+		{ "PAPI_TOT_CYC", "perf::TASK-CLOCK" },
+		{ "PAPI_TOT_INS", "perf::CONTEXT-SWITCHES" },
+	};
+	int i, j;
+
+	for ( i = 0; i < 2; i++ ) {
+		for ( j = 0; j < 2; j++ ) {
+			if ( PAPI_event_name_to_code( names[i][j],
+					&event_code[num_events] ) == PAPI_OK &&
+				 PAPI_query_event( event_code[num_events] ) == PAPI_OK ) {
+				num_events++;
+				break;
+			}
+		}
+	}
+	return num_events ? PAPI_OK : PAPI_ENOEVNT;
+}
+
+static void
+print_error( FILE *out, int error )
+{
+	const char *msg = PAPI_strerror( error );
+
+	fprintf( out, "\"error\": \"%s\"", msg ? msg : "unknown" );
+}
+
+/* Runs in a child: all thread counts of one workload */
+static void
+run_workload( FILE *out, int max_threads, double seconds )
+{
+	bench_thread_t *threads;
+	long long ops;
+	int n, retval, error, first = 1;
+
+	fprintf( out, "\n    { \"name\": \"%s\", ", workload->name );
+
+	/* the high-level API initializes the library and its threads itself */
+	if ( !workload->high_level ) {
+		retval = PAPI_library_init( PAPI_VER_CURRENT );
+		if ( retval != PAPI_VER_CURRENT ) {
+			fprintf( out, "\"error\": \"PAPI_library_init failed\" }" );
+			return;
+		}
+		if ( ( retval = PAPI_thread_init( ( unsigned long ( * )( void ) )
+				pthread_self ) ) != PAPI_OK ||
+			 ( workload->multiplex &&
+			   ( retval = PAPI_multiplex_init(  ) ) != PAPI_OK ) ||
+			 ( retval = find_events(  ) ) != PAPI_OK ) {
+			print_error( out, retval );
+			fprintf( out, " }" );
+			return;
+		}
+	}
+
+	threads = calloc( ( size_t ) max_threads, sizeof ( bench_thread_t ) );
+	if ( threads == NULL ) {
+		print_error( out, PAPI_ENOMEM );
+		fprintf( out, " }" );
+		return;
+	}
+
+	fprintf( out, "\"results\": [" );
+	for ( n = 1; n <= max_threads; n = ( n < max_threads && n * 2 > max_threads ) ?
+		  max_threads : n * 2 ) {
+		ops = run_threads( threads, n, seconds, &error );
+		fprintf( out, "%s\n      { \"threads\": %d, ", first ? "" : ",", n );
+		first = 0;
+		if ( error != PAPI_OK ) {
+			print_error( out, error );
+			fprintf( out, " }" );
+			break;
+		}
+		fprintf( out, "\"ops\": %lld, \"ops_per_sec\": %.1f, "
+			"\"ops_per_sec_per_thread\": %.1f }",
+			ops, ( double ) ops / seconds, ( double ) ops / seconds / n );
+		if ( n == max_threads )
+			break;
+	}
+	fprintf( out, "\n      ] }" );
+	free( threads );
+}
+
+static void
+print_help( void )
+{
+	printf( "This is the PAPI thread scaling benchmark.\n" );
+	printf( "It reports PAPI operations per second for 1..N threads as JSON.  Usage:\n\n" );
+	printf( "    papi_thread_bench [options]\n\n" );
+	printf( "Options:\n\n" );
+	printf( "  -h            print this help message\n" );
+	printf( "  -n THREADS    largest number of threads. Default: online cpus, at least 4\n" );
+	printf( "  -o FILE       write the JSON to FILE instead of stdout\n" );
+	printf( "  -s SECONDS    time per thread count. Default: 1\n" );
+	printf( "  -w WORKLOAD   only run WORKLOAD (lifecycle, read, multiplex, hl_region)\n" );
+	printf( "\n" );
+}
+
+int
+main( int argc, char **argv )
+{
+	const char *only = NULL;
+	FILE *out = stdout;
+	double seconds = 1.0;
+	int max_threads, i, c, status, first = 1;
+	pid_t pid;
+
+	max_threads = ( int ) sysconf( _SC_NPROCESSORS_ONLN );
+	if ( max_threads < 4 )
+		max_threads = 4;
+
+	while ( ( c = getopt( argc, argv, "hn:o:s:w:" ) ) != -1 ) {
+		switch ( c ) {
+		case 'n':
+			max_threads = atoi( optarg );
+			if ( max_threads < 1 || max_threads > MAX_THREADS ) {
+				fprintf( stderr, "Threads must be 1..%d\n", MAX_THREADS );
+				return 1;
+			}
+			break;
+		case 'o':
+			out = fopen( optarg, "w" );
+			if ( out == NULL ) {
+				perror( optarg );
+				return 1;
+			}
+			break;
+		case 's':
+			seconds = atof( optarg );
+			if ( seconds <= 0 ) {
+				fprintf( stderr, "Seconds must be positive\n" );
+				return 1;
+			}
+			break;
+		case 'w':
+			only = optarg;
+			break;
+		case 'h':
+		default:
+			print_help(  );
+			return 1;
+		}
+	}
+
+	fprintf( out, "{\n  \"papi_version\": \"%d.%d.%d.%d\",\n",
+		PAPI_VERSION_MAJOR( PAPI_VERSION ), PAPI_VERSION_MINOR( PAPI_VERSION ),
+		PAPI_VERSION_REVISION( PAPI_VERSION ), PAPI_VERSION_INCREMENT( PAPI_VERSION ) );
+	fprintf( out, "  \"seconds\": %.3f,\n  \"max_threads\": %d,\n",
+		seconds, max_threads );
+	fprintf( out, "  \"workloads\": [" );
+
+	for ( i = 0; i < NUM_WORKLOADS; i++ ) {
+		if ( only && strcmp( only, workloads[i].name ) )
+			continue;
+
+		if ( !first )
+			fprintf( out, "," );
+		first = 0;
+		fflush( out );
+
+		/* a fresh library per workload, the high-level API wants its own */
+		pid = fork(  );
+		if ( pid < 0 ) {
+			perror( "fork" );
+			return 1;
+		}
+		if ( pid == 0 ) {
+			workload = &workloads[i];
+			run_workload( out, max_threads, seconds );
+			fflush( out );
+			/* skip atexit handlers, e.g. the high-level report */
+			_exit( 0 );
+		}
+		waitpid( pid, &status, 0 );
+		if ( !WIFEXITED( status ) || WEXITSTATUS( status ) ) {
+			fprintf( out, "\n    { \"name\": \"%s\", \"error\": \"child %s %d\" }",
+				workloads[i].name,
+				WIFSIGNALED( status ) ? "killed by signal" : "exited with",
+				WIFSIGNALED( status ) ? WTERMSIG( status ) :
+				WEXITSTATUS( status ) );
+		}
+	}
+
+	fprintf( out, "\n  ]\n}\n" );
+	if ( out != stdout )
+		fclose( out );
+
+	return 0;
+}